@@ -0,0 +1,503 @@
+/*
+ * This file is part of the MicroPython project, http://micropython.org/
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2019 Damien P. George
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <string.h>
+
+#include "py/runtime.h"
+#include "py/smallint.h"
+#include "py/stream.h"
+#include "py/mperrno.h"
+#include "py/mphal.h"
+#include "extmod/modutimeq.h"
+#include "extmod/moduselect.h"
+
+#include "supervisor/shared/translate.h"
+
+#if MICROPY_PY_UEVENT
+
+// An event loop for coroutines.  Tasks are generators, resumed directly with
+// mp_resume.  When a task yields, the value tells the loop what it waits for:
+// a sleep object puts it in the timer queue (a utimeq), an I/O object puts it
+// in the poll map (as used by uselect) until its stream is ready, and anything
+// else puts it at the back of the run queue.  The sleep and I/O objects are
+// native awaitables: they yield themselves once, then finish, so that
+// "await uevent.sleep_ms(10)" in a coroutine is what reaches the loop.
+
+#define TICKS_PERIOD MICROPY_PY_UTIME_TICKS_PERIOD
+#define TICKS_MAX (TICKS_PERIOD - 1)
+#define TICKS_HALFPERIOD (TICKS_PERIOD / 2)
+
+STATIC mp_uint_t uevent_ticks_ms(void) {
+    return mp_hal_ticks_ms() & TICKS_MAX;
+}
+
+STATIC mp_int_t uevent_ticks_diff(mp_uint_t end, mp_uint_t start) {
+    return ((end - start + TICKS_HALFPERIOD) & TICKS_MAX) - TICKS_HALFPERIOD;
+}
+
+/******************************************************************************/
+// Awaitables
+
+STATIC const mp_obj_type_t uevent_sleep_type;
+STATIC const mp_obj_type_t uevent_io_type;
+
+typedef struct _mp_obj_uevent_sleep_t {
+    mp_obj_base_t base;
+    mp_uint_t ms;
+    bool yielded;
+} mp_obj_uevent_sleep_t;
+
+STATIC mp_obj_t uevent_sleep_iternext(mp_obj_t self_in) {
+    mp_obj_uevent_sleep_t *self = MP_OBJ_TO_PTR(self_in);
+    if (!self->yielded) {
+        // hand ourselves to the loop, which wakes the task when we're due
+        self->yielded = true;
+        return self_in;
+    }
+    return MP_OBJ_STOP_ITERATION;
+}
+
+STATIC const mp_obj_type_t uevent_sleep_type = {
+    { &mp_type_type },
+    .name = MP_QSTR_sleep,
+    .getiter = mp_identity_getiter,
+    .iternext = uevent_sleep_iternext,
+};
+
+STATIC mp_obj_t uevent_new_sleep(mp_int_t ms) {
+    mp_obj_uevent_sleep_t *o = m_new_obj(mp_obj_uevent_sleep_t);
+    o->base.type = &uevent_sleep_type;
+    o->ms = ms < 0 ? 0 : ms;
+    o->yielded = false;
+    return MP_OBJ_FROM_PTR(o);
+}
+
+STATIC mp_obj_t uevent_sleep_ms(mp_obj_t ms_in) {
+    return uevent_new_sleep(mp_obj_get_int(ms_in));
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(uevent_sleep_ms_obj, uevent_sleep_ms);
+
+STATIC mp_obj_t uevent_sleep(mp_obj_t s_in) {
+    #if MICROPY_PY_BUILTINS_FLOAT
+    return uevent_new_sleep(1000 * mp_obj_get_float(s_in));
+    #else
+    return uevent_new_sleep(1000 * mp_obj_get_int(s_in));
+    #endif
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(uevent_sleep_obj, uevent_sleep);
+
+enum {
+    UEVENT_IO_READ,
+    UEVENT_IO_READINTO,
+    UEVENT_IO_READLINE,
+    UEVENT_IO_WRITE,
+};
+
+typedef struct _mp_obj_uevent_io_t {
+    mp_obj_base_t base;
+    mp_obj_t stream;
+    byte op;
+    byte *buf;      // data being read into or written
+    size_t len;     // size of buf
+    size_t done;    // bytes of buf read or written so far
+    mp_obj_t obj;   // the object buf belongs to, if given by the caller
+} mp_obj_uevent_io_t;
+
+// Do as much of the operation as the stream allows without blocking.  Returns
+// the object itself if the task must wait for the stream, otherwise finishes
+// with the result of the operation.
+STATIC mp_obj_t uevent_io_iternext(mp_obj_t self_in) {
+    mp_obj_uevent_io_t *self = MP_OBJ_TO_PTR(self_in);
+    const mp_stream_p_t *stream_p = mp_get_stream(self->stream);
+    int errcode;
+    for (;;) {
+        mp_uint_t n;
+        if (self->op == UEVENT_IO_WRITE) {
+            if (self->done == self->len) {
+                return MP_OBJ_STOP_ITERATION;
+            }
+            n = stream_p->write(self->stream, self->buf + self->done, self->len - self->done, &errcode);
+        } else {
+            if (self->op == UEVENT_IO_READLINE && self->done == self->len) {
+                self->len *= 2;
+                self->buf = m_renew(byte, self->buf, self->done, self->len);
+            }
+            // a line is read a byte at a time, so nothing past it is consumed
+            size_t size = self->op == UEVENT_IO_READLINE ? 1 : self->len - self->done;
+            n = stream_p->read(self->stream, self->buf + self->done, size, &errcode);
+        }
+        if (n == MP_STREAM_ERROR) {
+            if (mp_is_nonblocking_error(errcode)) {
+                return self_in;
+            }
+            mp_raise_OSError(errcode);
+        }
+        self->done += n;
+        switch (self->op) {
+            case UEVENT_IO_READ:
+                return mp_make_stop_iteration(mp_obj_new_bytes(self->buf, self->done));
+            case UEVENT_IO_READINTO:
+                return mp_make_stop_iteration(MP_OBJ_NEW_SMALL_INT(self->done));
+            case UEVENT_IO_READLINE:
+                if (n == 0 || self->buf[self->done - 1] == '\n') {
+                    return mp_make_stop_iteration(mp_obj_new_bytes(self->buf, self->done));
+                }
+                break;
+        }
+    }
+}
+
+STATIC const mp_obj_type_t uevent_io_type = {
+    { &mp_type_type },
+    .name = MP_QSTR_io,
+    .getiter = mp_identity_getiter,
+    .iternext = uevent_io_iternext,
+};
+
+STATIC mp_obj_t uevent_new_io(mp_obj_t stream, byte op, int stream_op) {
+    mp_get_stream_raise(stream, stream_op | MP_STREAM_OP_IOCTL);
+    mp_obj_uevent_io_t *o = m_new_obj(mp_obj_uevent_io_t);
+    o->base.type = &uevent_io_type;
+    o->stream = stream;
+    o->op = op;
+    o->buf = NULL;
+    o->len = 0;
+    o->done = 0;
+    o->obj = MP_OBJ_NULL;
+    return MP_OBJ_FROM_PTR(o);
+}
+
+STATIC mp_obj_t uevent_read(mp_obj_t stream, mp_obj_t n_in) {
+    mp_obj_uevent_io_t *o = MP_OBJ_TO_PTR(uevent_new_io(stream, UEVENT_IO_READ, MP_STREAM_OP_READ));
+    o->len = mp_obj_get_int(n_in);
+    o->buf = m_new(byte, o->len);
+    return MP_OBJ_FROM_PTR(o);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_2(uevent_read_obj, uevent_read);
+
+STATIC mp_obj_t uevent_readinto(mp_obj_t stream, mp_obj_t buf_in) {
+    mp_obj_uevent_io_t *o = MP_OBJ_TO_PTR(uevent_new_io(stream, UEVENT_IO_READINTO, MP_STREAM_OP_READ));
+    mp_buffer_info_t bufinfo;
+    mp_get_buffer_raise(buf_in, &bufinfo, MP_BUFFER_WRITE);
+    o->buf = bufinfo.buf;
+    o->len = bufinfo.len;
+    o->obj = buf_in;
+    return MP_OBJ_FROM_PTR(o);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_2(uevent_readinto_obj, uevent_readinto);
+
+STATIC mp_obj_t uevent_readline(mp_obj_t stream) {
+    mp_obj_uevent_io_t *o = MP_OBJ_TO_PTR(uevent_new_io(stream, UEVENT_IO_READLINE, MP_STREAM_OP_READ));
+    o->len = 16;
+    o->buf = m_new(byte, o->len);
+    return MP_OBJ_FROM_PTR(o);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(uevent_readline_obj, uevent_readline);
+
+STATIC mp_obj_t uevent_write(mp_obj_t stream, mp_obj_t buf_in) {
+    mp_obj_uevent_io_t *o = MP_OBJ_TO_PTR(uevent_new_io(stream, UEVENT_IO_WRITE, MP_STREAM_OP_WRITE));
+    mp_buffer_info_t bufinfo;
+    mp_get_buffer_raise(buf_in, &bufinfo, MP_BUFFER_READ);
+    o->buf = bufinfo.buf;
+    o->len = bufinfo.len;
+    o->obj = buf_in;
+    return MP_OBJ_FROM_PTR(o);
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_2(uevent_write_obj, uevent_write);
+
+/******************************************************************************/
+// Loop
+
+typedef struct _mp_obj_uevent_loop_t {
+    mp_obj_base_t base;
+    // tasks ready to run, a ring buffer
+    mp_obj_t *runq;
+    size_t runq_alloc;
+    size_t runq_head;
+    size_t runq_len;
+    // sleeping tasks, by wake up time
+    mp_obj_t timers;
+    // streams waited on, with the waiting tasks keyed the same way
+    mp_map_t poll_map;
+    mp_map_t readers;
+    mp_map_t writers;
+    // the task given to run_until_complete, and its result once it's done
+    mp_obj_t main_task;
+    mp_obj_t main_result;
+    bool stopped;
+} mp_obj_uevent_loop_t;
+
+STATIC void uevent_runq_push(mp_obj_uevent_loop_t *self, mp_obj_t task) {
+    if (self->runq_len == self->runq_alloc) {
+        // grow, moving the part of the ring that wraps around to the new end
+        size_t old_alloc = self->runq_alloc;
+        self->runq = m_renew(mp_obj_t, self->runq, old_alloc, old_alloc * 2);
+        self->runq_alloc = old_alloc * 2;
+        for (size_t i = 0; i < self->runq_head; i++) {
+            self->runq[old_alloc + i] = self->runq[i];
+            self->runq[i] = MP_OBJ_NULL;
+        }
+    }
+    size_t i = self->runq_head + self->runq_len;
+    if (i >= self->runq_alloc) {
+        i -= self->runq_alloc;
+    }
+    self->runq[i] = task;
+    self->runq_len++;
+}
+
+STATIC mp_obj_t uevent_runq_pop(mp_obj_uevent_loop_t *self) {
+    mp_obj_t task = self->runq[self->runq_head];
+    self->runq[self->runq_head] = MP_OBJ_NULL; // so we don't retain a pointer
+    if (++self->runq_head == self->runq_alloc) {
+        self->runq_head = 0;
+    }
+    self->runq_len--;
+    return task;
+}
+
+STATIC mp_obj_t uevent_loop_make_new(const mp_obj_type_t *type, size_t n_args, const mp_obj_t *args, mp_map_t *kw_args) {
+    mp_arg_check_num(n_args, kw_args, 0, 1, false);
+    mp_int_t len = n_args > 0 ? mp_obj_get_int(args[0]) : 16;
+    if (len < 1) {
+        mp_raise_ValueError_varg(translate("%q must be >= 1"), MP_QSTR_len);
+    }
+    mp_obj_uevent_loop_t *self = m_new_obj(mp_obj_uevent_loop_t);
+    self->base.type = type;
+    self->runq = m_new0(mp_obj_t, len);
+    self->runq_alloc = len;
+    self->runq_head = 0;
+    self->runq_len = 0;
+    self->timers = mp_utimeq_new(len);
+    mp_map_init(&self->poll_map, 0);
+    mp_map_init(&self->readers, 0);
+    mp_map_init(&self->writers, 0);
+    self->main_task = MP_OBJ_NULL;
+    self->main_result = mp_const_none;
+    self->stopped = false;
+    return MP_OBJ_FROM_PTR(self);
+}
+
+// Make the task wait for the stream of the I/O object to become ready.
+STATIC void uevent_loop_wait_io(mp_obj_uevent_loop_t *self, mp_obj_t task, mp_obj_uevent_io_t *io) {
+    mp_uint_t flags;
+    mp_map_t *waiters;
+    if (io->op == UEVENT_IO_WRITE) {
+        flags = MP_STREAM_POLL_WR;
+        waiters = &self->writers;
+    } else {
+        flags = MP_STREAM_POLL_RD;
+        waiters = &self->readers;
+    }
+    mp_map_elem_t *elem = mp_map_lookup(waiters, mp_obj_id(io->stream), MP_MAP_LOOKUP_ADD_IF_NOT_FOUND);
+    if (elem->value != MP_OBJ_NULL) {
+        mp_raise_msg(&mp_type_RuntimeError, translate("stream already waited on"));
+    }
+    elem->value = task;
+    mp_poll_map_add(&self->poll_map, &io->stream, 1, flags, true);
+}
+
+// Wait up to timeout ms, or forever if it's -1, for a stream to be ready, and
+// move the tasks whose streams are ready to the run queue.
+STATIC void uevent_loop_poll(mp_obj_uevent_loop_t *self, mp_int_t timeout) {
+    if (mp_poll_map_wait(&self->poll_map, timeout) == 0) {
+        return;
+    }
+    for (size_t i = 0; i < self->poll_map.alloc; i++) {
+        if (!MP_MAP_SLOT_IS_FILLED(&self->poll_map, i)) {
+            continue;
+        }
+        mp_obj_t key = self->poll_map.table[i].key;
+        mp_poll_obj_t *poll_obj = MP_OBJ_TO_PTR(self->poll_map.table[i].value);
+        mp_uint_t ret = poll_obj->flags_ret;
+        if (ret == 0) {
+            continue;
+        }
+        // errors wake both kinds of waiter, which then see the error
+        mp_uint_t err = ret & (MP_STREAM_POLL_ERR | MP_STREAM_POLL_HUP);
+        if ((poll_obj->flags & MP_STREAM_POLL_RD) && (ret & MP_STREAM_POLL_RD || err)) {
+            poll_obj->flags &= ~MP_STREAM_POLL_RD;
+            uevent_runq_push(self, mp_map_lookup(&self->readers, key, MP_MAP_LOOKUP_REMOVE_IF_FOUND)->value);
+        }
+        if ((poll_obj->flags & MP_STREAM_POLL_WR) && (ret & MP_STREAM_POLL_WR || err)) {
+            poll_obj->flags &= ~MP_STREAM_POLL_WR;
+            uevent_runq_push(self, mp_map_lookup(&self->writers, key, MP_MAP_LOOKUP_REMOVE_IF_FOUND)->value);
+        }
+        if (poll_obj->flags == 0) {
+            mp_map_lookup(&self->poll_map, key, MP_MAP_LOOKUP_REMOVE_IF_FOUND);
+        }
+    }
+}
+
+// Wait until there is a task to run, moving tasks that are due from the timer
+// queue and the poll map to the run queue.  Returns false if nothing is left
+// that could ever run.
+STATIC bool uevent_loop_wait(mp_obj_uevent_loop_t *self) {
+    for (;;) {
+        mp_int_t timeout = -1;
+        mp_uint_t now = uevent_ticks_ms();
+        while (mp_utimeq_len(self->timers) > 0) {
+            mp_int_t dt = uevent_ticks_diff(mp_utimeq_peektime(self->timers), now);
+            if (dt > 0) {
+                timeout = dt;
+                break;
+            }
+            uevent_runq_push(self, mp_utimeq_pop(self->timers, NULL, NULL));
+        }
+        if (self->runq_len > 0) {
+            // only check the streams, there's already a task to run
+            timeout = 0;
+        }
+        if (self->poll_map.used > 0) {
+            // wait for a stream until the next timer is due
+            uevent_loop_poll(self, timeout);
+        } else if (self->runq_len == 0) {
+            if (timeout < 0) {
+                return false;
+            }
+            mp_hal_delay_ms(timeout);
+        }
+        if (self->runq_len > 0) {
+            return true;
+        }
+    }
+}
+
+// Resume the task until it yields or finishes, and queue it according to what
+// it yielded.  An exception from the task is raised out of the loop.
+STATIC void uevent_loop_run_task(mp_obj_uevent_loop_t *self, mp_obj_t task) {
+    mp_obj_t ret;
+    mp_vm_return_kind_t ret_kind = mp_resume(task, mp_const_none, MP_OBJ_NULL, &ret);
+    if (ret_kind == MP_VM_RETURN_YIELD) {
+        if (MP_OBJ_IS_TYPE(ret, &uevent_sleep_type)) {
+            mp_obj_uevent_sleep_t *sleep = MP_OBJ_TO_PTR(ret);
+            mp_utimeq_push(self->timers, (uevent_ticks_ms() + sleep->ms) & TICKS_MAX, task, mp_const_none);
+        } else if (MP_OBJ_IS_TYPE(ret, &uevent_io_type)) {
+            uevent_loop_wait_io(self, task, MP_OBJ_TO_PTR(ret));
+        } else {
+            uevent_runq_push(self, task);
+        }
+    } else if (ret_kind == MP_VM_RETURN_NORMAL) {
+        if (task == self->main_task) {
+            self->main_result = ret == MP_OBJ_STOP_ITERATION ? mp_const_none : ret;
+            self->main_task = MP_OBJ_NULL;
+            self->stopped = true;
+        }
+    } else {
+        if (task == self->main_task) {
+            self->main_task = MP_OBJ_NULL;
+        }
+        nlr_raise(ret);
+    }
+}
+
+STATIC void uevent_loop_run(mp_obj_uevent_loop_t *self) {
+    self->stopped = false;
+    while (!self->stopped && uevent_loop_wait(self)) {
+        // tasks queued while these run wait for the next round, so that
+        // timers and streams are checked between rounds
+        for (size_t n = self->runq_len; n > 0 && !self->stopped; n--) {
+            uevent_loop_run_task(self, uevent_runq_pop(self));
+        }
+    }
+}
+
+STATIC mp_obj_t uevent_loop_create_task(mp_obj_t self_in, mp_obj_t task) {
+    mp_obj_uevent_loop_t *self = MP_OBJ_TO_PTR(self_in);
+    uevent_runq_push(self, task);
+    return task;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_2(uevent_loop_create_task_obj, uevent_loop_create_task);
+
+STATIC mp_obj_t uevent_loop_call_later_ms(mp_obj_t self_in, mp_obj_t ms_in, mp_obj_t task) {
+    mp_obj_uevent_loop_t *self = MP_OBJ_TO_PTR(self_in);
+    mp_int_t ms = mp_obj_get_int(ms_in);
+    mp_utimeq_push(self->timers, (uevent_ticks_ms() + (ms < 0 ? 0 : ms)) & TICKS_MAX, task, mp_const_none);
+    return task;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_3(uevent_loop_call_later_ms_obj, uevent_loop_call_later_ms);
+
+STATIC mp_obj_t uevent_loop_run_forever(mp_obj_t self_in) {
+    uevent_loop_run(MP_OBJ_TO_PTR(self_in));
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(uevent_loop_run_forever_obj, uevent_loop_run_forever);
+
+STATIC mp_obj_t uevent_loop_run_until_complete(mp_obj_t self_in, mp_obj_t task) {
+    mp_obj_uevent_loop_t *self = MP_OBJ_TO_PTR(self_in);
+    uevent_runq_push(self, task);
+    self->main_task = task;
+    self->main_result = mp_const_none;
+    uevent_loop_run(self);
+    self->main_task = MP_OBJ_NULL;
+    mp_obj_t result = self->main_result;
+    self->main_result = mp_const_none;
+    return result;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_2(uevent_loop_run_until_complete_obj, uevent_loop_run_until_complete);
+
+STATIC mp_obj_t uevent_loop_stop(mp_obj_t self_in) {
+    mp_obj_uevent_loop_t *self = MP_OBJ_TO_PTR(self_in);
+    self->stopped = true;
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(uevent_loop_stop_obj, uevent_loop_stop);
+
+STATIC const mp_rom_map_elem_t uevent_loop_locals_dict_table[] = {
+    { MP_ROM_QSTR(MP_QSTR_create_task), MP_ROM_PTR(&uevent_loop_create_task_obj) },
+    { MP_ROM_QSTR(MP_QSTR_call_later_ms), MP_ROM_PTR(&uevent_loop_call_later_ms_obj) },
+    { MP_ROM_QSTR(MP_QSTR_run_forever), MP_ROM_PTR(&uevent_loop_run_forever_obj) },
+    { MP_ROM_QSTR(MP_QSTR_run_until_complete), MP_ROM_PTR(&uevent_loop_run_until_complete_obj) },
+    { MP_ROM_QSTR(MP_QSTR_stop), MP_ROM_PTR(&uevent_loop_stop_obj) },
+};
+STATIC MP_DEFINE_CONST_DICT(uevent_loop_locals_dict, uevent_loop_locals_dict_table);
+
+STATIC const mp_obj_type_t uevent_loop_type = {
+    { &mp_type_type },
+    .name = MP_QSTR_Loop,
+    .make_new = uevent_loop_make_new,
+    .locals_dict = (mp_obj_dict_t*)&uevent_loop_locals_dict,
+};
+
+STATIC const mp_rom_map_elem_t mp_module_uevent_globals_table[] = {
+    { MP_ROM_QSTR(MP_QSTR___name__), MP_ROM_QSTR(MP_QSTR_uevent) },
+    { MP_ROM_QSTR(MP_QSTR_Loop), MP_ROM_PTR(&uevent_loop_type) },
+    { MP_ROM_QSTR(MP_QSTR_sleep), MP_ROM_PTR(&uevent_sleep_obj) },
+    { MP_ROM_QSTR(MP_QSTR_sleep_ms), MP_ROM_PTR(&uevent_sleep_ms_obj) },
+    { MP_ROM_QSTR(MP_QSTR_read), MP_ROM_PTR(&uevent_read_obj) },
+    { MP_ROM_QSTR(MP_QSTR_readinto), MP_ROM_PTR(&uevent_readinto_obj) },
+    { MP_ROM_QSTR(MP_QSTR_readline), MP_ROM_PTR(&uevent_readline_obj) },
+    { MP_ROM_QSTR(MP_QSTR_write), MP_ROM_PTR(&uevent_write_obj) },
+};
+
+STATIC MP_DEFINE_CONST_DICT(mp_module_uevent_globals, mp_module_uevent_globals_table);
+
+const mp_obj_module_t mp_module_uevent = {
+    .base = { &mp_type_module },
+    .globals = (mp_obj_dict_t*)&mp_module_uevent_globals,
+};
+
+#endif // MICROPY_PY_UEVENT
@@ -25,7 +25,7 @@
  */
 
 #include "py/mpconfig.h"
-#if MICROPY_PY_USELECT
+#if MICROPY_PY_USELECT || MICROPY_PY_UEVENT
 
 #include <stdio.h>
 
@@ -36,53 +36,40 @@
 #include "py/stream.h"
 #include "py/mperrno.h"
 #include "py/mphal.h"
+#include "extmod/moduselect.h"
 
-// Flags for poll()
-#define FLAG_ONESHOT (1)
-
-/// \module select - Provides select function to wait for events on a stream
-///
-/// This module provides the select function.
-
-typedef struct _poll_obj_t {
-    mp_obj_t obj;
-    mp_uint_t (*ioctl)(mp_obj_t obj, mp_uint_t request, mp_uint_t arg, int *errcode);
-    mp_uint_t flags;
-    mp_uint_t flags_ret;
-} poll_obj_t;
-
-STATIC void poll_map_add(mp_map_t *poll_map, const mp_obj_t *obj, mp_uint_t obj_len, mp_uint_t flags, bool or_flags) {
+void mp_poll_map_add(mp_map_t *poll_map, const mp_obj_t *obj, mp_uint_t obj_len, mp_uint_t flags, bool or_flags) {
     for (mp_uint_t i = 0; i < obj_len; i++) {
         mp_map_elem_t *elem = mp_map_lookup(poll_map, mp_obj_id(obj[i]), MP_MAP_LOOKUP_ADD_IF_NOT_FOUND);
-        if (elem->value == NULL) {
+        if (elem->value == MP_OBJ_NULL) {
             // object not found; get its ioctl and add it to the poll list
             const mp_stream_p_t *stream_p = mp_get_stream_raise(obj[i], MP_STREAM_OP_IOCTL);
-            poll_obj_t *poll_obj = m_new_obj(poll_obj_t);
+            mp_poll_obj_t *poll_obj = m_new_obj(mp_poll_obj_t);
             poll_obj->obj = obj[i];
             poll_obj->ioctl = stream_p->ioctl;
             poll_obj->flags = flags;
             poll_obj->flags_ret = 0;
-            elem->value = poll_obj;
+            elem->value = MP_OBJ_FROM_PTR(poll_obj);
         } else {
             // object exists; update its flags
             if (or_flags) {
-                ((poll_obj_t*)elem->value)->flags |= flags;
+                ((mp_poll_obj_t*)MP_OBJ_TO_PTR(elem->value))->flags |= flags;
             } else {
-                ((poll_obj_t*)elem->value)->flags = flags;
+                ((mp_poll_obj_t*)MP_OBJ_TO_PTR(elem->value))->flags = flags;
             }
         }
     }
 }
 
 // poll each object in the map
-STATIC mp_uint_t poll_map_poll(mp_map_t *poll_map, mp_uint_t *rwx_num) {
+mp_uint_t mp_poll_map_poll(mp_map_t *poll_map, mp_uint_t *rwx_num) {
     mp_uint_t n_ready = 0;
     for (mp_uint_t i = 0; i < poll_map->alloc; ++i) {
         if (!MP_MAP_SLOT_IS_FILLED(poll_map, i)) {
             continue;
         }
 
-        poll_obj_t *poll_obj = (poll_obj_t*)poll_map->table[i].value;
+        mp_poll_obj_t *poll_obj = MP_OBJ_TO_PTR(poll_map->table[i].value);
         int errcode;
         mp_int_t ret = poll_obj->ioctl(poll_obj->obj, MP_STREAM_POLL, poll_obj->flags, &errcode);
         poll_obj->flags_ret = ret;
@@ -111,6 +98,79 @@ STATIC mp_uint_t poll_map_poll(mp_map_t *poll_map, mp_uint_t *rwx_num) {
     return n_ready;
 }
 
+#if MICROPY_PY_USELECT_POSIX
+
+#include <poll.h>
+
+// Block in poll() until an object may be ready or timeout ms have passed.
+// Returns false, without waiting, if an object has no file descriptor.
+STATIC bool mp_poll_map_wait_fds(mp_map_t *poll_map, mp_int_t timeout) {
+    struct pollfd *fds = m_new(struct pollfd, poll_map->used);
+    size_t n = 0;
+    for (mp_uint_t i = 0; i < poll_map->alloc; ++i) {
+        if (!MP_MAP_SLOT_IS_FILLED(poll_map, i)) {
+            continue;
+        }
+        mp_poll_obj_t *poll_obj = MP_OBJ_TO_PTR(poll_map->table[i].value);
+        int errcode;
+        mp_uint_t fd = poll_obj->ioctl(poll_obj->obj, MP_STREAM_GET_FILENO, 0, &errcode);
+        if (fd == MP_STREAM_ERROR) {
+            m_del(struct pollfd, fds, poll_map->used);
+            return false;
+        }
+        // the MP_STREAM_POLL_xxx flags have the same values as POLLxxx
+        fds[n].fd = fd;
+        fds[n].events = poll_obj->flags;
+        fds[n].revents = 0;
+        n++;
+    }
+    MP_THREAD_GIL_EXIT();
+    poll(fds, n, timeout);
+    MP_THREAD_GIL_ENTER();
+    m_del(struct pollfd, fds, poll_map->used);
+    return true;
+}
+
+#endif
+
+mp_uint_t mp_poll_map_wait(mp_map_t *poll_map, mp_int_t timeout) {
+    mp_uint_t start_tick = mp_hal_ticks_ms();
+    for (;;) {
+        mp_uint_t n_ready = mp_poll_map_poll(poll_map, NULL);
+        mp_int_t left = timeout;
+        if (timeout > 0) {
+            left = timeout - (mp_int_t)(mp_hal_ticks_ms() - start_tick);
+            if (left < 0) {
+                left = 0;
+            }
+        }
+        if (n_ready > 0 || left == 0) {
+            return n_ready;
+        }
+        #if MICROPY_PY_USELECT_POSIX
+        if (mp_poll_map_wait_fds(poll_map, left)) {
+            mp_handle_pending();
+            continue;
+        }
+        #endif
+        #ifdef MICROPY_EVENT_POLL_HOOK
+        MICROPY_EVENT_POLL_HOOK
+        #else
+        mp_handle_pending();
+        mp_hal_delay_ms(1);
+        #endif
+    }
+}
+
+#if MICROPY_PY_USELECT
+
+// Flags for poll()
+#define FLAG_ONESHOT (1)
+
+/// \module select - Provides select function to wait for events on a stream
+///
+/// This module provides the select function.
+
 /// \function select(rlist, wlist, xlist[, timeout])
 STATIC mp_obj_t select_select(uint n_args, const mp_obj_t *args) {
     // get array data from tuple/list arguments
@@ -138,15 +198,15 @@ STATIC mp_obj_t select_select(uint n_args, const mp_obj_t *args) {
     // merge separate lists and get the ioctl function for each object
     mp_map_t poll_map;
     mp_map_init(&poll_map, rwx_len[0] + rwx_len[1] + rwx_len[2]);
-    poll_map_add(&poll_map, r_array, rwx_len[0], MP_STREAM_POLL_RD, true);
-    poll_map_add(&poll_map, w_array, rwx_len[1], MP_STREAM_POLL_WR, true);
-    poll_map_add(&poll_map, x_array, rwx_len[2], MP_STREAM_POLL_ERR | MP_STREAM_POLL_HUP, true);
+    mp_poll_map_add(&poll_map, r_array, rwx_len[0], MP_STREAM_POLL_RD, true);
+    mp_poll_map_add(&poll_map, w_array, rwx_len[1], MP_STREAM_POLL_WR, true);
+    mp_poll_map_add(&poll_map, x_array, rwx_len[2], MP_STREAM_POLL_ERR | MP_STREAM_POLL_HUP, true);
 
     mp_uint_t start_tick = mp_hal_ticks_ms();
     rwx_len[0] = rwx_len[1] = rwx_len[2] = 0;
     for (;;) {
         // poll the objects
-        mp_uint_t n_ready = poll_map_poll(&poll_map, rwx_len);
+        mp_uint_t n_ready = mp_poll_map_poll(&poll_map, rwx_len);
 
         if (n_ready > 0 || (timeout != -1 && mp_hal_ticks_ms() - start_tick >= timeout)) {
             // one or more objects are ready, or we had a timeout
@@ -159,7 +219,7 @@ STATIC mp_obj_t select_select(uint n_args, const mp_obj_t *args) {
                 if (!MP_MAP_SLOT_IS_FILLED(&poll_map, i)) {
                     continue;
                 }
-                poll_obj_t *poll_obj = (poll_obj_t*)poll_map.table[i].value;
+                mp_poll_obj_t *poll_obj = MP_OBJ_TO_PTR(poll_map.table[i].value);
                 if (poll_obj->flags_ret & MP_STREAM_POLL_RD) {
                     ((mp_obj_list_t*)list_array[0])->items[rwx_len[0]++] = poll_obj->obj;
                 }
@@ -199,7 +259,7 @@ STATIC mp_obj_t poll_register(uint n_args, const mp_obj_t *args) {
     } else {
         flags = MP_STREAM_POLL_RD | MP_STREAM_POLL_WR;
     }
-    poll_map_add(&self->poll_map, &args[1], 1, flags, false);
+    mp_poll_map_add(&self->poll_map, &args[1], 1, flags, false);
     return mp_const_none;
 }
 MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(poll_register_obj, 2, 3, poll_register);
@@ -220,7 +280,7 @@ STATIC mp_obj_t poll_modify(mp_obj_t self_in, mp_obj_t obj_in, mp_obj_t eventmas
     if (elem == NULL) {
         mp_raise_OSError(MP_ENOENT);
     }
-    ((poll_obj_t*)elem->value)->flags = mp_obj_get_int(eventmask_in);
+    ((mp_poll_obj_t*)MP_OBJ_TO_PTR(elem->value))->flags = mp_obj_get_int(eventmask_in);
     return mp_const_none;
 }
 MP_DEFINE_CONST_FUN_OBJ_3(poll_modify_obj, poll_modify);
@@ -249,7 +309,7 @@ STATIC mp_uint_t poll_poll_internal(uint n_args, const mp_obj_t *args) {
     mp_uint_t n_ready;
     for (;;) {
         // poll the objects
-        n_ready = poll_map_poll(&self->poll_map, NULL);
+        n_ready = mp_poll_map_poll(&self->poll_map, NULL);
         if (n_ready > 0 || (timeout != -1 && mp_hal_ticks_ms() - start_tick >= timeout)) {
             break;
         }
@@ -270,7 +330,7 @@ STATIC mp_obj_t poll_poll(uint n_args, const mp_obj_t *args) {
         if (!MP_MAP_SLOT_IS_FILLED(&self->poll_map, i)) {
             continue;
         }
-        poll_obj_t *poll_obj = (poll_obj_t*)self->poll_map.table[i].value;
+        mp_poll_obj_t *poll_obj = MP_OBJ_TO_PTR(self->poll_map.table[i].value);
         if (poll_obj->flags_ret != 0) {
             mp_obj_t tuple[2] = {poll_obj->obj, MP_OBJ_NEW_SMALL_INT(poll_obj->flags_ret)};
             ret_list->items[n_ready++] = mp_obj_new_tuple(2, tuple);
@@ -313,7 +373,7 @@ STATIC mp_obj_t poll_iternext(mp_obj_t self_in) {
         if (!MP_MAP_SLOT_IS_FILLED(&self->poll_map, i)) {
             continue;
         }
-        poll_obj_t *poll_obj = (poll_obj_t*)self->poll_map.table[i].value;
+        mp_poll_obj_t *poll_obj = MP_OBJ_TO_PTR(self->poll_map.table[i].value);
         if (poll_obj->flags_ret != 0) {
             mp_obj_tuple_t *t = MP_OBJ_TO_PTR(self->ret_tuple);
             t->items[0] = poll_obj->obj;
@@ -377,3 +437,5 @@ const mp_obj_module_t mp_module_uselect = {
 };
 
 #endif // MICROPY_PY_USELECT
+
+#endif // MICROPY_PY_USELECT || MICROPY_PY_UEVENT
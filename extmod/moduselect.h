@@ -0,0 +1,51 @@
+/*
+ * This file is part of the MicroPython project, http://micropython.org/
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2014 Damien P. George
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#ifndef MICROPY_INCLUDED_EXTMOD_MODUSELECT_H
+#define MICROPY_INCLUDED_EXTMOD_MODUSELECT_H
+
+#include "py/obj.h"
+
+// An object being polled, as stored in a poll map keyed by mp_obj_id(obj)
+typedef struct _mp_poll_obj_t {
+    mp_obj_t obj;
+    mp_uint_t (*ioctl)(mp_obj_t obj, mp_uint_t request, mp_uint_t arg, int *errcode);
+    mp_uint_t flags;
+    mp_uint_t flags_ret;
+} mp_poll_obj_t;
+
+// Add objects to the map, or update the flags of objects already in it
+void mp_poll_map_add(mp_map_t *poll_map, const mp_obj_t *obj, mp_uint_t obj_len, mp_uint_t flags, bool or_flags);
+
+// Poll each object once with the MP_STREAM_POLL ioctl, setting its flags_ret.
+// Returns the number of ready objects; rwx_num, if given, counts them by kind.
+mp_uint_t mp_poll_map_poll(mp_map_t *poll_map, mp_uint_t *rwx_num);
+
+// Poll the objects until one is ready or timeout ms have passed, or forever if
+// timeout is -1.  Ports that can block on the objects' file descriptors do so
+// rather than polling them repeatedly.  Returns the number of ready objects.
+mp_uint_t mp_poll_map_wait(mp_map_t *poll_map, mp_int_t timeout);
+
+#endif // MICROPY_INCLUDED_EXTMOD_MODUSELECT_H
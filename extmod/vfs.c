@@ -118,7 +118,7 @@ STATIC mp_obj_t mp_vfs_proxy_call(mp_vfs_mount_t *vfs, qstr meth_name, size_t n_
     return mp_call_method_n_kw(n_args, 0, meth);
 }
 
-mp_import_stat_t mp_vfs_import_stat(const char *path) {
+STATIC mp_import_stat_t vfs_import_stat(const char *path) {
     const char *path_out;
     mp_vfs_mount_t *vfs = mp_vfs_lookup_path(path, &path_out);
     if (vfs == MP_VFS_NONE || vfs == MP_VFS_ROOT) {
@@ -152,6 +152,146 @@ mp_import_stat_t mp_vfs_import_stat(const char *path) {
     }
 }
 
+#if MICROPY_VFS_IMPORT_STAT_CACHE
+
+// The cache holds the listings of the directories that imports last looked in,
+// most recent first.  A listing is the path of the directory, then the name of
+// each entry after 'd' for a directory, 'f' for a file or '?' if the type isn't
+// known, all nul-terminated, then an empty string.  A directory that doesn't
+// exist has a listing with no entries.
+
+void mp_vfs_import_stat_cache_clear(void) {
+    // this only drops pointers, so it can be called from an interrupt
+    for (size_t i = 0; i < MICROPY_VFS_IMPORT_STAT_CACHE; ++i) {
+        MP_STATE_VM(vfs_import_stat_cache)[i] = NULL;
+    }
+}
+
+// Return a new listing of the directory dir, or NULL if it can't be listed or
+// the listing would be too big to keep.
+STATIC char *vfs_import_stat_list(const char *dir, size_t dir_len) {
+    vstr_t vstr;
+    nlr_buf_t nlr;
+    if (nlr_push(&nlr) == 0) {
+        vstr_init(&vstr, dir_len + 32);
+        vstr_add_strn(&vstr, dir, dir_len);
+        vstr_add_byte(&vstr, '\0');
+        mp_obj_t dir_obj = mp_obj_new_str(dir, dir_len);
+        mp_obj_t iter = mp_vfs_ilistdir(dir_len == 0 ? 0 : 1, &dir_obj);
+        mp_obj_t next;
+        while ((next = mp_iternext(iter)) != MP_OBJ_STOP_ITERATION) {
+            size_t len;
+            mp_obj_t *items;
+            mp_obj_get_array(next, &len, &items);
+            const char *name = mp_obj_str_get_data(items[0], &len);
+            if (vstr.len + len + 3 > MICROPY_VFS_IMPORT_STAT_CACHE_MAX_LISTING) {
+                nlr_pop();
+                vstr_clear(&vstr);
+                return NULL;
+            }
+            mp_int_t type = mp_obj_get_int(items[1]);
+            vstr_add_byte(&vstr, type == MP_S_IFDIR ? 'd' : type == MP_S_IFREG ? 'f' : '?');
+            vstr_add_strn(&vstr, name, len);
+            vstr_add_byte(&vstr, '\0');
+        }
+        vstr_add_byte(&vstr, '\0');
+        nlr_pop();
+        return vstr.buf;
+    } else {
+        mp_obj_t exc = MP_OBJ_FROM_PTR(nlr.ret_val);
+        if (!mp_obj_is_subclass_fast(MP_OBJ_FROM_PTR(mp_obj_get_type(exc)), MP_OBJ_FROM_PTR(&mp_type_OSError))) {
+            return NULL;
+        }
+        mp_obj_t err = mp_obj_exception_get_value(exc);
+        if (err != MP_OBJ_NEW_SMALL_INT(MP_ENOENT) && err != MP_OBJ_NEW_SMALL_INT(MP_ENOTDIR)) {
+            return NULL;
+        }
+        // no such directory, so no entries
+        char *listing = m_new_maybe(char, dir_len + 2);
+        if (listing != NULL) {
+            memcpy(listing, dir, dir_len);
+            listing[dir_len] = '\0';
+            listing[dir_len + 1] = '\0';
+        }
+        return listing;
+    }
+}
+
+STATIC bool vfs_name_eq_nocase(const char *a, const char *b) {
+    for (; unichar_tolower((byte)*a) == unichar_tolower((byte)*b); ++a, ++b) {
+        if (*a == '\0') {
+            return true;
+        }
+    }
+    return false;
+}
+
+mp_import_stat_t mp_vfs_import_stat(const char *path) {
+    // split the path into the directory and the name in it
+    const char *name = strrchr(path, '/');
+    size_t dir_len = name == NULL ? 0 : name == path ? 1 : (size_t)(name - path);
+    name = name == NULL ? path : name + 1;
+    if (*name == '\0') {
+        return vfs_import_stat(path);
+    }
+
+    // find the listing of the directory, or make one, and move it to the front
+    char **cache = MP_STATE_VM(vfs_import_stat_cache);
+    char *listing = NULL;
+    size_t i = 0;
+    for (; i < MICROPY_VFS_IMPORT_STAT_CACHE; ++i) {
+        listing = cache[i];
+        if (listing == NULL || (strlen(listing) == dir_len && memcmp(listing, path, dir_len) == 0)) {
+            break;
+        }
+    }
+    if (i == MICROPY_VFS_IMPORT_STAT_CACHE || listing == NULL) {
+        listing = vfs_import_stat_list(path, dir_len);
+        if (listing == NULL) {
+            return vfs_import_stat(path);
+        }
+        i = MICROPY_VFS_IMPORT_STAT_CACHE - 1;
+    }
+    for (; i > 0; --i) {
+        cache[i] = cache[i - 1];
+    }
+    cache[0] = listing;
+
+    bool other_case = false;
+    for (const char *entry = listing + dir_len + 1; *entry != '\0'; entry += strlen(entry) + 1) {
+        if (strcmp(entry + 1, name) == 0) {
+            switch (entry[0]) {
+                case 'd': return MP_IMPORT_STAT_DIR;
+                case 'f': return MP_IMPORT_STAT_FILE;
+                default: return vfs_import_stat(path);
+            }
+        }
+        other_case |= vfs_name_eq_nocase(entry + 1, name);
+    }
+    if (other_case) {
+        // the filesystem may not be case-sensitive, so let it decide
+        return vfs_import_stat(path);
+    }
+    for (mp_vfs_mount_t *vfs = MP_STATE_VM(vfs_mount_table); vfs != NULL; vfs = vfs->next) {
+        if (strcmp(vfs->str, path) == 0) {
+            // mount points aren't in the listing of the directory they're in
+            return MP_IMPORT_STAT_DIR;
+        }
+    }
+    return MP_IMPORT_STAT_NO_EXIST;
+}
+
+#else
+
+void mp_vfs_import_stat_cache_clear(void) {
+}
+
+mp_import_stat_t mp_vfs_import_stat(const char *path) {
+    return vfs_import_stat(path);
+}
+
+#endif
+
 mp_obj_t mp_vfs_mount(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
     enum { ARG_readonly, ARG_mkfs };
     static const mp_arg_t allowed_args[] = {
@@ -213,6 +353,7 @@ mp_obj_t mp_vfs_mount(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args
         vfsp = &(*vfsp)->next;
     }
     *vfsp = vfs;
+    mp_vfs_import_stat_cache_clear();
 
     return mp_const_none;
 }
@@ -243,6 +384,8 @@ mp_obj_t mp_vfs_umount(mp_obj_t mnt_in) {
         MP_STATE_VM(vfs_cur) = MP_VFS_ROOT;
     }
 
+    mp_vfs_import_stat_cache_clear();
+
     // call the underlying object to do any unmounting operation
     mp_vfs_proxy_call(vfs, MP_QSTR_umount, 0, NULL);
 
@@ -265,6 +408,10 @@ mp_obj_t mp_vfs_open(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args)
     mp_arg_parse_all(n_args, pos_args, kw_args, MP_ARRAY_SIZE(allowed_args), allowed_args, args);
 
     mp_vfs_mount_t *vfs = lookup_path(args[ARG_file].u_obj, &args[ARG_file].u_obj);
+    if (strpbrk(mp_obj_str_get_str(args[ARG_mode].u_obj), "wax+") != NULL) {
+        // the file may be created
+        mp_vfs_import_stat_cache_clear();
+    }
     return mp_vfs_proxy_call(vfs, MP_QSTR_open, 2, (mp_obj_t*)&args);
 }
 MP_DEFINE_CONST_FUN_OBJ_KW(mp_vfs_open_obj, 0, mp_vfs_open);
@@ -272,6 +419,8 @@ MP_DEFINE_CONST_FUN_OBJ_KW(mp_vfs_open_obj, 0, mp_vfs_open);
 mp_obj_t mp_vfs_chdir(mp_obj_t path_in) {
     mp_obj_t path_out;
     mp_vfs_mount_t *vfs = lookup_path(path_in, &path_out);
+    // the cache has listings of relative paths
+    mp_vfs_import_stat_cache_clear();
     MP_STATE_VM(vfs_cur) = vfs;
     if (vfs == MP_VFS_ROOT) {
         // If we change to the root dir and a VFS is mounted at the root then
@@ -385,6 +534,7 @@ mp_obj_t mp_vfs_mkdir(mp_obj_t path_in) {
     if (vfs == MP_VFS_ROOT || (vfs != MP_VFS_NONE && !strcmp(mp_obj_str_get_str(path_out), "/"))) {
         mp_raise_OSError(MP_EEXIST);
     }
+    mp_vfs_import_stat_cache_clear();
     return mp_vfs_proxy_call(vfs, MP_QSTR_mkdir, 1, &path_out);
 }
 MP_DEFINE_CONST_FUN_OBJ_1(mp_vfs_mkdir_obj, mp_vfs_mkdir);
@@ -392,6 +542,7 @@ MP_DEFINE_CONST_FUN_OBJ_1(mp_vfs_mkdir_obj, mp_vfs_mkdir);
 mp_obj_t mp_vfs_remove(mp_obj_t path_in) {
     mp_obj_t path_out;
     mp_vfs_mount_t *vfs = lookup_path(path_in, &path_out);
+    mp_vfs_import_stat_cache_clear();
     return mp_vfs_proxy_call(vfs, MP_QSTR_remove, 1, &path_out);
 }
 MP_DEFINE_CONST_FUN_OBJ_1(mp_vfs_remove_obj, mp_vfs_remove);
@@ -404,6 +555,7 @@ mp_obj_t mp_vfs_rename(mp_obj_t old_path_in, mp_obj_t new_path_in) {
         // can't rename across filesystems
         mp_raise_OSError(MP_EPERM);
     }
+    mp_vfs_import_stat_cache_clear();
     return mp_vfs_proxy_call(old_vfs, MP_QSTR_rename, 2, args);
 }
 MP_DEFINE_CONST_FUN_OBJ_2(mp_vfs_rename_obj, mp_vfs_rename);
@@ -411,6 +563,7 @@ MP_DEFINE_CONST_FUN_OBJ_2(mp_vfs_rename_obj, mp_vfs_rename);
 mp_obj_t mp_vfs_rmdir(mp_obj_t path_in) {
     mp_obj_t path_out;
     mp_vfs_mount_t *vfs = lookup_path(path_in, &path_out);
+    mp_vfs_import_stat_cache_clear();
     return mp_vfs_proxy_call(vfs, MP_QSTR_rmdir, 1, &path_out);
 }
 MP_DEFINE_CONST_FUN_OBJ_1(mp_vfs_rmdir_obj, mp_vfs_rmdir);
@@ -2,6 +2,7 @@
 #include <string.h>
 
 #include "py/obj.h"
+#include "py/mphal.h"
 #include "py/objstr.h"
 #include "py/runtime.h"
 #include "py/gc.h"
@@ -381,7 +382,7 @@ STATIC mp_obj_t extra_coverage(void) {
         fun_bc.bytecode = (const byte*)"\x01"; // just needed for n_state
         mp_code_state_t *code_state = m_new_obj_var(mp_code_state_t, mp_obj_t, 1);
         code_state->fun_bc = &fun_bc;
-        code_state->ip = (const byte*)"\x00"; // just needed for an invalid opcode
+        code_state->ip = (const byte*)"\x15"; // just needed for an invalid opcode
         code_state->sp = &code_state->state[0];
         code_state->exc_sp = NULL;
         code_state->old_globals = NULL;
@@ -416,6 +417,57 @@ STATIC mp_obj_t extra_coverage(void) {
         while (mp_sched_num_pending()) {
             mp_handle_pending();
         }
+
+        // duplicates are coalesced, higher priorities run first
+        mp_sched_lock();
+        mp_sched_schedule(MP_OBJ_FROM_PTR(&mp_builtin_print_obj), MP_OBJ_NEW_SMALL_INT(5));
+        mp_sched_schedule(MP_OBJ_FROM_PTR(&mp_builtin_print_obj), MP_OBJ_NEW_SMALL_INT(6));
+        mp_sched_schedule(MP_OBJ_FROM_PTR(&mp_builtin_print_obj), MP_OBJ_NEW_SMALL_INT(5));
+        mp_sched_schedule_priority(MP_OBJ_FROM_PTR(&mp_builtin_print_obj), MP_OBJ_NEW_SMALL_INT(7), 1);
+        mp_sched_schedule_priority(MP_OBJ_FROM_PTR(&mp_builtin_print_obj), MP_OBJ_NEW_SMALL_INT(6), 2);
+        mp_printf(&mp_plat_print, "pending=%d\n", mp_sched_num_pending());
+        mp_sched_unlock();
+        while (mp_sched_num_pending()) {
+            mp_handle_pending();
+        }
+
+        // change the depth of the queue
+        mp_printf(&mp_plat_print, "depth=%d\n", mp_sched_set_depth(6));
+        mp_sched_lock();
+        for (int i = 0; i < 7; ++i) {
+            mp_printf(&mp_plat_print, "sched(%d)=%d\n", i, mp_sched_schedule(MP_OBJ_FROM_PTR(&mp_builtin_print_obj), MP_OBJ_NEW_SMALL_INT(i)));
+        }
+        mp_printf(&mp_plat_print, "depth=%d\n", mp_sched_set_depth(0));
+        mp_sched_unlock();
+        while (mp_sched_num_pending()) {
+            mp_handle_pending();
+        }
+        mp_printf(&mp_plat_print, "depth=%d\n", mp_sched_set_depth(0));
+
+        // the depth is capped
+        mp_sched_set_depth(1000);
+        mp_printf(&mp_plat_print, "max_depth=%d\n", MP_STATE_VM(sched_depth) == MICROPY_SCHEDULER_MAX_DEPTH);
+        mp_sched_set_depth(0);
+
+        #if MICROPY_SCHEDULER_LATENCY
+        // each callback counts once in the latency histogram, and one that
+        // waits for 2ms goes in the bucket of waits of 11 bits or more
+        memset(MP_STATE_VM(sched_latency), 0, sizeof(MP_STATE_VM(sched_latency)));
+        mp_sched_schedule(MP_OBJ_FROM_PTR(&mp_builtin_len_obj), mp_const_empty_tuple);
+        mp_sched_schedule(MP_OBJ_FROM_PTR(&mp_builtin_len_obj), mp_const_empty_bytes);
+        mp_handle_pending();
+        mp_sched_schedule(MP_OBJ_FROM_PTR(&mp_builtin_abs_obj), MP_OBJ_NEW_SMALL_INT(1));
+        mp_hal_delay_ms(2);
+        mp_handle_pending();
+        mp_uint_t n_total = 0, n_slow = 0;
+        for (size_t i = 0; i < MICROPY_SCHEDULER_LATENCY_BUCKETS; ++i) {
+            n_total += MP_STATE_VM(sched_latency)[i];
+            if (i >= 11) {
+                n_slow += MP_STATE_VM(sched_latency)[i];
+            }
+        }
+        mp_printf(&mp_plat_print, "latency=%u slow=%u\n", (uint)n_total, (uint)n_slow);
+        #endif
     }
 
     mp_obj_streamtest_t *s = m_new_obj(mp_obj_streamtest_t);
@@ -37,6 +37,7 @@
 #include <arpa/inet.h>
 #include <netdb.h>
 #include <errno.h>
+#include <poll.h>
 
 #include "py/objtuple.h"
 #include "py/objstr.h"
@@ -112,8 +113,21 @@ STATIC mp_uint_t socket_write(mp_obj_t o_in, const void *buf, mp_uint_t size, in
 
 STATIC mp_uint_t socket_ioctl(mp_obj_t o_in, mp_uint_t request, uintptr_t arg, int *errcode) {
     mp_obj_socket_t *self = MP_OBJ_TO_PTR(o_in);
-    (void)arg;
     switch (request) {
+        case MP_STREAM_POLL: {
+            // the MP_STREAM_POLL_xxx flags have the same values as POLLxxx
+            struct pollfd pfd = { .fd = self->fd, .events = arg };
+            int r = poll(&pfd, 1, 0);
+            if (r == -1) {
+                *errcode = errno;
+                return MP_STREAM_ERROR;
+            }
+            return r == 0 ? 0 : (pfd.revents & (arg | MP_STREAM_POLL_ERR | MP_STREAM_POLL_HUP));
+        }
+
+        case MP_STREAM_GET_FILENO:
+            return self->fd;
+
         case MP_STREAM_CLOSE:
             // There's a POSIX drama regarding return value of close in general,
             // and EINTR error in particular. See e.g.
@@ -33,8 +33,12 @@
 #include <mpconfigport.h>
 
 #define MICROPY_FLOAT_HIGH_QUALITY_HASH (1)
+#define MICROPY_EMIT_NATIVE_JIT        (MICROPY_EMIT_X64)
 #define MICROPY_ENABLE_SCHEDULER       (1)
+#define MICROPY_SCHEDULER_LATENCY      (1)
 #define MICROPY_READER_VFS             (1)
+#define MICROPY_PERSISTENT_CODE_CACHE  (1)
+#define MICROPY_VFS_IMPORT_STAT_CACHE  (4)
 #define MICROPY_PY_DELATTR_SETATTR     (1)
 #define MICROPY_PY_REVERSE_SPECIAL_METHODS (1)
 #define MICROPY_PY_BUILTINS_RANGE_BINOP (1)
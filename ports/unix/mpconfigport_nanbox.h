@@ -35,9 +35,17 @@
 
 #include <stdint.h>
 
+#if UINTPTR_MAX == UINT64_MAX
+// on a 64-bit host objects and pointers are the same size, and x86-64 and
+// aarch64 user-space pointers fit in the 48 bits an object pointer has
+typedef long mp_int_t;
+typedef unsigned long mp_uint_t;
+#else
+// on a 32-bit host machine ints are widened to the size of an object
 typedef int64_t mp_int_t;
 typedef uint64_t mp_uint_t;
 #define UINT_FMT "%llu"
 #define INT_FMT "%lld"
+#endif
 
 #include <mpconfigport.h>
@@ -42,6 +42,10 @@ typedef struct _thread_t {
     pthread_t id;           // system id of thread
     int ready;              // whether the thread is ready and running
     void *arg;              // thread Python args, a GC root pointer
+    #if MICROPY_PY_THREAD_GC_STOP_WORLD
+    void *stack_cur;        // bottom of the stack to scan while it's stopped
+    mp_state_thread_t *state; // Python state of the thread while it's stopped
+    #endif
     struct _thread_t *next;
 } thread_t;
 
@@ -55,6 +59,54 @@ STATIC thread_t *thread;
 // it's needed because we can't use any pthread calls in a signal handler
 STATIC volatile int thread_signal_done;
 
+#if MICROPY_PY_THREAD_GC_STOP_WORLD
+
+// the bottom of the stack and the state of the thread that was just stopped
+STATIC void *volatile thread_signal_stack_cur;
+STATIC mp_state_thread_t *volatile thread_signal_state;
+
+// incremented each time stopped threads are resumed
+STATIC volatile unsigned int thread_resume_count;
+
+// whether mp_thread_gc_stop_others has stopped the other threads
+STATIC bool thread_others_stopped;
+
+// this signal handler parks a thread for the duration of a garbage collection
+// the kernel saves the registers of the thread in the context, on the stack
+// below everything else the thread was using, so the collector scans from
+// there to the top of the stack
+STATIC void mp_thread_gc(int signo, siginfo_t *info, void *context) {
+    (void)info; // unused
+    if (signo == SIGUSR1) {
+        unsigned int resume_count = thread_resume_count;
+        thread_signal_stack_cur = context;
+        thread_signal_state = mp_thread_get_state();
+        #if MICROPY_GC_TLAB
+        if (thread_signal_state->gc_tlab_busy) {
+            // it's halfway through taking blocks from its allocation buffer,
+            // ask the collector to try again
+            thread_signal_done = 2;
+            return;
+        }
+        #endif
+        thread_signal_done = 1;
+        // wait for SIGUSR2, which is blocked while this handler runs so it
+        // can't be missed between checking the count and suspending
+        sigset_t mask;
+        pthread_sigmask(SIG_BLOCK, NULL, &mask);
+        sigdelset(&mask, SIGUSR2);
+        while (thread_resume_count == resume_count) {
+            sigsuspend(&mask);
+        }
+    }
+}
+
+STATIC void mp_thread_gc_resume(int signo) {
+    (void)signo; // unused
+}
+
+#else
+
 // this signal handler is used to scan the regs and stack of a thread
 STATIC void mp_thread_gc(int signo, siginfo_t *info, void *context) {
     (void)info; // unused
@@ -74,6 +126,8 @@ STATIC void mp_thread_gc(int signo, siginfo_t *info, void *context) {
     }
 }
 
+#endif
+
 void mp_thread_init(void) {
     pthread_key_create(&tls_key, NULL);
     pthread_setspecific(tls_key, &mp_state_ctx.thread);
@@ -90,9 +144,82 @@ void mp_thread_init(void) {
     sa.sa_flags = SA_SIGINFO;
     sa.sa_sigaction = mp_thread_gc;
     sigemptyset(&sa.sa_mask);
+    #if MICROPY_PY_THREAD_GC_STOP_WORLD
+    sa.sa_flags |= SA_RESTART;
+    sigaddset(&sa.sa_mask, SIGUSR2);
+    #endif
     sigaction(SIGUSR1, &sa, NULL);
+
+    #if MICROPY_PY_THREAD_GC_STOP_WORLD
+    // enable signal handler to resume threads stopped for garbage collection
+    sa.sa_flags = SA_RESTART;
+    sa.sa_handler = mp_thread_gc_resume;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGUSR2, &sa, NULL);
+    #endif
+}
+
+#if MICROPY_PY_THREAD_GC_STOP_WORLD
+
+// Stop all other threads so that none of them can change the heap or root
+// pointers while a garbage collection is marking.  The thread list stays
+// locked until mp_thread_gc_resume_others, so no thread can start or finish
+// in the meantime.  This is called with the GC mutex held.
+void mp_thread_gc_stop_others(void) {
+    pthread_mutex_lock(&thread_mutex);
+    for (thread_t *th = thread; th != NULL; th = th->next) {
+        if (th->id == pthread_self() || !th->ready) {
+            continue;
+        }
+        do {
+            thread_signal_done = 0;
+            pthread_kill(th->id, SIGUSR1);
+            while (thread_signal_done == 0) {
+                sched_yield();
+            }
+        } while (thread_signal_done == 2);
+        th->stack_cur = thread_signal_stack_cur;
+        th->state = thread_signal_state;
+    }
+    thread_others_stopped = true;
+}
+
+void mp_thread_gc_resume_others(void) {
+    if (!thread_others_stopped) {
+        return;
+    }
+    thread_others_stopped = false;
+    thread_resume_count++;
+    for (thread_t *th = thread; th != NULL; th = th->next) {
+        if (th->id == pthread_self() || !th->ready) {
+            continue;
+        }
+        pthread_kill(th->id, SIGUSR2);
+    }
+    pthread_mutex_unlock(&thread_mutex);
 }
 
+// This function scans all pointers that are external to the current thread:
+// the arguments of every thread and the registers, stack and Python stack of
+// each thread stopped by mp_thread_gc_stop_others.
+void mp_thread_gc_others(void) {
+    for (thread_t *th = thread; th != NULL; th = th->next) {
+        gc_collect_root(&th->arg, 1);
+        if (th->id == pthread_self() || !th->ready) {
+            continue;
+        }
+        mp_state_thread_t *state = th->state;
+        void **ptrs = (void**)th->stack_cur;
+        gc_collect_root(ptrs, ((uintptr_t)state->stack_top - (uintptr_t)ptrs) / sizeof(uintptr_t));
+        #if MICROPY_ENABLE_PYSTACK
+        ptrs = (void**)(void*)state->pystack_start;
+        gc_collect_root(ptrs, (state->pystack_cur - state->pystack_start) / sizeof(void*));
+        #endif
+    }
+}
+
+#else
+
 // This function scans all pointers that are external to the current thread.
 // It does this by signalling all other threads and getting them to scan their
 // own registers and stack.  Note that there may still be some edge cases left
@@ -118,6 +245,8 @@ void mp_thread_gc_others(void) {
     pthread_mutex_unlock(&thread_mutex);
 }
 
+#endif
+
 mp_state_thread_t *mp_thread_get_state(void) {
     return (mp_state_thread_t*)pthread_getspecific(tls_key);
 }
@@ -310,6 +310,27 @@ void asm_thumb_mov_reg_local_addr(asm_thumb_t *as, uint rlo_dest, int local_num)
     asm_thumb_op16(as, OP_ADD_REG_SP_OFFSET(rlo_dest, word_offset));
 }
 
+#define OP_LDR_W_HI(reg_base) (0xf8d0 | (reg_base))
+#define OP_LDR_W_LO(reg_dest, imm12) ((reg_dest) << 12 | (imm12))
+#define OP_STR_W_HI(reg_base) (0xf8c0 | (reg_base))
+#define OP_STR_W_LO(reg_src, imm12) ((reg_src) << 12 | (imm12))
+
+void asm_thumb_ldr_reg_reg_i12_optimised(asm_thumb_t *as, uint reg_dest, uint reg_base, uint word_offset) {
+    if (reg_dest < ASM_THUMB_REG_R8 && reg_base < ASM_THUMB_REG_R8 && word_offset < 32) {
+        asm_thumb_ldr_rlo_rlo_i5(as, reg_dest, reg_base, word_offset);
+    } else {
+        asm_thumb_op32(as, OP_LDR_W_HI(reg_base), OP_LDR_W_LO(reg_dest, word_offset * 4));
+    }
+}
+
+void asm_thumb_str_reg_reg_i12_optimised(asm_thumb_t *as, uint reg_src, uint reg_base, uint word_offset) {
+    if (reg_src < ASM_THUMB_REG_R8 && reg_base < ASM_THUMB_REG_R8 && word_offset < 32) {
+        asm_thumb_str_rlo_rlo_i5(as, reg_src, reg_base, word_offset);
+    } else {
+        asm_thumb_op32(as, OP_STR_W_HI(reg_base), OP_STR_W_LO(reg_src, word_offset * 4));
+    }
+}
+
 // this could be wrong, because it should have a range of +/- 16MiB...
 #define OP_BW_HI(byte_offset) (0xf000 | (((byte_offset) >> 12) & 0x07ff))
 #define OP_BW_LO(byte_offset) (0xb800 | (((byte_offset) >> 1) & 0x07ff))
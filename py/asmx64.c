@@ -190,7 +190,8 @@ STATIC void asm_x64_write_r64_disp(asm_x64_t *as, int r64, int disp_r64, int dis
         return;
     }
 
-    if (disp_offset == 0 && disp_r64 != ASM_X64_REG_RBP) {
+    // rbp and r13 share a low encoding, and mod=00 with that rm means rip-relative
+    if (disp_offset == 0 && (disp_r64 & 7) != ASM_X64_REG_RBP) {
         asm_x64_write_byte_1(as, MODRM_R64(r64) | MODRM_RM_DISP0 | MODRM_RM_R64(disp_r64));
     } else if (SIGNED_FIT8(disp_offset)) {
         asm_x64_write_byte_2(as, MODRM_R64(r64) | MODRM_RM_DISP8 | MODRM_RM_R64(disp_r64), IMM32_L0(disp_offset));
@@ -281,31 +282,28 @@ void asm_x64_mov_r64_to_mem64(asm_x64_t *as, int src_r64, int dest_r64, int dest
 }
 
 void asm_x64_mov_mem8_to_r64zx(asm_x64_t *as, int src_r64, int src_disp, int dest_r64) {
-    assert(src_r64 < 8);
-    if (dest_r64 < 8) {
+    if (src_r64 < 8 && dest_r64 < 8) {
         asm_x64_write_byte_2(as, 0x0f, OPCODE_MOVZX_RM8_TO_R64);
     } else {
-        asm_x64_write_byte_3(as, REX_PREFIX | REX_R, 0x0f, OPCODE_MOVZX_RM8_TO_R64);
+        asm_x64_write_byte_3(as, REX_PREFIX | REX_R_FROM_R64(dest_r64) | REX_B_FROM_R64(src_r64), 0x0f, OPCODE_MOVZX_RM8_TO_R64);
     }
     asm_x64_write_r64_disp(as, dest_r64, src_r64, src_disp);
 }
 
 void asm_x64_mov_mem16_to_r64zx(asm_x64_t *as, int src_r64, int src_disp, int dest_r64) {
-    assert(src_r64 < 8);
-    if (dest_r64 < 8) {
+    if (src_r64 < 8 && dest_r64 < 8) {
         asm_x64_write_byte_2(as, 0x0f, OPCODE_MOVZX_RM16_TO_R64);
     } else {
-        asm_x64_write_byte_3(as, REX_PREFIX | REX_R, 0x0f, OPCODE_MOVZX_RM16_TO_R64);
+        asm_x64_write_byte_3(as, REX_PREFIX | REX_R_FROM_R64(dest_r64) | REX_B_FROM_R64(src_r64), 0x0f, OPCODE_MOVZX_RM16_TO_R64);
     }
     asm_x64_write_r64_disp(as, dest_r64, src_r64, src_disp);
 }
 
 void asm_x64_mov_mem32_to_r64zx(asm_x64_t *as, int src_r64, int src_disp, int dest_r64) {
-    assert(src_r64 < 8);
-    if (dest_r64 < 8) {
+    if (src_r64 < 8 && dest_r64 < 8) {
         asm_x64_write_byte_1(as, OPCODE_MOV_RM64_TO_R64);
     } else {
-        asm_x64_write_byte_2(as, REX_PREFIX | REX_R, OPCODE_MOV_RM64_TO_R64);
+        asm_x64_write_byte_2(as, REX_PREFIX | REX_R_FROM_R64(dest_r64) | REX_B_FROM_R64(src_r64), OPCODE_MOV_RM64_TO_R64);
     }
     asm_x64_write_r64_disp(as, dest_r64, src_r64, src_disp);
 }
@@ -481,6 +479,55 @@ STATIC mp_uint_t get_label_dest(asm_x64_t *as, mp_uint_t label) {
     return as->base.label_offsets[label];
 }
 
+// SSE instructions are: [prefix] [REX] 0x0f opcode modrm
+STATIC void asm_x64_sse_generic(asm_x64_t *as, int prefix, int rex_w, int op, int reg, int rm) {
+    asm_x64_write_byte_1(as, prefix);
+    if (rex_w || reg >= 8 || rm >= 8) {
+        asm_x64_write_byte_1(as, REX_PREFIX | rex_w | REX_R_FROM_R64(reg) | REX_B_FROM_R64(rm));
+    }
+    asm_x64_write_byte_3(as, 0x0f, op, MODRM_R64(reg) | MODRM_RM_REG | MODRM_RM_R64(rm));
+}
+
+void asm_x64_movq_r64_to_xmm(asm_x64_t *as, int src_r64, int dest_xmm) {
+    // movq xmm, r/m64 -- 0x66 REX.W 0x0f 0x6e /r
+    asm_x64_sse_generic(as, OP_SIZE_PREFIX, REX_W, 0x6e, dest_xmm, src_r64);
+}
+
+void asm_x64_movq_xmm_to_r64(asm_x64_t *as, int src_xmm, int dest_r64) {
+    // movq r/m64, xmm -- 0x66 REX.W 0x0f 0x7e /r
+    asm_x64_sse_generic(as, OP_SIZE_PREFIX, REX_W, 0x7e, src_xmm, dest_r64);
+}
+
+void asm_x64_movd_r32_to_xmm(asm_x64_t *as, int src_r32, int dest_xmm) {
+    // movd xmm, r/m32 -- 0x66 0x0f 0x6e /r
+    asm_x64_sse_generic(as, OP_SIZE_PREFIX, 0, 0x6e, dest_xmm, src_r32);
+}
+
+void asm_x64_movd_xmm_to_r32(asm_x64_t *as, int src_xmm, int dest_r32) {
+    // movd r/m32, xmm -- 0x66 0x0f 0x7e /r, zero extends into the 64-bit reg
+    asm_x64_sse_generic(as, OP_SIZE_PREFIX, 0, 0x7e, src_xmm, dest_r32);
+}
+
+void asm_x64_sse_op_xmm_xmm(asm_x64_t *as, int op, int dest_xmm, int src_xmm) {
+    asm_x64_sse_generic(as, op >> 8, 0, op & 0xff, dest_xmm, src_xmm);
+}
+
+void asm_x64_cmpsd_xmm_xmm(asm_x64_t *as, int pred, int dest_xmm, int src_xmm) {
+    // cmpsd xmm, xmm/m64, imm8 -- 0xf2 0x0f 0xc2 /r ib
+    asm_x64_sse_generic(as, 0xf2, 0, 0xc2, dest_xmm, src_xmm);
+    asm_x64_write_byte_1(as, pred);
+}
+
+void asm_x64_cvtsi2sd_r64_to_xmm(asm_x64_t *as, int src_r64, int dest_xmm) {
+    // cvtsi2sd xmm, r/m64 -- 0xf2 REX.W 0x0f 0x2a /r
+    asm_x64_sse_generic(as, 0xf2, REX_W, 0x2a, dest_xmm, src_r64);
+}
+
+void asm_x64_cvttsd2si_xmm_to_r64(asm_x64_t *as, int src_xmm, int dest_r64) {
+    // cvttsd2si r64, xmm/m64 -- 0xf2 REX.W 0x0f 0x2c /r
+    asm_x64_sse_generic(as, 0xf2, REX_W, 0x2c, dest_r64, src_xmm);
+}
+
 void asm_x64_jmp_label(asm_x64_t *as, mp_uint_t label) {
     mp_uint_t dest = get_label_dest(as, label);
     mp_int_t rel = dest - as->base.code_offset;
@@ -59,6 +59,23 @@
 #define ASM_X64_REG_R14 (14)
 #define ASM_X64_REG_R15 (15)
 
+#define ASM_X64_REG_XMM0 (0)
+#define ASM_X64_REG_XMM1 (1)
+
+// scalar SSE2 operations, encoded as (mandatory prefix << 8) | opcode
+#define ASM_X64_SSE_ADDSD    (0xf258)
+#define ASM_X64_SSE_MULSD    (0xf259)
+#define ASM_X64_SSE_SUBSD    (0xf25c)
+#define ASM_X64_SSE_DIVSD    (0xf25e)
+#define ASM_X64_SSE_CVTSD2SS (0xf25a)
+#define ASM_X64_SSE_CVTSS2SD (0xf35a)
+
+// predicates for cmpsd
+#define ASM_X64_CMPSD_EQ  (0)
+#define ASM_X64_CMPSD_LT  (1)
+#define ASM_X64_CMPSD_LE  (2)
+#define ASM_X64_CMPSD_NEQ (4)
+
 // condition codes, used for jcc and setcc (despite their j-name!)
 #define ASM_X64_CC_JB  (0x2) // below, unsigned
 #define ASM_X64_CC_JZ  (0x4)
@@ -105,6 +122,14 @@ void asm_x64_mul_r64_r64(asm_x64_t* as, int dest_r64, int src_r64);
 void asm_x64_cmp_r64_with_r64(asm_x64_t* as, int src_r64_a, int src_r64_b);
 void asm_x64_test_r8_with_r8(asm_x64_t* as, int src_r64_a, int src_r64_b);
 void asm_x64_setcc_r8(asm_x64_t* as, int jcc_type, int dest_r8);
+void asm_x64_movq_r64_to_xmm(asm_x64_t *as, int src_r64, int dest_xmm);
+void asm_x64_movq_xmm_to_r64(asm_x64_t *as, int src_xmm, int dest_r64);
+void asm_x64_movd_r32_to_xmm(asm_x64_t *as, int src_r32, int dest_xmm);
+void asm_x64_movd_xmm_to_r32(asm_x64_t *as, int src_xmm, int dest_r32);
+void asm_x64_sse_op_xmm_xmm(asm_x64_t *as, int op, int dest_xmm, int src_xmm);
+void asm_x64_cmpsd_xmm_xmm(asm_x64_t *as, int pred, int dest_xmm, int src_xmm);
+void asm_x64_cvtsi2sd_r64_to_xmm(asm_x64_t *as, int src_r64, int dest_xmm);
+void asm_x64_cvttsd2si_xmm_to_r64(asm_x64_t *as, int src_xmm, int dest_r64);
 void asm_x64_jmp_label(asm_x64_t* as, mp_uint_t label);
 void asm_x64_jcc_label(asm_x64_t* as, int jcc_type, mp_uint_t label);
 void asm_x64_entry(asm_x64_t* as, int num_locals);
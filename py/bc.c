@@ -72,21 +72,22 @@ const byte *mp_decode_uint_skip(const byte *ptr) {
     return ptr;
 }
 
-STATIC NORETURN void fun_pos_args_mismatch(mp_obj_fun_bc_t *f, size_t expected, size_t given) {
+// code_info is in the prelude, so this names native functions too
+STATIC NORETURN void fun_pos_args_mismatch(const byte *code_info, size_t expected, size_t given) {
 #if MICROPY_ERROR_REPORTING == MICROPY_ERROR_REPORTING_TERSE
     // generic message, used also for other argument issues
-    (void)f;
+    (void)code_info;
     (void)expected;
     (void)given;
     mp_arg_error_terse_mismatch();
 #elif MICROPY_ERROR_REPORTING == MICROPY_ERROR_REPORTING_NORMAL
-    (void)f;
+    (void)code_info;
     mp_raise_TypeError_varg(
         translate("function takes %d positional arguments but %d were given"), expected, given);
 #elif MICROPY_ERROR_REPORTING == MICROPY_ERROR_REPORTING_DETAILED
     mp_raise_TypeError_varg(
         translate("%q() takes %d positional arguments but %d were given"),
-        mp_obj_fun_get_name(MP_OBJ_FROM_PTR(f)), expected, given);
+        mp_obj_code_get_name(code_info), expected, given);
 #endif
 }
 
@@ -145,7 +146,7 @@ void mp_setup_code_state(mp_code_state_t *code_state, size_t n_args, size_t n_kw
     if (n_args > n_pos_args) {
         // given more than enough arguments
         if ((scope_flags & MP_SCOPE_FLAG_VARARGS) == 0) {
-            fun_pos_args_mismatch(self, n_pos_args, n_args);
+            fun_pos_args_mismatch(code_state->ip, n_pos_args, n_args);
         }
         // put extra arguments in varargs tuple
         *var_pos_kw_args-- = mp_obj_new_tuple(n_args - n_pos_args, args + n_pos_args);
@@ -164,7 +165,7 @@ void mp_setup_code_state(mp_code_state_t *code_state, size_t n_args, size_t n_kw
                     code_state->state[n_state - 1 - i] = self->extra_args[i - (n_pos_args - n_def_pos_args)];
                 }
             } else {
-                fun_pos_args_mismatch(self, n_pos_args - n_def_pos_args, n_args);
+                fun_pos_args_mismatch(code_state->ip, n_pos_args - n_def_pos_args, n_args);
             }
         }
     }
@@ -314,18 +315,18 @@ continue2:;
 #define V (MP_OPCODE_VAR_UINT) // single byte plus variable encoded unsigned int
 #define O (MP_OPCODE_OFFSET) // single byte plus 2-byte bytecode offset
 STATIC const byte opcode_format_table[64] = {
-    OC4(U, U, U, U), // 0x00-0x03
-    OC4(U, U, U, U), // 0x04-0x07
-    OC4(U, U, U, U), // 0x08-0x0b
-    OC4(U, U, U, U), // 0x0c-0x0f
-    OC4(B, B, B, U), // 0x10-0x13
+    OC4(Q, Q, Q, Q), // 0x00-0x03
+    OC4(Q, Q, Q, Q), // 0x04-0x07
+    OC4(Q, Q, Q, Q), // 0x08-0x0b
+    OC4(Q, Q, Q, Q), // 0x0c-0x0f
+    OC4(B, B, B, V), // 0x10-0x13
     OC4(V, U, Q, V), // 0x14-0x17
     OC4(B, V, V, Q), // 0x18-0x1b
     OC4(Q, Q, Q, Q), // 0x1c-0x1f
     OC4(B, B, V, V), // 0x20-0x23
     OC4(Q, Q, Q, B), // 0x24-0x27
     OC4(V, V, Q, Q), // 0x28-0x2b
-    OC4(U, U, U, U), // 0x2c-0x2f
+    OC4(O, O, U, U), // 0x2c-0x2f
     OC4(B, B, B, B), // 0x30-0x33
     OC4(B, O, O, O), // 0x34-0x37
     OC4(O, O, U, U), // 0x38-0x3b
@@ -395,20 +396,29 @@ STATIC const byte opcode_format_table[64] = {
 uint mp_opcode_format(const byte *ip, size_t *opcode_size) {
     uint f = (opcode_format_table[*ip >> 2] >> (2 * (*ip & 3))) & 3;
     const byte *ip_start = ip;
+    int extra_byte = (
+        *ip == MP_BC_RAISE_VARARGS
+        || *ip == MP_BC_MAKE_CLOSURE
+        || *ip == MP_BC_MAKE_CLOSURE_DEFARGS
+        || *ip == MP_BC_UNWIND_JUMP
+        || *ip == MP_BC_COMPARE_POP_JUMP_IF_TRUE
+        || *ip == MP_BC_COMPARE_POP_JUMP_IF_FALSE
+    );
+    if (*ip == MP_BC_LOAD_FAST_CONST_BINARY_OP) {
+        // local number and binary op follow the small-int argument
+        extra_byte = 2;
+    }
+    if (MICROPY_OPT_CACHE_MAP_LOOKUP_IN_BYTECODE_DYNAMIC && (
+        *ip == MP_BC_LOAD_NAME
+        || *ip == MP_BC_LOAD_GLOBAL
+        || *ip == MP_BC_LOAD_ATTR
+        || *ip == MP_BC_STORE_ATTR
+        || *ip < MP_BC_LOAD_FAST_ATTR_MULTI + 16)) {
+        extra_byte = 1;
+    }
     if (f == MP_OPCODE_QSTR) {
         ip += 3;
     } else {
-        int extra_byte = (
-            *ip == MP_BC_RAISE_VARARGS
-            || *ip == MP_BC_MAKE_CLOSURE
-            || *ip == MP_BC_MAKE_CLOSURE_DEFARGS
-            #if MICROPY_OPT_CACHE_MAP_LOOKUP_IN_BYTECODE
-            || *ip == MP_BC_LOAD_NAME
-            || *ip == MP_BC_LOAD_GLOBAL
-            || *ip == MP_BC_LOAD_ATTR
-            || *ip == MP_BC_STORE_ATTR
-            #endif
-        );
         ip += 1;
         if (f == MP_OPCODE_VAR_UINT) {
             while ((*ip++ & 0x80) != 0) {
@@ -416,8 +426,8 @@ uint mp_opcode_format(const byte *ip, size_t *opcode_size) {
         } else if (f == MP_OPCODE_OFFSET) {
             ip += 2;
         }
-        ip += extra_byte;
     }
+    ip += extra_byte;
     *opcode_size = ip - ip_start;
     return f;
 }
@@ -32,6 +32,7 @@
 #define MP_BC_LOAD_CONST_FALSE   (0x10)
 #define MP_BC_LOAD_CONST_NONE    (0x11)
 #define MP_BC_LOAD_CONST_TRUE    (0x12)
+#define MP_BC_LOAD_FAST_CONST_BINARY_OP (0x13) // signed var-int, byte, byte
 #define MP_BC_LOAD_CONST_SMALL_INT   (0x14) // signed var-int
 #define MP_BC_LOAD_CONST_STRING  (0x16) // qstr
 #define MP_BC_LOAD_CONST_OBJ     (0x17) // ptr
@@ -59,6 +60,9 @@
 #define MP_BC_DELETE_NAME        (0x2a) // qstr
 #define MP_BC_DELETE_GLOBAL      (0x2b) // qstr
 
+#define MP_BC_COMPARE_POP_JUMP_IF_TRUE  (0x2c) // rel byte code offset, 16-bit signed, in excess; then a byte
+#define MP_BC_COMPARE_POP_JUMP_IF_FALSE (0x2d) // rel byte code offset, 16-bit signed, in excess; then a byte
+
 #define MP_BC_DUP_TOP            (0x30)
 #define MP_BC_DUP_TOP_TWO        (0x31)
 #define MP_BC_POP_TOP            (0x32)
@@ -110,6 +114,7 @@
 #define MP_BC_IMPORT_FROM        (0x69) // qstr
 #define MP_BC_IMPORT_STAR        (0x6a)
 
+#define MP_BC_LOAD_FAST_ATTR_MULTI       (0x00) // + N(16); qstr
 #define MP_BC_LOAD_CONST_SMALL_INT_MULTI (0x70) // + N(64)
 #define MP_BC_LOAD_FAST_MULTI            (0xb0) // + N(16)
 #define MP_BC_STORE_FAST_MULTI           (0xc0) // + N(16)
@@ -154,7 +154,7 @@ STATIC void do_load_from_lexer(mp_obj_t module_obj, mp_lexer_t *lex) {
 }
 #endif
 
-#if MICROPY_PERSISTENT_CODE_LOAD || MICROPY_MODULE_FROZEN_MPY
+#if MICROPY_PERSISTENT_CODE_LOAD || MICROPY_MODULE_FROZEN_MPY || MICROPY_PERSISTENT_CODE_CACHE
 STATIC void do_execute_raw_code(mp_obj_t module_obj, mp_raw_code_t *raw_code, const char *filename) {
     #if MICROPY_PY___FILE__
     mp_store_attr(module_obj, MP_QSTR___file__, MP_OBJ_NEW_QSTR(qstr_from_str(filename)));
@@ -191,6 +191,39 @@ STATIC void do_execute_raw_code(mp_obj_t module_obj, mp_raw_code_t *raw_code, co
 }
 #endif
 
+#if MICROPY_PERSISTENT_CODE_CACHE
+STATIC void do_load_cached(mp_obj_t module_obj, const char *file_str) {
+    // the source is read once, both to check the cache and to compile it
+    vstr_t source;
+    vstr_init(&source, 256);
+    mp_reader_t reader;
+    mp_reader_new_file(&reader, file_str);
+    for (mp_uint_t b; (b = reader.readbyte(reader.data)) != MP_READER_EOF;) {
+        vstr_add_byte(&source, b);
+    }
+    reader.close(reader.data);
+
+    byte key[MP_RAW_CODE_CACHE_KEY_LEN];
+    mp_raw_code_t *raw_code = mp_raw_code_load_cached(file_str, (const byte*)source.buf, source.len, MP_EMIT_OPT_NONE, key);
+    if (raw_code != NULL) {
+        vstr_clear(&source);
+    } else {
+        // compile the source and cache the result before executing it; the
+        // lexer frees the source when it's done with it
+        mp_lexer_t *lex = mp_lexer_new_from_str_len(qstr_from_str(file_str), source.buf, source.len, source.alloc);
+        #if MICROPY_COMP_STREAM
+        raw_code = mp_compile_stream_to_raw_code(lex, MP_EMIT_OPT_NONE);
+        #else
+        qstr source_name = lex->source_name;
+        mp_parse_tree_t parse_tree = mp_parse(lex, MP_PARSE_FILE_INPUT);
+        raw_code = mp_compile_to_raw_code(&parse_tree, source_name, MP_EMIT_OPT_NONE, false);
+        #endif
+        mp_raw_code_save_cached(raw_code, file_str, key);
+    }
+    do_execute_raw_code(module_obj, raw_code, file_str);
+}
+#endif
+
 STATIC void do_load(mp_obj_t module_obj, vstr_t *file) {
     #if MICROPY_MODULE_FROZEN || MICROPY_PERSISTENT_CODE_LOAD || MICROPY_ENABLE_COMPILER
     char *file_str = vstr_null_terminated_str(file);
@@ -238,8 +271,14 @@ STATIC void do_load(mp_obj_t module_obj, vstr_t *file) {
     }
     #endif
 
+    // If we cache compiled scripts then load the cached code, compiling and
+    // caching the file first if needed, and execute it.
+    #if MICROPY_PERSISTENT_CODE_CACHE
+    do_load_cached(module_obj, file_str);
+    return;
+
     // If we can compile scripts then load the file and compile and execute it.
-    #if MICROPY_ENABLE_COMPILER
+    #elif MICROPY_ENABLE_COMPILER
     {
         mp_lexer_t *lex = mp_lexer_new_from_file(file_str);
         do_load_from_lexer(module_obj, lex);
@@ -139,6 +139,7 @@
 #define MICROPY_VFS                 (1)
 #define MICROPY_VFS_FAT             (MICROPY_VFS)
 #define MICROPY_READER_VFS          (MICROPY_VFS)
+#define MICROPY_VFS_IMPORT_STAT_CACHE (4)
 
 
 // type definitions for the specific machine
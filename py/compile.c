@@ -120,6 +120,7 @@ typedef struct _compiler_t {
     uint8_t is_repl;
     uint8_t pass; // holds enum type pass_kind_t
     uint8_t have_star;
+    uint8_t allow_doc_string;
 
     // try to keep compiler clean from nlr
     mp_obj_t compile_error; // set to an exception object if there's an error
@@ -172,6 +173,19 @@ STATIC uint comp_next_label(compiler_t *comp) {
     return comp->next_label++;
 }
 
+#if MICROPY_EMIT_NATIVE
+// The native emitter needs some labels of its own for generators, exception
+// handling and with blocks.  It takes them from the compiler's label counter at
+// the point the corresponding construct is emitted, so reserve them here.
+STATIC void reserve_labels_for_native(compiler_t *comp, int n) {
+    if (comp->scope_cur->emit_options != MP_EMIT_OPT_BYTECODE) {
+        comp->next_label += n;
+    }
+}
+#else
+#define reserve_labels_for_native(comp, n)
+#endif
+
 STATIC void compile_increase_except_level(compiler_t *comp) {
     comp->cur_except_level += 1;
     if (comp->cur_except_level > comp->scope_cur->exc_stack_size) {
@@ -1596,6 +1610,7 @@ STATIC void compile_try_except(compiler_t *comp, mp_parse_node_t pn_body, int n_
 
             compile_decrease_except_level(comp);
             EMIT(end_finally);
+            reserve_labels_for_native(comp, 2);
         }
         EMIT_ARG(jump, l2);
         EMIT_ARG(label_assign, end_finally_label);
@@ -1604,6 +1619,7 @@ STATIC void compile_try_except(compiler_t *comp, mp_parse_node_t pn_body, int n_
 
     compile_decrease_except_level(comp);
     EMIT(end_finally);
+    reserve_labels_for_native(comp, 2);
     EMIT(end_except_handler);
 
     EMIT_ARG(label_assign, success_label);
@@ -1632,6 +1648,7 @@ STATIC void compile_try_finally(compiler_t *comp, mp_parse_node_t pn_body, int n
 
     compile_decrease_except_level(comp);
     EMIT(end_finally);
+    reserve_labels_for_native(comp, 2);
 }
 
 STATIC void compile_try_stmt(compiler_t *comp, mp_parse_node_struct_t *pns) {
@@ -1667,11 +1684,8 @@ STATIC void compile_with_stmt_helper(compiler_t *comp, int n, mp_parse_node_t *n
         compile_node(comp, body);
     } else {
         uint l_end = comp_next_label(comp);
-        if (MICROPY_EMIT_NATIVE && comp->scope_cur->emit_options != MP_EMIT_OPT_BYTECODE) {
-            // we need to allocate an extra label for the native emitter
-            // it will use l_end+1 as an auxiliary label
-            comp_next_label(comp);
-        }
+        // the native emitter uses l_end+1 and l_end+2 as auxiliary labels
+        reserve_labels_for_native(comp, 2);
         if (MP_PARSE_NODE_IS_STRUCT_KIND(nodes[0], PN_with_item)) {
             // this pre-bit is of the form "a as b"
             mp_parse_node_struct_t *pns = (mp_parse_node_struct_t*)nodes[0];
@@ -1691,6 +1705,7 @@ STATIC void compile_with_stmt_helper(compiler_t *comp, int n, mp_parse_node_t *n
         EMIT_ARG(with_cleanup, l_end);
         compile_decrease_except_level(comp);
         EMIT(end_finally);
+        reserve_labels_for_native(comp, 2);
     }
 }
 
@@ -1708,6 +1723,7 @@ STATIC void compile_yield_from(compiler_t *comp) {
     EMIT_ARG(get_iter, false);
     EMIT_ARG(load_const_tok, MP_TOKEN_KW_NONE);
     EMIT_ARG(yield, MP_EMIT_YIELD_FROM);
+    reserve_labels_for_native(comp, 3);
 }
 
 #if MICROPY_PY_ASYNC_AWAIT
@@ -1757,6 +1773,7 @@ STATIC void compile_async_for_stmt(compiler_t *comp, mp_parse_node_struct_t *pns
     EMIT_ARG(adjust_stack_size, 1); // if we jump here, the exc is on the stack
     compile_decrease_except_level(comp);
     EMIT(end_finally);
+    reserve_labels_for_native(comp, 2);
     EMIT(end_except_handler);
 
     EMIT_ARG(label_assign, try_else_label);
@@ -1841,6 +1858,7 @@ STATIC void compile_async_with_stmt_helper(compiler_t *comp, int n, mp_parse_nod
         EMIT_ARG(adjust_stack_size, 3); // adjust for __aexit__, self, exc
         compile_decrease_except_level(comp);
         EMIT(end_finally);
+        reserve_labels_for_native(comp, 2);
         EMIT(end_except_handler);
 
         EMIT_ARG(label_assign, try_else_label); // start of try-else handler
@@ -2612,6 +2630,7 @@ STATIC void compile_yield_expr(compiler_t *comp, mp_parse_node_struct_t *pns) {
     if (MP_PARSE_NODE_IS_NULL(pns->nodes[0])) {
         EMIT_ARG(load_const_tok, MP_TOKEN_KW_NONE);
         EMIT_ARG(yield, MP_EMIT_YIELD_VALUE);
+        reserve_labels_for_native(comp, 2);
     } else if (MP_PARSE_NODE_IS_STRUCT_KIND(pns->nodes[0], PN_yield_arg_from)) {
         pns = (mp_parse_node_struct_t*)pns->nodes[0];
         compile_node(comp, pns->nodes[0]);
@@ -2619,6 +2638,7 @@ STATIC void compile_yield_expr(compiler_t *comp, mp_parse_node_struct_t *pns) {
     } else {
         compile_node(comp, pns->nodes[0]);
         EMIT_ARG(yield, MP_EMIT_YIELD_VALUE);
+        reserve_labels_for_native(comp, 2);
     }
 }
 
@@ -2853,6 +2873,7 @@ STATIC void compile_scope_comp_iter(compiler_t *comp, mp_parse_node_struct_t *pn
         compile_node(comp, pn_inner_expr);
         if (comp->scope_cur->kind == SCOPE_GEN_EXPR) {
             EMIT_ARG(yield, MP_EMIT_YIELD_VALUE);
+            reserve_labels_for_native(comp, 2);
             EMIT(pop_top);
         } else {
             EMIT_ARG(store_comp, comp->scope_cur->kind, 4 * for_depth + 5);
@@ -2927,6 +2948,7 @@ STATIC void compile_scope(compiler_t *comp, scope_t *scope, pass_kind_t pass) {
     comp->scope_cur = scope;
     comp->next_label = 0;
     EMIT_ARG(start_pass, pass, scope);
+    reserve_labels_for_native(comp, 4);
 
     if (comp->pass == MP_PASS_SCOPE) {
         // reset maximum stack sizes in scope
@@ -2942,7 +2964,7 @@ STATIC void compile_scope(compiler_t *comp, scope_t *scope, pass_kind_t pass) {
         compile_node(comp, pns->nodes[0]); // compile the expression
         EMIT(return_value);
     } else if (scope->kind == SCOPE_MODULE) {
-        if (!comp->is_repl) {
+        if (comp->allow_doc_string) {
             check_for_doc_string(comp, scope->pn);
         }
         compile_node(comp, scope->pn);
@@ -3336,16 +3358,14 @@ STATIC void scope_compute_things(scope_t *scope) {
     }
 }
 
-#if !MICROPY_PERSISTENT_CODE_SAVE
-STATIC
-#endif
-mp_raw_code_t *mp_compile_to_raw_code(mp_parse_tree_t *parse_tree, qstr source_file, uint emit_opt, bool is_repl) {
+STATIC mp_raw_code_t *compile_module(mp_parse_tree_t *parse_tree, qstr source_file, uint emit_opt, bool is_repl, bool allow_doc_string) {
     // put compiler state on the stack, it's relatively small
     compiler_t comp_state = {0};
     compiler_t *comp = &comp_state;
 
     comp->source_file = source_file;
     comp->is_repl = is_repl;
+    comp->allow_doc_string = allow_doc_string;
     comp->break_label = INVALID_LABEL;
     comp->continue_label = INVALID_LABEL;
 
@@ -3423,7 +3443,7 @@ mp_raw_code_t *mp_compile_to_raw_code(mp_parse_tree_t *parse_tree, qstr source_f
                 case MP_EMIT_OPT_NATIVE_PYTHON:
                 case MP_EMIT_OPT_VIPER:
                     if (emit_native == NULL) {
-                        emit_native = NATIVE_EMITTER(new)(&comp->compile_error, max_num_labels);
+                        emit_native = NATIVE_EMITTER(new)(&comp->compile_error, &comp->next_label, max_num_labels);
                     }
                     comp->emit_method_table = &NATIVE_EMITTER(method_table);
                     comp->emit = emit_native;
@@ -3495,6 +3515,108 @@ mp_raw_code_t *mp_compile_to_raw_code(mp_parse_tree_t *parse_tree, qstr source_f
     }
 }
 
+#if !MICROPY_PERSISTENT_CODE_SAVE && !MICROPY_COMP_STREAM
+STATIC
+#endif
+mp_raw_code_t *mp_compile_to_raw_code(mp_parse_tree_t *parse_tree, qstr source_file, uint emit_opt, bool is_repl) {
+    return compile_module(parse_tree, source_file, emit_opt, is_repl, !is_repl);
+}
+
+#if MICROPY_COMP_STREAM
+
+// Emit the module that runs each of the compiled groups in turn.  The groups
+// are themselves module-level code so they share the globals of the caller.
+STATIC void compile_stream_scope(emit_t *emit, scope_t *scope, mp_raw_code_t **groups, size_t num_groups, pass_kind_t pass) {
+    scope_t group_scope;
+    mp_emit_bc_start_pass(emit, pass, scope);
+    for (size_t i = 0; i < num_groups; i++) {
+        // make_function only needs the raw code from the scope
+        group_scope.raw_code = groups[i];
+        mp_emit_bc_make_function(emit, &group_scope, 0, 0);
+        mp_emit_bc_call_function(emit, 0, 0, 0);
+        mp_emit_bc_pop_top(emit);
+    }
+    mp_emit_bc_load_const_tok(emit, MP_TOKEN_KW_NONE);
+    mp_emit_bc_return_value(emit);
+    mp_emit_bc_end_pass(emit);
+}
+
+STATIC mp_raw_code_t *compile_stream(mp_lexer_t *lex, uint emit_opt) {
+    qstr source_file = lex->source_name;
+    mp_parse_stream_t *ps = mp_parse_stream_new(lex);
+
+    // compile each group as soon as it's parsed, so that only the parse tree
+    // of a single group is ever in memory
+    size_t groups_alloc = 4;
+    size_t num_groups = 0;
+    mp_raw_code_t **groups = m_new(mp_raw_code_t*, groups_alloc);
+    for (;;) {
+        mp_parse_tree_t tree = mp_parse_stream_next(ps);
+        if (MP_PARSE_NODE_IS_NULL(tree.root) && num_groups > 0) {
+            break;
+        }
+        if (num_groups == groups_alloc) {
+            groups = m_renew(mp_raw_code_t*, groups, groups_alloc, groups_alloc * 2);
+            groups_alloc *= 2;
+        }
+        bool first = num_groups == 0;
+        groups[num_groups++] = compile_module(&tree, source_file, emit_opt, false, first);
+        if (MP_PARSE_NODE_IS_NULL(tree.root)) {
+            break;
+        }
+    }
+    mp_parse_stream_free(ps);
+
+    if (num_groups == 1) {
+        mp_raw_code_t *rc = groups[0];
+        m_del(mp_raw_code_t*, groups, groups_alloc);
+        return rc;
+    }
+
+    // build the outer module, which doesn't appear in tracebacks because
+    // the module code of each group already does
+    scope_t *scope = scope_new(SCOPE_MODULE, MP_PARSE_NODE_NULL, source_file, MP_EMIT_OPT_NONE);
+    scope->scope_flags |= MP_SCOPE_FLAG_NO_TRACEBACK;
+    emit_t *emit = emit_bc_new();
+    emit_bc_set_max_num_labels(emit, 0);
+    compile_stream_scope(emit, scope, groups, num_groups, MP_PASS_STACK_SIZE);
+    compile_stream_scope(emit, scope, groups, num_groups, MP_PASS_CODE_SIZE);
+    compile_stream_scope(emit, scope, groups, num_groups, MP_PASS_EMIT);
+    emit_bc_free(emit);
+
+    mp_raw_code_t *rc = scope->raw_code;
+    scope_free(scope);
+    m_del(mp_raw_code_t*, groups, groups_alloc);
+    return rc;
+}
+
+mp_raw_code_t *mp_compile_stream_to_raw_code(mp_lexer_t *lex, uint emit_opt) {
+    #if MICROPY_MEM_STATS
+    // measure the peak heap used by parsing and compiling on its own
+    size_t start_bytes = MP_STATE_MEM(current_bytes_allocated);
+    size_t peak_bytes = MP_STATE_MEM(peak_bytes_allocated);
+    MP_STATE_MEM(peak_bytes_allocated) = start_bytes;
+    nlr_buf_t nlr;
+    mp_raw_code_t *rc = NULL;
+    if (nlr_push(&nlr) == 0) {
+        rc = compile_stream(lex, emit_opt);
+        nlr_pop();
+    }
+    MP_STATE_MEM(compile_peak_bytes_allocated) = MP_STATE_MEM(peak_bytes_allocated) - start_bytes;
+    if (MP_STATE_MEM(peak_bytes_allocated) < peak_bytes) {
+        MP_STATE_MEM(peak_bytes_allocated) = peak_bytes;
+    }
+    if (rc == NULL) {
+        nlr_jump(nlr.ret_val);
+    }
+    return rc;
+    #else
+    return compile_stream(lex, emit_opt);
+    #endif
+}
+
+#endif // MICROPY_COMP_STREAM
+
 mp_obj_t mp_compile(mp_parse_tree_t *parse_tree, qstr source_file, uint emit_opt, bool is_repl) {
     mp_raw_code_t *rc = mp_compile_to_raw_code(parse_tree, source_file, emit_opt, is_repl);
     // return function that executes the outer module
@@ -43,11 +43,18 @@ enum {
 // the compiler will clear the parse tree before it returns
 mp_obj_t mp_compile(mp_parse_tree_t *parse_tree, qstr source_file, uint emit_opt, bool is_repl);
 
-#if MICROPY_PERSISTENT_CODE_SAVE
+#if MICROPY_PERSISTENT_CODE_SAVE || MICROPY_COMP_STREAM
 // this has the same semantics as mp_compile
 mp_raw_code_t *mp_compile_to_raw_code(mp_parse_tree_t *parse_tree, qstr source_file, uint emit_opt, bool is_repl);
 #endif
 
+#if MICROPY_COMP_STREAM
+// parse and compile the file_input from the lexer a group of statements at a
+// time, so the parse tree of the whole file is never in memory at once
+// the lexer is freed before this returns
+mp_raw_code_t *mp_compile_stream_to_raw_code(mp_lexer_t *lex, uint emit_opt);
+#endif
+
 // this is implemented in runtime.c
 mp_obj_t mp_parse_compile_execute(mp_lexer_t *lex, mp_parse_input_kind_t parse_input_kind, mp_obj_dict_t *globals, mp_obj_dict_t *locals);
 
@@ -39,6 +39,18 @@
 #define BYTES_FOR_INT ((BYTES_PER_WORD * 8 + 6) / 7)
 #define DUMMY_DATA_SIZE (BYTES_FOR_INT)
 
+// Kinds of instruction remembered for fusing into a superinstruction
+#define SUPERINSN_NONE (0)
+#define SUPERINSN_LOAD_FAST (1)
+#define SUPERINSN_LOAD_CONST_SMALL_INT (2)
+#define SUPERINSN_COMPARE (3)
+
+typedef struct _emit_superinsn_t {
+    byte kind;
+    size_t offset;
+    mp_int_t arg;
+} emit_superinsn_t;
+
 struct _emit_t {
     // Accessed as mp_obj_t, so must be aligned as such, and we rely on the
     // memory allocator returning a suitably aligned pointer.
@@ -70,6 +82,10 @@ struct _emit_t {
     uint16_t ct_cur_raw_code;
     #endif
     mp_uint_t *const_table;
+
+    // The last two instructions emitted, if they can start a superinstruction
+    emit_superinsn_t superinsn_last;
+    emit_superinsn_t superinsn_prev;
 };
 
 emit_t *emit_bc_new(void) {
@@ -306,6 +322,39 @@ STATIC void emit_write_bytecode_byte_signed_label(emit_t *emit, byte b1, mp_uint
     c[2] = bytecode_offset >> 8;
 }
 
+// as above, but with an extra byte after the label that is included in the relative offset
+STATIC void emit_write_bytecode_byte_signed_label_byte(emit_t *emit, byte b1, mp_uint_t label, byte b2) {
+    int bytecode_offset;
+    if (emit->pass < MP_PASS_EMIT) {
+        bytecode_offset = 0;
+    } else {
+        bytecode_offset = emit->label_offsets[label] - emit->bytecode_offset - 4 + 0x8000;
+    }
+    byte *c = emit_get_cur_to_write_bytecode(emit, 4);
+    c[0] = b1;
+    c[1] = bytecode_offset;
+    c[2] = bytecode_offset >> 8;
+    c[3] = b2;
+}
+
+// Remember that the instruction about to be written at the current offset may
+// be fused with the one that follows it.  The decision to fuse depends only on
+// the sequence of emit calls, so it is the same in every pass.
+STATIC void emit_bc_superinsn_start(emit_t *emit, byte kind, mp_int_t arg) {
+    if (MICROPY_OPT_BYTECODE_SUPERINSTRUCTIONS_DYNAMIC) {
+        emit->superinsn_last.kind = kind;
+        emit->superinsn_last.offset = emit->bytecode_offset;
+        emit->superinsn_last.arg = arg;
+    }
+}
+
+// Drop any pending candidates, eg when a label or line-number entry refers to
+// the current offset and so the preceding code must not be rewritten.
+STATIC void emit_bc_superinsn_reset(emit_t *emit) {
+    emit->superinsn_last.kind = SUPERINSN_NONE;
+    emit->superinsn_prev.kind = SUPERINSN_NONE;
+}
+
 void mp_emit_bc_start_pass(emit_t *emit, pass_kind_t pass, scope_t *scope) {
     emit->pass = pass;
     emit->stack_size = 0;
@@ -321,6 +370,7 @@ void mp_emit_bc_start_pass(emit_t *emit, pass_kind_t pass, scope_t *scope) {
     #endif
     emit->bytecode_offset = 0;
     emit->code_info_offset = 0;
+    emit_bc_superinsn_reset(emit);
 
     // Write local state size and exception stack size.
     {
@@ -466,6 +516,8 @@ void mp_emit_bc_adjust_stack_size(emit_t *emit, mp_int_t delta) {
 
 static inline void emit_bc_pre(emit_t *emit, mp_int_t stack_size_delta) {
     mp_emit_bc_adjust_stack_size(emit, stack_size_delta);
+    emit->superinsn_prev = emit->superinsn_last;
+    emit->superinsn_last.kind = SUPERINSN_NONE;
 }
 
 void mp_emit_bc_set_source_line(emit_t *emit, mp_uint_t source_line) {
@@ -481,6 +533,7 @@ void mp_emit_bc_set_source_line(emit_t *emit, mp_uint_t source_line) {
         emit_write_code_info_bytes_lines(emit, bytes_to_skip, lines_to_skip);
         emit->last_source_line_offset = emit->bytecode_offset;
         emit->last_source_line = source_line;
+        emit_bc_superinsn_reset(emit);
     }
 #else
     (void)emit;
@@ -534,6 +587,7 @@ void mp_emit_bc_load_const_tok(emit_t *emit, mp_token_kind_t tok) {
 
 void mp_emit_bc_load_const_small_int(emit_t *emit, mp_int_t arg) {
     emit_bc_pre(emit, 1);
+    emit_bc_superinsn_start(emit, SUPERINSN_LOAD_CONST_SMALL_INT, arg);
     if (-16 <= arg && arg <= 47) {
         emit_write_bytecode_byte(emit, MP_BC_LOAD_CONST_SMALL_INT_MULTI + 16 + arg);
     } else {
@@ -561,6 +615,9 @@ void mp_emit_bc_load_local(emit_t *emit, qstr qst, mp_uint_t local_num, int kind
     MP_STATIC_ASSERT(MP_BC_LOAD_FAST_N + MP_EMIT_IDOP_LOCAL_DEREF == MP_BC_LOAD_DEREF);
     (void)qst;
     emit_bc_pre(emit, 1);
+    if (kind == MP_EMIT_IDOP_LOCAL_FAST && local_num <= 255) {
+        emit_bc_superinsn_start(emit, SUPERINSN_LOAD_FAST, local_num);
+    }
     if (kind == MP_EMIT_IDOP_LOCAL_FAST && local_num <= 15) {
         emit_write_bytecode_byte(emit, MP_BC_LOAD_FAST_MULTI + local_num);
     } else {
@@ -605,8 +662,15 @@ void mp_emit_bc_subscr(emit_t *emit, int kind) {
 
 void mp_emit_bc_attr(emit_t *emit, qstr qst, int kind) {
     if (kind == MP_EMIT_ATTR_LOAD) {
+        emit_superinsn_t last = emit->superinsn_last;
         emit_bc_pre(emit, 0);
-        emit_write_bytecode_byte_qstr(emit, MP_BC_LOAD_ATTR, qst);
+        if (last.kind == SUPERINSN_LOAD_FAST && last.arg <= 15) {
+            // fuse with the preceding LOAD_FAST_MULTI
+            emit->bytecode_offset = last.offset;
+            emit_write_bytecode_byte_qstr(emit, MP_BC_LOAD_FAST_ATTR_MULTI + last.arg, qst);
+        } else {
+            emit_write_bytecode_byte_qstr(emit, MP_BC_LOAD_ATTR, qst);
+        }
     } else {
         if (kind == MP_EMIT_ATTR_DELETE) {
             mp_emit_bc_load_null(emit);
@@ -643,6 +707,7 @@ void mp_emit_bc_delete_local(emit_t *emit, qstr qst, mp_uint_t local_num, int ki
     MP_STATIC_ASSERT(MP_BC_DELETE_FAST + MP_EMIT_IDOP_LOCAL_FAST == MP_BC_DELETE_FAST);
     MP_STATIC_ASSERT(MP_BC_DELETE_FAST + MP_EMIT_IDOP_LOCAL_DEREF == MP_BC_DELETE_DEREF);
     (void)qst;
+    emit_bc_pre(emit, 0);
     emit_write_bytecode_byte_uint(emit, MP_BC_DELETE_FAST + kind, local_num);
 }
 
@@ -684,8 +749,15 @@ void mp_emit_bc_jump(emit_t *emit, mp_uint_t label) {
 }
 
 void mp_emit_bc_pop_jump_if(emit_t *emit, bool cond, mp_uint_t label) {
+    emit_superinsn_t last = emit->superinsn_last;
     emit_bc_pre(emit, -1);
-    if (cond) {
+    if (last.kind == SUPERINSN_COMPARE) {
+        // fuse with the preceding comparison
+        emit->bytecode_offset = last.offset;
+        emit_write_bytecode_byte_signed_label_byte(emit,
+            cond ? MP_BC_COMPARE_POP_JUMP_IF_TRUE : MP_BC_COMPARE_POP_JUMP_IF_FALSE,
+            label, last.arg);
+    } else if (cond) {
         emit_write_bytecode_byte_signed_label(emit, MP_BC_POP_JUMP_IF_TRUE, label);
     } else {
         emit_write_bytecode_byte_signed_label(emit, MP_BC_POP_JUMP_IF_FALSE, label);
@@ -714,6 +786,7 @@ void mp_emit_bc_unwind_jump(emit_t *emit, mp_uint_t label, mp_uint_t except_dept
         }
         emit_write_bytecode_byte_signed_label(emit, MP_BC_JUMP, label & ~MP_EMIT_BREAK_FROM_FOR);
     } else {
+        emit_bc_pre(emit, 0);
         emit_write_bytecode_byte_signed_label(emit, MP_BC_UNWIND_JUMP, label & ~MP_EMIT_BREAK_FROM_FOR);
         emit_write_bytecode_byte(emit, ((label & MP_EMIT_BREAK_FROM_FOR) ? 0x80 : 0) | except_depth);
     }
@@ -785,8 +858,20 @@ void mp_emit_bc_binary_op(emit_t *emit, mp_binary_op_t op) {
         invert = true;
         op = MP_BINARY_OP_IS;
     }
+    emit_superinsn_t last = emit->superinsn_last;
+    emit_superinsn_t prev = emit->superinsn_prev;
     emit_bc_pre(emit, -1);
-    emit_write_bytecode_byte(emit, MP_BC_BINARY_OP_MULTI + op);
+    if (!invert && last.kind == SUPERINSN_LOAD_CONST_SMALL_INT && prev.kind == SUPERINSN_LOAD_FAST) {
+        // fuse with the preceding LOAD_FAST and LOAD_CONST_SMALL_INT
+        emit->bytecode_offset = prev.offset;
+        emit_write_bytecode_byte_int(emit, MP_BC_LOAD_FAST_CONST_BINARY_OP, last.arg);
+        emit_write_bytecode_byte_byte(emit, prev.arg, op);
+    } else {
+        if (!invert && op <= MP_BINARY_OP_NOT_EQUAL) {
+            emit_bc_superinsn_start(emit, SUPERINSN_COMPARE, op);
+        }
+        emit_write_bytecode_byte(emit, MP_BC_BINARY_OP_MULTI + op);
+    }
     if (invert) {
         emit_bc_pre(emit, 0);
         emit_write_bytecode_byte(emit, MP_BC_UNARY_OP_MULTI + MP_UNARY_OP_NOT);
@@ -145,6 +145,18 @@ mp_obj_t mp_make_function_from_raw_code(const mp_raw_code_t *rc, mp_obj_t def_ar
         case MP_CODE_BYTECODE:
             fun = mp_obj_new_fun_bc(def_args, def_kw_args, rc->data.u_byte.bytecode, rc->data.u_byte.const_table);
             break;
+        #if MICROPY_PERSISTENT_CODE_LOAD_LAZY
+        case MP_CODE_BYTECODE_LAZY: {
+            // the bytecode is loaded when the function is first needed
+            const mp_raw_code_t *loaded = rc->data.u_lazy.loaded;
+            if (loaded != NULL) {
+                fun = mp_obj_new_fun_bc(def_args, def_kw_args, loaded->data.u_byte.bytecode, loaded->data.u_byte.const_table);
+            } else {
+                fun = mp_obj_new_fun_bc(def_args, def_kw_args, NULL, (const mp_uint_t*)rc);
+            }
+            break;
+        }
+        #endif
         default:
             // All other kinds are invalid.
             mp_raise_RuntimeError(translate("Corrupt raw code"));
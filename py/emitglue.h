@@ -37,6 +37,7 @@ typedef enum {
     MP_CODE_NATIVE_PY,
     MP_CODE_NATIVE_VIPER,
     MP_CODE_NATIVE_ASM,
+    MP_CODE_BYTECODE_LAZY,
 } mp_raw_code_kind_t;
 
 typedef struct _mp_raw_code_t {
@@ -58,6 +59,14 @@ typedef struct _mp_raw_code_t {
             const mp_uint_t *const_table;
             mp_uint_t type_sig; // for viper, compressed as 2-bit types; ret is MSB, then arg0, arg1, etc
         } u_native;
+        #if MICROPY_PERSISTENT_CODE_LOAD_LAZY
+        struct {
+            const byte *mpy; // start of this raw code in its .mpy image
+            const byte *mpy_top; // end of the .mpy image
+            void *owner; // heap object that keeps the image valid
+            struct _mp_raw_code_t *loaded; // the loaded raw code, once it is
+        } u_lazy;
+        #endif
     } data;
 } mp_raw_code_t;
 
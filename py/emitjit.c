@@ -0,0 +1,1208 @@
+/*
+ * This file is part of the MicroPython project, http://micropython.org/
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 Damien P. George
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <string.h>
+#include <assert.h>
+
+#include "py/emitjit.h"
+#include "py/compile.h"
+#include "py/emit.h"
+#include "py/scope.h"
+#include "py/bc0.h"
+#include "py/bc.h"
+#include "py/gc.h"
+#include "py/objtuple.h"
+#include "py/runtime.h"
+
+#if MICROPY_EMIT_NATIVE_JIT
+
+// The JIT is a second front end to the native emitter.  Instead of walking
+// the parse tree like compile.c does, it walks the bytecode of a function and
+// makes the same calls into the emitter that the compiler made to produce that
+// bytecode.  Most opcodes map directly to one call.  What the bytecode doesn't
+// record is recovered by scanning it first:
+//  - the labels, from the destinations of jumps, SETUP_xxx and FOR_ITER
+//  - where except handlers start and for loops end, which the native emitter
+//    needs to be told about
+//  - the stack depth at each label, which the compiler fixed up with
+//    adjust_stack_size after unconditional jumps
+// Bytecode that can't be replayed faithfully is left to the VM.
+
+#if MICROPY_EMIT_X64
+#define NATIVE_EMITTER(f) emit_native_x64_##f
+#elif MICROPY_EMIT_X86
+#define NATIVE_EMITTER(f) emit_native_x86_##f
+#elif MICROPY_EMIT_THUMB
+#define NATIVE_EMITTER(f) emit_native_thumb_##f
+#elif MICROPY_EMIT_ARM
+#define NATIVE_EMITTER(f) emit_native_arm_##f
+#elif MICROPY_EMIT_XTENSA
+#define NATIVE_EMITTER(f) emit_native_xtensa_##f
+#else
+#error "unknown native emitter"
+#endif
+
+// labels 0-3 are taken by the native emitter at the start of each pass, and 4
+// is for raising NameError on an unbound local
+#define JIT_FIRST_LABEL (5)
+
+// the kind of exception block (or for loop) whose handler (or exit) is at a target
+enum {
+    JIT_BLOCK_NONE,
+    JIT_BLOCK_EXCEPT,
+    JIT_BLOCK_FINALLY,
+    JIT_BLOCK_WITH,
+    JIT_BLOCK_FOR,
+};
+
+typedef struct _jit_target_t {
+    uint16_t label;         // label for jumps to here, or 0 if there are none
+    uint16_t block_label;   // label for the block handler (or loop exit) here
+    int16_t depth;          // stack depth at label, or -1 if not known yet
+    int16_t block_depth;    // likewise for block_label
+    uint8_t block_kind;     // one of JIT_BLOCK_xxx
+} jit_target_t;
+
+// A decoded opcode.  The _MULTI forms are turned into their plain equivalent,
+// except that the unary and binary ops keep the _MULTI opcode with the op in arg.
+typedef struct _jit_insn_t {
+    byte op;
+    byte extra;             // the byte following the argument of some opcodes
+    mp_uint_t arg;
+    mp_int_t num;
+    qstr qst;
+    mp_uint_t ptr;          // a constant object or a raw code
+    const byte *target;
+} jit_insn_t;
+
+typedef struct _jit_t {
+    emit_t *emit;
+    scope_t *scope;
+    const mp_uint_t *const_table;
+    const byte *code;
+    const byte *code_end;
+    jit_target_t *targets;  // indexed by the offset of an opcode from code
+    int16_t *block_base;    // stack depth outside each active exception block
+    size_t block_alloc;
+    size_t block_sp;
+    mp_uint_t n_static_labels;
+    uint next_label;        // the emitter's label slot, see reserve_labels_for_native()
+    mp_obj_t error;
+    bool failed;
+} jit_t;
+
+// An entry of the cache of compiled bytecode.  Entries are never modified once
+// published, so that a thread looking one up sees the bytecode and raw code
+// that belong together: replacing an entry is a single pointer store.
+typedef struct _mp_jit_cache_entry_t {
+    const byte *bytecode;
+    mp_raw_code_t *rc;
+} mp_jit_cache_entry_t;
+
+STATIC const byte *jit_decode_int(const byte *ip, mp_int_t *num_out) {
+    mp_int_t num = 0;
+    if ((ip[0] & 0x40) != 0) {
+        // number is negative
+        num--;
+    }
+    do {
+        num = (num << 7) | (*ip & 0x7f);
+    } while ((*ip++ & 0x80) != 0);
+    *num_out = num;
+    return ip;
+}
+
+STATIC const byte *jit_decode_qstr(const byte *ip, qstr *qst) {
+    #if MICROPY_PERSISTENT_CODE
+    *qst = ip[0] | ip[1] << 8;
+    return ip + 2;
+    #else
+    *qst = mp_decode_uint(&ip);
+    return ip;
+    #endif
+}
+
+STATIC const byte *jit_decode_ptr(const byte *ip, const mp_uint_t *const_table, mp_uint_t *ptr) {
+    #if MICROPY_PERSISTENT_CODE
+    *ptr = const_table[mp_decode_uint(&ip)];
+    #else
+    (void)const_table;
+    ip = (const byte*)MP_ALIGN(ip, sizeof(mp_uint_t));
+    *ptr = *(const mp_uint_t*)ip;
+    ip += sizeof(mp_uint_t);
+    #endif
+    return ip;
+}
+
+// Decode the opcode at ip into insn, returning the address of the next opcode,
+// or NULL if the opcode isn't one the JIT knows about.
+STATIC const byte *jit_decode(const byte *ip, const mp_uint_t *const_table, jit_insn_t *insn) {
+    byte op = *ip++;
+    insn->op = op;
+    insn->target = NULL;
+
+    if (op >= MP_BC_BINARY_OP_MULTI) {
+        insn->op = MP_BC_BINARY_OP_MULTI;
+        insn->arg = op - MP_BC_BINARY_OP_MULTI;
+        return insn->arg < MP_BINARY_OP_NUM_BYTECODE ? ip : NULL;
+    } else if (op >= MP_BC_UNARY_OP_MULTI) {
+        insn->op = MP_BC_UNARY_OP_MULTI;
+        insn->arg = op - MP_BC_UNARY_OP_MULTI;
+        return insn->arg < MP_UNARY_OP_NUM_BYTECODE ? ip : NULL;
+    } else if (op >= MP_BC_STORE_FAST_MULTI) {
+        insn->op = MP_BC_STORE_FAST_N;
+        insn->arg = op - MP_BC_STORE_FAST_MULTI;
+        return ip;
+    } else if (op >= MP_BC_LOAD_FAST_MULTI) {
+        insn->op = MP_BC_LOAD_FAST_N;
+        insn->arg = op - MP_BC_LOAD_FAST_MULTI;
+        return ip;
+    } else if (op >= MP_BC_LOAD_CONST_SMALL_INT_MULTI) {
+        insn->op = MP_BC_LOAD_CONST_SMALL_INT;
+        insn->num = (mp_int_t)op - MP_BC_LOAD_CONST_SMALL_INT_MULTI - 16;
+        return ip;
+    #if MICROPY_OPT_BYTECODE_SUPERINSTRUCTIONS
+    } else if (op < MP_BC_LOAD_FAST_ATTR_MULTI + 16) {
+        insn->op = MP_BC_LOAD_FAST_ATTR_MULTI;
+        insn->arg = op - MP_BC_LOAD_FAST_ATTR_MULTI;
+        ip = jit_decode_qstr(ip, &insn->qst);
+        if (MICROPY_OPT_CACHE_MAP_LOOKUP_IN_BYTECODE) {
+            ip++;
+        }
+        return ip;
+    #endif
+    }
+
+    switch (op) {
+        case MP_BC_LOAD_CONST_FALSE:
+        case MP_BC_LOAD_CONST_NONE:
+        case MP_BC_LOAD_CONST_TRUE:
+        case MP_BC_LOAD_NULL:
+        case MP_BC_LOAD_BUILD_CLASS:
+        case MP_BC_LOAD_SUBSCR:
+        case MP_BC_STORE_SUBSCR:
+        case MP_BC_DUP_TOP:
+        case MP_BC_DUP_TOP_TWO:
+        case MP_BC_POP_TOP:
+        case MP_BC_ROT_TWO:
+        case MP_BC_ROT_THREE:
+        case MP_BC_WITH_CLEANUP:
+        case MP_BC_END_FINALLY:
+        case MP_BC_GET_ITER:
+        case MP_BC_GET_ITER_STACK:
+        case MP_BC_POP_BLOCK:
+        case MP_BC_POP_EXCEPT:
+        case MP_BC_STORE_MAP:
+        case MP_BC_RETURN_VALUE:
+        case MP_BC_YIELD_VALUE:
+        case MP_BC_YIELD_FROM:
+        case MP_BC_IMPORT_STAR:
+            break;
+
+        #if MICROPY_OPT_BYTECODE_SUPERINSTRUCTIONS
+        case MP_BC_LOAD_FAST_CONST_BINARY_OP:
+            ip = jit_decode_int(ip, &insn->num);
+            insn->arg = *ip++;
+            insn->extra = *ip++;
+            break;
+        #endif
+
+        case MP_BC_LOAD_CONST_SMALL_INT:
+            ip = jit_decode_int(ip, &insn->num);
+            break;
+
+        case MP_BC_LOAD_NAME:
+        case MP_BC_LOAD_GLOBAL:
+        case MP_BC_LOAD_ATTR:
+        case MP_BC_STORE_ATTR:
+            ip = jit_decode_qstr(ip, &insn->qst);
+            if (MICROPY_OPT_CACHE_MAP_LOOKUP_IN_BYTECODE) {
+                ip++;
+            }
+            break;
+
+        case MP_BC_LOAD_CONST_STRING:
+        case MP_BC_LOAD_METHOD:
+        case MP_BC_LOAD_SUPER_METHOD:
+        case MP_BC_STORE_NAME:
+        case MP_BC_STORE_GLOBAL:
+        case MP_BC_DELETE_NAME:
+        case MP_BC_DELETE_GLOBAL:
+        case MP_BC_IMPORT_NAME:
+        case MP_BC_IMPORT_FROM:
+            ip = jit_decode_qstr(ip, &insn->qst);
+            break;
+
+        case MP_BC_LOAD_CONST_OBJ:
+        case MP_BC_MAKE_FUNCTION:
+        case MP_BC_MAKE_FUNCTION_DEFARGS:
+            ip = jit_decode_ptr(ip, const_table, &insn->ptr);
+            break;
+
+        case MP_BC_MAKE_CLOSURE:
+        case MP_BC_MAKE_CLOSURE_DEFARGS:
+            ip = jit_decode_ptr(ip, const_table, &insn->ptr);
+            insn->extra = *ip++;
+            break;
+
+        case MP_BC_LOAD_FAST_N:
+        case MP_BC_LOAD_DEREF:
+        case MP_BC_STORE_FAST_N:
+        case MP_BC_STORE_DEREF:
+        case MP_BC_DELETE_FAST:
+        case MP_BC_DELETE_DEREF:
+        case MP_BC_BUILD_TUPLE:
+        case MP_BC_BUILD_LIST:
+        case MP_BC_BUILD_MAP:
+        #if MICROPY_PY_BUILTINS_SET
+        case MP_BC_BUILD_SET:
+        #endif
+        #if MICROPY_PY_BUILTINS_SLICE
+        case MP_BC_BUILD_SLICE:
+        #endif
+        case MP_BC_STORE_COMP:
+        case MP_BC_UNPACK_SEQUENCE:
+        case MP_BC_UNPACK_EX:
+        case MP_BC_CALL_FUNCTION:
+        case MP_BC_CALL_FUNCTION_VAR_KW:
+        case MP_BC_CALL_METHOD:
+        case MP_BC_CALL_METHOD_VAR_KW:
+            insn->arg = mp_decode_uint(&ip);
+            break;
+
+        case MP_BC_RAISE_VARARGS:
+            insn->arg = *ip++;
+            break;
+
+        case MP_BC_JUMP:
+        case MP_BC_POP_JUMP_IF_TRUE:
+        case MP_BC_POP_JUMP_IF_FALSE:
+        case MP_BC_JUMP_IF_TRUE_OR_POP:
+        case MP_BC_JUMP_IF_FALSE_OR_POP:
+            ip += 2;
+            insn->target = ip + (ip[-2] | (ip[-1] << 8)) - 0x8000;
+            break;
+
+        #if MICROPY_OPT_BYTECODE_SUPERINSTRUCTIONS
+        case MP_BC_COMPARE_POP_JUMP_IF_TRUE:
+        case MP_BC_COMPARE_POP_JUMP_IF_FALSE:
+            // the jump is relative to the end of the opcode, after the op byte
+            ip += 3;
+            insn->target = ip + (ip[-3] | (ip[-2] << 8)) - 0x8000;
+            insn->extra = ip[-1];
+            break;
+        #endif
+
+        case MP_BC_UNWIND_JUMP:
+            // the jump is relative to the end of the label, before the byte
+            ip += 2;
+            insn->target = ip + (ip[-2] | (ip[-1] << 8)) - 0x8000;
+            insn->extra = *ip++;
+            break;
+
+        case MP_BC_SETUP_WITH:
+        case MP_BC_SETUP_EXCEPT:
+        case MP_BC_SETUP_FINALLY:
+        case MP_BC_FOR_ITER:
+            ip += 2;
+            insn->target = ip + (ip[-2] | (ip[-1] << 8));
+            break;
+
+        default:
+            return NULL;
+    }
+    return ip;
+}
+
+// The number of values an opcode needs on the stack.  Only used to stop the
+// stack underflowing in unreachable code, where the compiler may have adjusted
+// the depth with nothing in the bytecode to show for it.
+STATIC mp_uint_t jit_insn_pops(const jit_insn_t *insn) {
+    switch (insn->op) {
+        case MP_BC_LOAD_ATTR:
+        case MP_BC_LOAD_METHOD:
+        case MP_BC_STORE_FAST_N:
+        case MP_BC_STORE_DEREF:
+        case MP_BC_STORE_NAME:
+        case MP_BC_STORE_GLOBAL:
+        case MP_BC_DUP_TOP:
+        case MP_BC_POP_TOP:
+        case MP_BC_POP_JUMP_IF_TRUE:
+        case MP_BC_POP_JUMP_IF_FALSE:
+        case MP_BC_JUMP_IF_TRUE_OR_POP:
+        case MP_BC_JUMP_IF_FALSE_OR_POP:
+        case MP_BC_SETUP_WITH:
+        case MP_BC_END_FINALLY:
+        case MP_BC_GET_ITER:
+        case MP_BC_GET_ITER_STACK:
+        case MP_BC_UNARY_OP_MULTI:
+        case MP_BC_UNPACK_SEQUENCE:
+        case MP_BC_UNPACK_EX:
+        case MP_BC_RETURN_VALUE:
+        case MP_BC_YIELD_VALUE:
+        case MP_BC_IMPORT_FROM:
+        case MP_BC_IMPORT_STAR:
+            return 1;
+        case MP_BC_LOAD_SUBSCR:
+        case MP_BC_STORE_ATTR:
+        case MP_BC_DUP_TOP_TWO:
+        case MP_BC_ROT_TWO:
+        case MP_BC_COMPARE_POP_JUMP_IF_TRUE:
+        case MP_BC_COMPARE_POP_JUMP_IF_FALSE:
+        case MP_BC_BINARY_OP_MULTI:
+        case MP_BC_YIELD_FROM:
+        case MP_BC_MAKE_FUNCTION_DEFARGS:
+        case MP_BC_IMPORT_NAME:
+            return 2;
+        case MP_BC_LOAD_SUPER_METHOD:
+        case MP_BC_STORE_SUBSCR:
+        case MP_BC_ROT_THREE:
+        case MP_BC_STORE_MAP:
+            return 3;
+        case MP_BC_FOR_ITER:
+            return MP_OBJ_ITER_BUF_NSLOTS;
+        case MP_BC_BUILD_TUPLE:
+        case MP_BC_BUILD_LIST:
+        case MP_BC_BUILD_SET:
+        case MP_BC_BUILD_SLICE:
+        case MP_BC_RAISE_VARARGS:
+            return insn->arg;
+        case MP_BC_STORE_COMP:
+            return (insn->arg >> 2) + 1;
+        case MP_BC_CALL_FUNCTION:
+            return (insn->arg & 0xff) + 2 * (insn->arg >> 8) + 1;
+        case MP_BC_CALL_FUNCTION_VAR_KW:
+        case MP_BC_CALL_METHOD:
+            return (insn->arg & 0xff) + 2 * (insn->arg >> 8) + 3 - (insn->op == MP_BC_CALL_METHOD);
+        case MP_BC_CALL_METHOD_VAR_KW:
+            return (insn->arg & 0xff) + 2 * (insn->arg >> 8) + 4;
+        case MP_BC_MAKE_CLOSURE:
+            return insn->extra;
+        case MP_BC_MAKE_CLOSURE_DEFARGS:
+            return insn->extra + 2;
+        default:
+            return 0;
+    }
+}
+
+STATIC bool jit_is_fallthrough(byte op) {
+    return !(op == MP_BC_JUMP || op == MP_BC_UNWIND_JUMP
+        || op == MP_BC_RETURN_VALUE || op == MP_BC_RAISE_VARARGS);
+}
+
+// Find the extent of the code and check that every opcode in it is known.
+// Anything after the last opcode that can't fall through, and that no jump
+// goes beyond, is unreachable and isn't compiled.  Also count the labels
+// that the emitter takes as it goes, and the number of locals.
+STATIC bool jit_scan(jit_t *jit, mp_uint_t *n_dynamic_labels, mp_uint_t *max_local) {
+    const byte *ip = jit->code;
+    const byte *max_target = ip;
+    mp_uint_t n_args = jit->scope->num_pos_args + jit->scope->num_kwonly_args;
+    *n_dynamic_labels = 0;
+    for (;;) {
+        jit_insn_t insn;
+        const byte *next = jit_decode(ip, jit->const_table, &insn);
+        if (next == NULL) {
+            return false;
+        }
+        if (insn.target != NULL && insn.target > max_target) {
+            max_target = insn.target;
+        }
+        switch (insn.op) {
+            case MP_BC_DELETE_FAST:
+                // the emitter doesn't check arguments for being unbound
+                if (insn.arg < n_args) {
+                    return false;
+                }
+                // fallthrough
+            case MP_BC_LOAD_FAST_N:
+            case MP_BC_LOAD_DEREF:
+            case MP_BC_STORE_FAST_N:
+            case MP_BC_STORE_DEREF:
+            case MP_BC_DELETE_DEREF:
+            case MP_BC_LOAD_FAST_ATTR_MULTI:
+            case MP_BC_LOAD_FAST_CONST_BINARY_OP:
+                if (insn.arg + 1 > *max_local) {
+                    *max_local = insn.arg + 1;
+                }
+                break;
+            case MP_BC_YIELD_VALUE:
+            case MP_BC_END_FINALLY:
+                *n_dynamic_labels += 2;
+                break;
+            case MP_BC_YIELD_FROM:
+                *n_dynamic_labels += 3;
+                break;
+        }
+        ip = next;
+        if (!jit_is_fallthrough(insn.op) && ip > max_target) {
+            break;
+        }
+    }
+    jit->code_end = ip;
+    return true;
+}
+
+// Give a label to each destination of a jump, and a block label to each
+// exception handler and for loop exit.
+STATIC bool jit_scan_targets(jit_t *jit) {
+    mp_uint_t label = JIT_FIRST_LABEL;
+    for (const byte *ip = jit->code; ip < jit->code_end;) {
+        jit_insn_t insn;
+        ip = jit_decode(ip, jit->const_table, &insn);
+        if (insn.target == NULL) {
+            continue;
+        }
+        jit_target_t *t = &jit->targets[insn.target - jit->code];
+        int kind;
+        switch (insn.op) {
+            case MP_BC_SETUP_EXCEPT: kind = JIT_BLOCK_EXCEPT; break;
+            case MP_BC_SETUP_FINALLY: kind = JIT_BLOCK_FINALLY; break;
+            case MP_BC_SETUP_WITH: kind = JIT_BLOCK_WITH; break;
+            case MP_BC_FOR_ITER: kind = JIT_BLOCK_FOR; break;
+            default: kind = JIT_BLOCK_NONE; break;
+        }
+        if (kind == JIT_BLOCK_NONE) {
+            if (t->label == 0) {
+                t->label = label++;
+            }
+        } else {
+            if (t->block_kind != JIT_BLOCK_NONE) {
+                // two blocks can't end in the same place
+                return false;
+            }
+            #if MICROPY_PY_SYS_EXC_INFO
+            if (kind != JIT_BLOCK_FOR) {
+                // native handlers don't set sys.exc_info(), so leave
+                // functions that catch exceptions with the VM
+                return false;
+            }
+            #endif
+            t->block_kind = kind;
+            t->block_label = label;
+            // with_cleanup uses label+1 and label+2 too
+            label += kind == JIT_BLOCK_WITH ? 3 : 1;
+        }
+    }
+    for (const byte *ip = jit->code; ip < jit->code_end; ++ip) {
+        jit_target_t *t = &jit->targets[ip - jit->code];
+        if (t->block_kind == JIT_BLOCK_WITH && t->label != 0) {
+            // only the end of the with body leads to its cleanup
+            return false;
+        }
+    }
+    jit->n_static_labels = label - JIT_FIRST_LABEL;
+    return true;
+}
+
+// Check that the stack depth at a jump matches that at its destination.
+STATIC void jit_jump_depth(jit_t *jit, const byte *target, mp_int_t depth) {
+    jit_target_t *t = &jit->targets[target - jit->code];
+    if (t->depth < 0) {
+        t->depth = depth;
+    } else if (t->depth != depth) {
+        jit->failed = true;
+    }
+}
+
+STATIC void jit_adjust_depth(jit_t *jit, mp_int_t depth) {
+    mp_int_t cur = NATIVE_EMITTER(get_stack_size)(jit->emit);
+    if (depth != cur) {
+        NATIVE_EMITTER(method_table).adjust_stack_size(jit->emit, depth - cur);
+    }
+}
+
+// Enter an exception block, recording the stack depth an unwind jump out of
+// it leaves behind.
+STATIC void jit_push_block(jit_t *jit, mp_int_t depth) {
+    if (jit->block_sp == jit->block_alloc) {
+        jit->failed = true;
+        return;
+    }
+    jit->block_base[jit->block_sp++] = depth;
+}
+
+STATIC void jit_emit_pass(jit_t *jit, pass_kind_t pass) {
+    emit_t *emit = jit->emit;
+    const emit_method_table_t *m = &NATIVE_EMITTER(method_table);
+    jit->next_label = 0;
+    jit->block_sp = 0;
+    m->start_pass(emit, pass, jit->scope);
+    uint dynamic_label = JIT_FIRST_LABEL + jit->n_static_labels;
+
+    bool reachable = true;
+    byte prev_op = MP_BC_LOAD_NULL;
+    for (const byte *ip = jit->code; ip < jit->code_end && !jit->failed;) {
+        jit_target_t *t = &jit->targets[ip - jit->code];
+        mp_int_t depth = NATIVE_EMITTER(get_stack_size)(emit);
+
+        // the handler of an exception block, or the exit of a for loop
+        if (t->block_kind != JIT_BLOCK_NONE && t->block_kind != JIT_BLOCK_WITH) {
+            if (t->block_depth >= 0 && t->block_depth != depth) {
+                if (reachable) {
+                    jit->failed = true;
+                    break;
+                }
+                jit_adjust_depth(jit, t->block_depth);
+            }
+            m->label_assign(emit, t->block_label);
+            if (t->block_kind == JIT_BLOCK_EXCEPT) {
+                m->start_except_handler(emit);
+            } else if (t->block_kind == JIT_BLOCK_FOR) {
+                m->for_iter_end(emit);
+            }
+            reachable = true;
+            depth = NATIVE_EMITTER(get_stack_size)(emit);
+        }
+
+        // the destination of jumps
+        if (t->label != 0) {
+            if (t->depth < 0) {
+                t->depth = depth;
+            } else if (t->depth != depth) {
+                if (reachable) {
+                    jit->failed = true;
+                    break;
+                }
+                jit_adjust_depth(jit, t->depth);
+                depth = t->depth;
+            }
+            m->label_assign(emit, t->label);
+            reachable = true;
+        }
+
+        jit_insn_t insn;
+        const byte *next = jit_decode(ip, jit->const_table, &insn);
+        if (!reachable && (mp_uint_t)depth < jit_insn_pops(&insn)) {
+            jit_adjust_depth(jit, jit_insn_pops(&insn));
+            depth = jit_insn_pops(&insn);
+        }
+        jit_target_t *dest = insn.target == NULL ? NULL : &jit->targets[insn.target - jit->code];
+
+        switch (insn.op) {
+            case MP_BC_LOAD_CONST_FALSE:
+                m->load_const_tok(emit, MP_TOKEN_KW_FALSE);
+                break;
+            case MP_BC_LOAD_CONST_NONE:
+                m->load_const_tok(emit, MP_TOKEN_KW_NONE);
+                break;
+            case MP_BC_LOAD_CONST_TRUE:
+                m->load_const_tok(emit, MP_TOKEN_KW_TRUE);
+                break;
+            case MP_BC_LOAD_CONST_SMALL_INT:
+                m->load_const_small_int(emit, insn.num);
+                break;
+            case MP_BC_LOAD_CONST_STRING:
+                m->load_const_str(emit, insn.qst);
+                break;
+            case MP_BC_LOAD_CONST_OBJ:
+                m->load_const_obj(emit, (mp_obj_t)insn.ptr);
+                break;
+            case MP_BC_LOAD_NULL:
+                m->load_null(emit);
+                break;
+            case MP_BC_LOAD_FAST_N:
+                m->load_id.local(emit, MP_QSTR_, insn.arg, MP_EMIT_IDOP_LOCAL_FAST);
+                break;
+            case MP_BC_LOAD_DEREF:
+                m->load_id.local(emit, MP_QSTR_, insn.arg, MP_EMIT_IDOP_LOCAL_DEREF);
+                break;
+            case MP_BC_LOAD_NAME:
+                m->load_id.global(emit, insn.qst, MP_EMIT_IDOP_GLOBAL_NAME);
+                break;
+            case MP_BC_LOAD_GLOBAL:
+                m->load_id.global(emit, insn.qst, MP_EMIT_IDOP_GLOBAL_GLOBAL);
+                break;
+            case MP_BC_LOAD_ATTR:
+                m->attr(emit, insn.qst, MP_EMIT_ATTR_LOAD);
+                break;
+            case MP_BC_LOAD_METHOD:
+            case MP_BC_LOAD_SUPER_METHOD:
+                m->load_method(emit, insn.qst, insn.op == MP_BC_LOAD_SUPER_METHOD);
+                break;
+            case MP_BC_LOAD_BUILD_CLASS:
+                m->load_build_class(emit);
+                break;
+            case MP_BC_LOAD_SUBSCR:
+                m->subscr(emit, MP_EMIT_SUBSCR_LOAD);
+                break;
+            case MP_BC_STORE_FAST_N:
+                m->store_id.local(emit, MP_QSTR_, insn.arg, MP_EMIT_IDOP_LOCAL_FAST);
+                break;
+            case MP_BC_STORE_DEREF:
+                m->store_id.local(emit, MP_QSTR_, insn.arg, MP_EMIT_IDOP_LOCAL_DEREF);
+                break;
+            case MP_BC_STORE_NAME:
+                m->store_id.global(emit, insn.qst, MP_EMIT_IDOP_GLOBAL_NAME);
+                break;
+            case MP_BC_STORE_GLOBAL:
+                m->store_id.global(emit, insn.qst, MP_EMIT_IDOP_GLOBAL_GLOBAL);
+                break;
+            case MP_BC_STORE_ATTR:
+                // also does delete, with a NULL value
+                m->attr(emit, insn.qst, MP_EMIT_ATTR_STORE);
+                break;
+            case MP_BC_STORE_SUBSCR:
+                m->subscr(emit, MP_EMIT_SUBSCR_STORE);
+                break;
+            case MP_BC_DELETE_FAST:
+                m->delete_id.local(emit, MP_QSTR_, insn.arg, MP_EMIT_IDOP_LOCAL_FAST);
+                break;
+            case MP_BC_DELETE_DEREF:
+                m->delete_id.local(emit, MP_QSTR_, insn.arg, MP_EMIT_IDOP_LOCAL_DEREF);
+                break;
+            case MP_BC_DELETE_NAME:
+                m->delete_id.global(emit, insn.qst, MP_EMIT_IDOP_GLOBAL_NAME);
+                break;
+            case MP_BC_DELETE_GLOBAL:
+                m->delete_id.global(emit, insn.qst, MP_EMIT_IDOP_GLOBAL_GLOBAL);
+                break;
+            case MP_BC_DUP_TOP:
+                m->dup_top(emit);
+                break;
+            case MP_BC_DUP_TOP_TWO:
+                m->dup_top_two(emit);
+                break;
+            case MP_BC_POP_TOP:
+                m->pop_top(emit);
+                break;
+            case MP_BC_ROT_TWO:
+                m->rot_two(emit);
+                break;
+            case MP_BC_ROT_THREE:
+                m->rot_three(emit);
+                break;
+
+            case MP_BC_JUMP:
+                if (reachable) {
+                    jit_jump_depth(jit, insn.target, depth);
+                }
+                m->jump(emit, dest->label);
+                reachable = false;
+                break;
+            case MP_BC_POP_JUMP_IF_TRUE:
+            case MP_BC_POP_JUMP_IF_FALSE:
+                if (reachable) {
+                    jit_jump_depth(jit, insn.target, depth - 1);
+                }
+                m->pop_jump_if(emit, insn.op == MP_BC_POP_JUMP_IF_TRUE, dest->label);
+                break;
+            case MP_BC_JUMP_IF_TRUE_OR_POP:
+            case MP_BC_JUMP_IF_FALSE_OR_POP:
+                if (reachable) {
+                    jit_jump_depth(jit, insn.target, depth);
+                }
+                m->jump_if_or_pop(emit, insn.op == MP_BC_JUMP_IF_TRUE_OR_POP, dest->label);
+                break;
+            #if MICROPY_OPT_BYTECODE_SUPERINSTRUCTIONS
+            case MP_BC_COMPARE_POP_JUMP_IF_TRUE:
+            case MP_BC_COMPARE_POP_JUMP_IF_FALSE:
+                if (reachable) {
+                    jit_jump_depth(jit, insn.target, depth - 2);
+                }
+                m->binary_op(emit, insn.extra);
+                m->pop_jump_if(emit, insn.op == MP_BC_COMPARE_POP_JUMP_IF_TRUE, dest->label);
+                break;
+            #endif
+            case MP_BC_UNWIND_JUMP: {
+                // The destination is outside the blocks being unwound, and
+                // outside the for loop too if the jump breaks out of one.
+                // Code before it may be unreachable, so its depth is taken
+                // from the block stack.
+                mp_uint_t unum = insn.extra & 0x7f;
+                if (reachable) {
+                    if (unum > jit->block_sp) {
+                        jit->failed = true;
+                        break;
+                    }
+                    mp_int_t dest_depth = unum == 0 ? depth : jit->block_base[jit->block_sp - unum];
+                    if (insn.extra & 0x80) {
+                        dest_depth -= MP_OBJ_ITER_BUF_NSLOTS;
+                    }
+                    jit_jump_depth(jit, insn.target, dest_depth);
+                }
+                mp_uint_t label = dest->label;
+                if (insn.extra & 0x80) {
+                    label |= MP_EMIT_BREAK_FROM_FOR;
+                }
+                m->unwind_jump(emit, label, unum);
+                reachable = false;
+                break;
+            }
+
+            case MP_BC_SETUP_WITH:
+                // the context manager is consumed by the with statement
+                jit_push_block(jit, depth - 1);
+                m->setup_block(emit, dest->block_label, MP_EMIT_SETUP_BLOCK_WITH);
+                // the value from __enter__ is stored or popped before the body
+                dest->block_depth = NATIVE_EMITTER(get_stack_size)(emit) - 1;
+                break;
+            case MP_BC_SETUP_EXCEPT:
+                // async with loads __aexit__ and self to keep under its block
+                jit_push_block(jit, prev_op == MP_BC_LOAD_METHOD ? depth - 2 : depth);
+                m->setup_block(emit, dest->block_label, MP_EMIT_SETUP_BLOCK_EXCEPT);
+                dest->block_depth = depth;
+                break;
+            case MP_BC_SETUP_FINALLY:
+                jit_push_block(jit, depth);
+                m->setup_block(emit, dest->block_label, MP_EMIT_SETUP_BLOCK_FINALLY);
+                // the finally block is entered with None (or the exception) pushed
+                dest->block_depth = depth + 1;
+                break;
+            case MP_BC_POP_BLOCK: {
+                // the end of a with body is POP_BLOCK, LOAD_CONST_NONE and
+                // then WITH_CLEANUP at the destination of the SETUP_WITH
+                jit_target_t *t_cleanup = &jit->targets[ip + 2 - jit->code];
+                if (ip + 2 < jit->code_end && ip[1] == MP_BC_LOAD_CONST_NONE
+                    && t_cleanup->block_kind == JIT_BLOCK_WITH && ip[2] == MP_BC_WITH_CLEANUP) {
+                    if (t_cleanup->block_depth >= 0 && t_cleanup->block_depth != depth) {
+                        if (reachable) {
+                            jit->failed = true;
+                            break;
+                        }
+                        jit_adjust_depth(jit, t_cleanup->block_depth);
+                    }
+                    m->with_cleanup(emit, t_cleanup->block_label);
+                    next = ip + 3;
+                    reachable = true;
+                } else {
+                    m->pop_block(emit);
+                }
+                break;
+            }
+            case MP_BC_END_FINALLY:
+                // the compiler leaves the block here, even in unreachable code
+                if (jit->block_sp == 0) {
+                    jit->failed = true;
+                    break;
+                }
+                jit->block_sp -= 1;
+                jit->next_label = dynamic_label;
+                m->end_finally(emit);
+                dynamic_label += 2;
+                break;
+            case MP_BC_POP_EXCEPT:
+                m->pop_except(emit);
+                break;
+            case MP_BC_GET_ITER:
+            case MP_BC_GET_ITER_STACK:
+                m->get_iter(emit, insn.op == MP_BC_GET_ITER_STACK);
+                break;
+            case MP_BC_FOR_ITER:
+                // the loop exits with the iterator still on the stack
+                dest->block_depth = depth;
+                m->for_iter(emit, dest->block_label);
+                break;
+
+            case MP_BC_UNARY_OP_MULTI:
+                m->unary_op(emit, insn.arg);
+                break;
+            case MP_BC_BINARY_OP_MULTI:
+                m->binary_op(emit, insn.arg);
+                break;
+
+            case MP_BC_BUILD_TUPLE:
+                m->build(emit, insn.arg, MP_EMIT_BUILD_TUPLE);
+                break;
+            case MP_BC_BUILD_LIST:
+                m->build(emit, insn.arg, MP_EMIT_BUILD_LIST);
+                break;
+            case MP_BC_BUILD_MAP:
+                m->build(emit, insn.arg, MP_EMIT_BUILD_MAP);
+                break;
+            #if MICROPY_PY_BUILTINS_SET
+            case MP_BC_BUILD_SET:
+                m->build(emit, insn.arg, MP_EMIT_BUILD_SET);
+                break;
+            #endif
+            #if MICROPY_PY_BUILTINS_SLICE
+            case MP_BC_BUILD_SLICE:
+                m->build(emit, insn.arg, MP_EMIT_BUILD_SLICE);
+                break;
+            #endif
+            case MP_BC_STORE_MAP:
+                m->store_map(emit);
+                break;
+            case MP_BC_STORE_COMP: {
+                // see mp_emit_bc_store_comp() for the encoding
+                mp_uint_t index = insn.arg >> 2;
+                scope_kind_t kind;
+                if ((insn.arg & 3) == 0) {
+                    kind = SCOPE_LIST_COMP;
+                } else if ((insn.arg & 3) == 1) {
+                    kind = SCOPE_DICT_COMP;
+                    index -= 1;
+                } else {
+                    kind = SCOPE_SET_COMP;
+                }
+                m->store_comp(emit, kind, index);
+                break;
+            }
+            case MP_BC_UNPACK_SEQUENCE:
+                m->unpack_sequence(emit, insn.arg);
+                break;
+            case MP_BC_UNPACK_EX:
+                m->unpack_ex(emit, insn.arg & 0xff, insn.arg >> 8);
+                break;
+
+            case MP_BC_MAKE_FUNCTION:
+            case MP_BC_MAKE_FUNCTION_DEFARGS:
+            case MP_BC_MAKE_CLOSURE:
+            case MP_BC_MAKE_CLOSURE_DEFARGS: {
+                // the emitter only needs the raw code of the child scope
+                scope_t child;
+                child.raw_code = (mp_raw_code_t*)insn.ptr;
+                mp_uint_t n_defaults = insn.op == MP_BC_MAKE_FUNCTION_DEFARGS || insn.op == MP_BC_MAKE_CLOSURE_DEFARGS;
+                if (insn.op <= MP_BC_MAKE_FUNCTION_DEFARGS) {
+                    m->make_function(emit, &child, n_defaults, 0);
+                } else {
+                    m->make_closure(emit, &child, insn.extra, n_defaults, 0);
+                }
+                break;
+            }
+            case MP_BC_CALL_FUNCTION:
+            case MP_BC_CALL_FUNCTION_VAR_KW:
+            case MP_BC_CALL_METHOD:
+            case MP_BC_CALL_METHOD_VAR_KW: {
+                mp_uint_t star_flags = 0;
+                if (insn.op == MP_BC_CALL_FUNCTION_VAR_KW || insn.op == MP_BC_CALL_METHOD_VAR_KW) {
+                    star_flags = MP_EMIT_STAR_FLAG_SINGLE | MP_EMIT_STAR_FLAG_DOUBLE;
+                }
+                if (insn.op <= MP_BC_CALL_FUNCTION_VAR_KW) {
+                    m->call_function(emit, insn.arg & 0xff, insn.arg >> 8, star_flags);
+                } else {
+                    m->call_method(emit, insn.arg & 0xff, insn.arg >> 8, star_flags);
+                }
+                break;
+            }
+            case MP_BC_RETURN_VALUE:
+                m->return_value(emit);
+                reachable = false;
+                break;
+            case MP_BC_RAISE_VARARGS:
+                m->raise_varargs(emit, insn.arg);
+                reachable = false;
+                break;
+            case MP_BC_YIELD_VALUE:
+            case MP_BC_YIELD_FROM:
+                jit->next_label = dynamic_label;
+                m->yield(emit, insn.op == MP_BC_YIELD_VALUE ? MP_EMIT_YIELD_VALUE : MP_EMIT_YIELD_FROM);
+                dynamic_label += insn.op == MP_BC_YIELD_VALUE ? 2 : 3;
+                break;
+
+            case MP_BC_IMPORT_NAME:
+                m->import(emit, insn.qst, MP_EMIT_IMPORT_NAME);
+                break;
+            case MP_BC_IMPORT_FROM:
+                m->import(emit, insn.qst, MP_EMIT_IMPORT_FROM);
+                break;
+            case MP_BC_IMPORT_STAR:
+                m->import(emit, MP_QSTR_, MP_EMIT_IMPORT_STAR);
+                break;
+
+            #if MICROPY_OPT_BYTECODE_SUPERINSTRUCTIONS
+            case MP_BC_LOAD_FAST_ATTR_MULTI:
+                m->load_id.local(emit, MP_QSTR_, insn.arg, MP_EMIT_IDOP_LOCAL_FAST);
+                m->attr(emit, insn.qst, MP_EMIT_ATTR_LOAD);
+                break;
+            case MP_BC_LOAD_FAST_CONST_BINARY_OP:
+                m->load_id.local(emit, MP_QSTR_, insn.arg, MP_EMIT_IDOP_LOCAL_FAST);
+                m->load_const_small_int(emit, insn.num);
+                m->binary_op(emit, insn.extra);
+                break;
+            #endif
+
+            default:
+                // WITH_CLEANUP outside of the usual sequence
+                jit->failed = true;
+                break;
+        }
+        if (jit->error != MP_OBJ_NULL) {
+            jit->failed = true;
+        }
+        prev_op = insn.op;
+        ip = next;
+    }
+
+    if (!jit->failed) {
+        jit_adjust_depth(jit, 0);
+        m->end_pass(emit);
+    }
+}
+
+// Compile the bytecode of fun to native code.  The result is a raw code which
+// is MP_CODE_NATIVE_PY if that worked.
+STATIC mp_raw_code_t *jit_translate(mp_obj_fun_bc_t *fun) {
+    mp_raw_code_t *rc = mp_emit_glue_new_raw_code();
+
+    scope_t scope;
+    memset(&scope, 0, sizeof(scope));
+    scope.kind = SCOPE_FUNCTION;
+    scope.emit_options = MP_EMIT_OPT_NATIVE_PYTHON;
+    scope.raw_code = rc;
+
+    // decode the prelude
+    const byte *ip = fun->bytecode;
+    size_t n_state = mp_decode_uint(&ip);
+    scope.exc_stack_size = mp_decode_uint(&ip);
+    scope.scope_flags = *ip++;
+    scope.num_pos_args = *ip++;
+    scope.num_kwonly_args = *ip++;
+    scope.num_def_pos_args = *ip++;
+    const byte *code_info = ip;
+    size_t code_info_size = mp_decode_uint(&ip);
+    #if MICROPY_PERSISTENT_CODE
+    scope.simple_name = ip[0] | (ip[1] << 8);
+    scope.source_file = ip[2] | (ip[3] << 8);
+    #else
+    scope.simple_name = mp_decode_uint(&ip);
+    scope.source_file = mp_decode_uint(&ip);
+    #endif
+    ip = code_info + code_info_size;
+    const byte *cells = ip;
+    while (*ip != 255) {
+        ++ip;
+    }
+    size_t n_cells = ip - cells;
+
+    jit_t jit_state;
+    jit_t *jit = &jit_state;
+    memset(jit, 0, sizeof(*jit));
+    jit->scope = &scope;
+    jit->const_table = fun->const_table;
+    jit->code = ip + 1;
+
+    mp_uint_t n_dynamic_labels;
+    mp_uint_t num_locals = 0;
+    if (!jit_scan(jit, &n_dynamic_labels, &num_locals)) {
+        return rc;
+    }
+
+    size_t code_len = jit->code_end - jit->code;
+    jit->targets = m_new(jit_target_t, code_len);
+    for (size_t i = 0; i < code_len; ++i) {
+        jit->targets[i] = (jit_target_t){0, 0, -1, -1, JIT_BLOCK_NONE};
+    }
+    if (!jit_scan_targets(jit)) {
+        m_del(jit_target_t, jit->targets, code_len);
+        return rc;
+    }
+    jit->block_alloc = scope.exc_stack_size;
+    jit->block_base = m_new(int16_t, jit->block_alloc);
+
+    // make the identifiers the emitter needs: the arguments and the cells
+    mp_uint_t n_args = scope.num_pos_args + scope.num_kwonly_args;
+    if (scope.scope_flags & MP_SCOPE_FLAG_VARARGS) {
+        n_args += 1;
+    }
+    if (scope.scope_flags & MP_SCOPE_FLAG_VARKEYWORDS) {
+        n_args += 1;
+    }
+    scope.id_info_alloc = n_args + n_cells;
+    scope.id_info = m_new0(id_info_t, scope.id_info_alloc);
+    for (mp_uint_t i = 0; i < n_args; ++i) {
+        id_info_t *id = &scope.id_info[scope.id_info_len++];
+        id->kind = ID_INFO_KIND_LOCAL;
+        id->local_num = i;
+        id->qst = MP_QSTR__star_;
+        if (i < (mp_uint_t)scope.num_pos_args + scope.num_kwonly_args) {
+            id->qst = MP_OBJ_QSTR_VALUE(fun->const_table[i]);
+        }
+        // free variables are passed as arguments too, but have no name
+        if (id->qst != MP_QSTR__star_ || i >= (mp_uint_t)scope.num_pos_args + scope.num_kwonly_args) {
+            id->flags = ID_FLAG_IS_PARAM;
+        }
+    }
+    for (size_t i = 0; i < n_cells; ++i) {
+        if (cells[i] < n_args) {
+            scope.id_info[cells[i]].kind = ID_INFO_KIND_CELL;
+        } else {
+            id_info_t *id = &scope.id_info[scope.id_info_len++];
+            id->kind = ID_INFO_KIND_CELL;
+            id->local_num = cells[i];
+            id->qst = MP_QSTR_;
+        }
+        if (cells[i] + 1u > num_locals) {
+            num_locals = cells[i] + 1;
+        }
+    }
+    if (n_args > num_locals) {
+        num_locals = n_args;
+    }
+    scope.num_locals = num_locals;
+
+    // The emitter sizes its record of the stack from the scope on its first
+    // pass, so start with the bytecode's state size as a bound on that, and
+    // let the first pass work out the real size.
+    scope.stack_size = n_state;
+
+    uint max_num_labels = JIT_FIRST_LABEL + jit->n_static_labels + n_dynamic_labels;
+    jit->emit = NATIVE_EMITTER(new)(&jit->error, &jit->next_label, max_num_labels);
+    const emit_method_table_t *m = &NATIVE_EMITTER(method_table);
+    m->set_native_type(jit->emit, MP_EMIT_NATIVE_TYPE_ENABLE, false, 0);
+    m->set_native_type(jit->emit, MP_EMIT_NATIVE_TYPE_CHECK_UNBOUND, true, 0);
+
+    jit_emit_pass(jit, MP_PASS_STACK_SIZE);
+    if (!jit->failed) {
+        scope.stack_size = 0;
+        jit_emit_pass(jit, MP_PASS_STACK_SIZE);
+    }
+    if (!jit->failed) {
+        jit_emit_pass(jit, MP_PASS_CODE_SIZE);
+    }
+    if (!jit->failed) {
+        jit_emit_pass(jit, MP_PASS_EMIT);
+    }
+
+    NATIVE_EMITTER(free)(jit->emit);
+    m_del(id_info_t, scope.id_info, scope.id_info_alloc);
+    m_del(int16_t, jit->block_base, jit->block_alloc);
+    m_del(jit_target_t, jit->targets, code_len);
+    return rc;
+}
+
+mp_obj_t mp_jit_compile(mp_obj_fun_bc_t *fun) {
+    if (gc_is_locked()) {
+        // can't allocate, eg in a finaliser, so try again on the next call
+        return MP_OBJ_NULL;
+    }
+
+    nlr_buf_t nlr;
+    if (nlr_push(&nlr) != 0) {
+        // out of memory, most likely, which isn't for the caller to see, so
+        // leave the function with the VM for a while and then try again
+        fun->jit = MP_JIT_COUNTER_INIT;
+        return MP_OBJ_NULL;
+    }
+
+    // functions made from the same raw code share their native code
+    const byte *bytecode = fun->bytecode;
+    size_t idx = ((uintptr_t)bytecode >> 4) % MICROPY_EMIT_NATIVE_JIT_CACHE_SIZE;
+    mp_jit_cache_entry_t *entry = MP_STATE_VM(jit_cache)[idx];
+    mp_raw_code_t *rc;
+    if (entry != NULL && entry->bytecode == bytecode) {
+        rc = entry->rc;
+    } else {
+        rc = jit_translate(fun);
+        entry = m_new_obj(mp_jit_cache_entry_t);
+        entry->bytecode = bytecode;
+        entry->rc = rc;
+        MP_THREAD_STORE_FENCE();
+        MP_STATE_VM(jit_cache)[idx] = entry;
+    }
+
+    if (rc->kind != MP_CODE_NATIVE_PY) {
+        nlr_pop();
+        fun->jit = mp_const_none;
+        return MP_OBJ_NULL;
+    }
+
+    mp_obj_t def_args = MP_OBJ_NULL;
+    mp_obj_t def_kw_args = MP_OBJ_NULL;
+    const byte *ip = mp_decode_uint_skip(mp_decode_uint_skip(bytecode));
+    size_t scope_flags = ip[0];
+    size_t n_def_pos_args = ip[3];
+    if (n_def_pos_args > 0) {
+        def_args = mp_obj_new_tuple(n_def_pos_args, fun->extra_args);
+    }
+    if (scope_flags & MP_SCOPE_FLAG_DEFKWARGS) {
+        def_kw_args = fun->extra_args[n_def_pos_args];
+    }
+    mp_obj_fun_bc_t *native = MP_OBJ_TO_PTR(mp_obj_new_fun_native(def_args, def_kw_args,
+        rc->data.u_native.fun_data, rc->data.u_native.const_table));
+    nlr_pop();
+
+    native->globals = fun->globals;
+    // native code refers to the constants of the bytecode, keep them alive
+    native->jit = MP_OBJ_FROM_PTR(fun);
+    fun->jit = MP_OBJ_FROM_PTR(native);
+    return fun->jit;
+}
+
+void mp_jit_add_traceback(const mp_obj_fun_bc_t *fun, mp_obj_t exc) {
+    if (exc == MP_OBJ_FROM_PTR(&mp_const_GeneratorExit_obj)) {
+        return;
+    }
+    // native code doesn't keep track of its position in the bytecode, so the
+    // entry gives the line where the function starts
+    const byte *ip = fun->bytecode;
+    ip = mp_decode_uint_skip(ip); // skip n_state
+    ip = mp_decode_uint_skip(ip); // skip n_exc_stack
+    ip += 4; // skip scope_flags, n_pos_args, n_kwonly_args, n_def_pos_args
+    ip = mp_decode_uint_skip(ip); // skip code_info_size
+    #if MICROPY_PERSISTENT_CODE
+    qstr block_name = ip[0] | (ip[1] << 8);
+    qstr source_file = ip[2] | (ip[3] << 8);
+    ip += 4;
+    #else
+    qstr block_name = mp_decode_uint_value(ip);
+    ip = mp_decode_uint_skip(ip);
+    qstr source_file = mp_decode_uint_value(ip);
+    ip = mp_decode_uint_skip(ip);
+    #endif
+    size_t source_line = 1;
+    size_t c;
+    while ((c = *ip)) {
+        size_t b, l;
+        if ((c & 0x80) == 0) {
+            b = c & 0x1f;
+            l = c >> 5;
+            ip += 1;
+        } else {
+            b = c & 0xf;
+            l = ((c << 4) & 0x700) | ip[1];
+            ip += 2;
+        }
+        if (b > 0) {
+            break;
+        }
+        source_line += l;
+    }
+    mp_obj_exception_add_traceback(exc, source_file, source_line, block_name);
+}
+
+mp_obj_t mp_jit_call(mp_obj_fun_bc_t *fun, mp_obj_t native, size_t n_args, size_t n_kw, const mp_obj_t *args) {
+    mp_obj_fun_bc_t *self = MP_OBJ_TO_PTR(native);
+    mp_call_fun_t f = MICROPY_MAKE_POINTER_CALLABLE((void*)self->bytecode);
+
+    // native code looks up globals in the current context, like the VM does
+    // once fun_bc_call() has switched it
+    mp_obj_dict_t *old_globals = mp_globals_get();
+    mp_globals_set(fun->globals);
+    nlr_buf_t nlr;
+    if (nlr_push(&nlr) == 0) {
+        mp_obj_t ret = f(native, n_args, n_kw, args);
+        nlr_pop();
+        mp_globals_set(old_globals);
+        return ret;
+    } else {
+        mp_globals_set(old_globals);
+        mp_jit_add_traceback(fun, MP_OBJ_FROM_PTR(nlr.ret_val));
+        nlr_jump(nlr.ret_val);
+    }
+}
+
+#endif // MICROPY_EMIT_NATIVE_JIT
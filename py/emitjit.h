@@ -0,0 +1,76 @@
+/*
+ * This file is part of the MicroPython project, http://micropython.org/
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 Damien P. George
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#ifndef MICROPY_INCLUDED_PY_EMITJIT_H
+#define MICROPY_INCLUDED_PY_EMITJIT_H
+
+#include "py/objfun.h"
+
+#if MICROPY_EMIT_NATIVE_JIT
+
+// The jit entry of a bytecode function starts as a small int counting down the
+// calls and loop iterations left until the function is hot.  When it reaches
+// zero the bytecode is translated into calls to the native emitter, and the
+// entry then holds the resulting native function, or None if the bytecode
+// can't be compiled (in which case the function stays with the VM).  The jit
+// entry of that native function points back to the bytecode function, whose
+// constants the native code uses.
+#define MP_JIT_COUNTER_INIT MP_OBJ_NEW_SMALL_INT(MICROPY_EMIT_NATIVE_JIT_THRESHOLD)
+
+mp_obj_t mp_jit_compile(mp_obj_fun_bc_t *fun);
+mp_obj_t mp_jit_call(mp_obj_fun_bc_t *fun, mp_obj_t native, size_t n_args, size_t n_kw, const mp_obj_t *args);
+
+// Add the traceback entry for fun, whose native code raised exc, that the VM
+// would have added if it had run the bytecode.
+void mp_jit_add_traceback(const mp_obj_fun_bc_t *fun, mp_obj_t exc);
+
+// Count a backward jump taken by the VM.
+static inline void mp_jit_tick(mp_obj_fun_bc_t *fun) {
+    if (MP_OBJ_IS_SMALL_INT(fun->jit)) {
+        mp_int_t n = MP_OBJ_SMALL_INT_VALUE(fun->jit);
+        if (n > 0) {
+            fun->jit = MP_OBJ_NEW_SMALL_INT(n - 1);
+        }
+    }
+}
+
+// Count a call of fun, and return the native function to run instead of the
+// bytecode, or MP_OBJ_NULL if there isn't one (yet).
+static inline mp_obj_t mp_jit_get(mp_obj_fun_bc_t *fun) {
+    mp_obj_t jit = fun->jit;
+    if (MP_OBJ_IS_SMALL_INT(jit)) {
+        mp_int_t n = MP_OBJ_SMALL_INT_VALUE(jit);
+        if (n > 0) {
+            fun->jit = MP_OBJ_NEW_SMALL_INT(n - 1);
+            return MP_OBJ_NULL;
+        }
+        return mp_jit_compile(fun);
+    }
+    return jit == mp_const_none ? MP_OBJ_NULL : jit;
+}
+
+#endif // MICROPY_EMIT_NATIVE_JIT
+
+#endif // MICROPY_INCLUDED_PY_EMITJIT_H
@@ -84,6 +84,16 @@
         ASM_MOV_LOCAL_REG((as), (local_num), (reg_temp)); \
     } while (false)
 
+// Viper floats are unboxed, held as the bits of their mp_float_t in a machine
+// word, so they're only available when they fit.  On x64 with double precision
+// the arithmetic is done inline with SSE2, otherwise by helpers in the runtime.
+#if MICROPY_PY_BUILTINS_FLOAT && (MICROPY_FLOAT_IMPL == MICROPY_FLOAT_IMPL_FLOAT || N_X64)
+#define N_VIPER_FLOAT (1)
+#else
+#define N_VIPER_FLOAT (0)
+#endif
+#define N_VIPER_FLOAT_SSE (N_VIPER_FLOAT && N_X64 && MICROPY_FLOAT_IMPL == MICROPY_FLOAT_IMPL_DOUBLE)
+
 #define EMIT_NATIVE_VIPER_TYPE_ERROR(emit, ...) do { \
         *emit->error_slot = mp_obj_new_exception_msg_varg(&mp_type_ViperTypeError, __VA_ARGS__); \
     } while (0)
@@ -105,6 +115,8 @@ typedef enum {
     VTYPE_PTR8 = 0x00 | MP_NATIVE_TYPE_PTR8,
     VTYPE_PTR16 = 0x00 | MP_NATIVE_TYPE_PTR16,
     VTYPE_PTR32 = 0x00 | MP_NATIVE_TYPE_PTR32,
+    VTYPE_FLOAT = 0x00 | MP_NATIVE_TYPE_FLOAT,
+    VTYPE_PTR_F32 = 0x00 | MP_NATIVE_TYPE_PTR_F32,
 
     VTYPE_PTR_NONE = 0x50 | MP_NATIVE_TYPE_PTR,
 
@@ -122,6 +134,8 @@ STATIC qstr vtype_to_qstr(vtype_kind_t vtype) {
         case VTYPE_PTR8: return MP_QSTR_ptr8;
         case VTYPE_PTR16: return MP_QSTR_ptr16;
         case VTYPE_PTR32: return MP_QSTR_ptr32;
+        case VTYPE_FLOAT: return MP_QSTR_float;
+        case VTYPE_PTR_F32: return MP_QSTR_ptr_f32;
         case VTYPE_PTR_NONE: default: return MP_QSTR_None;
     }
 }
@@ -135,11 +149,39 @@ typedef struct _stack_info_t {
     } data;
 } stack_info_t;
 
+// An entry for each try/except, try/finally and with block that encloses the
+// code currently being emitted.
+typedef struct _exc_stack_entry_t {
+    mp_uint_t label;
+    bool is_finally; // finally and with blocks must run when unwinding
+    bool is_with;
+    bool is_active; // false once the handler (or finally block) is running
+    bool unwind_used; // some unwind jump goes through this finally block
+    bool unwind_final; // ... and for at least one of them it's the last one
+} exc_stack_entry_t;
+
+// Code can jump to a label based on an id held in a state slot, being the
+// label number plus one (so 0 is never a valid id).  These are the labels that
+// are reached this way.
+typedef enum {
+    DISPATCH_HANDLER, // handler of an exception block, via the global handler
+    DISPATCH_RESUME, // resume point of a generator, on re-entry
+    DISPATCH_UNWIND, // destination after a finally block, when unwinding
+} dispatch_kind_t;
+
+typedef struct _dispatch_entry_t {
+    uint16_t kind;
+    uint16_t exc_depth; // for DISPATCH_UNWIND, index of the finally block
+    mp_uint_t label;
+} dispatch_entry_t;
+
 struct _emit_t {
     mp_obj_t *error_slot;
+    uint *label_slot;
     int pass;
 
     bool do_viper_types;
+    bool check_unbound;
 
     vtype_kind_t return_vtype;
 
@@ -150,12 +192,29 @@ struct _emit_t {
     stack_info_t *stack_info;
     vtype_kind_t saved_stack_vtype;
 
+    size_t exc_stack_alloc;
+    size_t exc_stack_size;
+    exc_stack_entry_t *exc_stack;
+
+    size_t dispatch_alloc;
+    size_t dispatch_len;
+    dispatch_entry_t *dispatch;
+
     int prelude_offset;
     int const_table_offset;
     int n_state;
+    int n_exc_slots;
+    int state_start;
     int stack_start;
     int stack_size;
 
+    mp_uint_t exit_label;
+    mp_uint_t global_except_label;
+    mp_uint_t resume_label;
+    mp_uint_t start_label;
+    mp_uint_t unbound_label;
+
+    bool is_generator;
     bool last_emit_was_return_value;
 
     scope_t *scope;
@@ -163,9 +222,10 @@ struct _emit_t {
     ASM_T *as;
 };
 
-emit_t *EXPORT_FUN(new)(mp_obj_t *error_slot, mp_uint_t max_num_labels) {
+emit_t *EXPORT_FUN(new)(mp_obj_t *error_slot, uint *label_slot, mp_uint_t max_num_labels) {
     emit_t *emit = m_new0(emit_t, 1);
     emit->error_slot = error_slot;
+    emit->label_slot = label_slot;
     emit->as = m_new0(ASM_T, 1);
     mp_asm_base_init(&emit->as->base, max_num_labels);
     return emit;
@@ -176,15 +236,34 @@ void EXPORT_FUN(free)(emit_t *emit) {
     m_del_obj(ASM_T, emit->as);
     m_del(vtype_kind_t, emit->local_vtype, emit->local_vtype_alloc);
     m_del(stack_info_t, emit->stack_info, emit->stack_info_alloc);
+    m_del(exc_stack_entry_t, emit->exc_stack, emit->exc_stack_alloc);
+    m_del(dispatch_entry_t, emit->dispatch, emit->dispatch_alloc);
     m_del_obj(emit_t, emit);
 }
 
+#if MICROPY_EMIT_NATIVE_JIT
+// The JIT replays bytecode without the compiler's stack bookkeeping, so it
+// follows the stack depth through the emitter.
+mp_uint_t EXPORT_FUN(get_stack_size)(emit_t *emit) {
+    return emit->stack_size;
+}
+#endif
+
 STATIC void emit_native_set_native_type(emit_t *emit, mp_uint_t op, mp_uint_t arg1, qstr arg2) {
     switch (op) {
         case MP_EMIT_NATIVE_TYPE_ENABLE:
             emit->do_viper_types = arg1;
             break;
 
+        #if MICROPY_EMIT_NATIVE_JIT
+        case MP_EMIT_NATIVE_TYPE_CHECK_UNBOUND:
+            // Code compiled from bytecode may load a local before it's stored
+            // to, or after it's deleted, and must raise NameError like the VM.
+            // Locals are then NULL when unbound, rather than None.
+            emit->check_unbound = arg1;
+            break;
+        #endif
+
         default: {
             vtype_kind_t type;
             switch (arg2) {
@@ -196,6 +275,10 @@ STATIC void emit_native_set_native_type(emit_t *emit, mp_uint_t op, mp_uint_t ar
                 case MP_QSTR_ptr8: type = VTYPE_PTR8; break;
                 case MP_QSTR_ptr16: type = VTYPE_PTR16; break;
                 case MP_QSTR_ptr32: type = VTYPE_PTR32; break;
+                #if N_VIPER_FLOAT
+                case MP_QSTR_float: type = VTYPE_FLOAT; break;
+                case MP_QSTR_ptr_f32: type = VTYPE_PTR_F32; break;
+                #endif
                 default: EMIT_NATIVE_VIPER_TYPE_ERROR(emit, translate("unknown type '%q'"), arg2); return;
             }
             if (op == MP_EMIT_NATIVE_TYPE_RETURN) {
@@ -213,9 +296,199 @@ STATIC void emit_pre_pop_reg(emit_t *emit, vtype_kind_t *vtype, int reg_dest);
 STATIC void emit_post_push_reg(emit_t *emit, vtype_kind_t vtype, int reg);
 STATIC void emit_native_load_fast(emit_t *emit, qstr qst, mp_uint_t local_num);
 STATIC void emit_native_store_fast(emit_t *emit, qstr qst, mp_uint_t local_num);
+STATIC void emit_native_pop_top(emit_t *emit);
 
 #define STATE_START (sizeof(mp_code_state_t) / sizeof(mp_uint_t))
 
+// The nlr_buf_t used for catching exceptions sits at the start of the C stack
+// frame, and its ret_val entry holds the exception being handled (or thrown
+// into a generator, or sent back from a "yield from").
+#define NLR_BUF_NWORDS (sizeof(nlr_buf_t) / sizeof(uintptr_t))
+#define LOCAL_IDX_EXC_VAL(emit) (offsetof(nlr_buf_t, ret_val) / sizeof(uintptr_t))
+
+// Slots in the state used for exception handling, which come before the
+// Python stack.  Each exception block has an unwind slot holding the id of
+// where to go after its finally block, the handler id to restore when that's
+// the end of the unwind, and the exception that its except clauses handle.
+#define LOCAL_IDX_EXC_HANDLER(emit) ((emit)->state_start + 0)
+#define LOCAL_IDX_RET_VAL(emit) ((emit)->state_start + 1)
+#define LOCAL_IDX_UNWIND(emit, idx) ((emit)->state_start + 2 + 3 * (idx))
+#define LOCAL_IDX_UNWIND_HANDLER(emit, idx) ((emit)->state_start + 3 + 3 * (idx))
+#define LOCAL_IDX_CUR_EXC(emit, idx) ((emit)->state_start + 4 + 3 * (idx))
+#define LOCAL_IDX_LOCAL_VAR(emit, local_num) ((emit)->state_start + (emit)->n_state - 1 - (local_num))
+
+// A function with exception blocks, or a generator, has one nlr_buf_t for the
+// whole function and dispatches caught exceptions to the active handler.
+// Registers are not preserved across a caught exception, so locals can only
+// be cached in registers when there is no such handler.
+#define NEED_GLOBAL_EXC_HANDLER(emit) ((emit)->scope->exc_stack_size > 0 || (emit)->is_generator)
+#define CAN_USE_REGS_FOR_LOCALS(emit) (!NEED_GLOBAL_EXC_HANDLER(emit))
+
+// A generator's state lives in its heap-allocated code_state, a pointer to
+// which is kept in this register.
+#define REG_GENERATOR_STATE (REG_LOCAL_3)
+
+STATIC const uint8_t reg_local_table[REG_LOCAL_NUM] = {REG_LOCAL_1, REG_LOCAL_2, REG_LOCAL_3};
+
+// Moves between registers and slots of the state, which is either on the C
+// stack or (for generators) pointed to by REG_GENERATOR_STATE.
+STATIC void emit_native_mov_state_reg(emit_t *emit, int local_num, int reg_src) {
+    if (emit->is_generator) {
+        ASM_STORE_REG_REG_OFFSET(emit->as, reg_src, REG_GENERATOR_STATE, local_num);
+    } else {
+        ASM_MOV_LOCAL_REG(emit->as, local_num, reg_src);
+    }
+}
+
+STATIC void emit_native_mov_reg_state(emit_t *emit, int reg_dest, int local_num) {
+    if (emit->is_generator) {
+        ASM_LOAD_REG_REG_OFFSET(emit->as, reg_dest, REG_GENERATOR_STATE, local_num);
+    } else {
+        ASM_MOV_REG_LOCAL(emit->as, reg_dest, local_num);
+    }
+}
+
+STATIC void emit_native_mov_state_imm_via(emit_t *emit, int local_num, mp_uint_t imm, int reg_temp) {
+    ASM_MOV_REG_IMM(emit->as, reg_temp, imm);
+    emit_native_mov_state_reg(emit, local_num, reg_temp);
+}
+
+STATIC void emit_native_mov_reg_state_addr(emit_t *emit, int reg_dest, int local_num) {
+    if (emit->is_generator) {
+        ASM_MOV_REG_IMM(emit->as, reg_dest, local_num * ASM_WORD_SIZE);
+        ASM_ADD_REG_REG(emit->as, reg_dest, REG_GENERATOR_STATE);
+    } else {
+        ASM_MOV_REG_LOCAL_ADDR(emit->as, reg_dest, local_num);
+    }
+}
+
+STATIC void emit_native_add_dispatch(emit_t *emit, dispatch_kind_t kind, size_t exc_depth, mp_uint_t label) {
+    if (kind == DISPATCH_UNWIND) {
+        // several unwind jumps can share a destination
+        for (size_t i = 0; i < emit->dispatch_len; i++) {
+            dispatch_entry_t *d = &emit->dispatch[i];
+            if (d->kind == kind && d->exc_depth == exc_depth && d->label == label) {
+                return;
+            }
+        }
+    }
+    if (emit->dispatch_len >= emit->dispatch_alloc) {
+        emit->dispatch = m_renew(dispatch_entry_t, emit->dispatch, emit->dispatch_alloc, emit->dispatch_alloc + 8);
+        emit->dispatch_alloc += 8;
+    }
+    dispatch_entry_t *d = &emit->dispatch[emit->dispatch_len++];
+    d->kind = kind;
+    d->exc_depth = exc_depth;
+    d->label = label;
+}
+
+// Jump to the label of each dispatch entry of the given kind whose id matches
+// the value in reg, using reg_temp as scratch.  Falls through if none match.
+STATIC void emit_native_dispatch(emit_t *emit, dispatch_kind_t kind, size_t exc_depth, int reg, int reg_temp) {
+    for (size_t i = 0; i < emit->dispatch_len; i++) {
+        dispatch_entry_t *d = &emit->dispatch[i];
+        if (d->kind == kind && d->exc_depth == exc_depth) {
+            ASM_MOV_REG_IMM(emit->as, reg_temp, d->label + 1);
+            ASM_JUMP_IF_REG_EQ(emit->as, reg, reg_temp, d->label);
+        }
+    }
+}
+
+// Get the id of the handler for exceptions raised at exception depth idx.
+STATIC mp_uint_t emit_native_exc_handler_id(emit_t *emit, int idx) {
+    for (; idx >= 0; --idx) {
+        if (emit->exc_stack[idx].is_active) {
+            return emit->exc_stack[idx].label + 1;
+        }
+    }
+    return 0;
+}
+
+STATIC void emit_native_push_exc_stack(emit_t *emit, mp_uint_t label, bool is_finally, bool is_with) {
+    assert(emit->exc_stack_size < emit->exc_stack_alloc);
+    exc_stack_entry_t *e = &emit->exc_stack[emit->exc_stack_size++];
+    e->label = label;
+    e->is_finally = is_finally;
+    e->is_with = is_with;
+    e->is_active = true;
+    e->unwind_used = false;
+    e->unwind_final = false;
+
+    // exceptions are now caught by this block
+    emit_native_mov_state_imm_via(emit, LOCAL_IDX_EXC_HANDLER(emit), label + 1, REG_TEMP0);
+    emit_native_add_dispatch(emit, DISPATCH_HANDLER, 0, label);
+}
+
+// The innermost exception block is no longer catching exceptions (its body
+// finished, or its handler started) so pass them to the next active one.
+STATIC void emit_native_leave_exc_stack(emit_t *emit) {
+    assert(emit->exc_stack_size > 0);
+    int idx = emit->exc_stack_size - 1;
+    emit->exc_stack[idx].is_active = false;
+    emit_native_mov_state_imm_via(emit, LOCAL_IDX_EXC_HANDLER(emit), emit_native_exc_handler_id(emit, idx), REG_TEMP0);
+}
+
+STATIC void emit_native_global_exc_entry(emit_t *emit) {
+    if (!NEED_GLOBAL_EXC_HANDLER(emit)) {
+        return;
+    }
+
+    // catch all exceptions raised within this function
+    ASM_MOV_REG_LOCAL_ADDR(emit->as, REG_ARG_1, 0);
+    ASM_CALL_IND(emit->as, mp_fun_table[MP_F_NLR_PUSH], MP_F_NLR_PUSH);
+    ASM_JUMP_IF_REG_NONZERO(emit->as, REG_RET, emit->global_except_label);
+
+    if (emit->is_generator) {
+        // go to where the generator last yielded, or to the start
+        ASM_JUMP(emit->as, emit->resume_label);
+        mp_asm_base_label_assign(&emit->as->base, emit->start_label);
+    }
+}
+
+STATIC void emit_native_global_exc_exit(emit_t *emit) {
+    // normal exit, with the return value in its state slot
+    mp_asm_base_label_assign(&emit->as->base, emit->exit_label);
+    ASM_CALL_IND(emit->as, mp_fun_table[MP_F_NLR_POP], MP_F_NLR_POP);
+    if (emit->is_generator) {
+        emit_native_mov_reg_state_addr(emit, REG_TEMP0, LOCAL_IDX_RET_VAL(emit));
+        ASM_STORE_REG_REG_OFFSET(emit->as, REG_TEMP0, REG_GENERATOR_STATE, offsetof(mp_code_state_t, sp) / sizeof(uintptr_t));
+        ASM_MOV_REG_IMM(emit->as, REG_RET, MP_VM_RETURN_NORMAL);
+    } else {
+        emit_native_mov_reg_state(emit, REG_RET, LOCAL_IDX_RET_VAL(emit));
+    }
+    ASM_EXIT(emit->as);
+
+    // an exception was caught: re-arm the nlr_buf (the handler may raise
+    // again) and jump to the active handler, if there is one
+    mp_asm_base_label_assign(&emit->as->base, emit->global_except_label);
+    ASM_MOV_REG_LOCAL_ADDR(emit->as, REG_ARG_1, 0);
+    ASM_CALL_IND(emit->as, mp_fun_table[MP_F_NLR_PUSH], MP_F_NLR_PUSH);
+    ASM_JUMP_IF_REG_NONZERO(emit->as, REG_RET, emit->global_except_label);
+    emit_native_mov_reg_state(emit, REG_ARG_1, LOCAL_IDX_EXC_HANDLER(emit));
+    emit_native_dispatch(emit, DISPATCH_HANDLER, 0, REG_ARG_1, REG_ARG_2);
+
+    // no active handler, so the exception propagates out of this function
+    ASM_CALL_IND(emit->as, mp_fun_table[MP_F_NLR_POP], MP_F_NLR_POP);
+    ASM_MOV_REG_LOCAL(emit->as, REG_ARG_1, LOCAL_IDX_EXC_VAL(emit));
+    if (emit->is_generator) {
+        // the generator object expects the exception in the last state slot
+        emit_native_mov_state_reg(emit, emit->state_start + emit->n_state - 1, REG_ARG_1);
+        ASM_MOV_REG_IMM(emit->as, REG_RET, MP_VM_RETURN_EXCEPTION);
+        ASM_EXIT(emit->as);
+
+        // (re-)entry to the generator: resume after the yield it stopped at
+        mp_asm_base_label_assign(&emit->as->base, emit->resume_label);
+        ASM_LOAD_REG_REG_OFFSET(emit->as, REG_ARG_1, REG_GENERATOR_STATE, offsetof(mp_code_state_t, ip) / sizeof(uintptr_t));
+        emit_native_dispatch(emit, DISPATCH_RESUME, 0, REG_ARG_1, REG_ARG_2);
+
+        // otherwise it's the first run, so raise any exception thrown in
+        ASM_MOV_REG_LOCAL(emit->as, REG_ARG_1, LOCAL_IDX_EXC_VAL(emit));
+        ASM_MOV_REG_IMM(emit->as, REG_ARG_2, 0);
+        ASM_JUMP_IF_REG_EQ(emit->as, REG_ARG_1, REG_ARG_2, emit->start_label);
+    }
+    ASM_CALL_IND(emit->as, mp_fun_table[MP_F_NATIVE_RAISE], MP_F_NATIVE_RAISE);
+}
+
 STATIC void emit_native_start_pass(emit_t *emit, pass_kind_t pass, scope_t *scope) {
     DEBUG_printf("start_pass(pass=%u, scope=%p)\n", pass, scope);
 
@@ -224,6 +497,7 @@ STATIC void emit_native_start_pass(emit_t *emit, pass_kind_t pass, scope_t *scop
     emit->stack_size = 0;
     emit->last_emit_was_return_value = false;
     emit->scope = scope;
+    emit->is_generator = (scope->scope_flags & MP_SCOPE_FLAG_GENERATOR) && !emit->do_viper_types;
 
     // allocate memory for keeping track of the types of locals
     if (emit->local_vtype_alloc < scope->num_locals) {
@@ -239,6 +513,23 @@ STATIC void emit_native_start_pass(emit_t *emit, pass_kind_t pass, scope_t *scop
         emit->stack_info = m_new(stack_info_t, emit->stack_info_alloc);
     }
 
+    // allocate memory for keeping track of the exception blocks
+    if (emit->exc_stack_alloc < scope->exc_stack_size) {
+        emit->exc_stack = m_renew(exc_stack_entry_t, emit->exc_stack, emit->exc_stack_alloc, scope->exc_stack_size);
+        emit->exc_stack_alloc = scope->exc_stack_size;
+    }
+    emit->exc_stack_size = 0;
+    emit->dispatch_len = 0;
+
+    // the compiler reserves these labels for us at the start of each scope
+    mp_uint_t label_base = *emit->label_slot;
+    emit->exit_label = label_base;
+    emit->global_except_label = label_base + 1;
+    emit->resume_label = label_base + 2;
+    emit->start_label = label_base + 3;
+    // with check_unbound the JIT reserves one more, for raising NameError
+    emit->unbound_label = label_base + 4;
+
     // set default type for return
     emit->return_vtype = VTYPE_PYOBJ;
 
@@ -267,6 +558,10 @@ STATIC void emit_native_start_pass(emit_t *emit, pass_kind_t pass, scope_t *scop
 
     mp_asm_base_start_pass(&emit->as->base, pass == MP_PASS_EMIT ? MP_ASM_PASS_EMIT : MP_ASM_PASS_COMPUTE);
 
+    // work out size of state: exception handling slots, then stack, then locals
+    emit->n_exc_slots = NEED_GLOBAL_EXC_HANDLER(emit) ? 2 + 3 * scope->exc_stack_size : 0;
+    emit->n_state = emit->n_exc_slots + scope->num_locals + scope->stack_size;
+
     // generate code for entry to function
 
     if (emit->do_viper_types) {
@@ -277,17 +572,10 @@ STATIC void emit_native_start_pass(emit_t *emit, pass_kind_t pass, scope_t *scop
             return;
         }
 
-        // entry to function
-        int num_locals = 0;
-        if (pass > MP_PASS_SCOPE) {
-            num_locals = scope->num_locals - REG_LOCAL_NUM;
-            if (num_locals < 0) {
-                num_locals = 0;
-            }
-            emit->stack_start = num_locals;
-            num_locals += scope->stack_size;
-        }
-        ASM_ENTRY(emit->as, num_locals);
+        // entry to function, with the state on the C stack after the nlr_buf
+        emit->state_start = NEED_GLOBAL_EXC_HANDLER(emit) ? NLR_BUF_NWORDS : 0;
+        emit->stack_start = emit->state_start + emit->n_exc_slots;
+        ASM_ENTRY(emit->as, emit->state_start + emit->n_state);
 
         // TODO don't load r7 if we don't need it
         #if N_THUMB
@@ -298,38 +586,74 @@ STATIC void emit_native_start_pass(emit_t *emit, pass_kind_t pass, scope_t *scop
 
         #if N_X86
         for (int i = 0; i < scope->num_pos_args; i++) {
-            if (i == 0) {
-                asm_x86_mov_arg_to_r32(emit->as, i, REG_LOCAL_1);
-            } else if (i == 1) {
-                asm_x86_mov_arg_to_r32(emit->as, i, REG_LOCAL_2);
-            } else if (i == 2) {
-                asm_x86_mov_arg_to_r32(emit->as, i, REG_LOCAL_3);
+            if (i < REG_LOCAL_NUM && CAN_USE_REGS_FOR_LOCALS(emit)) {
+                asm_x86_mov_arg_to_r32(emit->as, i, reg_local_table[i]);
             } else {
                 asm_x86_mov_arg_to_r32(emit->as, i, REG_TEMP0);
-                asm_x86_mov_r32_to_local(emit->as, REG_TEMP0, i - REG_LOCAL_NUM);
+                asm_x86_mov_r32_to_local(emit->as, REG_TEMP0, LOCAL_IDX_LOCAL_VAR(emit, i));
             }
         }
         #else
+        STATIC const uint8_t reg_arg_table[4] = {REG_ARG_1, REG_ARG_2, REG_ARG_3, REG_ARG_4};
         for (int i = 0; i < scope->num_pos_args; i++) {
-            if (i == 0) {
-                ASM_MOV_REG_REG(emit->as, REG_LOCAL_1, REG_ARG_1);
-            } else if (i == 1) {
-                ASM_MOV_REG_REG(emit->as, REG_LOCAL_2, REG_ARG_2);
-            } else if (i == 2) {
-                ASM_MOV_REG_REG(emit->as, REG_LOCAL_3, REG_ARG_3);
+            if (i < REG_LOCAL_NUM && CAN_USE_REGS_FOR_LOCALS(emit)) {
+                ASM_MOV_REG_REG(emit->as, reg_local_table[i], reg_arg_table[i]);
             } else {
-                assert(i == 3); // should be true; max 4 args is checked above
-                ASM_MOV_LOCAL_REG(emit->as, i - REG_LOCAL_NUM, REG_ARG_4);
+                ASM_MOV_LOCAL_REG(emit->as, LOCAL_IDX_LOCAL_VAR(emit, i), reg_arg_table[i]);
             }
         }
         #endif
 
-    } else {
-        // work out size of state (locals plus stack)
-        emit->n_state = scope->num_locals + scope->stack_size;
+        if (NEED_GLOBAL_EXC_HANDLER(emit)) {
+            // no exception handler is active yet
+            ASM_MOV_LOCAL_IMM_VIA(emit->as, LOCAL_IDX_EXC_HANDLER(emit), 0, REG_TEMP0);
+        }
+        emit_native_global_exc_entry(emit);
+
+    } else if (emit->is_generator) {
+        // The state is in the generator object, which sets it up.  The first
+        // word of the code is the offset to the prelude, so the generator
+        // object can find it, and the entry point follows that word.  It's
+        // called as: mp_vm_return_kind_t f(mp_code_state_t*, mp_obj_t throw)
+        emit->state_start = STATE_START;
+        emit->stack_start = emit->state_start + emit->n_exc_slots;
+        mp_asm_base_data(&emit->as->base, ASM_WORD_SIZE, emit->prelude_offset);
+        ASM_ENTRY(emit->as, NLR_BUF_NWORDS);
+
+        // TODO don't load r7 if we don't need it
+        #if N_THUMB
+        asm_thumb_mov_reg_i32(emit->as, ASM_THUMB_REG_R7, (mp_uint_t)mp_fun_table);
+        #elif N_ARM
+        asm_arm_mov_reg_i32(emit->as, ASM_ARM_REG_R7, (mp_uint_t)mp_fun_table);
+        #endif
+
+        // keep the code_state pointer, and the thrown value in the exception slot
+        #if N_X86
+        asm_x86_mov_arg_to_r32(emit->as, 0, REG_GENERATOR_STATE);
+        asm_x86_mov_arg_to_r32(emit->as, 1, REG_TEMP0);
+        ASM_MOV_LOCAL_REG(emit->as, LOCAL_IDX_EXC_VAL(emit), REG_TEMP0);
+        #else
+        ASM_MOV_REG_REG(emit->as, REG_GENERATOR_STATE, REG_ARG_1);
+        ASM_MOV_LOCAL_REG(emit->as, LOCAL_IDX_EXC_VAL(emit), REG_ARG_2);
+        #endif
 
-        // allocate space on C-stack for code_state structure, which includes state
-        ASM_ENTRY(emit->as, STATE_START + emit->n_state);
+        emit_native_global_exc_entry(emit);
+
+        // set the type of closed over variables
+        for (mp_uint_t i = 0; i < scope->id_info_len; i++) {
+            id_info_t *id = &scope->id_info[i];
+            if (id->kind == ID_INFO_KIND_CELL) {
+                emit->local_vtype[id->local_num] = VTYPE_PYOBJ;
+            }
+        }
+
+    } else {
+        // the code_state structure, which includes the state, goes on the
+        // C stack after the nlr_buf
+        int code_state_start = NEED_GLOBAL_EXC_HANDLER(emit) ? NLR_BUF_NWORDS : 0;
+        emit->state_start = code_state_start + STATE_START;
+        emit->stack_start = emit->state_start + emit->n_exc_slots;
+        ASM_ENTRY(emit->as, emit->state_start + emit->n_state);
 
         // TODO don't load r7 if we don't need it
         #if N_THUMB
@@ -348,14 +672,14 @@ STATIC void emit_native_start_pass(emit_t *emit, pass_kind_t pass, scope_t *scop
         #endif
 
         // set code_state.fun_bc
-        ASM_MOV_LOCAL_REG(emit->as, offsetof(mp_code_state_t, fun_bc) / sizeof(uintptr_t), REG_ARG_1);
+        ASM_MOV_LOCAL_REG(emit->as, code_state_start + offsetof(mp_code_state_t, fun_bc) / sizeof(uintptr_t), REG_ARG_1);
 
         // set code_state.ip (offset from start of this function to prelude info)
         // XXX this encoding may change size
-        ASM_MOV_LOCAL_IMM_VIA(emit->as, offsetof(mp_code_state_t, ip) / sizeof(uintptr_t), emit->prelude_offset, REG_ARG_1);
+        ASM_MOV_LOCAL_IMM_VIA(emit->as, code_state_start + offsetof(mp_code_state_t, ip) / sizeof(uintptr_t), emit->prelude_offset, REG_ARG_1);
 
         // put address of code_state into first arg
-        ASM_MOV_REG_LOCAL_ADDR(emit->as, REG_ARG_1, 0);
+        ASM_MOV_REG_LOCAL_ADDR(emit->as, REG_ARG_1, code_state_start);
 
         // call mp_setup_code_state to prepare code_state structure
         #if N_THUMB
@@ -366,14 +690,12 @@ STATIC void emit_native_start_pass(emit_t *emit, pass_kind_t pass, scope_t *scop
         ASM_CALL_IND(emit->as, mp_fun_table[MP_F_SETUP_CODE_STATE], MP_F_SETUP_CODE_STATE);
         #endif
 
+        emit_native_global_exc_entry(emit);
+
         // cache some locals in registers
-        if (scope->num_locals > 0) {
-            ASM_MOV_REG_LOCAL(emit->as, REG_LOCAL_1, STATE_START + emit->n_state - 1 - 0);
-            if (scope->num_locals > 1) {
-                ASM_MOV_REG_LOCAL(emit->as, REG_LOCAL_2, STATE_START + emit->n_state - 1 - 1);
-                if (scope->num_locals > 2) {
-                    ASM_MOV_REG_LOCAL(emit->as, REG_LOCAL_3, STATE_START + emit->n_state - 1 - 2);
-                }
+        if (CAN_USE_REGS_FOR_LOCALS(emit)) {
+            for (int i = 0; i < REG_LOCAL_NUM && i < scope->num_locals; i++) {
+                ASM_MOV_REG_LOCAL(emit->as, reg_local_table[i], LOCAL_IDX_LOCAL_VAR(emit, i));
             }
         }
 
@@ -389,10 +711,19 @@ STATIC void emit_native_start_pass(emit_t *emit, pass_kind_t pass, scope_t *scop
 }
 
 STATIC void emit_native_end_pass(emit_t *emit) {
-    if (!emit->last_emit_was_return_value) {
+    if (NEED_GLOBAL_EXC_HANDLER(emit)) {
+        emit_native_global_exc_exit(emit);
+    } else if (!emit->last_emit_was_return_value) {
         ASM_EXIT(emit->as);
     }
 
+    #if MICROPY_EMIT_NATIVE_JIT
+    if (emit->check_unbound) {
+        mp_asm_base_label_assign(&emit->as->base, emit->unbound_label);
+        ASM_CALL_IND(emit->as, mp_fun_table[MP_F_NATIVE_RAISE_UNBOUND_LOCAL], MP_F_NATIVE_RAISE_UNBOUND_LOCAL);
+    }
+    #endif
+
     if (!emit->do_viper_types) {
         emit->prelude_offset = mp_asm_base_get_code_pos(&emit->as->base);
         mp_asm_base_data(&emit->as->base, 1, 0x80 | ((emit->n_state >> 7) & 0x7f));
@@ -411,7 +742,9 @@ STATIC void emit_native_end_pass(emit_t *emit) {
         mp_asm_base_data(&emit->as->base, 1, emit->scope->source_file);
         mp_asm_base_data(&emit->as->base, 1, emit->scope->source_file >> 8);
         #else
-        mp_asm_base_data(&emit->as->base, 1, 1);
+        mp_asm_base_data(&emit->as->base, 1, 3);
+        mp_asm_base_data(&emit->as->base, 1, 0x80 | ((emit->scope->simple_name >> 7) & 0x7f));
+        mp_asm_base_data(&emit->as->base, 1, emit->scope->simple_name & 0x7f);
         #endif
 
         // bytecode prelude: initialise closed over variables
@@ -538,7 +871,7 @@ STATIC void need_reg_single(emit_t *emit, int reg_needed, int skip_stack_pos) {
             stack_info_t *si = &emit->stack_info[i];
             if (si->kind == STACK_REG && si->data.u_reg == reg_needed) {
                 si->kind = STACK_VALUE;
-                ASM_MOV_LOCAL_REG(emit->as, emit->stack_start + i, si->data.u_reg);
+                emit_native_mov_state_reg(emit, emit->stack_start + i, si->data.u_reg);
             }
         }
     }
@@ -549,7 +882,7 @@ STATIC void need_reg_all(emit_t *emit) {
         stack_info_t *si = &emit->stack_info[i];
         if (si->kind == STACK_REG) {
             si->kind = STACK_VALUE;
-            ASM_MOV_LOCAL_REG(emit->as, emit->stack_start + i, si->data.u_reg);
+            emit_native_mov_state_reg(emit, emit->stack_start + i, si->data.u_reg);
         }
     }
 }
@@ -561,7 +894,7 @@ STATIC void need_stack_settled(emit_t *emit) {
         if (si->kind == STACK_REG) {
             DEBUG_printf("    reg(%u) to local(%u)\n", si->data.u_reg, emit->stack_start + i);
             si->kind = STACK_VALUE;
-            ASM_MOV_LOCAL_REG(emit->as, emit->stack_start + i, si->data.u_reg);
+            emit_native_mov_state_reg(emit, emit->stack_start + i, si->data.u_reg);
         }
     }
     for (int i = 0; i < emit->stack_size; i++) {
@@ -569,7 +902,7 @@ STATIC void need_stack_settled(emit_t *emit) {
         if (si->kind == STACK_IMM) {
             DEBUG_printf("    imm(" INT_FMT ") to local(%u)\n", si->data.u_imm, emit->stack_start + i);
             si->kind = STACK_VALUE;
-            ASM_MOV_LOCAL_IMM_VIA(emit->as, emit->stack_start + i, si->data.u_imm, REG_TEMP0);
+            emit_native_mov_state_imm_via(emit, emit->stack_start + i, si->data.u_imm, REG_TEMP0);
         }
     }
 }
@@ -581,7 +914,7 @@ STATIC void emit_access_stack(emit_t *emit, int pos, vtype_kind_t *vtype, int re
     *vtype = si->vtype;
     switch (si->kind) {
         case STACK_VALUE:
-            ASM_MOV_REG_LOCAL(emit->as, reg_dest, emit->stack_start + emit->stack_size - pos);
+            emit_native_mov_reg_state(emit, reg_dest, emit->stack_start + emit->stack_size - pos);
             break;
 
         case STACK_REG:
@@ -603,7 +936,7 @@ STATIC void emit_fold_stack_top(emit_t *emit, int reg_dest) {
     si[0] = si[1];
     if (si->kind == STACK_VALUE) {
         // if folded element was on the stack we need to put it in a register
-        ASM_MOV_REG_LOCAL(emit->as, reg_dest, emit->stack_start + emit->stack_size - 1);
+        emit_native_mov_reg_state(emit, reg_dest, emit->stack_start + emit->stack_size - 1);
         si->kind = STACK_REG;
         si->data.u_reg = reg_dest;
     }
@@ -740,21 +1073,25 @@ STATIC void emit_get_stack_pointer_to_reg_for_pop(emit_t *emit, mp_uint_t reg_de
             si->kind = STACK_VALUE;
             switch (si->vtype) {
                 case VTYPE_PYOBJ:
-                    ASM_MOV_LOCAL_IMM_VIA(emit->as, emit->stack_start + emit->stack_size - 1 - i, si->data.u_imm, reg_dest);
+                    emit_native_mov_state_imm_via(emit, emit->stack_start + emit->stack_size - 1 - i, si->data.u_imm, reg_dest);
                     break;
                 case VTYPE_BOOL:
                     if (si->data.u_imm == 0) {
-                        ASM_MOV_LOCAL_IMM_VIA(emit->as, emit->stack_start + emit->stack_size - 1 - i, (mp_uint_t)mp_const_false, reg_dest);
+                        emit_native_mov_state_imm_via(emit, emit->stack_start + emit->stack_size - 1 - i, (mp_uint_t)mp_const_false, reg_dest);
                     } else {
-                        ASM_MOV_LOCAL_IMM_VIA(emit->as, emit->stack_start + emit->stack_size - 1 - i, (mp_uint_t)mp_const_true, reg_dest);
+                        emit_native_mov_state_imm_via(emit, emit->stack_start + emit->stack_size - 1 - i, (mp_uint_t)mp_const_true, reg_dest);
                     }
                     si->vtype = VTYPE_PYOBJ;
                     break;
                 case VTYPE_INT:
                 case VTYPE_UINT:
-                    ASM_MOV_LOCAL_IMM_VIA(emit->as, emit->stack_start + emit->stack_size - 1 - i, (uintptr_t)MP_OBJ_NEW_SMALL_INT(si->data.u_imm), reg_dest);
+                    emit_native_mov_state_imm_via(emit, emit->stack_start + emit->stack_size - 1 - i, (uintptr_t)MP_OBJ_NEW_SMALL_INT(si->data.u_imm), reg_dest);
                     si->vtype = VTYPE_PYOBJ;
                     break;
+                case VTYPE_FLOAT:
+                    // store the bits, it's boxed below
+                    emit_native_mov_state_imm_via(emit, emit->stack_start + emit->stack_size - 1 - i, si->data.u_imm, reg_dest);
+                    break;
                 default:
                     // not handled
                     mp_raise_NotImplementedError(translate("conversion to object"));
@@ -770,9 +1107,9 @@ STATIC void emit_get_stack_pointer_to_reg_for_pop(emit_t *emit, mp_uint_t reg_de
         stack_info_t *si = &emit->stack_info[emit->stack_size - 1 - i];
         if (si->vtype != VTYPE_PYOBJ) {
             mp_uint_t local_num = emit->stack_start + emit->stack_size - 1 - i;
-            ASM_MOV_REG_LOCAL(emit->as, REG_ARG_1, local_num);
+            emit_native_mov_reg_state(emit, REG_ARG_1, local_num);
             emit_call_with_imm_arg(emit, MP_F_CONVERT_NATIVE_TO_OBJ, si->vtype, REG_ARG_2); // arg2 = type
-            ASM_MOV_LOCAL_REG(emit->as, local_num, REG_RET);
+            emit_native_mov_state_reg(emit, local_num, REG_RET);
             si->vtype = VTYPE_PYOBJ;
             DEBUG_printf("  convert_native_to_obj(local_num=" UINT_FMT ")\n", local_num);
         }
@@ -780,7 +1117,7 @@ STATIC void emit_get_stack_pointer_to_reg_for_pop(emit_t *emit, mp_uint_t reg_de
 
     // Adujust the stack for a pop of n_pop items, and load the stack pointer into reg_dest.
     adjust_stack(emit, -n_pop);
-    ASM_MOV_REG_LOCAL_ADDR(emit->as, reg_dest, emit->stack_start + emit->stack_size);
+    emit_native_mov_reg_state_addr(emit, reg_dest, emit->stack_start + emit->stack_size);
 }
 
 // vtype of all n_push objects is VTYPE_PYOBJ
@@ -790,17 +1127,40 @@ STATIC void emit_get_stack_pointer_to_reg_for_push(emit_t *emit, mp_uint_t reg_d
         emit->stack_info[emit->stack_size + i].kind = STACK_VALUE;
         emit->stack_info[emit->stack_size + i].vtype = VTYPE_PYOBJ;
     }
-    ASM_MOV_REG_LOCAL_ADDR(emit->as, reg_dest, emit->stack_start + emit->stack_size);
+    emit_native_mov_reg_state_addr(emit, reg_dest, emit->stack_start + emit->stack_size);
     adjust_stack(emit, n_push);
 }
 
 STATIC void emit_native_label_assign(emit_t *emit, mp_uint_t l) {
     DEBUG_printf("label_assign(" UINT_FMT ")\n", l);
+
+    bool is_finally = false;
+    if (emit->exc_stack_size > 0) {
+        exc_stack_entry_t *e = &emit->exc_stack[emit->exc_stack_size - 1];
+        is_finally = e->is_finally && !e->is_with && e->label == l;
+    }
+
     emit_native_pre(emit);
+    if (is_finally) {
+        // The None pushed before a finally block goes in the exception slot,
+        // which is where the exception (or the unwind marker) is when this
+        // block is jumped to.
+        emit_pre_pop_discard(emit);
+    }
     // need to commit stack because we can jump here from elsewhere
     need_stack_settled(emit);
+    if (is_finally) {
+        ASM_MOV_LOCAL_IMM_VIA(emit->as, LOCAL_IDX_EXC_VAL(emit), (mp_uint_t)mp_const_none, REG_TEMP0);
+    }
     mp_asm_base_label_assign(&emit->as->base, l);
     emit_post(emit);
+
+    if (is_finally) {
+        // the finally block runs with the next outer handler active
+        emit_native_leave_exc_stack(emit);
+        ASM_MOV_REG_LOCAL(emit->as, REG_TEMP0, LOCAL_IDX_EXC_VAL(emit));
+        emit_post_push_reg(emit, VTYPE_PYOBJ, REG_TEMP0);
+    }
 }
 
 STATIC void emit_native_import_name(emit_t *emit, qstr qst) {
@@ -922,6 +1282,13 @@ STATIC void emit_native_load_const_str(emit_t *emit, qstr qst) {
 
 STATIC void emit_native_load_const_obj(emit_t *emit, mp_obj_t obj) {
     emit_native_pre(emit);
+    #if N_VIPER_FLOAT
+    if (emit->do_viper_types && mp_obj_is_float(obj)) {
+        // float literals are unboxed in viper, like int literals
+        emit_post_push_imm(emit, VTYPE_FLOAT, mp_native_from_float(mp_obj_float_get(obj)));
+        return;
+    }
+    #endif
     need_reg_single(emit, REG_RET, 0);
     ASM_MOV_REG_ALIGNED_IMM(emit->as, REG_RET, (mp_uint_t)obj);
     emit_post_push_reg(emit, VTYPE_PYOBJ, REG_RET);
@@ -932,28 +1299,42 @@ STATIC void emit_native_load_null(emit_t *emit) {
     emit_post_push_imm(emit, VTYPE_PYOBJ, 0);
 }
 
+#if MICROPY_EMIT_NATIVE_JIT
+// Jump to the code raising NameError if reg holds NULL.
+STATIC void emit_native_check_unbound(emit_t *emit, int reg) {
+    need_reg_single(emit, REG_TEMP1, 0);
+    ASM_MOV_REG_IMM(emit->as, REG_TEMP1, 0);
+    ASM_JUMP_IF_REG_EQ(emit->as, reg, REG_TEMP1, emit->unbound_label);
+}
+#endif
+
 STATIC void emit_native_load_fast(emit_t *emit, qstr qst, mp_uint_t local_num) {
     DEBUG_printf("load_fast(%s, " UINT_FMT ")\n", qstr_str(qst), local_num);
     vtype_kind_t vtype = emit->local_vtype[local_num];
     if (vtype == VTYPE_UNBOUND) {
-        EMIT_NATIVE_VIPER_TYPE_ERROR(emit, translate("local '%q' used before type known"), qst);
+        if (emit->check_unbound) {
+            // not known to be stored to yet, but may be by a backward jump
+            vtype = VTYPE_PYOBJ;
+        } else {
+            EMIT_NATIVE_VIPER_TYPE_ERROR(emit, translate("local '%q' used before type known"), qst);
+        }
     }
     emit_native_pre(emit);
-    if (local_num == 0) {
-        emit_post_push_reg(emit, vtype, REG_LOCAL_1);
-    } else if (local_num == 1) {
-        emit_post_push_reg(emit, vtype, REG_LOCAL_2);
-    } else if (local_num == 2) {
-        emit_post_push_reg(emit, vtype, REG_LOCAL_3);
+    int reg;
+    if (local_num < REG_LOCAL_NUM && CAN_USE_REGS_FOR_LOCALS(emit)) {
+        reg = reg_local_table[local_num];
     } else {
         need_reg_single(emit, REG_TEMP0, 0);
-        if (emit->do_viper_types) {
-            ASM_MOV_REG_LOCAL(emit->as, REG_TEMP0, local_num - REG_LOCAL_NUM);
-        } else {
-            ASM_MOV_REG_LOCAL(emit->as, REG_TEMP0, STATE_START + emit->n_state - 1 - local_num);
-        }
-        emit_post_push_reg(emit, vtype, REG_TEMP0);
+        emit_native_mov_reg_state(emit, REG_TEMP0, LOCAL_IDX_LOCAL_VAR(emit, local_num));
+        reg = REG_TEMP0;
+    }
+    #if MICROPY_EMIT_NATIVE_JIT
+    // arguments are only unbound if deleted, which the JIT doesn't compile
+    if (emit->check_unbound && local_num >= (mp_uint_t)emit->scope->num_pos_args + emit->scope->num_kwonly_args) {
+        emit_native_check_unbound(emit, reg);
     }
+    #endif
+    emit_post_push_reg(emit, vtype, reg);
 }
 
 STATIC void emit_native_load_deref(emit_t *emit, qstr qst, mp_uint_t local_num) {
@@ -964,6 +1345,12 @@ STATIC void emit_native_load_deref(emit_t *emit, qstr qst, mp_uint_t local_num)
     int reg_base = REG_RET;
     emit_pre_pop_reg_flexible(emit, &vtype, &reg_base, -1, -1);
     ASM_LOAD_REG_REG_OFFSET(emit->as, REG_RET, reg_base, 1);
+    #if MICROPY_EMIT_NATIVE_JIT
+    if (emit->check_unbound) {
+        // the cell itself is always there, but its contents may be unbound
+        emit_native_check_unbound(emit, REG_RET);
+    }
+    #endif
     // closed over vars are always Python objects
     emit_post_push_reg(emit, VTYPE_PYOBJ, REG_RET);
 }
@@ -1004,6 +1391,14 @@ STATIC void emit_native_load_global(emit_t *emit, qstr qst, int kind) {
             } else if (qst == MP_QSTR_ptr32) {
                 emit_post_push_imm(emit, VTYPE_BUILTIN_CAST, VTYPE_PTR32);
                 return;
+            #if N_VIPER_FLOAT
+            } else if (qst == MP_QSTR_float) {
+                emit_post_push_imm(emit, VTYPE_BUILTIN_CAST, VTYPE_FLOAT);
+                return;
+            } else if (qst == MP_QSTR_ptr_f32) {
+                emit_post_push_imm(emit, VTYPE_BUILTIN_CAST, VTYPE_PTR_F32);
+                return;
+            #endif
             }
         }
     }
@@ -1043,6 +1438,30 @@ STATIC void emit_native_load_build_class(emit_t *emit) {
     emit_post_push_reg(emit, VTYPE_PYOBJ, REG_RET);
 }
 
+// ptr_f32 accesses single-precision floats in memory, which viper holds as an mp_float_t
+STATIC void emit_native_float_from_f32(emit_t *emit, int reg) {
+    #if N_VIPER_FLOAT_SSE
+    asm_x64_movd_r32_to_xmm(emit->as, reg, ASM_X64_REG_XMM0);
+    asm_x64_sse_op_xmm_xmm(emit->as, ASM_X64_SSE_CVTSS2SD, ASM_X64_REG_XMM0, ASM_X64_REG_XMM0);
+    asm_x64_movq_xmm_to_r64(emit->as, ASM_X64_REG_XMM0, reg);
+    #else
+    // mp_float_t is single precision, so there's nothing to convert
+    (void)emit;
+    (void)reg;
+    #endif
+}
+
+STATIC void emit_native_float_to_f32(emit_t *emit, int reg) {
+    #if N_VIPER_FLOAT_SSE
+    asm_x64_movq_r64_to_xmm(emit->as, reg, ASM_X64_REG_XMM0);
+    asm_x64_sse_op_xmm_xmm(emit->as, ASM_X64_SSE_CVTSD2SS, ASM_X64_REG_XMM0, ASM_X64_REG_XMM0);
+    asm_x64_movd_xmm_to_r32(emit->as, ASM_X64_REG_XMM0, reg);
+    #else
+    (void)emit;
+    (void)reg;
+    #endif
+}
+
 STATIC void emit_native_load_subscr(emit_t *emit) {
     DEBUG_printf("load_subscr\n");
     // need to compile: base[index]
@@ -1114,7 +1533,8 @@ STATIC void emit_native_load_subscr(emit_t *emit) {
                     ASM_LOAD16_REG_REG(emit->as, REG_RET, reg_base); // load from (base+2*index)
                     break;
                 }
-                case VTYPE_PTR32: {
+                case VTYPE_PTR32:
+                case VTYPE_PTR_F32: {
                     // pointer to 32-bit memory
                     if (index_value != 0) {
                         // index is a non-zero immediate
@@ -1160,7 +1580,8 @@ STATIC void emit_native_load_subscr(emit_t *emit) {
                     ASM_LOAD16_REG_REG(emit->as, REG_RET, REG_ARG_1); // load from (base+2*index)
                     break;
                 }
-                case VTYPE_PTR32: {
+                case VTYPE_PTR32:
+                case VTYPE_PTR_F32: {
                     // pointer to word-size memory
                     ASM_ADD_REG_REG(emit->as, REG_ARG_1, reg_index); // add index to base
                     ASM_ADD_REG_REG(emit->as, REG_ARG_1, reg_index); // add index to base
@@ -1174,25 +1595,38 @@ STATIC void emit_native_load_subscr(emit_t *emit) {
                         translate("can't load from '%q'"), vtype_to_qstr(vtype_base));
             }
         }
-        emit_post_push_reg(emit, VTYPE_INT, REG_RET);
+        if (vtype_base == VTYPE_PTR_F32) {
+            emit_native_float_from_f32(emit, REG_RET);
+            emit_post_push_reg(emit, VTYPE_FLOAT, REG_RET);
+        } else {
+            emit_post_push_reg(emit, VTYPE_INT, REG_RET);
+        }
+    }
+}
+
+// Check the type of a value being stored through a viper pointer, and
+// convert floats to single precision for ptr_f32.  The value is converted
+// in place, so for ptr_f32 it must be in a scratch register.
+STATIC void emit_native_viper_store_value(emit_t *emit, vtype_kind_t vtype_base, vtype_kind_t vtype_value, int reg_value) {
+    if (vtype_base == VTYPE_PTR_F32) {
+        if (vtype_value != VTYPE_FLOAT) {
+            EMIT_NATIVE_VIPER_TYPE_ERROR(emit,
+                translate("can't store '%q'"), vtype_to_qstr(vtype_value));
+        }
+        emit_native_float_to_f32(emit, reg_value);
+    } else if (vtype_value != VTYPE_BOOL && vtype_value != VTYPE_INT && vtype_value != VTYPE_UINT) {
+        EMIT_NATIVE_VIPER_TYPE_ERROR(emit,
+            translate("can't store '%q'"), vtype_to_qstr(vtype_value));
     }
 }
 
 STATIC void emit_native_store_fast(emit_t *emit, qstr qst, mp_uint_t local_num) {
     vtype_kind_t vtype;
-    if (local_num == 0) {
-        emit_pre_pop_reg(emit, &vtype, REG_LOCAL_1);
-    } else if (local_num == 1) {
-        emit_pre_pop_reg(emit, &vtype, REG_LOCAL_2);
-    } else if (local_num == 2) {
-        emit_pre_pop_reg(emit, &vtype, REG_LOCAL_3);
+    if (local_num < REG_LOCAL_NUM && CAN_USE_REGS_FOR_LOCALS(emit)) {
+        emit_pre_pop_reg(emit, &vtype, reg_local_table[local_num]);
     } else {
         emit_pre_pop_reg(emit, &vtype, REG_TEMP0);
-        if (emit->do_viper_types) {
-            ASM_MOV_LOCAL_REG(emit->as, local_num - REG_LOCAL_NUM, REG_TEMP0);
-        } else {
-            ASM_MOV_LOCAL_REG(emit->as, STATE_START + emit->n_state - 1 - local_num, REG_TEMP0);
-        }
+        emit_native_mov_state_reg(emit, LOCAL_IDX_LOCAL_VAR(emit, local_num), REG_TEMP0);
     }
     emit_post(emit);
 
@@ -1300,12 +1734,13 @@ STATIC void emit_native_store_subscr(emit_t *emit) {
             // special case: x86 needs byte stores to be from lower 4 regs (REG_ARG_3 is EDX)
             emit_pre_pop_reg(emit, &vtype_value, reg_value);
             #else
-            emit_pre_pop_reg_flexible(emit, &vtype_value, &reg_value, reg_base, reg_index);
-            #endif
-            if (vtype_value != VTYPE_BOOL && vtype_value != VTYPE_INT && vtype_value != VTYPE_UINT) {
-                EMIT_NATIVE_VIPER_TYPE_ERROR(emit,
-                    translate("can't store '%q'"), vtype_to_qstr(vtype_value));
+            if (vtype_base == VTYPE_PTR_F32) {
+                emit_pre_pop_reg(emit, &vtype_value, reg_value);
+            } else {
+                emit_pre_pop_reg_flexible(emit, &vtype_value, &reg_value, reg_base, reg_index);
             }
+            #endif
+            emit_native_viper_store_value(emit, vtype_base, vtype_value, reg_value);
             switch (vtype_base) {
                 case VTYPE_PTR8: {
                     // pointer to 8-bit memory
@@ -1350,7 +1785,8 @@ STATIC void emit_native_store_subscr(emit_t *emit) {
                     ASM_STORE16_REG_REG(emit->as, reg_value, reg_base); // store value to (base+2*index)
                     break;
                 }
-                case VTYPE_PTR32: {
+                case VTYPE_PTR32:
+                case VTYPE_PTR_F32: {
                     // pointer to 32-bit memory
                     if (index_value != 0) {
                         // index is a non-zero immediate
@@ -1390,12 +1826,13 @@ STATIC void emit_native_store_subscr(emit_t *emit) {
             // special case: x86 needs byte stores to be from lower 4 regs (REG_ARG_3 is EDX)
             emit_pre_pop_reg(emit, &vtype_value, reg_value);
             #else
-            emit_pre_pop_reg_flexible(emit, &vtype_value, &reg_value, REG_ARG_1, reg_index);
-            #endif
-            if (vtype_value != VTYPE_BOOL && vtype_value != VTYPE_INT && vtype_value != VTYPE_UINT) {
-                EMIT_NATIVE_VIPER_TYPE_ERROR(emit,
-                    translate("can't store '%q'"), vtype_to_qstr(vtype_value));
+            if (vtype_base == VTYPE_PTR_F32) {
+                emit_pre_pop_reg(emit, &vtype_value, reg_value);
+            } else {
+                emit_pre_pop_reg_flexible(emit, &vtype_value, &reg_value, REG_ARG_1, reg_index);
             }
+            #endif
+            emit_native_viper_store_value(emit, vtype_base, vtype_value, reg_value);
             switch (vtype_base) {
                 case VTYPE_PTR8: {
                     // pointer to 8-bit memory
@@ -1419,7 +1856,8 @@ STATIC void emit_native_store_subscr(emit_t *emit) {
                     ASM_STORE16_REG_REG(emit->as, reg_value, REG_ARG_1); // store value to (base+2*index)
                     break;
                 }
-                case VTYPE_PTR32: {
+                case VTYPE_PTR32:
+                case VTYPE_PTR_F32: {
                     // pointer to 32-bit memory
                     #if N_ARM
                     asm_arm_str_reg_reg_reg(emit->as, reg_value, REG_ARG_1, reg_index);
@@ -1442,6 +1880,20 @@ STATIC void emit_native_store_subscr(emit_t *emit) {
 }
 
 STATIC void emit_native_delete_local(emit_t *emit, qstr qst, mp_uint_t local_num, int kind) {
+    #if MICROPY_EMIT_NATIVE_JIT
+    if (emit->check_unbound) {
+        // deleting an unbound local raises NameError, otherwise it's unbound
+        emit_native_load_local(emit, qst, local_num, kind);
+        emit_native_pop_top(emit);
+        emit_native_load_null(emit);
+        if (kind == MP_EMIT_IDOP_LOCAL_FAST) {
+            emit_native_store_fast(emit, qst, local_num);
+        } else {
+            emit_native_store_deref(emit, qst, local_num);
+        }
+        return;
+    }
+    #endif
     if (kind == MP_EMIT_IDOP_LOCAL_FAST) {
         // TODO: This is not compliant implementation. We could use MP_OBJ_SENTINEL
         // to mark deleted vars but then every var would need to be checked on
@@ -1449,7 +1901,9 @@ STATIC void emit_native_delete_local(emit_t *emit, qstr qst, mp_uint_t local_num
         emit_native_load_const_tok(emit, MP_TOKEN_KW_NONE);
         emit_native_store_fast(emit, qst, local_num);
     } else {
-        // TODO implement me!
+        // As above, set the cell's contents to None rather than unbinding it.
+        emit_native_load_const_tok(emit, MP_TOKEN_KW_NONE);
+        emit_native_store_deref(emit, qst, local_num);
     }
 }
 
@@ -1590,9 +2044,56 @@ STATIC void emit_native_jump_if_or_pop(emit_t *emit, bool cond, mp_uint_t label)
     emit_post(emit);
 }
 
+// Record that the finally block at exception depth idx is followed by a jump
+// to label when it's run as part of an unwind.
+STATIC void emit_native_unwind_via(emit_t *emit, int idx, mp_uint_t label) {
+    emit->exc_stack[idx].unwind_used = true;
+    emit_native_mov_state_imm_via(emit, LOCAL_IDX_UNWIND(emit, idx), label + 1, REG_TEMP0);
+    emit_native_add_dispatch(emit, DISPATCH_UNWIND, idx, label);
+}
+
 STATIC void emit_native_unwind_jump(emit_t *emit, mp_uint_t label, mp_uint_t except_depth) {
-    (void)except_depth;
-    emit_native_jump(emit, label & ~MP_EMIT_BREAK_FROM_FOR); // TODO properly
+    label &= ~MP_EMIT_BREAK_FROM_FOR;
+    if (except_depth == 0) {
+        emit_native_jump(emit, label);
+        return;
+    }
+
+    emit_native_pre(emit);
+    // need to commit stack because we are jumping elsewhere
+    need_stack_settled(emit);
+
+    // Each finally (and with) block being jumped out of must run, innermost
+    // first.  Chain them together via their unwind slots, the last one going
+    // on to the label.
+    int idx = emit->exc_stack_size - 1;
+    int first = -1;
+    int prev = -1;
+    for (; except_depth > 0; --except_depth, --idx) {
+        exc_stack_entry_t *e = &emit->exc_stack[idx];
+        if (e->is_finally && e->is_active) {
+            if (prev < 0) {
+                first = idx;
+            } else {
+                emit_native_unwind_via(emit, prev, e->label);
+            }
+            prev = idx;
+        }
+    }
+
+    // idx is now the innermost exception block that remains
+    mp_uint_t handler_id = emit_native_exc_handler_id(emit, idx);
+    if (prev < 0) {
+        emit_native_mov_state_imm_via(emit, LOCAL_IDX_EXC_HANDLER(emit), handler_id, REG_TEMP0);
+        ASM_JUMP(emit->as, label);
+    } else {
+        emit_native_unwind_via(emit, prev, label);
+        emit->exc_stack[prev].unwind_final = true;
+        emit_native_mov_state_imm_via(emit, LOCAL_IDX_UNWIND_HANDLER(emit, prev), handler_id, REG_TEMP0);
+        ASM_MOV_LOCAL_IMM_VIA(emit->as, LOCAL_IDX_EXC_VAL(emit), (mp_uint_t)MP_OBJ_SENTINEL, REG_TEMP0);
+        ASM_JUMP(emit->as, emit->exc_stack[first].label);
+    }
+    emit_post(emit);
 }
 
 STATIC void emit_native_setup_with(emit_t *emit, mp_uint_t label) {
@@ -1628,13 +2129,8 @@ STATIC void emit_native_setup_with(emit_t *emit, mp_uint_t label) {
 
     // need to commit stack because we may jump elsewhere
     need_stack_settled(emit);
-    emit_get_stack_pointer_to_reg_for_push(emit, REG_ARG_1, sizeof(nlr_buf_t) / sizeof(mp_uint_t)); // arg1 = pointer to nlr buf
-    emit_call(emit, MP_F_NLR_PUSH);
-    ASM_JUMP_IF_REG_NONZERO(emit->as, REG_RET, label);
-
-    emit_access_stack(emit, sizeof(nlr_buf_t) / sizeof(mp_uint_t) + 1, &vtype, REG_RET); // access return value of __enter__
-    emit_post_push_reg(emit, VTYPE_PYOBJ, REG_RET); // push return value of __enter__
-    // stack: (..., __exit__, self, as_value, nlr_buf, as_value)
+    emit_native_push_exc_stack(emit, label, true, true);
+    emit_post(emit);
 }
 
 STATIC void emit_native_setup_block(emit_t *emit, mp_uint_t label, int kind) {
@@ -1645,61 +2141,48 @@ STATIC void emit_native_setup_block(emit_t *emit, mp_uint_t label, int kind) {
         emit_native_pre(emit);
         // need to commit stack because we may jump elsewhere
         need_stack_settled(emit);
-        emit_get_stack_pointer_to_reg_for_push(emit, REG_ARG_1, sizeof(nlr_buf_t) / sizeof(mp_uint_t)); // arg1 = pointer to nlr buf
-        emit_call(emit, MP_F_NLR_PUSH);
-        ASM_JUMP_IF_REG_NONZERO(emit->as, REG_RET, label);
+        emit_native_push_exc_stack(emit, label, kind == MP_EMIT_SETUP_BLOCK_FINALLY, false);
         emit_post(emit);
     }
 }
 
 STATIC void emit_native_with_cleanup(emit_t *emit, mp_uint_t label) {
-    // note: label+1 is available as an auxiliary label
+    // note: label+1 and label+2 are available as auxiliary labels
 
-    // stack: (..., __exit__, self, as_value, nlr_buf)
-    emit_native_pre(emit);
-    emit_call(emit, MP_F_NLR_POP);
-    adjust_stack(emit, -(mp_int_t)(sizeof(nlr_buf_t) / sizeof(mp_uint_t)) - 1);
     // stack: (..., __exit__, self)
-
-    // call __exit__
-    emit_post_push_imm(emit, VTYPE_PYOBJ, (mp_uint_t)mp_const_none);
-    emit_post_push_imm(emit, VTYPE_PYOBJ, (mp_uint_t)mp_const_none);
-    emit_post_push_imm(emit, VTYPE_PYOBJ, (mp_uint_t)mp_const_none);
-    emit_get_stack_pointer_to_reg_for_pop(emit, REG_ARG_3, 5);
-    emit_call_with_2_imm_args(emit, MP_F_CALL_METHOD_N_KW, 3, REG_ARG_1, 0, REG_ARG_2);
-
-    // jump to after with cleanup nlr_catch block
-    adjust_stack(emit, 1); // dummy nlr_buf.prev
-    emit_native_load_const_tok(emit, MP_TOKEN_KW_NONE); // nlr_buf.ret_val = no exception
-    emit_native_jump(emit, label + 1);
-
-    // nlr_catch
-    emit_native_label_assign(emit, label);
-
-    // adjust stack counter for: __exit__, self, as_value
-    adjust_stack(emit, 3);
-    // stack: (..., __exit__, self, as_value, nlr_buf.prev, nlr_buf.ret_val)
+    // The body finished normally, with no exception, or jumped here with the
+    // exception (or the unwind marker) in the exception slot.
+    emit_native_pre(emit);
+    need_stack_settled(emit);
+    ASM_MOV_LOCAL_IMM_VIA(emit->as, LOCAL_IDX_EXC_VAL(emit), (mp_uint_t)mp_const_none, REG_TEMP0);
+    mp_asm_base_label_assign(&emit->as->base, label);
+    emit_native_leave_exc_stack(emit);
 
     vtype_kind_t vtype;
-    emit_pre_pop_reg(emit, &vtype, REG_ARG_1); // get the thrown value (exc)
-    adjust_stack(emit, -2); // discard nlr_buf.prev and as_value
-    // stack: (..., __exit__, self)
-    // REG_ARG_1=exc
+    emit_pre_pop_reg(emit, &vtype, REG_ARG_3); // self
+    emit_pre_pop_reg(emit, &vtype, REG_ARG_2); // __exit__
+    ASM_MOV_REG_LOCAL(emit->as, REG_ARG_1, LOCAL_IDX_EXC_VAL(emit));
+    emit_post_push_reg(emit, VTYPE_PYOBJ, REG_ARG_1); // push exc to save it for later
+    emit_post_push_reg(emit, vtype, REG_ARG_2); // __exit__
+    emit_post_push_reg(emit, vtype, REG_ARG_3); // self
+    emit_post_push_imm(emit, VTYPE_PYOBJ, (mp_uint_t)mp_const_none); // type(exc)
+    emit_post_push_imm(emit, VTYPE_PYOBJ, (mp_uint_t)mp_const_none); // exc value
+    emit_post_push_imm(emit, VTYPE_PYOBJ, (mp_uint_t)mp_const_none); // traceback info
+    need_stack_settled(emit);
+    // stack: (..., exc, __exit__, self, None, None, None)
 
-    emit_pre_pop_reg(emit, &vtype, REG_ARG_2); // self
-    emit_pre_pop_reg(emit, &vtype, REG_ARG_3); // __exit__
-    adjust_stack(emit, 1); // dummy nlr_buf.prev
-    emit_post_push_reg(emit, vtype, REG_ARG_1); // push exc to save it for later
-    emit_post_push_reg(emit, vtype, REG_ARG_3); // __exit__
-    emit_post_push_reg(emit, vtype, REG_ARG_2); // self
-    // stack: (..., exc, __exit__, self)
-    // REG_ARG_1=exc
+    // if there's no exception then call __exit__ with the Nones
+    ASM_MOV_REG_LOCAL(emit->as, REG_ARG_1, LOCAL_IDX_EXC_VAL(emit));
+    ASM_MOV_REG_IMM(emit->as, REG_ARG_2, (mp_uint_t)mp_const_none);
+    ASM_JUMP_IF_REG_EQ(emit->as, REG_ARG_1, REG_ARG_2, label + 1);
+    ASM_MOV_REG_IMM(emit->as, REG_ARG_2, (mp_uint_t)MP_OBJ_SENTINEL);
+    ASM_JUMP_IF_REG_EQ(emit->as, REG_ARG_1, REG_ARG_2, label + 1);
 
+    // otherwise pass the exception details
     ASM_LOAD_REG_REG_OFFSET(emit->as, REG_ARG_2, REG_ARG_1, 0); // get type(exc)
-    emit_post_push_reg(emit, VTYPE_PYOBJ, REG_ARG_2); // push type(exc)
-    emit_post_push_reg(emit, VTYPE_PYOBJ, REG_ARG_1); // push exc value
-    emit_post_push_imm(emit, VTYPE_PYOBJ, (mp_uint_t)mp_const_none); // traceback info
-    // stack: (..., exc, __exit__, self, type(exc), exc, traceback)
+    emit_native_mov_state_reg(emit, emit->stack_start + emit->stack_size - 3, REG_ARG_2);
+    emit_native_mov_state_reg(emit, emit->stack_start + emit->stack_size - 2, REG_ARG_1);
+    // stack: (..., exc, __exit__, self, type(exc), exc, None)
 
     // call __exit__ method
     emit_get_stack_pointer_to_reg_for_pop(emit, REG_ARG_3, 5);
@@ -1711,26 +2194,75 @@ STATIC void emit_native_with_cleanup(emit_t *emit, mp_uint_t label) {
         ASM_MOV_REG_REG(emit->as, REG_ARG_1, REG_RET);
     }
     emit_call(emit, MP_F_OBJ_IS_TRUE);
-    ASM_JUMP_IF_REG_ZERO(emit->as, REG_RET, label + 1);
+    ASM_JUMP_IF_REG_ZERO(emit->as, REG_RET, label + 2);
 
     // replace exc with None
     emit_pre_pop_discard(emit);
     emit_post_push_imm(emit, VTYPE_PYOBJ, (mp_uint_t)mp_const_none);
+    emit_native_jump(emit, label + 2);
 
-    // end of with cleanup nlr_catch block
-    emit_native_label_assign(emit, label + 1);
+    // no exception: call __exit__ method, ignoring its result
+    mp_asm_base_label_assign(&emit->as->base, label + 1);
+    emit_native_adjust_stack_size(emit, 5);
+    // stack: (..., exc, __exit__, self, None, None, None)
+    emit_get_stack_pointer_to_reg_for_pop(emit, REG_ARG_3, 5);
+    emit_call_with_2_imm_args(emit, MP_F_CALL_METHOD_N_KW, 3, REG_ARG_1, 0, REG_ARG_2);
+
+    // end of with cleanup
+    emit_native_label_assign(emit, label + 2);
+    // stack: (..., exc_or_None)
 }
 
 STATIC void emit_native_end_finally(emit_t *emit) {
     // logic:
     //   exc = pop_stack
     //   if exc == None: pass
+    //   elif exc is the unwind marker: continue the unwind
     //   else: raise exc
-    // the check if exc is None is done in the MP_F_NATIVE_RAISE stub
+    // the check if exc is None (or the marker) is done in the MP_F_NATIVE_RAISE stub
+    emit_native_pre(emit);
+    assert(emit->exc_stack_size > 0);
+    exc_stack_entry_t *e = &emit->exc_stack[--emit->exc_stack_size];
+    if (e->unwind_used) {
+        need_stack_settled(emit);
+    }
     vtype_kind_t vtype;
-    emit_pre_pop_reg(emit, &vtype, REG_ARG_1); // get nlr_buf.ret_val
-    emit_pre_pop_discard(emit); // discard nlr_buf.prev
+    emit_pre_pop_reg(emit, &vtype, REG_ARG_1);
     emit_call(emit, MP_F_NATIVE_RAISE);
+
+    if (e->unwind_used) {
+        // note: the compiler reserves 2 labels for this
+        mp_uint_t l = *emit->label_slot;
+        emit_native_mov_reg_state(emit, REG_ARG_1, emit->stack_start + emit->stack_size);
+        ASM_MOV_REG_IMM(emit->as, REG_ARG_2, (mp_uint_t)MP_OBJ_SENTINEL);
+        ASM_JUMP_IF_REG_EQ(emit->as, REG_ARG_1, REG_ARG_2, l);
+        ASM_JUMP(emit->as, l + 1);
+
+        // an unwind is in progress: go on to the next finally block, or to
+        // the destination of the unwind
+        mp_asm_base_label_assign(&emit->as->base, l);
+        ASM_MOV_LOCAL_REG(emit->as, LOCAL_IDX_EXC_VAL(emit), REG_ARG_2);
+        size_t idx = emit->exc_stack_size;
+        if (e->unwind_final) {
+            // (a finally block that comes next sets its own handler)
+            emit_native_mov_reg_state(emit, REG_ARG_1, LOCAL_IDX_UNWIND_HANDLER(emit, idx));
+            emit_native_mov_state_reg(emit, LOCAL_IDX_EXC_HANDLER(emit), REG_ARG_1);
+        }
+        emit_native_mov_reg_state(emit, REG_ARG_1, LOCAL_IDX_UNWIND(emit, idx));
+        emit_native_dispatch(emit, DISPATCH_UNWIND, idx, REG_ARG_1, REG_ARG_2);
+
+        // these destinations are done with
+        size_t n = 0;
+        for (size_t i = 0; i < emit->dispatch_len; i++) {
+            dispatch_entry_t *d = &emit->dispatch[i];
+            if (!(d->kind == DISPATCH_UNWIND && d->exc_depth == idx)) {
+                emit->dispatch[n++] = *d;
+            }
+        }
+        emit->dispatch_len = n;
+
+        mp_asm_base_label_assign(&emit->as->base, l + 1);
+    }
     emit_post(emit);
 }
 
@@ -1771,8 +2303,8 @@ STATIC void emit_native_for_iter_end(emit_t *emit) {
 
 STATIC void emit_native_pop_block(emit_t *emit) {
     emit_native_pre(emit);
-    emit_call(emit, MP_F_NLR_POP);
-    adjust_stack(emit, -(mp_int_t)(sizeof(nlr_buf_t) / sizeof(mp_uint_t)) + 1);
+    need_reg_single(emit, REG_TEMP0, 0);
+    emit_native_leave_exc_stack(emit);
     emit_post(emit);
 }
 
@@ -1786,6 +2318,16 @@ STATIC void emit_native_unary_op(emit_t *emit, mp_unary_op_t op) {
     if (vtype == VTYPE_PYOBJ) {
         emit_call_with_imm_arg(emit, MP_F_UNARY_OP, op, REG_ARG_1);
         emit_post_push_reg(emit, VTYPE_PYOBJ, REG_RET);
+    #if N_VIPER_FLOAT
+    } else if (vtype == VTYPE_FLOAT && (op == MP_UNARY_OP_POSITIVE || op == MP_UNARY_OP_NEGATIVE)) {
+        if (op == MP_UNARY_OP_NEGATIVE) {
+            // flip the sign bit
+            need_reg_single(emit, REG_ARG_3, 0);
+            ASM_MOV_REG_IMM(emit->as, REG_ARG_3, (mp_uint_t)1 << (sizeof(mp_float_t) * 8 - 1));
+            ASM_XOR_REG_REG(emit->as, REG_ARG_2, REG_ARG_3);
+        }
+        emit_post_push_reg(emit, VTYPE_FLOAT, REG_ARG_2);
+    #endif
     } else {
         adjust_stack(emit, 1);
         EMIT_NATIVE_VIPER_TYPE_ERROR(emit,
@@ -1793,6 +2335,91 @@ STATIC void emit_native_unary_op(emit_t *emit, mp_unary_op_t op) {
     }
 }
 
+#if N_VIPER_FLOAT
+STATIC void emit_native_binary_op_float(emit_t *emit, mp_binary_op_t op) {
+    if (MP_BINARY_OP_INPLACE_OR <= op && op <= MP_BINARY_OP_INPLACE_POWER) {
+        op += MP_BINARY_OP_OR - MP_BINARY_OP_INPLACE_OR;
+    }
+    bool is_compare = MP_BINARY_OP_LESS <= op && op <= MP_BINARY_OP_NOT_EQUAL;
+    if (!is_compare && op != MP_BINARY_OP_ADD && op != MP_BINARY_OP_SUBTRACT
+        && op != MP_BINARY_OP_MULTIPLY && op != MP_BINARY_OP_TRUE_DIVIDE) {
+        adjust_stack(emit, -1);
+        EMIT_NATIVE_VIPER_TYPE_ERROR(emit,
+            translate("binary op %q not implemented"), mp_binary_op_method_name[op]);
+        return;
+    }
+    vtype_kind_t vtype_lhs, vtype_rhs;
+    emit_pre_pop_reg_reg(emit, &vtype_rhs, REG_ARG_3, &vtype_lhs, REG_ARG_2);
+    #if N_VIPER_FLOAT_SSE
+    asm_x64_movq_r64_to_xmm(emit->as, REG_ARG_2, ASM_X64_REG_XMM0);
+    asm_x64_movq_r64_to_xmm(emit->as, REG_ARG_3, ASM_X64_REG_XMM1);
+    if (is_compare) {
+        // cmpsd only has <, <=, == and != so swap the args for > and >=,
+        // it gives all ones for true so mask that down to 1
+        static const byte preds[6] = {
+            ASM_X64_CMPSD_LT,
+            0x80 | ASM_X64_CMPSD_LT,
+            ASM_X64_CMPSD_EQ,
+            ASM_X64_CMPSD_LE,
+            0x80 | ASM_X64_CMPSD_LE,
+            ASM_X64_CMPSD_NEQ,
+        };
+        byte pred = preds[op - MP_BINARY_OP_LESS];
+        int reg_res = ASM_X64_REG_XMM0;
+        if (pred & 0x80) {
+            reg_res = ASM_X64_REG_XMM1;
+            asm_x64_cmpsd_xmm_xmm(emit->as, pred & 0x7f, ASM_X64_REG_XMM1, ASM_X64_REG_XMM0);
+        } else {
+            asm_x64_cmpsd_xmm_xmm(emit->as, pred, ASM_X64_REG_XMM0, ASM_X64_REG_XMM1);
+        }
+        need_reg_single(emit, REG_RET, 0);
+        asm_x64_movd_xmm_to_r32(emit->as, reg_res, REG_ARG_2);
+        ASM_MOV_REG_IMM(emit->as, REG_RET, 1);
+        ASM_AND_REG_REG(emit->as, REG_RET, REG_ARG_2);
+        emit_post_push_reg(emit, VTYPE_BOOL, REG_RET);
+    } else {
+        static const uint16_t ops[] = {
+            [MP_BINARY_OP_ADD - MP_BINARY_OP_ADD] = ASM_X64_SSE_ADDSD,
+            [MP_BINARY_OP_SUBTRACT - MP_BINARY_OP_ADD] = ASM_X64_SSE_SUBSD,
+            [MP_BINARY_OP_MULTIPLY - MP_BINARY_OP_ADD] = ASM_X64_SSE_MULSD,
+            [MP_BINARY_OP_TRUE_DIVIDE - MP_BINARY_OP_ADD] = ASM_X64_SSE_DIVSD,
+        };
+        asm_x64_sse_op_xmm_xmm(emit->as, ops[op - MP_BINARY_OP_ADD], ASM_X64_REG_XMM0, ASM_X64_REG_XMM1);
+        asm_x64_movq_xmm_to_r64(emit->as, ASM_X64_REG_XMM0, REG_ARG_2);
+        emit_post_push_reg(emit, VTYPE_FLOAT, REG_ARG_2);
+    }
+    #else
+    emit_call_with_imm_arg(emit, MP_F_NATIVE_FLOAT_BINARY_OP, op, REG_ARG_1);
+    emit_post_push_reg(emit, is_compare ? VTYPE_BOOL : VTYPE_FLOAT, REG_RET);
+    #endif
+}
+
+// Cast between a viper float and an integer type, with the value at the top of the stack.
+STATIC void emit_native_float_cast(emit_t *emit, vtype_kind_t vtype_cast) {
+    vtype_kind_t vtype;
+    emit_pre_pop_reg(emit, &vtype, REG_ARG_1);
+    emit_pre_pop_discard(emit);
+    if (vtype_cast == VTYPE_FLOAT ? vtype != VTYPE_BOOL && vtype != VTYPE_INT && vtype != VTYPE_UINT
+        : vtype_cast != VTYPE_INT && vtype_cast != VTYPE_UINT) {
+        EMIT_NATIVE_VIPER_TYPE_ERROR(emit,
+            translate("can't convert '%q' to '%q'"), vtype_to_qstr(vtype), vtype_to_qstr(vtype_cast));
+    }
+    #if N_VIPER_FLOAT_SSE
+    need_reg_single(emit, REG_RET, 0);
+    if (vtype_cast == VTYPE_FLOAT) {
+        asm_x64_cvtsi2sd_r64_to_xmm(emit->as, REG_ARG_1, ASM_X64_REG_XMM0);
+        asm_x64_movq_xmm_to_r64(emit->as, ASM_X64_REG_XMM0, REG_RET);
+    } else {
+        asm_x64_movq_r64_to_xmm(emit->as, REG_ARG_1, ASM_X64_REG_XMM0);
+        asm_x64_cvttsd2si_xmm_to_r64(emit->as, ASM_X64_REG_XMM0, REG_RET);
+    }
+    #else
+    emit_call_with_imm_arg(emit, MP_F_NATIVE_FLOAT_CONVERT, vtype_cast & 0xf, REG_ARG_2);
+    #endif
+    emit_post_push_reg(emit, vtype_cast, REG_RET);
+}
+#endif
+
 STATIC void emit_native_binary_op(emit_t *emit, mp_binary_op_t op) {
     DEBUG_printf("binary_op(" UINT_FMT ")\n", op);
     vtype_kind_t vtype_lhs = peek_vtype(emit, 1);
@@ -1947,6 +2574,10 @@ STATIC void emit_native_binary_op(emit_t *emit, mp_binary_op_t op) {
             EMIT_NATIVE_VIPER_TYPE_ERROR(emit,
                 translate("binary op %q not implemented"), mp_binary_op_method_name[op]);
         }
+    #if N_VIPER_FLOAT
+    } else if (vtype_lhs == VTYPE_FLOAT && vtype_rhs == VTYPE_FLOAT) {
+        emit_native_binary_op_float(emit, op);
+    #endif
     } else if (vtype_lhs == VTYPE_PYOBJ && vtype_rhs == VTYPE_PYOBJ) {
         emit_pre_pop_reg_reg(emit, &vtype_rhs, REG_ARG_3, &vtype_lhs, REG_ARG_2);
         bool invert = false;
@@ -2119,6 +2750,13 @@ STATIC void emit_native_call_function(emit_t *emit, mp_uint_t n_positional, mp_u
         assert(!star_flags);
         DEBUG_printf("  cast to %d\n", vtype_fun);
         vtype_kind_t vtype_cast = peek_stack(emit, 1)->data.u_imm;
+        #if N_VIPER_FLOAT
+        vtype_kind_t vtype_arg = peek_vtype(emit, 0);
+        if (vtype_arg != VTYPE_PYOBJ && (vtype_arg == VTYPE_FLOAT) != (vtype_cast == VTYPE_FLOAT)) {
+            emit_native_float_cast(emit, vtype_cast);
+            return;
+        }
+        #endif
         switch (peek_vtype(emit, 0)) {
             case VTYPE_PYOBJ: {
                 vtype_kind_t vtype;
@@ -2135,6 +2773,8 @@ STATIC void emit_native_call_function(emit_t *emit, mp_uint_t n_positional, mp_u
             case VTYPE_PTR8:
             case VTYPE_PTR16:
             case VTYPE_PTR32:
+            case VTYPE_FLOAT:
+            case VTYPE_PTR_F32:
             case VTYPE_PTR_NONE:
                 emit_fold_stack_top(emit, REG_ARG_1);
                 emit_post_top_set_vtype(emit, vtype_cast);
@@ -2197,41 +2837,127 @@ STATIC void emit_native_return_value(emit_t *emit) {
         emit_pre_pop_reg(emit, &vtype, REG_RET);
         assert(vtype == VTYPE_PYOBJ);
     }
+    if (NEED_GLOBAL_EXC_HANDLER(emit)) {
+        // leave via the common exit path, running any finally blocks on the way
+        emit_native_mov_state_reg(emit, LOCAL_IDX_RET_VAL(emit), REG_RET);
+        emit_native_unwind_jump(emit, emit->exit_label, emit->exc_stack_size);
+    } else {
+        ASM_EXIT(emit->as);
+    }
     emit->last_emit_was_return_value = true;
-    ASM_EXIT(emit->as);
 }
 
 STATIC void emit_native_raise_varargs(emit_t *emit, mp_uint_t n_args) {
-    assert(n_args == 1);
-    vtype_kind_t vtype_exc;
-    emit_pre_pop_reg(emit, &vtype_exc, REG_ARG_1); // arg1 = object to raise
-    if (vtype_exc != VTYPE_PYOBJ) {
-        EMIT_NATIVE_VIPER_TYPE_ERROR(emit, translate("must raise an object"));
+    emit_native_pre(emit);
+    if (n_args == 0) {
+        // re-raise the exception being handled by the innermost except block
+        need_reg_all(emit);
+        int idx = emit->exc_stack_size - 1;
+        while (idx >= 0 && (emit->exc_stack[idx].is_finally || emit->exc_stack[idx].is_active)) {
+            --idx;
+        }
+        if (idx >= 0) {
+            emit_native_mov_reg_state(emit, REG_ARG_1, LOCAL_IDX_CUR_EXC(emit, idx));
+        } else {
+            // MP_F_NATIVE_RAISE raises a RuntimeError for this
+            ASM_MOV_REG_IMM(emit->as, REG_ARG_1, (mp_uint_t)MP_OBJ_NULL);
+        }
+    } else {
+        if (n_args == 2) {
+            // the cause is not supported, so discard it
+            emit_pre_pop_discard(emit);
+        }
+        vtype_kind_t vtype_exc;
+        emit_pre_pop_reg(emit, &vtype_exc, REG_ARG_1); // arg1 = object to raise
+        if (vtype_exc != VTYPE_PYOBJ) {
+            EMIT_NATIVE_VIPER_TYPE_ERROR(emit, translate("must raise an object"));
+        }
     }
     // TODO probably make this 1 call to the runtime (which could even call convert, native_raise(obj, type))
     emit_call(emit, MP_F_NATIVE_RAISE);
 }
 
+// Return from the generator to its caller, yielding the value in the given
+// state slot.  It's resumed at the given label.
+STATIC void emit_native_yield_exit(emit_t *emit, int local_num, mp_uint_t resume_label) {
+    emit_native_mov_reg_state_addr(emit, REG_TEMP0, local_num);
+    ASM_STORE_REG_REG_OFFSET(emit->as, REG_TEMP0, REG_GENERATOR_STATE, offsetof(mp_code_state_t, sp) / sizeof(uintptr_t));
+    ASM_MOV_REG_IMM(emit->as, REG_TEMP0, resume_label + 1);
+    ASM_STORE_REG_REG_OFFSET(emit->as, REG_TEMP0, REG_GENERATOR_STATE, offsetof(mp_code_state_t, ip) / sizeof(uintptr_t));
+    ASM_CALL_IND(emit->as, mp_fun_table[MP_F_NLR_POP], MP_F_NLR_POP);
+    ASM_MOV_REG_IMM(emit->as, REG_RET, MP_VM_RETURN_YIELD);
+    ASM_EXIT(emit->as);
+    emit_native_add_dispatch(emit, DISPATCH_RESUME, 0, resume_label);
+}
+
 STATIC void emit_native_yield(emit_t *emit, int kind) {
-    // not supported (for now)
-    (void)emit;
-    (void)kind;
-    mp_raise_NotImplementedError(translate("native yield"));
+    // note: the compiler reserves 2 (yield) or 3 (yield from) labels for this
+
+    if (emit->do_viper_types) {
+        mp_raise_NotImplementedError(translate("native yield"));
+    }
+
+    emit_native_pre(emit);
+    // the stack lives in the generator object, so must be up to date
+    need_stack_settled(emit);
+    mp_uint_t l = *emit->label_slot;
+
+    if (kind == MP_EMIT_YIELD_VALUE) {
+        // stack: (..., value)
+        adjust_stack(emit, -1);
+        emit_native_yield_exit(emit, emit->stack_start + emit->stack_size, l);
+
+        // resume point, with the sent value in the same slot as the yielded one
+        mp_asm_base_label_assign(&emit->as->base, l);
+        emit_native_adjust_stack_size(emit, 1);
+        emit_post_top_set_vtype(emit, VTYPE_PYOBJ);
+
+        // raise the exception thrown in, if any
+        ASM_MOV_REG_LOCAL(emit->as, REG_ARG_1, LOCAL_IDX_EXC_VAL(emit));
+        ASM_MOV_REG_IMM(emit->as, REG_ARG_2, 0);
+        ASM_JUMP_IF_REG_EQ(emit->as, REG_ARG_1, REG_ARG_2, l + 1);
+        emit_call(emit, MP_F_NATIVE_RAISE);
+        mp_asm_base_label_assign(&emit->as->base, l + 1);
+    } else {
+        // stack: (..., iter, send_value)
+        // The exception slot is used to pass in the thrown value and to get
+        // back the yielded (or returned) value.
+        ASM_MOV_LOCAL_IMM_VIA(emit->as, LOCAL_IDX_EXC_VAL(emit), (mp_uint_t)MP_OBJ_NULL, REG_TEMP0);
+        mp_asm_base_label_assign(&emit->as->base, l);
+        vtype_kind_t vtype;
+        emit_access_stack(emit, 2, &vtype, REG_ARG_1); // iter
+        emit_access_stack(emit, 1, &vtype, REG_ARG_2); // send value
+        ASM_MOV_REG_LOCAL_ADDR(emit->as, REG_ARG_3, LOCAL_IDX_EXC_VAL(emit));
+        emit_call(emit, MP_F_NATIVE_YIELD_FROM);
+        ASM_JUMP_IF_REG_ZERO(emit->as, REG_RET, l + 2);
+
+        // yield the value from the sub-generator, putting it in the slot that
+        // the sent value comes back in, then pass that value on
+        ASM_MOV_REG_LOCAL(emit->as, REG_TEMP0, LOCAL_IDX_EXC_VAL(emit));
+        emit_native_mov_state_reg(emit, emit->stack_start + emit->stack_size - 1, REG_TEMP0);
+        emit_native_yield_exit(emit, emit->stack_start + emit->stack_size - 1, l + 1);
+        mp_asm_base_label_assign(&emit->as->base, l + 1);
+        ASM_JUMP(emit->as, l);
+
+        // the sub-generator finished, with its return value in the exception slot
+        mp_asm_base_label_assign(&emit->as->base, l + 2);
+        adjust_stack(emit, -2);
+        ASM_MOV_REG_LOCAL(emit->as, REG_TEMP0, LOCAL_IDX_EXC_VAL(emit));
+        emit_post_push_reg(emit, VTYPE_PYOBJ, REG_TEMP0);
+    }
 }
 
 STATIC void emit_native_start_except_handler(emit_t *emit) {
-    // This instruction follows an nlr_pop, so the stack counter is back to zero, when really
-    // it should be up by a whole nlr_buf_t.  We then want to pop the nlr_buf_t here, but save
-    // the first 2 elements, so we can get the thrown value.
-    adjust_stack(emit, 1);
-    vtype_kind_t vtype_nlr;
-    emit_pre_pop_reg(emit, &vtype_nlr, REG_ARG_1); // get the thrown value
-    emit_pre_pop_discard(emit); // discard the linked-list pointer in the nlr_buf
-    emit_post_push_reg_reg_reg(emit, VTYPE_PYOBJ, REG_ARG_1, VTYPE_PYOBJ, REG_ARG_1, VTYPE_PYOBJ, REG_ARG_1); // push the 3 exception items
+    // The handler for this exception block is now running.  Keep its
+    // exception so it can be re-raised, and push it for the except clauses.
+    emit_native_leave_exc_stack(emit);
+    ASM_MOV_REG_LOCAL(emit->as, REG_TEMP0, LOCAL_IDX_EXC_VAL(emit));
+    emit_native_mov_state_reg(emit, LOCAL_IDX_CUR_EXC(emit, emit->exc_stack_size - 1), REG_TEMP0);
+    emit_post_push_reg(emit, VTYPE_PYOBJ, REG_TEMP0);
 }
 
 STATIC void emit_native_end_except_handler(emit_t *emit) {
-    adjust_stack(emit, -1);
+    (void)emit;
 }
 
 const emit_method_table_t EXPORT_FUN(method_table) = {
@@ -59,6 +59,14 @@ STATIC byte mp_f_n_args[MP_F_NUMBER_OF] = {
     [MP_F_SETUP_CODE_STATE] = 5,
     [MP_F_SMALL_INT_FLOOR_DIVIDE] = 2,
     [MP_F_SMALL_INT_MODULO] = 2,
+    [MP_F_NATIVE_YIELD_FROM] = 3,
+    #if MICROPY_PY_BUILTINS_FLOAT
+    [MP_F_NATIVE_FLOAT_BINARY_OP] = 3,
+    [MP_F_NATIVE_FLOAT_CONVERT] = 2,
+    #endif
+    #if MICROPY_EMIT_NATIVE_JIT
+    [MP_F_NATIVE_RAISE_UNBOUND_LOCAL] = 0,
+    #endif
 };
 
 #define N_X86 (1)
@@ -28,6 +28,7 @@
 #if MICROPY_FLOAT_IMPL != MICROPY_FLOAT_IMPL_NONE
 
 #include <assert.h>
+#include <stdbool.h>
 #include <stdlib.h>
 #include <stdint.h>
 #include <math.h>
@@ -89,6 +90,639 @@ static inline int fp_isless1(float x) { union floatbits fb = {x}; return fb.u <
 
 #endif
 
+#if MICROPY_FLOAT_FORMAT_EXACT
+
+/***********************************************************************
+
+  Exact conversion of a float to decimal digits.
+
+  The float is held as r / s * 10^k, with r and s big integers and
+  0.1 <= r / s < 1, and each digit is found by multiplying r by 10 and
+  dividing it by s.  For the shortest representation (Steele & White,
+  Burger & Dybvig) the digits stop as soon as they are closer to the float
+  than to its neighbours, which m_lo and m_hi track; otherwise the digits
+  are correctly rounded, ties to even.  No tables are needed, and the big
+  integers are only as long as the exponent makes them, so numbers of
+  ordinary size take just a few words.
+
+***********************************************************************/
+
+#if MICROPY_FLOAT_IMPL == MICROPY_FLOAT_IMPL_FLOAT
+#define FPMANT_BITS (23)
+#define FPEXP_MIN (-149) // exponent of the smallest subnormal
+#define FPEXP_LEN (4) // e+38
+#define FPREPR_DECPT_MAX (7)
+#define FPEXACT_POW10 (10)
+#define FPDEC_EXP_MIN (-65) // 19 digits * 10^-65 is the smallest that can be nonzero
+#define FPDEC_EXP_MAX (38)
+#define FPBIG_WORDS (10)
+static inline uint64_t fp_bits(float x) { union floatbits fb = {x}; return fb.u; }
+#else
+#define FPMANT_BITS (52)
+#define FPEXP_MIN (-1074)
+#define FPEXP_LEN (5) // e+308
+#define FPREPR_DECPT_MAX (16)
+#define FPEXACT_POW10 (22)
+#define FPDEC_EXP_MIN (-343)
+#define FPDEC_EXP_MAX (308)
+#define FPBIG_WORDS (40)
+union doublebits {
+    double f;
+    uint64_t u;
+};
+static inline uint64_t fp_bits(double x) { union doublebits db = {x}; return db.u; }
+#endif
+
+#define FPMAX_DIGITS (32)
+
+typedef struct _fpbig_t {
+    int len;
+    uint32_t d[FPBIG_WORDS];
+} fpbig_t;
+
+typedef struct _fp_digits_t {
+    fpbig_t r, s, m_lo, m_hi_buf, t;
+    fpbig_t *m_hi; // points to m_lo when the gaps to both neighbours are equal
+    // the same, for numbers small enough to be done in 64 bits
+    uint64_t r64, s64, m_lo64, m_hi64;
+    bool small;
+    int k;
+    bool even; // whether the halfway points read back as this float
+} fp_digits_t;
+
+STATIC void fpbig_set(fpbig_t *b, uint64_t v) {
+    b->d[0] = (uint32_t)v;
+    b->d[1] = (uint32_t)(v >> 32);
+    b->len = b->d[1] != 0 ? 2 : b->d[0] != 0;
+}
+
+STATIC void fpbig_shl(fpbig_t *b, int n) {
+    int words = n / 32;
+    int bits = n % 32;
+    int len = b->len;
+    assert(len + words < FPBIG_WORDS);
+    b->d[len + words] = bits != 0 ? b->d[len - 1] >> (32 - bits) : 0;
+    for (int i = len - 1; i >= 0; --i) {
+        uint32_t w = b->d[i] << bits;
+        if (bits != 0 && i > 0) {
+            w |= b->d[i - 1] >> (32 - bits);
+        }
+        b->d[i + words] = w;
+    }
+    for (int i = 0; i < words; ++i) {
+        b->d[i] = 0;
+    }
+    b->len = len + words + (b->d[len + words] != 0);
+}
+
+STATIC void fpbig_mul_small(fpbig_t *b, uint32_t m) {
+    uint32_t carry = 0;
+    for (int i = 0; i < b->len; ++i) {
+        uint64_t p = (uint64_t)b->d[i] * m + carry;
+        b->d[i] = (uint32_t)p;
+        carry = p >> 32;
+    }
+    if (carry != 0) {
+        assert(b->len < FPBIG_WORDS);
+        b->d[b->len++] = carry;
+    }
+}
+
+STATIC void fpbig_mul_pow10(fpbig_t *b, int n) {
+    for (; n >= 9; n -= 9) {
+        fpbig_mul_small(b, 1000000000);
+    }
+    uint32_t m = 1;
+    while (n-- > 0) {
+        m *= 10;
+    }
+    fpbig_mul_small(b, m);
+}
+
+STATIC int fpbig_cmp(const fpbig_t *a, const fpbig_t *b) {
+    if (a->len != b->len) {
+        return a->len - b->len;
+    }
+    for (int i = a->len - 1; i >= 0; --i) {
+        if (a->d[i] != b->d[i]) {
+            return a->d[i] < b->d[i] ? -1 : 1;
+        }
+    }
+    return 0;
+}
+
+// dest = a + b
+STATIC void fpbig_add(fpbig_t *dest, const fpbig_t *a, const fpbig_t *b) {
+    if (a->len < b->len) {
+        const fpbig_t *tmp = a;
+        a = b;
+        b = tmp;
+    }
+    uint32_t carry = 0;
+    for (int i = 0; i < a->len; ++i) {
+        uint64_t sum = (uint64_t)a->d[i] + (i < b->len ? b->d[i] : 0) + carry;
+        dest->d[i] = (uint32_t)sum;
+        carry = sum >> 32;
+    }
+    dest->len = a->len;
+    if (carry != 0) {
+        assert(dest->len < FPBIG_WORDS);
+        dest->d[dest->len++] = carry;
+    }
+}
+
+// Divide r by s, leaving the remainder in r and returning the quotient, which
+// must be less than 10.  The top word of s must be at least 2^27 and less than
+// 2^28 so that r fits in as many words as s, and so that the quotient estimated
+// from the top words is at most 2 too small.
+STATIC int fpbig_div_digit(fpbig_t *r, const fpbig_t *s) {
+    int n = s->len;
+    if (r->len < n) {
+        return 0;
+    }
+    uint32_t q = r->d[n - 1] / (s->d[n - 1] + 1);
+    if (q != 0) {
+        uint32_t carry = 0;
+        uint32_t borrow = 0;
+        for (int i = 0; i < n; ++i) {
+            uint64_t p = (uint64_t)s->d[i] * q + carry;
+            carry = p >> 32;
+            uint64_t diff = (uint64_t)r->d[i] - (uint32_t)p - borrow;
+            r->d[i] = (uint32_t)diff;
+            borrow = (diff >> 32) & 1;
+        }
+        while (r->len > 0 && r->d[r->len - 1] == 0) {
+            --r->len;
+        }
+    }
+    while (fpbig_cmp(r, s) >= 0) {
+        uint32_t borrow = 0;
+        for (int i = 0; i < n; ++i) {
+            uint64_t diff = (uint64_t)r->d[i] - s->d[i] - borrow;
+            r->d[i] = (uint32_t)diff;
+            borrow = (diff >> 32) & 1;
+        }
+        while (r->len > 0 && r->d[r->len - 1] == 0) {
+            --r->len;
+        }
+        ++q;
+    }
+    return q;
+}
+
+// Split f, which must be positive and finite, into *mant * 2^*e.  Returns
+// whether the gap to the float below is half the gap above, as it is at a
+// power of two.
+STATIC int fp_decode(FPTYPE f, uint64_t *mant, int *e) {
+    *mant = fp_bits(f) & (((uint64_t)1 << FPMANT_BITS) - 1);
+    int biased_exp = fp_bits(f) >> FPMANT_BITS;
+    *e = FPEXP_MIN;
+    if (biased_exp == 0) {
+        return 0;
+    }
+    int unequal = *mant == 0 && biased_exp > 1;
+    *mant |= (uint64_t)1 << FPMANT_BITS;
+    *e += biased_exp - 1;
+    return unequal;
+}
+
+// Set up st for the digits of mant * 2^e in 64 bits, if they fit, with s less
+// than 2^60 so that r * 10 and r + m_hi can't overflow.  The powers of two in
+// 10^k are cancelled against those of f to leave room.
+STATIC bool fp_digits_init_small(fp_digits_t *st, uint64_t mant, int e, int unequal, int k, bool shortest) {
+    if (e >= 0 || k < -2 || k > 17) {
+        return false;
+    }
+    uint64_t p = 1;
+    for (int i = k < 0 ? -k : k; i > 0; --i) {
+        p *= 5;
+    }
+    int sh = 1 + unequal - e + k;
+    if (sh < 0 || sh >= 60) {
+        return false;
+    }
+    uint64_t r = mant << (1 + unequal);
+    uint64_t s = (uint64_t)1 << sh;
+    uint64_t m_lo = 1;
+    if (k >= 0) {
+        if (p >= (uint64_t)1 << (60 - sh)) {
+            return false;
+        }
+        s *= p;
+    } else {
+        r *= p;
+        m_lo = p;
+    }
+    uint64_t m_hi = m_lo << unequal;
+    if (shortest ? r + m_hi > s || (st->even && r + m_hi == s) : r >= s) {
+        if (s >= ((uint64_t)1 << 60) / 10) {
+            return false;
+        }
+        s *= 10;
+        ++k;
+    }
+    if (r >= s) {
+        return false;
+    }
+    st->r64 = r;
+    st->s64 = s;
+    st->m_lo64 = m_lo;
+    st->m_hi64 = m_hi;
+    st->k = k;
+    return true;
+}
+
+// Set up st for the digits of f, which must be positive and finite, including
+// the margins if the shortest digits are wanted.  Returns k.
+STATIC int fp_digits_init(fp_digits_t *st, FPTYPE f, bool shortest) {
+    uint64_t mant;
+    int e;
+    int unequal = fp_decode(f, &mant, &e);
+    st->even = (mant & 1) == 0;
+
+    // floor(log2(f)) * log10(2), rounded down, is exact enough for any float
+    // exponent to give k or k - 1
+    int log2_f = e - 1;
+    for (uint64_t m = mant; m != 0; m >>= 1) {
+        ++log2_f;
+    }
+    int k = (int)(((int64_t)log2_f * 1292913986) >> 32) + 1;
+
+    st->small = fp_digits_init_small(st, mant, e, unequal, k, shortest);
+    if (st->small) {
+        return st->k;
+    }
+
+    // f is mant * 2^e; scale it, and the half gaps to its neighbours, so they
+    // are all integers
+    st->m_hi = unequal ? &st->m_hi_buf : &st->m_lo;
+    if (e >= 0) {
+        fpbig_set(&st->r, mant);
+        fpbig_shl(&st->r, e + 1 + unequal);
+        fpbig_set(&st->s, 2 << unequal);
+        fpbig_set(&st->m_lo, 1);
+        fpbig_shl(&st->m_lo, e);
+        fpbig_set(&st->m_hi_buf, 2);
+        fpbig_shl(&st->m_hi_buf, e);
+    } else {
+        fpbig_set(&st->r, mant << (1 + unequal));
+        fpbig_set(&st->s, 1);
+        fpbig_shl(&st->s, 1 + unequal - e);
+        fpbig_set(&st->m_lo, 1);
+        fpbig_set(&st->m_hi_buf, 2);
+    }
+
+    if (k >= 0) {
+        fpbig_mul_pow10(&st->s, k);
+    } else {
+        fpbig_mul_pow10(&st->r, -k);
+        if (shortest) {
+            fpbig_mul_pow10(&st->m_lo, -k);
+            if (unequal) {
+                fpbig_mul_pow10(&st->m_hi_buf, -k);
+            }
+        }
+    }
+    int c;
+    if (shortest) {
+        fpbig_add(&st->t, &st->r, st->m_hi);
+        c = fpbig_cmp(&st->t, &st->s) + st->even;
+    } else {
+        c = fpbig_cmp(&st->r, &st->s) + 1;
+    }
+    if (c > 0) {
+        fpbig_mul_small(&st->s, 10);
+        ++k;
+    }
+    st->k = k;
+
+    // shift everything so the top word of s is in [2^27, 2^28)
+    int top = 0;
+    for (uint32_t w = st->s.d[st->s.len - 1]; w > 1; w >>= 1) {
+        ++top;
+    }
+    int shift = (59 - top) % 32;
+    if (shift != 0) {
+        fpbig_shl(&st->r, shift);
+        fpbig_shl(&st->s, shift);
+        if (shortest) {
+            fpbig_shl(&st->m_lo, shift);
+            if (unequal) {
+                fpbig_shl(&st->m_hi_buf, shift);
+            }
+        }
+    }
+    return k;
+}
+
+// Add one to the last of the n digits, and return how many digits are left
+// once trailing zeros are dropped.
+STATIC int fp_digits_round_up(fp_digits_t *st, char *digs, int n) {
+    while (n > 0 && digs[n - 1] == '9') {
+        --n;
+    }
+    if (n == 0) {
+        digs[0] = '1';
+        ++st->k;
+        return 1;
+    }
+    ++digs[n - 1];
+    return n;
+}
+
+// Generate the fewest digits that read back as the float.
+STATIC int fp_digits_shortest(fp_digits_t *st, char *digs) {
+    if (st->small) {
+        uint64_t r = st->r64, s = st->s64, m_lo = st->m_lo64, m_hi = st->m_hi64;
+        for (int n = 0;;) {
+            r *= 10;
+            m_lo *= 10;
+            m_hi *= 10;
+            int d = r / s;
+            r %= s;
+            digs[n++] = '0' + d;
+            bool low = r < m_lo || (st->even && r == m_lo);
+            bool high = r + m_hi > s || (st->even && r + m_hi == s);
+            if (low || high) {
+                if (low && high) {
+                    high = 2 * r > s || (2 * r == s && (d & 1));
+                }
+                if (high) {
+                    n = fp_digits_round_up(st, digs, n);
+                }
+                return n;
+            }
+        }
+    }
+    for (int n = 0;;) {
+        fpbig_mul_small(&st->r, 10);
+        fpbig_mul_small(&st->m_lo, 10);
+        if (st->m_hi != &st->m_lo) {
+            fpbig_mul_small(st->m_hi, 10);
+        }
+        int d = fpbig_div_digit(&st->r, &st->s);
+        digs[n++] = '0' + d;
+        bool low = fpbig_cmp(&st->r, &st->m_lo) - st->even < 0;
+        fpbig_add(&st->t, &st->r, st->m_hi);
+        bool high = fpbig_cmp(&st->t, &st->s) + st->even > 0;
+        if (low || high) {
+            if (low && high) {
+                // both candidates read back correctly, so take the nearer one
+                fpbig_add(&st->t, &st->r, &st->r);
+                high = fpbig_cmp(&st->t, &st->s) + (d & 1) > 0;
+            }
+            if (high) {
+                n = fp_digits_round_up(st, digs, n);
+            }
+            return n;
+        }
+    }
+}
+
+// Generate the float correctly rounded to n digits, which may be 0 (giving a
+// single 1 or nothing) or negative (giving nothing).  Trailing zeros may be
+// left out of the digits returned.
+STATIC int fp_digits_fixed(fp_digits_t *st, char *digs, int n) {
+    if (n > FPMAX_DIGITS) {
+        n = FPMAX_DIGITS;
+    }
+    int i = 0;
+    int c;
+    if (st->small) {
+        uint64_t r = st->r64, s = st->s64;
+        for (; i < n && r != 0; ++i) {
+            r *= 10;
+            digs[i] = '0' + r / s;
+            r %= s;
+        }
+        if (n < 0 || r == 0) {
+            return i;
+        }
+        c = 2 * r > s ? 1 : 2 * r == s ? 0 : -1;
+    } else {
+        for (; i < n && st->r.len != 0; ++i) {
+            fpbig_mul_small(&st->r, 10);
+            digs[i] = '0' + fpbig_div_digit(&st->r, &st->s);
+        }
+        if (n < 0 || st->r.len == 0) {
+            return i;
+        }
+        fpbig_add(&st->t, &st->r, &st->r);
+        c = fpbig_cmp(&st->t, &st->s);
+    }
+    if (c + (i > 0 && (digs[i - 1] & 1)) > 0) {
+        i = fp_digits_round_up(st, digs, i);
+    }
+    return i;
+}
+
+STATIC char *fp_format_exact(char *s, int buf_remaining, FPTYPE f, char fmt, int prec) {
+    char e_char = 'E' | (fmt & 0x20); // e_char will match case of fmt
+    fmt |= 0x20; // Force fmt to be lowercase
+
+    // the digits, with any missing ones at the end being 0, stand for
+    // 0.d1d2... * 10^k; zero has no digits and k = 1, like other numbers < 10
+    fp_digits_t st;
+    char digs[FPMAX_DIGITS];
+    int nd = 0;
+    int k = 1;
+    bool zero = fp_iszero(f);
+    if (!zero) {
+        k = fp_digits_init(&st, f, fmt == 'r');
+    }
+
+    // number of digits after the decimal point, and whether to use an exponent
+    int frac = prec;
+    bool exp = false;
+    bool strip = false;
+    if (fmt == 'f') {
+        // rounding up may add a digit before the decimal point
+        int int_len = k >= 0 ? k + 1 : 1;
+        if (int_len >= buf_remaining) {
+            fmt = 'e';
+        } else {
+            if (int_len + 1 + frac > buf_remaining) {
+                frac = buf_remaining - int_len - 1;
+            }
+            if (!zero) {
+                nd = fp_digits_fixed(&st, digs, k + frac);
+            }
+        }
+    }
+    if (fmt == 'e') {
+        exp = true;
+        if (2 + frac + FPEXP_LEN > buf_remaining) {
+            frac = buf_remaining - 2 - FPEXP_LEN;
+            if (frac < 0) {
+                // no room for the decimal point either, but one digit fits
+                frac = 0;
+            }
+        }
+        if (!zero) {
+            nd = fp_digits_fixed(&st, digs, frac + 1);
+        }
+    } else if (fmt == 'g') {
+        // prec is the number of significant digits
+        if (prec + 1 + FPEXP_LEN > buf_remaining) {
+            prec = buf_remaining - 1 - FPEXP_LEN;
+        }
+        if (prec < 1) {
+            prec = 1;
+        }
+        if (!zero) {
+            nd = fp_digits_fixed(&st, digs, prec);
+        }
+        k = zero ? k : st.k;
+        exp = k - 1 < -4 || k - 1 >= prec;
+        frac = exp ? prec - 1 : prec - k;
+        strip = true;
+    } else if (fmt == 'r') {
+        // like repr in CPython: the fewest digits, switching to an exponent
+        // outside 1e-4 to 1e16
+        if (!zero) {
+            nd = fp_digits_shortest(&st, digs);
+        }
+        k = zero ? k : st.k;
+        exp = k - 1 < -4 || k - 1 >= FPREPR_DECPT_MAX;
+        frac = exp ? nd - 1 : nd - k;
+    }
+    if (!zero) {
+        k = st.k;
+    }
+    if (frac < 0) {
+        // This can happen when frac is trimmed to fit the buffer
+        frac = 0;
+    }
+
+    // Print the mantissa
+    int i = 0;
+    if (exp) {
+        *s++ = nd > 0 ? digs[i] : '0';
+        ++i;
+    } else if (k <= 0) {
+        *s++ = '0';
+        i = k;
+    } else {
+        for (; i < k; ++i) {
+            *s++ = i < nd ? digs[i] : '0';
+        }
+    }
+    if (frac > 0) {
+        *s++ = '.';
+        for (int end = i + frac; i < end; ++i) {
+            *s++ = i >= 0 && i < nd ? digs[i] : '0';
+        }
+        if (strip) {
+            // Remove trailing zeros and a trailing decimal point
+            while (s[-1] == '0') {
+                s--;
+            }
+            if (s[-1] == '.') {
+                s--;
+            }
+        }
+    }
+
+    // Append the exponent
+    if (exp) {
+        int x = k - 1;
+        *s++ = e_char;
+        if (x < 0) {
+            *s++ = '-';
+            x = -x;
+        } else {
+            *s++ = '+';
+        }
+        if (x >= 100) {
+            *s++ = '0' + (x / 100);
+        }
+        *s++ = '0' + ((x / 10) % 10);
+        *s++ = '0' + (x % 10);
+    }
+    return s;
+}
+
+// Compare (dec + more / 2) * 10^exp with odd * 2^e.
+STATIC int fp_cmp_decimal(uint64_t dec, bool more, int exp, uint64_t odd, int e) {
+    fpbig_t a, b;
+    fpbig_set(&a, dec);
+    fpbig_set(&b, odd);
+    if (more) {
+        fpbig_shl(&a, 1);
+        a.d[0] |= 1;
+        ++e;
+    }
+    if (exp >= 0) {
+        fpbig_mul_pow10(&a, exp);
+    } else {
+        fpbig_mul_pow10(&b, -exp);
+    }
+    if (e >= 0) {
+        fpbig_shl(&b, e);
+    } else {
+        fpbig_shl(&a, -e);
+    }
+    return fpbig_cmp(&a, &b);
+}
+
+FPTYPE mp_float_round_decimal(FPTYPE approx, uint64_t dec, int exp, bool more) {
+    if (!more && dec >> (FPMANT_BITS + 1) == 0 && exp >= -FPEXACT_POW10 && exp <= FPEXACT_POW10) {
+        // dec and 10^|exp| are exact, so approx came from one rounding
+        return approx;
+    }
+    if (dec == 0) {
+        return 0;
+    }
+    union {
+        FPTYPE f;
+        #if MICROPY_FLOAT_IMPL == MICROPY_FLOAT_IMPL_FLOAT
+        uint32_t u;
+        #else
+        uint64_t u;
+        #endif
+    } x = {approx};
+    if (fp_iszero(x.f)) {
+        if (exp < FPDEC_EXP_MIN) {
+            return x.f;
+        }
+        // start from the smallest float
+        ++x.u;
+    } else if (fp_isinf(x.f)) {
+        if (exp > FPDEC_EXP_MAX) {
+            return x.f;
+        }
+        // start from the largest float
+        --x.u;
+    }
+    for (;;) {
+        uint64_t mant;
+        int e;
+        int unequal = fp_decode(x.f, &mant, &e);
+        // step up or down a float while the value is past a halfway point,
+        // with a tie going to the even mantissa
+        int c = fp_cmp_decimal(dec, more, exp, 2 * mant + 1, e - 1);
+        if (c > 0 || (c == 0 && (mant & 1))) {
+            ++x.u;
+            if (fp_isinf(x.f)) {
+                break;
+            }
+            continue;
+        }
+        c = fp_cmp_decimal(dec, more, exp, (2 * mant << unequal) - 1, e - 1 - unequal);
+        if (c < 0 || (c == 0 && (mant & 1))) {
+            --x.u;
+            if (fp_iszero(x.f)) {
+                break;
+            }
+            continue;
+        }
+        break;
+    }
+    return x.f;
+}
+
+#else
+
 static const FPTYPE g_pos_pow[] = {
     #if FPDECEXP > 32
     1e256, 1e128, 1e64,
@@ -102,6 +736,8 @@ static const FPTYPE g_neg_pow[] = {
     1e-32, 1e-16, 1e-8, 1e-4, 1e-2, 1e-1
 };
 
+#endif
+
 int mp_format_float(FPTYPE f, char *buf, size_t buf_size, char fmt, int prec, char sign) {
 
     char *s = buf;
@@ -152,6 +788,13 @@ int mp_format_float(FPTYPE f, char *buf, size_t buf_size, char fmt, int prec, ch
     if (prec < 0) {
         prec = 6;
     }
+
+    #if MICROPY_FLOAT_FORMAT_EXACT
+
+    s = fp_format_exact(s, buf_remaining, f, fmt, prec);
+
+    #else
+
     char e_char = 'E' | (fmt & 0x20);   // e_char will match case of fmt
     fmt |= 0x20; // Force fmt to be lowercase
     char org_fmt = fmt;
@@ -418,6 +1061,9 @@ int mp_format_float(FPTYPE f, char *buf, size_t buf_size, char fmt, int prec, ch
         *s++ = '0' + ((e / 10) % 10);
         *s++ = '0' + (e % 10);
     }
+
+    #endif
+
     *s = '\0';
 
     // verify that we did not overrun the input buffer
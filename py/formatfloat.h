@@ -26,10 +26,21 @@
 #ifndef MICROPY_INCLUDED_PY_FORMATFLOAT_H
 #define MICROPY_INCLUDED_PY_FORMATFLOAT_H
 
+#include <stdbool.h>
+#include <stdint.h>
+
 #include "py/mpconfig.h"
 
 #if MICROPY_PY_BUILTINS_FLOAT
+// fmt is one of e, f, g and their capitals, or with MICROPY_FLOAT_FORMAT_EXACT
+// also r, which gives the shortest digits that read back as f laid out as by repr
 int mp_format_float(mp_float_t f, char *buf, size_t bufSize, char fmt, int prec, char sign);
+#if MICROPY_FLOAT_FORMAT_EXACT
+// Return the float nearest to dec * 10^exp, given approx within a few floats of
+// it; more says nonzero digits were left off dec, which counts them as half of
+// its last digit.
+mp_float_t mp_float_round_decimal(mp_float_t approx, uint64_t dec, int exp, bool more);
+#endif
 #endif
 
 #endif // MICROPY_INCLUDED_PY_FORMATFLOAT_H
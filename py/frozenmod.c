@@ -31,6 +31,51 @@
 #include "py/lexer.h"
 #include "py/frozenmod.h"
 
+#if MICROPY_MODULE_FROZEN
+
+// The names of the frozen modules of each kind, with the hash index generated
+// by tools/frozen_index.py.  A slot of the index holds the position of
+// a name in the list + 1, with FROZEN_INDEX_DIR set if the slot is for the
+// directory the name is in, or 0 if it's empty.
+typedef struct _frozen_list_t {
+    const char *names;
+    const uint16_t *name_offsets;
+    const uint16_t *index;
+    const uint16_t *index_size;
+} frozen_list_t;
+
+#define FROZEN_INDEX_DIR (0x8000)
+
+STATIC uint32_t frozen_hash(const char *str, size_t len) {
+    // djb2, as name_hash in tools/frozen_index.py
+    uint32_t hash = 5381;
+    const byte *p = (const byte*)str;
+    for (const byte *top = p + len; p < top; p++) {
+        hash = (hash * 33) ^ *p;
+    }
+    return hash;
+}
+
+// Return the position in the list of the module called str, or, if dir is
+// true, of a module in the directory called str, or -1 if there isn't one.
+STATIC int frozen_find(const frozen_list_t *list, const char *str, size_t len, bool dir) {
+    size_t mask = *list->index_size - 1;
+    for (size_t i = frozen_hash(str, len) & mask; list->index[i] != 0; i = (i + 1) & mask) {
+        uint16_t slot = list->index[i];
+        if (((slot & FROZEN_INDEX_DIR) != 0) != dir) {
+            continue;
+        }
+        int n = (slot & ~FROZEN_INDEX_DIR) - 1;
+        const char *name = list->names + list->name_offsets[n];
+        if (strncmp(name, str, len) == 0 && name[len] == (dir ? '/' : '\0')) {
+            return n;
+        }
+    }
+    return -1;
+}
+
+#endif
+
 #if MICROPY_MODULE_FROZEN_STR
 
 #ifndef MICROPY_MODULE_FROZEN_LEXER
@@ -40,9 +85,16 @@ mp_lexer_t *MICROPY_MODULE_FROZEN_LEXER(qstr src_name, const char *str, mp_uint_
 #endif
 
 extern const char mp_frozen_str_names[];
+extern const uint16_t mp_frozen_str_name_offsets[];
+extern const uint16_t mp_frozen_str_index[];
+extern const uint16_t mp_frozen_str_index_size;
 extern const uint32_t mp_frozen_str_sizes[];
 extern const char mp_frozen_str_content[];
 
+STATIC const frozen_list_t frozen_str_list = {
+    mp_frozen_str_names, mp_frozen_str_name_offsets, mp_frozen_str_index, &mp_frozen_str_index_size
+};
+
 // str_len is length of str. *len is set on on output to size of content
 const char *mp_find_frozen_str(const char *str, size_t str_len, size_t *len) {
     // If the frozen module pseudo dir (e.g., ".frozen/") is a prefix of str, remove it.
@@ -51,19 +103,16 @@ const char *mp_find_frozen_str(const char *str, size_t str_len, size_t *len) {
         str_len = str_len - MP_FROZEN_FAKE_DIR_SLASH_LENGTH;
     }
 
-    const char *name = mp_frozen_str_names;
-
+    int n = frozen_find(&frozen_str_list, str, str_len, false);
+    if (n < 0) {
+        return NULL;
+    }
     size_t offset = 0;
-    for (int i = 0; *name != 0; i++) {
-        size_t l = strlen(name);
-        if (l == str_len && !memcmp(str, name, l)) {
-            *len = mp_frozen_str_sizes[i];
-            return mp_frozen_str_content + offset;
-        }
-        name += l + 1;
+    for (int i = 0; i < n; i++) {
         offset += mp_frozen_str_sizes[i] + 1;
     }
-    return NULL;
+    *len = mp_frozen_str_sizes[n];
+    return mp_frozen_str_content + offset;
 }
 
 STATIC mp_lexer_t *mp_lexer_frozen_str(const char *str, size_t str_len) {
@@ -85,37 +134,30 @@ STATIC mp_lexer_t *mp_lexer_frozen_str(const char *str, size_t str_len) {
 #include "py/emitglue.h"
 
 extern const char mp_frozen_mpy_names[];
+extern const uint16_t mp_frozen_mpy_name_offsets[];
+extern const uint16_t mp_frozen_mpy_index[];
+extern const uint16_t mp_frozen_mpy_index_size;
 extern const mp_raw_code_t *const mp_frozen_mpy_content[];
 
+STATIC const frozen_list_t frozen_mpy_list = {
+    mp_frozen_mpy_names, mp_frozen_mpy_name_offsets, mp_frozen_mpy_index, &mp_frozen_mpy_index_size
+};
+
 STATIC const mp_raw_code_t *mp_find_frozen_mpy(const char *str, size_t str_len) {
-    const char *name = mp_frozen_mpy_names;
-    for (size_t i = 0; *name != 0; i++) {
-        size_t l = strlen(name);
-        if (l == str_len && !memcmp(str, name, l)) {
-            return mp_frozen_mpy_content[i];
-        }
-        name += l + 1;
-    }
-    return NULL;
+    int n = frozen_find(&frozen_mpy_list, str, str_len, false);
+    return n < 0 ? NULL : mp_frozen_mpy_content[n];
 }
 
 #endif
 
 #if MICROPY_MODULE_FROZEN
 
-STATIC mp_import_stat_t mp_frozen_stat_helper(const char *name, const char *str) {
+STATIC mp_import_stat_t mp_frozen_stat_helper(const frozen_list_t *list, const char *str) {
     size_t len = strlen(str);
-
-    for (int i = 0; *name != 0; i++) {
-        size_t l = strlen(name);
-        if (l >= len && !memcmp(str, name, len)) {
-            if (name[len] == 0) {
-                return MP_IMPORT_STAT_FILE;
-            } else if (name[len] == '/') {
-                return MP_IMPORT_STAT_DIR;
-            }
-        }
-        name += l + 1;
+    if (frozen_find(list, str, len, false) >= 0) {
+        return MP_IMPORT_STAT_FILE;
+    } else if (frozen_find(list, str, len, true) >= 0) {
+        return MP_IMPORT_STAT_DIR;
     }
     return MP_IMPORT_STAT_NO_EXIST;
 }
@@ -124,14 +166,14 @@ mp_import_stat_t mp_frozen_stat(const char *str) {
     mp_import_stat_t stat;
 
     #if MICROPY_MODULE_FROZEN_STR
-    stat = mp_frozen_stat_helper(mp_frozen_str_names, str);
+    stat = mp_frozen_stat_helper(&frozen_str_list, str);
     if (stat != MP_IMPORT_STAT_NO_EXIST) {
         return stat;
     }
     #endif
 
     #if MICROPY_MODULE_FROZEN_MPY
-    stat = mp_frozen_stat_helper(mp_frozen_mpy_names, str);
+    stat = mp_frozen_stat_helper(&frozen_mpy_list, str);
     if (stat != MP_IMPORT_STAT_NO_EXIST) {
         return stat;
     }
@@ -30,6 +30,12 @@
 
 #include "py/gc.h"
 #include "py/runtime.h"
+#if MICROPY_GC_COMPACT
+#include "py/objlist.h"
+#endif
+#if MICROPY_GC_GENERATIONAL
+#include "py/mphal.h"
+#endif
 
 #include "supervisor/shared/safe_mode.h"
 
@@ -89,6 +95,28 @@
 #define FTB_CLEAR(block) do { MP_STATE_MEM(gc_finaliser_table_start)[(block) / BLOCKS_PER_FTB] &= (~(1 << ((block) & 7))); } while (0)
 #endif
 
+#if MICROPY_GC_GENERATIONAL
+// whether the block is traced and swept by the current collection
+#define BLOCK_IS_COLLECTED(block) ((block) < MP_STATE_MEM(gc_young_end_block))
+#else
+#define BLOCK_IS_COLLECTED(block) (1)
+#endif
+
+#if MICROPY_GC_COMPACT
+// Storage owned by a container that compaction may move.  Block numbers are
+// kept rather than pointers so that the candidates themselves don't look
+// like references to the storage when the C stack is scanned.
+typedef struct _gc_compact_candidate_t {
+    size_t start;
+    size_t n_blocks;
+    size_t owner;   // head block of the container
+    void **field;   // where the container keeps its pointer to the storage
+    bool pinned;
+} gc_compact_candidate_t;
+
+STATIC void gc_compact_pin(void **ptrs, size_t len);
+#endif
+
 #if MICROPY_PY_THREAD && !MICROPY_PY_THREAD_GIL
 #define GC_ENTER() mp_thread_mutex_lock(&MP_STATE_MEM(gc_mutex), 1)
 #define GC_EXIT() mp_thread_mutex_unlock(&MP_STATE_MEM(gc_mutex))
@@ -108,6 +136,202 @@ void __attribute__ ((noinline)) gc_log_change(uint32_t start_block, uint32_t len
 #pragma GCC pop_options
 #endif
 
+#if MICROPY_GC_FREE_LISTS
+STATIC void gc_free_lists_clear(void) {
+    for (size_t i = 0; i < MICROPY_GC_FREE_LIST_MAX_BLOCKS - 1; i++) {
+        MP_STATE_MEM(gc_free_lists)[i].len = 0;
+    }
+}
+
+// Remember a run of free blocks.  Only the part below the long lived section
+// is kept, so that short lived allocations stay out of it until a collection.
+// Single blocks aren't kept: the linear search finds those straight away.
+STATIC void gc_free_lists_add(size_t start, size_t len) {
+    size_t crossover_block = BLOCK_FROM_PTR(MP_STATE_MEM(gc_lowest_long_lived_ptr));
+    if (start >= crossover_block) {
+        return;
+    }
+    if (start + len > crossover_block) {
+        len = crossover_block - start;
+    }
+    if (len < 2) {
+        return;
+    }
+    size_t n = MIN(len, MICROPY_GC_FREE_LIST_MAX_BLOCKS);
+    mp_gc_free_list_t *list = &MP_STATE_MEM(gc_free_lists)[n - 2];
+    if (list->len < MICROPY_GC_FREE_LIST_LEN) {
+        list->runs[list->len].start = start;
+        list->runs[list->len].len = len;
+        list->len++;
+    }
+}
+
+// Move the first free ATB index past ATB bytes that have no free blocks, so
+// that the linear search in gc_alloc doesn't rescan blocks handed out from
+// the free lists.
+STATIC void gc_free_lists_skip_used(void) {
+    size_t i = MP_STATE_MEM(gc_first_free_atb_index);
+    while (i < MP_STATE_MEM(gc_alloc_table_byte_len)) {
+        byte a = MP_STATE_MEM(gc_alloc_table_start)[i];
+        if (((a | (a >> 1)) & 0x55) != 0x55) {
+            break;
+        }
+        i++;
+    }
+    MP_STATE_MEM(gc_first_free_atb_index) = i;
+}
+
+// Take n_blocks free blocks from the smallest size class that has a run for
+// them, putting any remainder of the run back.  Returns the first block, or
+// (size_t)-1 if the lists have nothing suitable.
+STATIC size_t gc_free_lists_take(size_t n_blocks) {
+    size_t crossover_block = BLOCK_FROM_PTR(MP_STATE_MEM(gc_lowest_long_lived_ptr));
+    for (size_t n = n_blocks; n <= MICROPY_GC_FREE_LIST_MAX_BLOCKS; n++) {
+        mp_gc_free_list_t *list = &MP_STATE_MEM(gc_free_lists)[n - 2];
+        while (list->len > 0) {
+            mp_gc_free_run_t run = list->runs[--list->len];
+            if (run.start + n_blocks > crossover_block) {
+                continue;
+            }
+            // The run may have been allocated from since it was recorded, by
+            // the linear search or by gc_realloc.  Keep what lies beyond the
+            // first used block.
+            size_t i = 0;
+            while (i < n_blocks && ATB_GET_KIND(run.start + i) == AT_FREE) {
+                i++;
+            }
+            if (i < n_blocks) {
+                size_t rest = MAX(run.start + i + 1, MP_STATE_MEM(gc_first_free_atb_index) * BLOCKS_PER_ATB);
+                if (rest < run.start + run.len) {
+                    gc_free_lists_add(rest, run.start + run.len - rest);
+                }
+                continue;
+            }
+            if (run.len > n_blocks) {
+                gc_free_lists_add(run.start + n_blocks, run.len - n_blocks);
+            }
+            return run.start;
+        }
+    }
+    return (size_t)-1;
+}
+#endif
+
+#if MICROPY_GC_TLAB
+// A thread's allocation buffer is a run of MICROPY_GC_TLAB_BLOCKS blocks that
+// starts on an ATB byte, so the ATB bytes covering it belong to that thread
+// alone.  The unused part of the buffer is kept as one allocated run, which
+// other allocations skip, and the thread carves objects off the front of it
+// without the GC mutex.  Nothing else may write to the buffer's ATB bytes
+// while the thread has it: gc_free and gc_realloc leave blocks in a buffer
+// alone, and a collection returns the unused parts of all the buffers while
+// the other threads are stopped outside gc_tlab_alloc.
+
+// Whether the block is in the allocation buffer of any thread.  The GC mutex
+// must be held.
+STATIC bool gc_tlab_contains(size_t block) {
+    for (mp_state_thread_t *ts = MP_STATE_MEM(gc_tlab_threads); ts != NULL; ts = ts->gc_tlab_next) {
+        if (ts->gc_tlab_start <= block && block < ts->gc_tlab_end) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Free the unused part of the thread's buffer and forget the buffer.  The GC
+// mutex must be held and the thread must not be in gc_tlab_alloc.
+STATIC void gc_tlab_release(mp_state_thread_t *ts) {
+    if (ts->gc_tlab_end == 0) {
+        return;
+    }
+    size_t cur = ts->gc_tlab_cur;
+    size_t end = ts->gc_tlab_end;
+    for (size_t bl = cur; bl < end; bl++) {
+        ATB_ANY_TO_FREE(bl);
+    }
+    if (cur < end) {
+        if (cur / BLOCKS_PER_ATB < MP_STATE_MEM(gc_first_free_atb_index)) {
+            MP_STATE_MEM(gc_first_free_atb_index) = cur / BLOCKS_PER_ATB;
+        }
+        #if MICROPY_GC_FREE_LISTS
+        gc_free_lists_add(cur, end - cur);
+        #endif
+    }
+    mp_state_thread_t **prev = &MP_STATE_MEM(gc_tlab_threads);
+    while (*prev != ts) {
+        prev = &(*prev)->gc_tlab_next;
+    }
+    *prev = ts->gc_tlab_next;
+    ts->gc_tlab_start = 0;
+    ts->gc_tlab_cur = 0;
+    ts->gc_tlab_end = 0;
+}
+
+// Replace the thread's buffer with a new one from the short lived part of the
+// heap.  The GC mutex must be held.  Returns false if there's no room, in
+// which case no more buffers are handed out until the next collection.
+STATIC bool gc_tlab_refill(mp_state_thread_t *ts) {
+    gc_tlab_release(ts);
+    const size_t n_atb = MICROPY_GC_TLAB_BLOCKS / BLOCKS_PER_ATB;
+    size_t crossover_atb = BLOCK_FROM_PTR(MP_STATE_MEM(gc_lowest_long_lived_ptr)) / BLOCKS_PER_ATB;
+    size_t n_free = 0;
+    size_t i = MAX(MP_STATE_MEM(gc_tlab_next_atb_index), MP_STATE_MEM(gc_first_free_atb_index));
+    for (; i < crossover_atb; i++) {
+        if (MP_STATE_MEM(gc_alloc_table_start)[i] != 0) {
+            n_free = 0;
+        } else if (++n_free == n_atb) {
+            size_t start = (i + 1 - n_atb) * BLOCKS_PER_ATB;
+            size_t end = start + MICROPY_GC_TLAB_BLOCKS;
+            ATB_FREE_TO_HEAD(start);
+            for (size_t bl = start + 1; bl < end; bl++) {
+                ATB_FREE_TO_TAIL(bl);
+            }
+            #if MICROPY_GC_ALLOC_THRESHOLD
+            MP_STATE_MEM(gc_alloc_amount) += MICROPY_GC_TLAB_BLOCKS;
+            #endif
+            ts->gc_tlab_start = start;
+            ts->gc_tlab_cur = start;
+            ts->gc_tlab_end = end;
+            ts->gc_tlab_next = MP_STATE_MEM(gc_tlab_threads);
+            MP_STATE_MEM(gc_tlab_threads) = ts;
+            MP_STATE_MEM(gc_tlab_next_atb_index) = i + 1;
+            return true;
+        }
+    }
+    MP_STATE_MEM(gc_tlab_next_atb_index) = i;
+    return false;
+}
+
+// Take n_blocks from the front of the thread's buffer, by moving the head of
+// the unused part past them.  Only the thread itself may call this, and it
+// doesn't need the GC mutex.  Returns NULL if the buffer is too small.
+STATIC void *gc_tlab_alloc(mp_state_thread_t *ts, size_t n_blocks) {
+    void *ret_ptr = NULL;
+    ts->gc_tlab_busy = true;
+    size_t cur = ts->gc_tlab_cur;
+    size_t end = ts->gc_tlab_end;
+    if (end - cur >= n_blocks) {
+        size_t next = cur + n_blocks;
+        if (next < end) {
+            // volatile so the write stays between the stores to gc_tlab_busy
+            volatile byte *a = &MP_STATE_MEM(gc_alloc_table_start)[next / BLOCKS_PER_ATB];
+            *a = (*a & ~(AT_MARK << BLOCK_SHIFT(next))) | (AT_HEAD << BLOCK_SHIFT(next));
+        }
+        ts->gc_tlab_cur = next;
+        ret_ptr = (void*)PTR_FROM_BLOCK(cur);
+    }
+    ts->gc_tlab_busy = false;
+    return ret_ptr;
+}
+
+// Called by a thread before it finishes.
+void gc_tlab_flush(void) {
+    GC_ENTER();
+    gc_tlab_release(mp_thread_get_state());
+    GC_EXIT();
+}
+#endif
+
 // TODO waste less memory; currently requires that all entries in alloc_table have a corresponding block in pool
 void gc_init(void *start, void *end) {
     // align end pointer on block boundary
@@ -169,6 +393,30 @@ void gc_init(void *start, void *end) {
     MP_STATE_MEM(gc_alloc_amount) = 0;
     #endif
 
+    #if MICROPY_GC_FREE_LISTS
+    // the whole heap starts out as a single free run
+    gc_free_lists_clear();
+    gc_free_lists_add(0, MP_STATE_MEM(gc_alloc_table_byte_len) * BLOCKS_PER_ATB);
+    #endif
+
+    #if MICROPY_GC_TLAB
+    MP_STATE_MEM(gc_tlab_threads) = NULL;
+    MP_STATE_MEM(gc_tlab_enabled) = false;
+    MP_STATE_MEM(gc_tlab_next_atb_index) = 0;
+    mp_state_ctx.thread.gc_tlab_end = 0;
+    #endif
+
+    #if MICROPY_GC_GENERATIONAL
+    MP_STATE_MEM(gc_young_end_block) = MP_STATE_MEM(gc_alloc_table_byte_len) * BLOCKS_PER_ATB;
+    MP_STATE_MEM(gc_minor_requested) = false;
+    MP_STATE_MEM(gc_max_pause_us) = MICROPY_GC_MAX_PAUSE_US;
+    MP_STATE_MEM(gc_last_full_pause_us) = 0;
+    MP_STATE_MEM(gc_n_minor) = 0;
+    MP_STATE_MEM(gc_n_full) = 0;
+    MP_STATE_MEM(gc_longest_pause_us) = 0;
+    memset(MP_STATE_MEM(gc_pause_hist), 0, sizeof(MP_STATE_MEM(gc_pause_hist)));
+    #endif
+
     #if MICROPY_PY_THREAD
     mp_thread_mutex_init(&MP_STATE_MEM(gc_mutex));
     #endif
@@ -235,7 +483,7 @@ STATIC void gc_mark_subtree(size_t block) {
             if (VERIFY_PTR(ptr)) {
                 // Mark and push this pointer
                 size_t childblock = BLOCK_FROM_PTR(ptr);
-                if (ATB_GET_KIND(childblock) == AT_HEAD) {
+                if (BLOCK_IS_COLLECTED(childblock) && ATB_GET_KIND(childblock) == AT_HEAD) {
                     // an unmarked head, mark it, and push it on gc stack
                     TRACE_MARK(childblock, ptr);
                     ATB_HEAD_TO_MARK(childblock);
@@ -263,7 +511,7 @@ STATIC void gc_deal_with_stack_overflow(void) {
         MP_STATE_MEM(gc_stack_overflow) = 0;
 
         // scan entire memory looking for blocks which have been marked but not their children
-        for (size_t block = 0; block < MP_STATE_MEM(gc_alloc_table_byte_len) * BLOCKS_PER_ATB; block++) {
+        for (size_t block = 0; block < MP_STATE_MEM(gc_alloc_table_byte_len) * BLOCKS_PER_ATB && BLOCK_IS_COLLECTED(block); block++) {
             // trace (again) if mark bit set
             if (ATB_GET_KIND(block) == AT_MARK) {
                 gc_mark_subtree(block);
@@ -276,9 +524,22 @@ STATIC void gc_sweep(void) {
     #if MICROPY_PY_GC_COLLECT_RETVAL
     MP_STATE_MEM(gc_collected) = 0;
     #endif
+    #if MICROPY_GC_FREE_LISTS
+    // rebuild the free lists from the runs of free blocks left by the sweep
+    gc_free_lists_clear();
+    size_t run_start = 0;
+    size_t run_len = 0;
+    #endif
     // free unmarked heads and their tails
     int free_tail = 0;
     for (size_t block = 0; block < MP_STATE_MEM(gc_alloc_table_byte_len) * BLOCKS_PER_ATB; block++) {
+        #if MICROPY_GC_GENERATIONAL
+        // The old generation isn't swept by a minor collection, but the tail
+        // of an object that straddles the boundary is.
+        if (!BLOCK_IS_COLLECTED(block) && !(free_tail && ATB_GET_KIND(block) == AT_TAIL)) {
+            break;
+        }
+        #endif
         switch (ATB_GET_KIND(block)) {
             case AT_HEAD:
 #if MICROPY_ENABLE_FINALISER
@@ -332,14 +593,29 @@ STATIC void gc_sweep(void) {
                 free_tail = 0;
                 break;
         }
+        #if MICROPY_GC_FREE_LISTS
+        if (ATB_GET_KIND(block) == AT_FREE) {
+            if (run_len++ == 0) {
+                run_start = block;
+            }
+        } else if (run_len != 0) {
+            gc_free_lists_add(run_start, run_len);
+            run_len = 0;
+        }
+        #endif
+    }
+    #if MICROPY_GC_FREE_LISTS
+    if (run_len != 0) {
+        gc_free_lists_add(run_start, run_len);
     }
+    #endif
 }
 
 // Mark can handle NULL pointers because it verifies the pointer is within the heap bounds.
 STATIC void gc_mark(void* ptr) {
     if (VERIFY_PTR(ptr)) {
         size_t block = BLOCK_FROM_PTR(ptr);
-        if (ATB_GET_KIND(block) == AT_HEAD) {
+        if (BLOCK_IS_COLLECTED(block) && ATB_GET_KIND(block) == AT_HEAD) {
             // An unmarked head: mark it, and mark all its children
             TRACE_MARK(block, ptr);
             ATB_HEAD_TO_MARK(block);
@@ -348,14 +624,74 @@ STATIC void gc_mark(void* ptr) {
     }
 }
 
+#if MICROPY_GC_GENERATIONAL
+// There is no write barrier on pointer stores, so instead of keeping a
+// remembered set every allocated block of the old generation is treated as a
+// root.  This keeps any young object it refers to alive without tracing
+// through, or sweeping, the old generation itself.
+STATIC void gc_scan_old_generation(void) {
+    size_t total_blocks = MP_STATE_MEM(gc_alloc_table_byte_len) * BLOCKS_PER_ATB;
+    size_t block = MP_STATE_MEM(gc_young_end_block);
+    // skip the tail of a young object that straddles the boundary
+    while (block < total_blocks && ATB_GET_KIND(block) == AT_TAIL) {
+        block++;
+    }
+    for (; block < total_blocks; block++) {
+        if (ATB_GET_KIND(block) != AT_FREE) {
+            gc_collect_root((void**)PTR_FROM_BLOCK(block), WORDS_PER_BLOCK);
+        }
+    }
+}
+
+STATIC void gc_record_pause(void) {
+    uint32_t pause = mp_hal_ticks_us() - MP_STATE_MEM(gc_collect_start_us);
+    if (MP_STATE_MEM(gc_young_end_block) < MP_STATE_MEM(gc_alloc_table_byte_len) * BLOCKS_PER_ATB) {
+        MP_STATE_MEM(gc_n_minor)++;
+    } else {
+        MP_STATE_MEM(gc_n_full)++;
+        MP_STATE_MEM(gc_last_full_pause_us) = pause;
+    }
+    if (pause > MP_STATE_MEM(gc_longest_pause_us)) {
+        MP_STATE_MEM(gc_longest_pause_us) = pause;
+    }
+    size_t bucket = 0;
+    for (uint32_t t = pause >> 6; t != 0 && bucket < MICROPY_GC_PAUSE_HIST_LEN - 1; t >>= 1) {
+        bucket++;
+    }
+    MP_STATE_MEM(gc_pause_hist)[bucket]++;
+}
+#endif
+
 void gc_collect_start(void) {
     GC_ENTER();
+    #if MICROPY_PY_THREAD_GC_STOP_WORLD
+    // a stopped thread can't be holding the GC mutex, so it's safe to stop
+    // them all here; they stay stopped until marking is complete
+    mp_thread_gc_stop_others();
+    #endif
+    #if MICROPY_GC_TLAB
+    // no thread is allocating from its buffer now, so the unused parts can
+    // be freed; they'd otherwise look like live objects to the sweep
+    while (MP_STATE_MEM(gc_tlab_threads) != NULL) {
+        gc_tlab_release(MP_STATE_MEM(gc_tlab_threads));
+    }
+    MP_STATE_MEM(gc_tlab_next_atb_index) = 0;
+    #endif
     MP_STATE_MEM(gc_lock_depth)++;
     #if MICROPY_GC_ALLOC_THRESHOLD
     MP_STATE_MEM(gc_alloc_amount) = 0;
     #endif
     MP_STATE_MEM(gc_stack_overflow) = 0;
 
+    #if MICROPY_GC_GENERATIONAL
+    MP_STATE_MEM(gc_collect_start_us) = mp_hal_ticks_us();
+    if (MP_STATE_MEM(gc_minor_requested)) {
+        MP_STATE_MEM(gc_young_end_block) = BLOCK_FROM_PTR(MP_STATE_MEM(gc_lowest_long_lived_ptr));
+        MP_STATE_MEM(gc_minor_requested) = false;
+        gc_scan_old_generation();
+    }
+    #endif
+
     // Trace root pointers.  This relies on the root pointers being organised
     // correctly in the mp_state_ctx structure.  We scan nlr_top, dict_locals,
     // dict_globals, then the root pointer section of mp_state_vm.
@@ -374,10 +710,16 @@ void gc_collect_start(void) {
 }
 
 void gc_collect_ptr(void *ptr) {
+    #if MICROPY_GC_COMPACT
+    gc_compact_pin(&ptr, 1);
+    #endif
     gc_mark(ptr);
 }
 
 void gc_collect_root(void **ptrs, size_t len) {
+    #if MICROPY_GC_COMPACT
+    gc_compact_pin(ptrs, len);
+    #endif
     for (size_t i = 0; i < len; i++) {
         void *ptr = ptrs[i];
         gc_mark(ptr);
@@ -386,9 +728,18 @@ void gc_collect_root(void **ptrs, size_t len) {
 
 void gc_collect_end(void) {
     gc_deal_with_stack_overflow();
+    #if MICROPY_PY_THREAD_GC_STOP_WORLD
+    // unmarked blocks can't be reached by any thread, so the others can run
+    // while they're swept; allocating or freeing still needs the GC mutex
+    mp_thread_gc_resume_others();
+    #endif
     gc_sweep();
     MP_STATE_MEM(gc_first_free_atb_index) = 0;
     MP_STATE_MEM(gc_last_free_atb_index) = MP_STATE_MEM(gc_alloc_table_byte_len) - 1;
+    #if MICROPY_GC_GENERATIONAL
+    gc_record_pause();
+    MP_STATE_MEM(gc_young_end_block) = MP_STATE_MEM(gc_alloc_table_byte_len) * BLOCKS_PER_ATB;
+    #endif
     MP_STATE_MEM(gc_lock_depth)--;
     GC_EXIT();
 }
@@ -397,6 +748,9 @@ void gc_sweep_all(void) {
     GC_ENTER();
     MP_STATE_MEM(gc_lock_depth)++;
     MP_STATE_MEM(gc_stack_overflow) = 0;
+    #if MICROPY_GC_GENERATIONAL
+    MP_STATE_MEM(gc_collect_start_us) = mp_hal_ticks_us();
+    #endif
     gc_collect_end();
 }
 
@@ -464,6 +818,41 @@ void gc_info(gc_info_t *info) {
     GC_EXIT();
 }
 
+// Run a collection on behalf of gc_alloc.  With a pause target set and a full
+// collection known to exceed it, a minor collection is run instead if allowed.
+// Returns true if it was a minor collection, so a full one may free more.
+STATIC bool gc_collect_for_alloc(bool allow_minor) {
+    #if MICROPY_GC_GENERATIONAL
+    if (allow_minor && MP_STATE_MEM(gc_max_pause_us) != 0
+        && MP_STATE_MEM(gc_last_full_pause_us) > MP_STATE_MEM(gc_max_pause_us)
+        && (byte*)MP_STATE_MEM(gc_lowest_long_lived_ptr) < MP_STATE_MEM(gc_pool_end)) {
+        MP_STATE_MEM(gc_minor_requested) = true;
+        gc_collect();
+        MP_STATE_MEM(gc_minor_requested) = false;
+        return true;
+    }
+    #else
+    (void)allow_minor;
+    #endif
+    gc_collect();
+    return false;
+}
+
+STATIC void gc_clear_new_blocks(void *ret_ptr, size_t n_bytes, size_t n_blocks) {
+    #if MICROPY_GC_CONSERVATIVE_CLEAR
+    // be conservative and zero out all the newly allocated blocks
+    (void)n_bytes;
+    memset((byte*)ret_ptr, 0, n_blocks * BYTES_PER_BLOCK);
+    #else
+    // zero out the additional bytes of the newly allocated blocks
+    // This is needed because the blocks may have previously held pointers
+    // to the heap and will not be set to something else if the caller
+    // doesn't actually use the entire block.  As such they will continue
+    // to point to the heap and may prevent other blocks from being reclaimed.
+    memset((byte*)ret_ptr + n_bytes, 0, n_blocks * BYTES_PER_BLOCK - n_bytes);
+    #endif
+}
+
 // We place long lived objects at the end of the heap rather than the start. This reduces
 // fragmentation by localizing the heap churn to one portion of memory (the start of the heap.)
 void *gc_alloc(size_t n_bytes, bool has_finaliser, bool long_lived) {
@@ -479,6 +868,22 @@ void *gc_alloc(size_t n_bytes, bool has_finaliser, bool long_lived) {
         reset_into_safe_mode(GC_ALLOC_OUTSIDE_VM);
     }
 
+    #if MICROPY_GC_TLAB
+    // small short lived objects come from the thread's buffer if it has room
+    mp_state_thread_t *ts = NULL;
+    if (n_blocks <= MICROPY_GC_TLAB_BLOCKS / 4 && !has_finaliser && !long_lived
+        && MP_STATE_MEM(gc_tlab_enabled)) {
+        ts = mp_thread_get_state();
+        if (MP_STATE_MEM(gc_lock_depth) == 0) {
+            void *ret_ptr = gc_tlab_alloc(ts, n_blocks);
+            if (ret_ptr != NULL) {
+                gc_clear_new_blocks(ret_ptr, n_bytes, n_blocks);
+                return ret_ptr;
+            }
+        }
+    }
+    #endif
+
     GC_ENTER();
 
     // check if GC is locked
@@ -492,16 +897,36 @@ void *gc_alloc(size_t n_bytes, bool has_finaliser, bool long_lived) {
     size_t start_block;
     size_t n_free;
     bool collected = !MP_STATE_MEM(gc_auto_collect_enabled);
+    bool collected_minor = false;
 
     #if MICROPY_GC_ALLOC_THRESHOLD
     if (!collected && MP_STATE_MEM(gc_alloc_amount) >= MP_STATE_MEM(gc_alloc_threshold)) {
         GC_EXIT();
-        gc_collect();
+        collected_minor = gc_collect_for_alloc(true);
         collected = 1;
         GC_ENTER();
     }
     #endif
 
+    #if MICROPY_GC_TLAB
+    if (ts != NULL && gc_tlab_refill(ts)) {
+        void *ret_ptr = gc_tlab_alloc(ts, n_blocks);
+        GC_EXIT();
+        gc_clear_new_blocks(ret_ptr, n_bytes, n_blocks);
+        return ret_ptr;
+    }
+    #endif
+
+    #if MICROPY_GC_FREE_LISTS
+    if (!long_lived && n_blocks >= 2 && n_blocks <= MICROPY_GC_FREE_LIST_MAX_BLOCKS) {
+        start_block = gc_free_lists_take(n_blocks);
+        if (start_block != (size_t)-1) {
+            end_block = start_block + n_blocks - 1;
+            goto found;
+        }
+    }
+    #endif
+
     bool keep_looking = true;
 
     // When we start searching on the other side of the crossover block we make sure to
@@ -547,11 +972,11 @@ void *gc_alloc(size_t n_bytes, bool has_finaliser, bool long_lived) {
 
         GC_EXIT();
         // nothing found!
-        if (collected) {
+        if (collected && !collected_minor) {
             return NULL;
         }
         DEBUG_printf("gc_alloc(" UINT_FMT "): no free mem, triggering GC\n", n_bytes);
-        gc_collect();
+        collected_minor = gc_collect_for_alloc(!collected);
         collected = true;
         // Try again since we've hopefully freed up space.
         keep_looking = true;
@@ -579,6 +1004,9 @@ void *gc_alloc(size_t n_bytes, bool has_finaliser, bool long_lived) {
         }
     }
 
+    #if MICROPY_GC_FREE_LISTS
+found:
+    #endif
     #ifdef LOG_HEAP_ACTIVITY
     gc_log_change(start_block, end_block - start_block + 1);
     #endif
@@ -592,6 +1020,12 @@ void *gc_alloc(size_t n_bytes, bool has_finaliser, bool long_lived) {
         ATB_FREE_TO_TAIL(bl);
     }
 
+    #if MICROPY_GC_FREE_LISTS
+    if (!long_lived) {
+        gc_free_lists_skip_used();
+    }
+    #endif
+
     // get pointer to first block
     // we must create this pointer before unlocking the GC so a collection can find it
     void *ret_ptr = (void*)(MP_STATE_MEM(gc_pool_start) + start_block * BYTES_PER_BLOCK);
@@ -610,17 +1044,7 @@ void *gc_alloc(size_t n_bytes, bool has_finaliser, bool long_lived) {
 
     GC_EXIT();
 
-    #if MICROPY_GC_CONSERVATIVE_CLEAR
-    // be conservative and zero out all the newly allocated blocks
-    memset((byte*)ret_ptr, 0, (end_block - start_block + 1) * BYTES_PER_BLOCK);
-    #else
-    // zero out the additional bytes of the newly allocated blocks
-    // This is needed because the blocks may have previously held pointers
-    // to the heap and will not be set to something else if the caller
-    // doesn't actually use the entire block.  As such they will continue
-    // to point to the heap and may prevent other blocks from being reclaimed.
-    memset((byte*)ret_ptr + n_bytes, 0, (end_block - start_block + 1) * BYTES_PER_BLOCK - n_bytes);
-    #endif
+    gc_clear_new_blocks(ret_ptr, n_bytes, end_block - start_block + 1);
 
     #if MICROPY_ENABLE_FINALISER
     if (has_finaliser) {
@@ -672,6 +1096,15 @@ void gc_free(void *ptr) {
         size_t block = BLOCK_FROM_PTR(ptr);
         assert(ATB_GET_KIND(block) == AT_HEAD);
 
+        #if MICROPY_GC_TLAB
+        if (gc_tlab_contains(block)) {
+            // the owning thread writes to these ATB bytes without the GC
+            // mutex, so leave the blocks for the collector
+            GC_EXIT();
+            return;
+        }
+        #endif
+
         #if MICROPY_ENABLE_FINALISER
         FTB_CLEAR(block);
         #endif
@@ -688,11 +1121,18 @@ void gc_free(void *ptr) {
             #ifdef LOG_HEAP_ACTIVITY
             gc_log_change(block, 0);
             #endif
+        #if MICROPY_GC_FREE_LISTS
+        size_t start_block = block;
+        #endif
         do {
             ATB_ANY_TO_FREE(block);
             block += 1;
         } while (ATB_GET_KIND(block) == AT_TAIL);
 
+        #if MICROPY_GC_FREE_LISTS
+        gc_free_lists_add(start_block, block - start_block);
+        #endif
+
         GC_EXIT();
 
         #if EXTENSIVE_HEAP_PROFILING
@@ -765,6 +1205,253 @@ void *gc_make_long_lived(void *old_ptr) {
     return new_ptr;
 }
 
+#if MICROPY_GC_COMPACT
+// Compaction only moves the storage behind lists and dicts: their item arrays
+// and hash tables.  gc_realloc already moves these whenever they grow, so no
+// code may keep a pointer to them across an allocation, except on the C stack
+// for the duration of a call.  Anything that a root (C stack, registers, root
+// pointers) points into is pinned for the pass, as is anything with more than
+// the one reference from its container.  Buffers exposed through the buffer
+// protocol (and so possibly handed to DMA) are never moved.
+
+STATIC void gc_compact_pin(void **ptrs, size_t len) {
+    gc_compact_candidate_t *cand = MP_STATE_MEM(gc_compact_candidates);
+    size_t n_cand = MP_STATE_MEM(gc_compact_n_candidates);
+    if (n_cand == 0) {
+        return;
+    }
+    for (size_t i = 0; i < len; i++) {
+        byte *ptr = ptrs[i];
+        for (size_t j = 0; j < n_cand; j++) {
+            if (ptr >= (byte*)PTR_FROM_BLOCK(cand[j].start)
+                && ptr < (byte*)PTR_FROM_BLOCK(cand[j].start + cand[j].n_blocks)) {
+                cand[j].pinned = true;
+            }
+        }
+    }
+}
+
+// Return where the object at the given head block keeps a pointer to storage
+// that compaction can move, or NULL.
+STATIC void **gc_compact_owned_field(size_t block) {
+    mp_obj_base_t *o = (mp_obj_base_t*)PTR_FROM_BLOCK(block);
+    if (o->type == &mp_type_list) {
+        return (void**)&((mp_obj_list_t*)o)->items;
+    }
+    if (o->type == &mp_type_dict
+        #if MICROPY_PY_COLLECTIONS_ORDEREDDICT
+        || o->type == &mp_type_ordereddict
+        #endif
+        ) {
+        mp_obj_dict_t *d = (mp_obj_dict_t*)o;
+        if (!d->map.is_fixed) {
+            return (void**)&d->map.table;
+        }
+    }
+    return NULL;
+}
+
+// Pick up to MICROPY_GC_COMPACT_BATCH pieces of storage that are furthest
+// from their end of the heap: short lived storage moves towards the start of
+// the heap and long lived storage towards the end.
+STATIC size_t gc_compact_select(gc_compact_candidate_t *cand) {
+    size_t total_blocks = MP_STATE_MEM(gc_alloc_table_byte_len) * BLOCKS_PER_ATB;
+    size_t crossover_block = BLOCK_FROM_PTR(MP_STATE_MEM(gc_lowest_long_lived_ptr));
+    size_t first_free = 0;
+    while (first_free < total_blocks && ATB_GET_KIND(first_free) != AT_FREE) {
+        first_free++;
+    }
+    size_t last_free = total_blocks;
+    while (last_free > 0 && ATB_GET_KIND(last_free - 1) != AT_FREE) {
+        last_free--;
+    }
+    size_t n_cand = 0;
+    size_t score[MICROPY_GC_COMPACT_BATCH];
+    for (size_t block = 0; block < total_blocks; block++) {
+        if (ATB_GET_KIND(block) != AT_HEAD) {
+            continue;
+        }
+        void **field = gc_compact_owned_field(block);
+        if (field == NULL || !VERIFY_PTR(*field)) {
+            continue;
+        }
+        size_t start = BLOCK_FROM_PTR(*field);
+        if (ATB_GET_KIND(start) != AT_HEAD) {
+            continue;
+        }
+        #if MICROPY_ENABLE_FINALISER
+        if (FTB_GET(start)) {
+            continue;
+        }
+        #endif
+        size_t n_blocks = 1;
+        while (start + n_blocks < total_blocks && ATB_GET_KIND(start + n_blocks) == AT_TAIL) {
+            n_blocks++;
+        }
+        size_t s;
+        if (start < crossover_block) {
+            if (first_free >= start) {
+                continue;
+            }
+            s = start - first_free;
+        } else {
+            if (last_free <= start + n_blocks) {
+                continue;
+            }
+            s = last_free - start;
+        }
+        size_t j = n_cand;
+        if (n_cand == MICROPY_GC_COMPACT_BATCH) {
+            // replace the candidate with the lowest score if this one is better
+            j = 0;
+            for (size_t k = 1; k < n_cand; k++) {
+                if (score[k] < score[j]) {
+                    j = k;
+                }
+            }
+            if (score[j] >= s) {
+                continue;
+            }
+        } else {
+            n_cand++;
+        }
+        score[j] = s;
+        cand[j].start = start;
+        cand[j].n_blocks = n_blocks;
+        cand[j].owner = block;
+        cand[j].field = field;
+        cand[j].pinned = false;
+    }
+    return n_cand;
+}
+
+// Pin every candidate that some word in the heap points into, other than the
+// pointer held by its own container.
+STATIC void gc_compact_scan_heap(gc_compact_candidate_t *cand, size_t n_cand) {
+    size_t total_blocks = MP_STATE_MEM(gc_alloc_table_byte_len) * BLOCKS_PER_ATB;
+    for (size_t block = 0; block < total_blocks; block++) {
+        if (ATB_GET_KIND(block) == AT_FREE) {
+            continue;
+        }
+        void **ptrs = (void**)PTR_FROM_BLOCK(block);
+        for (size_t i = 0; i < WORDS_PER_BLOCK; i++) {
+            byte *ptr = ptrs[i];
+            for (size_t j = 0; j < n_cand; j++) {
+                if (ptr >= (byte*)PTR_FROM_BLOCK(cand[j].start)
+                    && ptr < (byte*)PTR_FROM_BLOCK(cand[j].start + cand[j].n_blocks)
+                    && !(&ptrs[i] == cand[j].field && ptr == (byte*)PTR_FROM_BLOCK(cand[j].start))) {
+                    cand[j].pinned = true;
+                }
+            }
+        }
+    }
+}
+
+// Move a candidate to the free run nearest its end of the heap, if that's
+// closer than where it is now.
+STATIC bool gc_compact_move(gc_compact_candidate_t *c) {
+    size_t total_blocks = MP_STATE_MEM(gc_alloc_table_byte_len) * BLOCKS_PER_ATB;
+    size_t crossover_block = BLOCK_FROM_PTR(MP_STATE_MEM(gc_lowest_long_lived_ptr));
+    size_t dest = (size_t)-1;
+    size_t n_free = 0;
+    if (c->start < crossover_block) {
+        for (size_t block = 0; block < c->start; block++) {
+            if (ATB_GET_KIND(block) != AT_FREE) {
+                n_free = 0;
+            } else if (++n_free == c->n_blocks) {
+                dest = block + 1 - c->n_blocks;
+                break;
+            }
+        }
+    } else {
+        for (size_t block = total_blocks; block-- > c->start + c->n_blocks;) {
+            if (ATB_GET_KIND(block) != AT_FREE) {
+                n_free = 0;
+            } else if (++n_free == c->n_blocks) {
+                dest = block;
+                break;
+            }
+        }
+    }
+    if (dest == (size_t)-1) {
+        return false;
+    }
+
+    memcpy((void*)PTR_FROM_BLOCK(dest), (void*)PTR_FROM_BLOCK(c->start), c->n_blocks * BYTES_PER_BLOCK);
+    ATB_FREE_TO_HEAD(dest);
+    for (size_t i = 1; i < c->n_blocks; i++) {
+        ATB_FREE_TO_TAIL(dest + i);
+    }
+    for (size_t i = 0; i < c->n_blocks; i++) {
+        ATB_ANY_TO_FREE(c->start + i);
+    }
+    *c->field = (void*)PTR_FROM_BLOCK(dest);
+    #if MICROPY_GC_FREE_LISTS
+    gc_free_lists_add(c->start, c->n_blocks);
+    #endif
+
+    if (c->start / BLOCKS_PER_ATB < MP_STATE_MEM(gc_first_free_atb_index)) {
+        MP_STATE_MEM(gc_first_free_atb_index) = c->start / BLOCKS_PER_ATB;
+    }
+    if (c->start / BLOCKS_PER_ATB > MP_STATE_MEM(gc_last_free_atb_index)) {
+        MP_STATE_MEM(gc_last_free_atb_index) = c->start / BLOCKS_PER_ATB;
+    }
+    return true;
+}
+
+size_t gc_compact(void) {
+    #if MICROPY_PY_THREAD && !MICROPY_PY_THREAD_GIL
+    // other threads can't be stopped while their storage is moved
+    if (MP_STATE_MEM(gc_compact_blocked)) {
+        return 0;
+    }
+    #endif
+    gc_compact_candidate_t cand[MICROPY_GC_COMPACT_BATCH];
+    size_t moved = 0;
+    gc_collect();
+    for (;;) {
+        GC_ENTER();
+        if (MP_STATE_MEM(gc_lock_depth) > 0) {
+            GC_EXIT();
+            break;
+        }
+        size_t n_cand = gc_compact_select(cand);
+        GC_EXIT();
+        if (n_cand == 0) {
+            break;
+        }
+
+        // Collect again to find the candidates that roots point into.  This
+        // also frees anything that died since the last pass.
+        MP_STATE_MEM(gc_compact_candidates) = cand;
+        MP_STATE_MEM(gc_compact_n_candidates) = n_cand;
+        gc_collect();
+        MP_STATE_MEM(gc_compact_n_candidates) = 0;
+
+        GC_ENTER();
+        gc_compact_scan_heap(cand, n_cand);
+        size_t moved_now = 0;
+        for (size_t i = 0; i < n_cand; i++) {
+            gc_compact_candidate_t *c = &cand[i];
+            // the container or its storage may have been freed by the collection
+            if (!c->pinned
+                && ATB_GET_KIND(c->owner) == AT_HEAD
+                && ATB_GET_KIND(c->start) == AT_HEAD
+                && *c->field == (void*)PTR_FROM_BLOCK(c->start)
+                && gc_compact_move(c)) {
+                moved_now += c->n_blocks;
+            }
+        }
+        GC_EXIT();
+        if (moved_now == 0) {
+            break;
+        }
+        moved += moved_now;
+    }
+    return moved * BYTES_PER_BLOCK;
+}
+#endif
+
 #if 0
 // old, simple realloc that didn't expand memory in place
 void *gc_realloc(void *ptr, mp_uint_t n_bytes) {
@@ -855,6 +1542,14 @@ void *gc_realloc(void *ptr_in, size_t n_bytes, bool allow_move) {
         return ptr_in;
     }
 
+    #if MICROPY_GC_TLAB
+    // blocks in an allocation buffer can't be freed, see gc_free
+    if (new_blocks < n_blocks && gc_tlab_contains(block)) {
+        GC_EXIT();
+        return ptr_in;
+    }
+    #endif
+
     // check if we can shrink the allocated area
     if (new_blocks < n_blocks) {
         // free unneeded tail blocks
@@ -60,6 +60,11 @@ void gc_collect_end(void);
 
 void *gc_alloc(size_t n_bytes, bool has_finaliser, bool long_lived);
 
+#if MICROPY_GC_TLAB
+// Return the unused part of the current thread's allocation buffer
+void gc_tlab_flush(void);
+#endif
+
 // Use this function to sweep the whole heap and run all finalisers
 void gc_sweep_all(void);
 
@@ -67,6 +72,12 @@ void gc_free(void *ptr); // does not call finaliser
 size_t gc_nbytes(const void *ptr);
 bool gc_has_finaliser(const void *ptr);
 void *gc_make_long_lived(void *old_ptr);
+
+#if MICROPY_GC_COMPACT
+// Move the storage of lists and dicts to close up free space.  Returns the
+// number of bytes moved.
+size_t gc_compact(void);
+#endif
 void *gc_realloc(void *ptr, size_t n_bytes, bool allow_move);
 
 // Prevents a pointer from ever being freed because it establishes a permanent reference to it. Use
@@ -352,12 +352,28 @@ def print_qstr_data(encoding_table, qcfgs, qstrs, i18ns):
         print("TRANSLATION(\"{}\", {}, {{ {} }}) // {}".format(original, len(translation_encoded)+1, ", ".join(["0x{:02x}".format(x) for x in compressed]), decompressed))
         total_text_size += len(translation.encode("utf-8"))
 
+    print_qstr_hash_index(cfg_bytes_hash, qstrs)
+
     print()
     print("// {} bytes worth of qstr".format(total_qstr_size))
     print("// {} bytes worth of translations".format(total_text_size))
     print("// {} bytes worth of translations compressed".format(total_text_compressed_size))
     print("// {} bytes saved".format(total_text_size - total_text_compressed_size))
 
+def print_qstr_hash_index(cfg_bytes_hash, qstrs):
+    # open addressing table, at most half full, mapping the hash of each qstr
+    # to its id; 0 (MP_QSTR_NULL) marks an empty slot
+    size = 1
+    while size < 2 * (len(qstrs) + 1):
+        size *= 2
+    table = [0] * size
+    for id, (order, ident, qstr) in enumerate(sorted(qstrs.values(), key=lambda x: x[0]), 1):
+        i = compute_hash(bytes_cons(qstr, 'utf8'), cfg_bytes_hash) & (size - 1)
+        while table[i]:
+            i = (i + 1) & (size - 1)
+        table[i] = id
+    print('QHASHINDEX(%d, {%s})' % (size, ', '.join(str(id) for id in table)))
+
 def print_qstr_enums(qstrs):
     # print out the starter of the generated C header file
     print('// This file was automatically generated by makeqstrdata.py')
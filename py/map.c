@@ -32,6 +32,7 @@
 #include "py/mpconfig.h"
 #include "py/misc.h"
 #include "py/runtime.h"
+#include "py/objstr.h"
 
 #if MICROPY_DEBUG_VERBOSE // print debugging info
 #define DEBUG_PRINT (1)
@@ -51,6 +52,39 @@ const mp_map_t mp_const_empty_map = {
     .table = NULL,
 };
 
+#if MICROPY_OPT_MAP_POW2_HASH
+
+// Hash tables are a power of 2 in size, so finding a slot is a mask rather
+// than a division, and they grow once they are 3/4 full so that probes stay
+// short.  Hashes that don't fit the table are mixed first, so that keys which
+// differ only in their upper bits (eg object addresses, or multiples of a power
+// of 2) don't all start at the same slot.  Smaller hashes, such as those of
+// small ints, are used as is and so keep their order, as in CPython.
+STATIC size_t get_hash_alloc_greater_or_equal_to(size_t x) {
+    size_t alloc = 4;
+    while (alloc < x) {
+        alloc *= 2;
+    }
+    return alloc;
+}
+
+STATIC inline size_t hash_pos(mp_uint_t hash, size_t alloc) {
+    if (hash >= alloc) {
+        hash ^= hash >> 16;
+        hash *= 0x45d9f3b;
+        hash ^= hash >> 16;
+    }
+    return hash & (alloc - 1);
+}
+
+#define HASH_NEXT(pos, alloc) (((pos) + 1) & ((alloc) - 1))
+#define HASH_ALLOC_FOR(n) ((n) == 0 ? 0 : get_hash_alloc_greater_or_equal_to((n) + ((n) + 2) / 3))
+#define HASH_IS_FULL(used, alloc) ((used) * 4 > (alloc) * 3)
+// size to rehash to when adding an element, which also clears out tombstones
+#define HASH_REHASH_ALLOC(alloc, used) (HASH_ALLOC_FOR((used) + 1))
+
+#else
+
 // This table of sizes is used to control the growth of hash tables.
 // The first set of sizes are chosen so the allocation fits exactly in a
 // 4-word GC block, and it's not so important for these small values to be
@@ -73,6 +107,14 @@ STATIC size_t get_hash_alloc_greater_or_equal_to(size_t x) {
     return (x + x / 2) | 1;
 }
 
+#define hash_pos(hash, alloc) ((hash) % (alloc))
+#define HASH_NEXT(pos, alloc) (((pos) + 1) % (alloc))
+#define HASH_ALLOC_FOR(n) (n)
+#define HASH_IS_FULL(used, alloc) (0)
+#define HASH_REHASH_ALLOC(alloc, used) (get_hash_alloc_greater_or_equal_to((alloc) + 1))
+
+#endif
+
 /******************************************************************************/
 /* map                                                                        */
 
@@ -81,13 +123,14 @@ void mp_map_init(mp_map_t *map, size_t n) {
         map->alloc = 0;
         map->table = NULL;
     } else {
-        map->alloc = n;
+        map->alloc = HASH_ALLOC_FOR(n);
         map->table = m_new0(mp_map_elem_t, map->alloc);
     }
     map->used = 0;
     map->all_keys_are_qstrs = 1;
     map->is_fixed = 0;
     map->is_ordered = 0;
+    map->is_class_dict = 0;
 }
 
 void mp_map_init_fixed_table(mp_map_t *map, size_t n, const mp_obj_t *table) {
@@ -96,6 +139,7 @@ void mp_map_init_fixed_table(mp_map_t *map, size_t n, const mp_obj_t *table) {
     map->all_keys_are_qstrs = 1;
     map->is_fixed = 1;
     map->is_ordered = 1;
+    map->is_class_dict = 0;
     map->table = (mp_map_elem_t*)table;
 }
 
@@ -108,6 +152,7 @@ void mp_map_deinit(mp_map_t *map) {
 }
 
 void mp_map_clear(mp_map_t *map) {
+    MP_MAP_CLASS_DICT_MUTATED(map);
     if (!map->is_fixed) {
         m_del(mp_map_elem_t, map->table, map->alloc);
     }
@@ -120,7 +165,7 @@ void mp_map_clear(mp_map_t *map) {
 
 STATIC void mp_map_rehash(mp_map_t *map) {
     size_t old_alloc = map->alloc;
-    size_t new_alloc = get_hash_alloc_greater_or_equal_to(map->alloc + 1);
+    size_t new_alloc = HASH_REHASH_ALLOC(map->alloc, map->used);
     DEBUG_printf("mp_map_rehash(%p): " UINT_FMT " -> " UINT_FMT "\n", map, old_alloc, new_alloc);
     mp_map_elem_t *old_table = map->table;
     mp_map_elem_t *new_table = m_new0(mp_map_elem_t, new_alloc);
@@ -137,6 +182,73 @@ STATIC void mp_map_rehash(mp_map_t *map) {
     m_del(mp_map_elem_t, old_table, old_alloc);
 }
 
+#if MICROPY_OPT_MAP_POW2_HASH
+// Get the hash of a key if that can't run Python code (or fail), which is the
+// case for small ints, str and bytes.
+STATIC bool hash_of_plain_key(mp_obj_t key, mp_uint_t *hash) {
+    if (MP_OBJ_IS_QSTR(key)) {
+        *hash = qstr_hash(MP_OBJ_QSTR_VALUE(key));
+    } else if (MP_OBJ_IS_SMALL_INT(key) || MP_OBJ_IS_STR_OR_BYTES(key)) {
+        *hash = MP_OBJ_SMALL_INT_VALUE(mp_unary_op(MP_UNARY_OP_HASH, key));
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// Whether an element at pos whose probe run starts at home may move back to
+// the gap at hole, ie the gap isn't before its home slot.
+#define HASH_CAN_FILL(home, hole, pos, alloc) ((((pos) - (home)) & ((alloc) - 1)) >= (((pos) - (hole)) & ((alloc) - 1)))
+
+// Delete the element in the given slot by moving later elements of the probe
+// run back into the gap, so no tombstone is left to lengthen probes.  If an
+// element's hash can't be taken safely a tombstone is left after all.
+// Returns the slot that was emptied, holding the deleted value for the caller.
+STATIC mp_map_elem_t *mp_map_remove_shift(mp_map_t *map, size_t hole) {
+    mp_obj_t value = map->table[hole].value;
+    mp_obj_t hole_key = MP_OBJ_NULL;
+    for (size_t pos = HASH_NEXT(hole, map->alloc);; pos = HASH_NEXT(pos, map->alloc)) {
+        mp_map_elem_t *slot = &map->table[pos];
+        mp_uint_t hash;
+        if (slot->key == MP_OBJ_NULL) {
+            break;
+        }
+        if (slot->key == MP_OBJ_SENTINEL || !hash_of_plain_key(slot->key, &hash)) {
+            hole_key = MP_OBJ_SENTINEL;
+            break;
+        }
+        if (HASH_CAN_FILL(hash_pos(hash, map->alloc), hole, pos, map->alloc)) {
+            map->table[hole] = *slot;
+            hole = pos;
+        }
+    }
+    map->table[hole].key = hole_key;
+    map->table[hole].value = value;
+    return &map->table[hole];
+}
+
+#if MICROPY_PY_BUILTINS_SET
+STATIC void mp_set_remove_shift(mp_set_t *set, size_t hole) {
+    for (size_t pos = HASH_NEXT(hole, set->alloc);; pos = HASH_NEXT(pos, set->alloc)) {
+        mp_obj_t elem = set->table[pos];
+        mp_uint_t hash;
+        if (elem == MP_OBJ_NULL) {
+            break;
+        }
+        if (elem == MP_OBJ_SENTINEL || !hash_of_plain_key(elem, &hash)) {
+            set->table[hole] = MP_OBJ_SENTINEL;
+            return;
+        }
+        if (HASH_CAN_FILL(hash_pos(hash, set->alloc), hole, pos, set->alloc)) {
+            set->table[hole] = elem;
+            hole = pos;
+        }
+    }
+    set->table[hole] = MP_OBJ_NULL;
+}
+#endif
+#endif
+
 // MP_MAP_LOOKUP behaviour:
 //  - returns NULL if not found, else the slot it was found in with key,value non-null
 // MP_MAP_LOOKUP_ADD_IF_NOT_FOUND behaviour:
@@ -147,6 +259,10 @@ mp_map_elem_t *mp_map_lookup(mp_map_t *map, mp_obj_t index, mp_map_lookup_kind_t
     // If the map is a fixed array then we must only be called for a lookup
     assert(!map->is_fixed || lookup_kind == MP_MAP_LOOKUP);
 
+    if (lookup_kind != MP_MAP_LOOKUP) {
+        MP_MAP_CLASS_DICT_MUTATED(map);
+    }
+
     // Work out if we can compare just pointers
     bool compare_only_ptrs = map->all_keys_are_qstrs;
     if (compare_only_ptrs) {
@@ -168,11 +284,19 @@ mp_map_elem_t *mp_map_lookup(mp_map_t *map, mp_obj_t index, mp_map_lookup_kind_t
 
     // if the map is an ordered array then we must do a brute force linear search
     if (map->is_ordered) {
-        for (mp_map_elem_t *elem = &map->table[0], *top = &map->table[map->used]; elem < top; elem++) {
-            if (elem->key == index || (!compare_only_ptrs && mp_obj_equal(elem->key, index))) {
+        // Comparing keys can run Python code which changes the map, so the
+        // table and its length are read again after each comparison.
+        for (size_t i = 0; i < map->used; i++) {
+            mp_obj_t key = map->table[i].key;
+            if (key == index || (!compare_only_ptrs && mp_obj_equal(key, index))) {
+                if (MP_UNLIKELY(i >= map->used)) {
+                    break;
+                }
+                mp_map_elem_t *elem = &map->table[i];
                 #if MICROPY_PY_COLLECTIONS_ORDEREDDICT
                 if (MP_UNLIKELY(lookup_kind == MP_MAP_LOOKUP_REMOVE_IF_FOUND)) {
                     // remove the found element by moving the rest of the array down
+                    mp_map_elem_t *top = &map->table[map->used];
                     mp_obj_t value = elem->value;
                     --map->used;
                     memmove(elem, elem + 1, (top - elem - 1) * sizeof(*elem));
@@ -208,14 +332,6 @@ mp_map_elem_t *mp_map_lookup(mp_map_t *map, mp_obj_t index, mp_map_lookup_kind_t
 
     // map is a hash table (not an ordered array), so do a hash lookup
 
-    if (map->alloc == 0) {
-        if (lookup_kind == MP_MAP_LOOKUP_ADD_IF_NOT_FOUND) {
-            mp_map_rehash(map);
-        } else {
-            return NULL;
-        }
-    }
-
     // get hash of index, with fast path for common case of qstr
     mp_uint_t hash;
     if (MP_OBJ_IS_QSTR(index)) {
@@ -224,7 +340,22 @@ mp_map_elem_t *mp_map_lookup(mp_map_t *map, mp_obj_t index, mp_map_lookup_kind_t
         hash = MP_OBJ_SMALL_INT_VALUE(mp_unary_op(MP_UNARY_OP_HASH, index));
     }
 
-    size_t pos = hash % map->alloc;
+    // Hashing and comparing keys can run Python code which changes the map,
+    // from this thread or from another one while its lock is released (see
+    // mp_thread_obj_call_unlocked), so the search starts again if the table
+    // was replaced in the meantime.
+restart:
+    if (map->alloc == 0) {
+        if (lookup_kind == MP_MAP_LOOKUP_ADD_IF_NOT_FOUND) {
+            mp_map_rehash(map);
+        } else {
+            return NULL;
+        }
+    }
+
+    mp_map_elem_t *table = map->table;
+    size_t alloc = map->alloc;
+    size_t pos = hash_pos(hash, map->alloc);
     size_t start_pos = pos;
     mp_map_elem_t *avail_slot = NULL;
     for (;;) {
@@ -232,6 +363,11 @@ mp_map_elem_t *mp_map_lookup(mp_map_t *map, mp_obj_t index, mp_map_lookup_kind_t
         if (slot->key == MP_OBJ_NULL) {
             // found NULL slot, so index is not in table
             if (lookup_kind == MP_MAP_LOOKUP_ADD_IF_NOT_FOUND) {
+                if (avail_slot == NULL && HASH_IS_FULL(map->used + 1, map->alloc)) {
+                    // grow the table and restart the search for the new element
+                    mp_map_rehash(map);
+                    goto restart;
+                }
                 map->used += 1;
                 if (avail_slot == NULL) {
                     avail_slot = slot;
@@ -251,29 +387,40 @@ mp_map_elem_t *mp_map_lookup(mp_map_t *map, mp_obj_t index, mp_map_lookup_kind_t
                 avail_slot = slot;
             }
         } else if (slot->key == index || (!compare_only_ptrs && mp_obj_equal(slot->key, index))) {
+            if (MP_UNLIKELY(map->table != table || map->alloc != alloc)) {
+                goto restart;
+            }
             // found index
             // Note: CPython does not replace the index; try x={True:'true'};x[1]='one';x
             if (lookup_kind == MP_MAP_LOOKUP_REMOVE_IF_FOUND) {
                 // delete element in this slot
                 map->used--;
-                if (map->table[(pos + 1) % map->alloc].key == MP_OBJ_NULL) {
+                #if MICROPY_OPT_MAP_POW2_HASH
+                return mp_map_remove_shift(map, pos);
+                #else
+                if (map->table[HASH_NEXT(pos, map->alloc)].key == MP_OBJ_NULL) {
                     // optimisation if next slot is empty
                     slot->key = MP_OBJ_NULL;
                 } else {
                     slot->key = MP_OBJ_SENTINEL;
                 }
                 // keep slot->value so that caller can access it if needed
+                #endif
             }
             return slot;
+        } else if (!compare_only_ptrs && MP_UNLIKELY(map->table != table || map->alloc != alloc)) {
+            goto restart;
         }
 
         // not yet found, keep searching in this table
-        pos = (pos + 1) % map->alloc;
+        pos = HASH_NEXT(pos, map->alloc);
 
         if (pos == start_pos) {
             // search got back to starting position, so index is not in table
             if (lookup_kind == MP_MAP_LOOKUP_ADD_IF_NOT_FOUND) {
-                if (avail_slot != NULL) {
+                // a power of 2 table with no empty slot is full of tombstones,
+                // so rehash it rather than keep probing the whole table
+                if (avail_slot != NULL && !MICROPY_OPT_MAP_POW2_HASH) {
                     // there was an available slot, so use that
                     map->used++;
                     avail_slot->key = index;
@@ -286,7 +433,7 @@ mp_map_elem_t *mp_map_lookup(mp_map_t *map, mp_obj_t index, mp_map_lookup_kind_t
                     // not enough room in table, rehash it
                     mp_map_rehash(map);
                     // restart the search for the new element
-                    start_pos = pos = hash % map->alloc;
+                    goto restart;
                 }
             } else {
                 return NULL;
@@ -301,7 +448,7 @@ mp_map_elem_t *mp_map_lookup(mp_map_t *map, mp_obj_t index, mp_map_lookup_kind_t
 #if MICROPY_PY_BUILTINS_SET
 
 void mp_set_init(mp_set_t *set, size_t n) {
-    set->alloc = n;
+    set->alloc = HASH_ALLOC_FOR(n);
     set->used = 0;
     set->table = m_new0(mp_obj_t, set->alloc);
 }
@@ -309,7 +456,7 @@ void mp_set_init(mp_set_t *set, size_t n) {
 STATIC void mp_set_rehash(mp_set_t *set) {
     size_t old_alloc = set->alloc;
     mp_obj_t *old_table = set->table;
-    set->alloc = get_hash_alloc_greater_or_equal_to(set->alloc + 1);
+    set->alloc = HASH_REHASH_ALLOC(set->alloc, set->used);
     set->used = 0;
     set->table = m_new0(mp_obj_t, set->alloc);
     for (size_t i = 0; i < old_alloc; i++) {
@@ -324,6 +471,10 @@ mp_obj_t mp_set_lookup(mp_set_t *set, mp_obj_t index, mp_map_lookup_kind_t looku
     // Note: lookup_kind can be MP_MAP_LOOKUP_ADD_IF_NOT_FOUND_OR_REMOVE_IF_FOUND which
     // is handled by using bitwise operations.
 
+    mp_uint_t hash = MP_OBJ_SMALL_INT_VALUE(mp_unary_op(MP_UNARY_OP_HASH, index));
+
+    // as in mp_map_lookup, start again if Python code replaced the table
+restart:
     if (set->alloc == 0) {
         if (lookup_kind & MP_MAP_LOOKUP_ADD_IF_NOT_FOUND) {
             mp_set_rehash(set);
@@ -331,8 +482,9 @@ mp_obj_t mp_set_lookup(mp_set_t *set, mp_obj_t index, mp_map_lookup_kind_t looku
             return MP_OBJ_NULL;
         }
     }
-    mp_uint_t hash = MP_OBJ_SMALL_INT_VALUE(mp_unary_op(MP_UNARY_OP_HASH, index));
-    size_t pos = hash % set->alloc;
+    mp_obj_t *table = set->table;
+    size_t alloc = set->alloc;
+    size_t pos = hash_pos(hash, set->alloc);
     size_t start_pos = pos;
     mp_obj_t *avail_slot = NULL;
     for (;;) {
@@ -340,6 +492,11 @@ mp_obj_t mp_set_lookup(mp_set_t *set, mp_obj_t index, mp_map_lookup_kind_t looku
         if (elem == MP_OBJ_NULL) {
             // found NULL slot, so index is not in table
             if (lookup_kind & MP_MAP_LOOKUP_ADD_IF_NOT_FOUND) {
+                if (avail_slot == NULL && HASH_IS_FULL(set->used + 1, set->alloc)) {
+                    // grow the table and restart the search for the new element
+                    mp_set_rehash(set);
+                    goto restart;
+                }
                 if (avail_slot == NULL) {
                     avail_slot = &set->table[pos];
                 }
@@ -355,27 +512,36 @@ mp_obj_t mp_set_lookup(mp_set_t *set, mp_obj_t index, mp_map_lookup_kind_t looku
                 avail_slot = &set->table[pos];
             }
         } else if (mp_obj_equal(elem, index)) {
+            if (MP_UNLIKELY(set->table != table || set->alloc != alloc)) {
+                goto restart;
+            }
             // found index
             if (lookup_kind & MP_MAP_LOOKUP_REMOVE_IF_FOUND) {
                 // delete element
                 set->used--;
-                if (set->table[(pos + 1) % set->alloc] == MP_OBJ_NULL) {
+                #if MICROPY_OPT_MAP_POW2_HASH
+                mp_set_remove_shift(set, pos);
+                #else
+                if (set->table[HASH_NEXT(pos, set->alloc)] == MP_OBJ_NULL) {
                     // optimisation if next slot is empty
                     set->table[pos] = MP_OBJ_NULL;
                 } else {
                     set->table[pos] = MP_OBJ_SENTINEL;
                 }
+                #endif
             }
             return elem;
+        } else if (MP_UNLIKELY(set->table != table || set->alloc != alloc)) {
+            goto restart;
         }
 
         // not yet found, keep searching in this table
-        pos = (pos + 1) % set->alloc;
+        pos = HASH_NEXT(pos, set->alloc);
 
         if (pos == start_pos) {
             // search got back to starting position, so index is not in table
             if (lookup_kind & MP_MAP_LOOKUP_ADD_IF_NOT_FOUND) {
-                if (avail_slot != NULL) {
+                if (avail_slot != NULL && !MICROPY_OPT_MAP_POW2_HASH) {
                     // there was an available slot, so use that
                     set->used++;
                     *avail_slot = index;
@@ -384,7 +550,7 @@ mp_obj_t mp_set_lookup(mp_set_t *set, mp_obj_t index, mp_map_lookup_kind_t looku
                     // not enough room in table, rehash it
                     mp_set_rehash(set);
                     // restart the search for the new element
-                    start_pos = pos = hash % set->alloc;
+                    goto restart;
                 }
             } else {
                 return MP_OBJ_NULL;
@@ -399,12 +565,16 @@ mp_obj_t mp_set_remove_first(mp_set_t *set) {
             mp_obj_t elem = set->table[pos];
             // delete element
             set->used--;
-            if (set->table[(pos + 1) % set->alloc] == MP_OBJ_NULL) {
+            #if MICROPY_OPT_MAP_POW2_HASH
+            mp_set_remove_shift(set, pos);
+            #else
+            if (set->table[HASH_NEXT(pos, set->alloc)] == MP_OBJ_NULL) {
                 // optimisation if next slot is empty
                 set->table[pos] = MP_OBJ_NULL;
             } else {
                 set->table[pos] = MP_OBJ_SENTINEL;
             }
+            #endif
             return elem;
         }
     }
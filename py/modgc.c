@@ -30,16 +30,30 @@
 
 #if MICROPY_PY_GC && MICROPY_ENABLE_GC
 
+#if MICROPY_GC_GENERATIONAL
+// collect([generation]): run a garbage collection, generation 0 is a minor one
+STATIC mp_obj_t py_gc_collect(size_t n_args, const mp_obj_t *args) {
+    if (n_args > 0 && mp_obj_get_int(args[0]) == 0) {
+        MP_STATE_MEM(gc_minor_requested) = true;
+    }
+    gc_collect();
+    MP_STATE_MEM(gc_minor_requested) = false;
+#else
 // collect(): run a garbage collection
 STATIC mp_obj_t py_gc_collect(void) {
     gc_collect();
+#endif
 #if MICROPY_PY_GC_COLLECT_RETVAL
     return MP_OBJ_NEW_SMALL_INT(MP_STATE_MEM(gc_collected));
 #else
     return mp_const_none;
 #endif
 }
+#if MICROPY_GC_GENERATIONAL
+MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(gc_collect_obj, 0, 1, py_gc_collect);
+#else
 MP_DEFINE_CONST_FUN_OBJ_0(gc_collect_obj, py_gc_collect);
+#endif
 
 // disable(): disable the garbage collector
 STATIC mp_obj_t gc_disable(void) {
@@ -95,6 +109,48 @@ STATIC mp_obj_t gc_threshold(size_t n_args, const mp_obj_t *args) {
 MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(gc_threshold_obj, 0, 1, gc_threshold);
 #endif
 
+#if MICROPY_GC_GENERATIONAL
+// max_pause([us]): get or set the pause target for automatic collections
+STATIC mp_obj_t gc_max_pause(size_t n_args, const mp_obj_t *args) {
+    if (n_args == 0) {
+        return mp_obj_new_int_from_uint(MP_STATE_MEM(gc_max_pause_us));
+    }
+    mp_int_t val = mp_obj_get_int(args[0]);
+    if (val < 0) {
+        val = 0;
+    }
+    MP_STATE_MEM(gc_max_pause_us) = val;
+    return mp_const_none;
+}
+MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(gc_max_pause_obj, 0, 1, gc_max_pause);
+
+// pause_stats(): return (minor collections, full collections, longest pause in
+// microseconds, histogram of pauses)
+STATIC mp_obj_t gc_pause_stats(void) {
+    mp_obj_t hist[MICROPY_GC_PAUSE_HIST_LEN];
+    for (size_t i = 0; i < MICROPY_GC_PAUSE_HIST_LEN; i++) {
+        hist[i] = mp_obj_new_int_from_uint(MP_STATE_MEM(gc_pause_hist)[i]);
+    }
+    mp_obj_t items[4] = {
+        mp_obj_new_int_from_uint(MP_STATE_MEM(gc_n_minor)),
+        mp_obj_new_int_from_uint(MP_STATE_MEM(gc_n_full)),
+        mp_obj_new_int_from_uint(MP_STATE_MEM(gc_longest_pause_us)),
+        mp_obj_new_tuple(MICROPY_GC_PAUSE_HIST_LEN, hist),
+    };
+    return mp_obj_new_tuple(4, items);
+}
+MP_DEFINE_CONST_FUN_OBJ_0(gc_pause_stats_obj, gc_pause_stats);
+#endif
+
+#if MICROPY_GC_COMPACT
+// compact(): move list and dict storage to close up free space, return the
+// number of bytes moved
+STATIC mp_obj_t py_gc_compact(void) {
+    return MP_OBJ_NEW_SMALL_INT(gc_compact());
+}
+MP_DEFINE_CONST_FUN_OBJ_0(gc_compact_obj, py_gc_compact);
+#endif
+
 STATIC const mp_rom_map_elem_t mp_module_gc_globals_table[] = {
     { MP_ROM_QSTR(MP_QSTR___name__), MP_ROM_QSTR(MP_QSTR_gc) },
     { MP_ROM_QSTR(MP_QSTR_collect), MP_ROM_PTR(&gc_collect_obj) },
@@ -106,6 +162,13 @@ STATIC const mp_rom_map_elem_t mp_module_gc_globals_table[] = {
     #if MICROPY_GC_ALLOC_THRESHOLD
     { MP_ROM_QSTR(MP_QSTR_threshold), MP_ROM_PTR(&gc_threshold_obj) },
     #endif
+    #if MICROPY_GC_GENERATIONAL
+    { MP_ROM_QSTR(MP_QSTR_max_pause), MP_ROM_PTR(&gc_max_pause_obj) },
+    { MP_ROM_QSTR(MP_QSTR_pause_stats), MP_ROM_PTR(&gc_pause_stats_obj) },
+    #endif
+    #if MICROPY_GC_COMPACT
+    { MP_ROM_QSTR(MP_QSTR_compact), MP_ROM_PTR(&gc_compact_obj) },
+    #endif
 };
 
 STATIC MP_DEFINE_CONST_DICT(mp_module_gc_globals, mp_module_gc_globals_table);
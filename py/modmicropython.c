@@ -66,6 +66,14 @@ STATIC mp_obj_t mp_micropython_mem_peak(void) {
     return MP_OBJ_NEW_SMALL_INT(m_get_peak_bytes_allocated());
 }
 STATIC MP_DEFINE_CONST_FUN_OBJ_0(mp_micropython_mem_peak_obj, mp_micropython_mem_peak);
+
+#if MICROPY_COMP_STREAM
+// peak heap used by the most recent streamed parse and compile
+STATIC mp_obj_t mp_micropython_mem_peak_compile(void) {
+    return MP_OBJ_NEW_SMALL_INT(MP_STATE_MEM(compile_peak_bytes_allocated));
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_0(mp_micropython_mem_peak_compile_obj, mp_micropython_mem_peak_compile);
+#endif
 #endif
 
 mp_obj_t mp_micropython_mem_info(size_t n_args, const mp_obj_t *args) {
@@ -150,13 +158,20 @@ STATIC MP_DEFINE_CONST_FUN_OBJ_1(mp_micropython_kbd_intr_obj, mp_micropython_kbd
 #endif
 
 #if MICROPY_ENABLE_SCHEDULER
-STATIC mp_obj_t mp_micropython_schedule(mp_obj_t function, mp_obj_t arg) {
-    if (!mp_sched_schedule(function, arg)) {
+STATIC mp_obj_t mp_micropython_schedule(size_t n_args, const mp_obj_t *args) {
+    mp_int_t priority = 0;
+    if (n_args > 2) {
+        priority = mp_obj_get_int(args[2]);
+        if (priority < 0 || priority > 255) {
+            mp_raise_ValueError(translate("priority must be between 0 and 255"));
+        }
+    }
+    if (!mp_sched_schedule_priority(args[0], args[1], priority)) {
         mp_raise_msg(&mp_type_RuntimeError, translate("schedule stack full"));
     }
     return mp_const_none;
 }
-STATIC MP_DEFINE_CONST_FUN_OBJ_2(mp_micropython_schedule_obj, mp_micropython_schedule);
+STATIC MP_DEFINE_CONST_FUN_OBJ_VAR_BETWEEN(mp_micropython_schedule_obj, 2, 3, mp_micropython_schedule);
 #endif
 
 STATIC const mp_rom_map_elem_t mp_module_micropython_globals_table[] = {
@@ -170,6 +185,9 @@ STATIC const mp_rom_map_elem_t mp_module_micropython_globals_table[] = {
     { MP_ROM_QSTR(MP_QSTR_mem_total), MP_ROM_PTR(&mp_micropython_mem_total_obj) },
     { MP_ROM_QSTR(MP_QSTR_mem_current), MP_ROM_PTR(&mp_micropython_mem_current_obj) },
     { MP_ROM_QSTR(MP_QSTR_mem_peak), MP_ROM_PTR(&mp_micropython_mem_peak_obj) },
+    #if MICROPY_COMP_STREAM
+    { MP_ROM_QSTR(MP_QSTR_mem_peak_compile), MP_ROM_PTR(&mp_micropython_mem_peak_compile_obj) },
+    #endif
 #endif
     { MP_ROM_QSTR(MP_QSTR_mem_info), MP_ROM_PTR(&mp_micropython_mem_info_obj) },
     { MP_ROM_QSTR(MP_QSTR_qstr_info), MP_ROM_PTR(&mp_micropython_qstr_info_obj) },
@@ -28,6 +28,8 @@
 #include <string.h>
 
 #include "py/runtime.h"
+#include "py/objtype.h"
+#include "py/objstr.h"
 #include "py/stackctrl.h"
 
 #include "supervisor/shared/translate.h"
@@ -35,6 +37,7 @@
 #if MICROPY_PY_THREAD
 
 #include "py/mpthread.h"
+#include "py/gc.h"
 
 #if MICROPY_DEBUG_VERBOSE // print debugging info
 #define DEBUG_PRINT (1)
@@ -125,6 +128,122 @@ STATIC const mp_obj_type_t mp_type_thread_lock = {
     .locals_dict = (mp_obj_dict_t*)&thread_lock_locals_dict,
 };
 
+#if MICROPY_PY_THREAD_OBJ_LOCK
+
+/****************************************************************/
+// Object locks
+
+// Builtin containers lock themselves while they're accessed, using one of a
+// fixed set of recursive locks chosen by the address of the object.  Code
+// holding a lock may need another one, for example to iterate over a set while
+// comparing it with an item of a list, and hashing and comparing keys or
+// calling a sort key can run Python code which needs any of them.  So that two
+// threads can never wait for each other, a thread only waits for a lock while
+// it holds none with a higher index: if it does, it releases all of them and
+// takes them back in index order along with the new one.  It also releases
+// them all while it calls a function (see mp_call_function_n_kw).  In both
+// cases the containers whose locks were held may be changed in the meantime,
+// so the code holding them must expect that.
+
+STATIC size_t mp_thread_obj_lock_index(const void *obj) {
+    size_t i = (uintptr_t)obj / MICROPY_BYTES_PER_GC_BLOCK;
+    return i & (MICROPY_PY_THREAD_OBJ_LOCK_NUM - 1);
+}
+
+// Releases all the object locks held by this thread, saving their depth.
+STATIC void mp_thread_obj_release_all(mp_state_thread_t *ts, size_t *depth) {
+    for (size_t i = 0; i < MICROPY_PY_THREAD_OBJ_LOCK_NUM; i++) {
+        mp_thread_obj_lock_t *lock = &MP_STATE_VM(obj_lock)[i];
+        depth[i] = 0;
+        if (lock->owner == ts) {
+            depth[i] = lock->depth;
+            lock->depth = 0;
+            lock->owner = NULL;
+            mp_thread_mutex_unlock(&lock->mutex);
+        }
+    }
+}
+
+// Takes the locks with a non-zero depth, in index order.
+STATIC void mp_thread_obj_take_all(mp_state_thread_t *ts, const size_t *depth) {
+    for (size_t i = 0; i < MICROPY_PY_THREAD_OBJ_LOCK_NUM; i++) {
+        if (depth[i] != 0) {
+            mp_thread_obj_lock_t *lock = &MP_STATE_VM(obj_lock)[i];
+            mp_thread_mutex_lock(&lock->mutex, 1);
+            lock->owner = ts;
+            lock->depth = depth[i];
+        }
+    }
+}
+
+// Waits for the mutex of lock index, which another thread holds, while this
+// thread holds other object locks.
+STATIC MP_NOINLINE void mp_thread_obj_lock_nested(mp_state_thread_t *ts, size_t index) {
+    for (size_t i = index + 1; i < MICROPY_PY_THREAD_OBJ_LOCK_NUM; i++) {
+        if (MP_STATE_VM(obj_lock)[i].owner == ts) {
+            size_t depth[MICROPY_PY_THREAD_OBJ_LOCK_NUM];
+            mp_thread_obj_release_all(ts, depth);
+            depth[index] = 1;
+            mp_thread_obj_take_all(ts, depth);
+            // the caller counts this lock as taken
+            MP_STATE_VM(obj_lock)[index].depth = 0;
+            return;
+        }
+    }
+    // all the locks held come before this one, so it's safe to wait for it
+    mp_thread_mutex_lock(&MP_STATE_VM(obj_lock)[index].mutex, 1);
+}
+
+void mp_thread_obj_lock(const void *obj) {
+    size_t index = mp_thread_obj_lock_index(obj);
+    mp_thread_obj_lock_t *lock = &MP_STATE_VM(obj_lock)[index];
+    mp_state_thread_t *ts = mp_thread_get_state();
+    if (lock->owner != ts) {
+        if (ts->obj_lock_depth == 0) {
+            mp_thread_mutex_lock(&lock->mutex, 1);
+        } else if (!mp_thread_mutex_lock(&lock->mutex, 0)) {
+            mp_thread_obj_lock_nested(ts, index);
+        }
+        lock->owner = ts;
+    }
+    lock->depth++;
+    ts->obj_lock_depth++;
+}
+
+void mp_thread_obj_unlock(const void *obj) {
+    mp_thread_obj_lock_t *lock = &MP_STATE_VM(obj_lock)[mp_thread_obj_lock_index(obj)];
+    MP_STATE_THREAD(obj_lock_depth)--;
+    if (--lock->depth == 0) {
+        lock->owner = NULL;
+        mp_thread_mutex_unlock(&lock->mutex);
+    }
+}
+
+mp_obj_t mp_thread_obj_call_unlocked(mp_obj_t fun, size_t n_args, size_t n_kw, const mp_obj_t *args) {
+    mp_state_thread_t *ts = mp_thread_get_state();
+    size_t depth[MICROPY_PY_THREAD_OBJ_LOCK_NUM];
+    mp_thread_obj_release_all(ts, depth);
+    size_t obj_lock_depth = ts->obj_lock_depth;
+    ts->obj_lock_depth = 0;
+
+    nlr_buf_t nlr;
+    mp_obj_t ret = MP_OBJ_NULL;
+    if (nlr_push(&nlr) == 0) {
+        ret = mp_obj_get_type(fun)->call(fun, n_args, n_kw, args);
+        nlr_pop();
+    }
+
+    mp_thread_obj_take_all(ts, depth);
+    ts->obj_lock_depth = obj_lock_depth;
+
+    if (ret == MP_OBJ_NULL) {
+        nlr_jump(nlr.ret_val);
+    }
+    return ret;
+}
+
+#endif
+
 /****************************************************************/
 // _thread module
 
@@ -164,6 +283,15 @@ STATIC void *thread_entry(void *args_in) {
     mp_state_thread_t ts;
     mp_thread_set_state(&ts);
 
+    #if MICROPY_GC_TLAB
+    ts.gc_tlab_end = 0;
+    ts.gc_tlab_busy = false;
+    #endif
+
+    #if MICROPY_PY_THREAD_OBJ_LOCK
+    ts.obj_lock_depth = 0;
+    #endif
+
     mp_stack_set_top(&ts + 1); // need to include ts in root-pointer scan
     mp_stack_set_limit(args->stack_size);
 
@@ -177,6 +305,14 @@ STATIC void *thread_entry(void *args_in) {
     mp_locals_set(args->dict_locals);
     mp_globals_set(args->dict_globals);
 
+    #if MICROPY_OPT_CLASS_LOOKUP_CACHE
+    mp_class_lookup_cache_init();
+    #endif
+
+    #if MICROPY_OPT_STR_UNICODE_INDEX
+    mp_str_index_cache_init();
+    #endif
+
     MP_THREAD_GIL_ENTER();
 
     // signal that we are set up and running
@@ -209,6 +345,11 @@ STATIC void *thread_entry(void *args_in) {
 
     DEBUG_printf("[thread] finish ts=%p\n", &ts);
 
+    #if MICROPY_GC_TLAB
+    // ts goes away with the thread
+    gc_tlab_flush();
+    #endif
+
     // signal that we are finished
     mp_thread_finish();
 
@@ -265,6 +406,21 @@ STATIC mp_obj_t mod_thread_start_new_thread(size_t n_args, const mp_obj_t *args)
     // set the function for thread entry
     th_args->fun = args[0];
 
+    #if MICROPY_GC_COMPACT && !MICROPY_PY_THREAD_GIL
+    // without a GIL, storage can't be moved while other threads run
+    MP_STATE_MEM(gc_compact_blocked) = true;
+    #endif
+
+    #if MICROPY_PY_THREAD_OBJ_LOCK
+    // from now on objects may be shared with another thread
+    MP_STATE_VM(obj_lock_enabled) = true;
+    #endif
+
+    #if MICROPY_GC_TLAB
+    // from now on the GC mutex may be contended
+    MP_STATE_MEM(gc_tlab_enabled) = true;
+    #endif
+
     // spawn the thread!
     mp_thread_create(thread_entry, th_args, &th_args->stack_size);
 
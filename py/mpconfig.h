@@ -40,7 +40,7 @@
 // to another, you must rebuild from scratch using "-B" switch to make.
 
 #ifdef MP_CONFIGFILE
-#include "mpconfigport_coverage.h"
+#include MP_CONFIGFILE
 #else
 #include <mpconfigport.h>
 #endif
@@ -127,6 +127,54 @@
 #define MICROPY_GC_ALLOC_THRESHOLD (1)
 #endif
 
+// Support generational collection: the long-lived region at the end of the
+// heap is treated as an old generation.  Minor collections scan it for
+// pointers into the rest of the heap but don't trace or sweep it.  The port
+// must provide mp_hal_ticks_us() to time collections.
+#ifndef MICROPY_GC_GENERATIONAL
+#define MICROPY_GC_GENERATIONAL (0)
+#endif
+
+// Keep lists of free runs of blocks, segregated by size class, so that small
+// multi-block allocations don't have to scan the allocation table.  The lists
+// are rebuilt by each sweep and hold up to MICROPY_GC_FREE_LIST_LEN runs per
+// class; runs of MICROPY_GC_FREE_LIST_MAX_BLOCKS or more share the last class.
+#ifndef MICROPY_GC_FREE_LISTS
+#define MICROPY_GC_FREE_LISTS (0)
+#endif
+
+#ifndef MICROPY_GC_FREE_LIST_MAX_BLOCKS
+#define MICROPY_GC_FREE_LIST_MAX_BLOCKS (8)
+#endif
+
+#ifndef MICROPY_GC_FREE_LIST_LEN
+#define MICROPY_GC_FREE_LIST_LEN (32)
+#endif
+
+// Support gc.compact(), which moves the storage of lists and dicts to close up
+// free space in a fragmented heap.  Each pass considers up to
+// MICROPY_GC_COMPACT_BATCH pieces of storage.
+#ifndef MICROPY_GC_COMPACT
+#define MICROPY_GC_COMPACT (0)
+#endif
+
+#ifndef MICROPY_GC_COMPACT_BATCH
+#define MICROPY_GC_COMPACT_BATCH (16)
+#endif
+
+// Default pause target in microseconds, configurable by gc.max_pause().  When
+// a full collection takes longer than this, automatic collections are minor
+// ones until a minor collection can't satisfy an allocation.  0 disables this.
+#ifndef MICROPY_GC_MAX_PAUSE_US
+#define MICROPY_GC_MAX_PAUSE_US (0)
+#endif
+
+// Number of buckets in the collection pause histogram.  Bucket n counts
+// pauses shorter than 64us << n; the last bucket also counts longer ones.
+#ifndef MICROPY_GC_PAUSE_HIST_LEN
+#define MICROPY_GC_PAUSE_HIST_LEN (12)
+#endif
+
 // Number of bytes to allocate initially when creating new chunks to store
 // interned string data.  Smaller numbers lead to more chunks being needed
 // and more wastage at the end of the chunk.  Larger numbers lead to wasted
@@ -141,6 +189,16 @@
 #define MICROPY_QSTR_POOL_MAX_ENTRIES (64)
 #endif
 
+// Whether to keep hash indexes of the qstr pools so that looking up a string
+// doesn't scan every pool.  The index of the const pool is generated with the
+// qstr data and goes in ROM; the other pools share one index on the heap.
+// The indexes are probed with the qstr hash, so this needs
+// MICROPY_QSTR_BYTES_IN_HASH of at least 2: with 1-byte hashes, indexes of more
+// than 256 slots would only use their first 256.
+#ifndef MICROPY_QSTR_HASH_INDEX
+#define MICROPY_QSTR_HASH_INDEX (0)
+#endif
+
 // Initial amount for lexer indentation level
 #ifndef MICROPY_ALLOC_LEXER_INDENT_INIT
 #define MICROPY_ALLOC_LEXER_INDENT_INIT (10)
@@ -182,6 +240,12 @@
 #define MICROPY_ALLOC_PARSE_CHUNK_INIT (128)
 #endif
 
+// When streaming, bytes of parse nodes after which a group of top-level
+// statements is compiled
+#ifndef MICROPY_ALLOC_PARSE_STREAM_GROUP
+#define MICROPY_ALLOC_PARSE_STREAM_GROUP (1024)
+#endif
+
 // Initial amount for ids in a scope
 #ifndef MICROPY_ALLOC_SCOPE_ID_INIT
 #define MICROPY_ALLOC_SCOPE_ID_INIT (4)
@@ -252,11 +316,25 @@
 #define MICROPY_PERSISTENT_CODE_LOAD (0)
 #endif
 
+// Whether persistent code can be loaded from a .mpy image that stays in
+// memory (eg memory-mapped flash, or a file mapped with mmap on unix), in which
+// case functions are left in the image until they are first called
+#ifndef MICROPY_PERSISTENT_CODE_LOAD_LAZY
+#define MICROPY_PERSISTENT_CODE_LOAD_LAZY (0)
+#endif
+
 // Whether to support saving of persistent code
 #ifndef MICROPY_PERSISTENT_CODE_SAVE
 #define MICROPY_PERSISTENT_CODE_SAVE (0)
 #endif
 
+// Whether an imported .py file is compiled once and the result saved to a
+// cache file next to it (foo.pyc for foo.py), which later imports load instead
+// of compiling the source again; requires persistent code load and save
+#ifndef MICROPY_PERSISTENT_CODE_CACHE
+#define MICROPY_PERSISTENT_CODE_CACHE (0)
+#endif
+
 // Whether generated code can persist independently of the VM/runtime instance
 // This is enabled automatically when needed by other features
 #ifndef MICROPY_PERSISTENT_CODE
@@ -314,6 +392,25 @@
 // Convenience definition for whether any inline assembler emitter is enabled
 #define MICROPY_EMIT_INLINE_ASM (MICROPY_EMIT_INLINE_THUMB || MICROPY_EMIT_INLINE_XTENSA)
 
+// Whether to recompile hot bytecode functions with the native emitter at
+// runtime; requires a native emitter.  Functions that catch exceptions stay
+// with the VM when sys.exc_info() is enabled, and a traceback entry for a
+// compiled function gives the line it starts at.
+#ifndef MICROPY_EMIT_NATIVE_JIT
+#define MICROPY_EMIT_NATIVE_JIT (0)
+#endif
+
+// Number of calls plus loop iterations after which a bytecode function is hot
+#ifndef MICROPY_EMIT_NATIVE_JIT_THRESHOLD
+#define MICROPY_EMIT_NATIVE_JIT_THRESHOLD (1000)
+#endif
+
+// Number of entries in the table of natively compiled bytecode, which lets
+// functions made from the same code (eg closures) share the native code
+#ifndef MICROPY_EMIT_NATIVE_JIT_CACHE_SIZE
+#define MICROPY_EMIT_NATIVE_JIT_CACHE_SIZE (32)
+#endif
+
 /*****************************************************************************/
 /* Compiler configuration                                                    */
 
@@ -330,9 +427,11 @@
 // Configure dynamic compiler macros
 #if MICROPY_DYNAMIC_COMPILER
 #define MICROPY_OPT_CACHE_MAP_LOOKUP_IN_BYTECODE_DYNAMIC (mp_dynamic_compiler.opt_cache_map_lookup_in_bytecode)
+#define MICROPY_OPT_BYTECODE_SUPERINSTRUCTIONS_DYNAMIC (mp_dynamic_compiler.opt_bytecode_superinstructions)
 #define MICROPY_PY_BUILTINS_STR_UNICODE_DYNAMIC (mp_dynamic_compiler.py_builtins_str_unicode)
 #else
 #define MICROPY_OPT_CACHE_MAP_LOOKUP_IN_BYTECODE_DYNAMIC MICROPY_OPT_CACHE_MAP_LOOKUP_IN_BYTECODE
+#define MICROPY_OPT_BYTECODE_SUPERINSTRUCTIONS_DYNAMIC MICROPY_OPT_BYTECODE_SUPERINSTRUCTIONS
 #define MICROPY_PY_BUILTINS_STR_UNICODE_DYNAMIC MICROPY_PY_BUILTINS_STR_UNICODE
 #endif
 
@@ -351,6 +450,12 @@
 #define MICROPY_COMP_CONST (1)
 #endif
 
+// Whether files are parsed and compiled a group of top-level statements at
+// a time, so the parse tree of a whole file is never held in memory
+#ifndef MICROPY_COMP_STREAM
+#define MICROPY_COMP_STREAM (0)
+#endif
+
 // Whether to enable optimisation of: a, b = c, d
 // Costs 124 bytes (Thumb2)
 #ifndef MICROPY_COMP_DOUBLE_TUPLE_ASSIGN
@@ -407,12 +512,76 @@
 #define MICROPY_OPT_CACHE_MAP_LOOKUP_IN_BYTECODE (0)
 #endif
 
+// Whether the bytecode compiler fuses common opcode sequences into single
+// superinstructions (LOAD_FAST+LOAD_ATTR, LOAD_FAST+LOAD_CONST_SMALL_INT+
+// BINARY_OP and COMPARE+POP_JUMP_IF), and the VM executes them.  This reduces
+// dispatch overhead in tight loops at the cost of a little code ROM.
+#ifndef MICROPY_OPT_BYTECODE_SUPERINSTRUCTIONS
+#define MICROPY_OPT_BYTECODE_SUPERINSTRUCTIONS (0)
+#endif
+
+// Whether to cache the result of looking up an attribute in the class hierarchy
+// of an instance (eg methods and class attributes accessed through self).  The
+// cache is keyed on (type, attr) and is invalidated when any class dict changes.
+// Uses MICROPY_OPT_CLASS_LOOKUP_CACHE_SIZE entries of 5 words per thread.
+#ifndef MICROPY_OPT_CLASS_LOOKUP_CACHE
+#define MICROPY_OPT_CLASS_LOOKUP_CACHE (0)
+#endif
+
+// Number of entries in the class lookup cache; must be a power of 2
+#ifndef MICROPY_OPT_CLASS_LOOKUP_CACHE_SIZE
+#define MICROPY_OPT_CLASS_LOOKUP_CACHE_SIZE (32)
+#endif
+
+// Whether to cache a code point index of recently indexed long str objects, so
+// that subscripting, slicing and len() don't have to walk the UTF-8 data from
+// the start each time.  ASCII-only strings need no table; other strings get a
+// table with the byte offset of every 32nd code point.  Uses
+// MICROPY_OPT_STR_UNICODE_INDEX_CACHE_SIZE entries of 4 words per thread, and
+// requires MICROPY_PY_BUILTINS_STR_UNICODE.
+#ifndef MICROPY_OPT_STR_UNICODE_INDEX
+#define MICROPY_OPT_STR_UNICODE_INDEX (0)
+#endif
+
+// Number of str objects whose code point index is kept per thread
+#ifndef MICROPY_OPT_STR_UNICODE_INDEX_CACHE_SIZE
+#define MICROPY_OPT_STR_UNICODE_INDEX_CACHE_SIZE (4)
+#endif
+
+// Whether to keep the qstr of each one-character ASCII str that is made (eg by
+// indexing or iterating over a str, or by chr()), so that making it again
+// doesn't have to search the qstr pools.  Uses 256 bytes of RAM.
+#ifndef MICROPY_OPT_STR_CHAR_CACHE
+#define MICROPY_OPT_STR_CHAR_CACHE (0)
+#endif
+
+// Whether hash tables of maps and sets are a power of 2 in size, which avoids
+// a division per probe.  Tables are kept at most 3/4 full, so they use a bit
+// more RAM, and deleting from a map with only qstr keys leaves no tombstone.
+#ifndef MICROPY_OPT_MAP_POW2_HASH
+#define MICROPY_OPT_MAP_POW2_HASH (0)
+#endif
+
 // Whether to use fast versions of bitwise operations (and, or, xor) when the
 // arguments are both positive.  Increases Thumb2 code size by about 250 bytes.
 #ifndef MICROPY_OPT_MPZ_BITWISE
 #define MICROPY_OPT_MPZ_BITWISE (0)
 #endif
 
+// Whether to use faster algorithms for large mpz numbers: Karatsuba
+// multiplication, sliding-window modular exponentiation for 3-arg pow, and
+// converting to a string several characters per division.  Increases code size
+// by about 1k.
+#ifndef MICROPY_OPT_MPZ_LARGE_NUMBERS
+#define MICROPY_OPT_MPZ_LARGE_NUMBERS (0)
+#endif
+
+// Minimum number of digits both operands of an mpz multiplication need for it
+// to use Karatsuba multiplication; must be at least 4
+#ifndef MICROPY_MPZ_KARATSUBA_THRESHOLD
+#define MICROPY_MPZ_KARATSUBA_THRESHOLD (32)
+#endif
+
 /*****************************************************************************/
 /* Python internal features                                                  */
 
@@ -610,6 +779,15 @@ typedef double mp_float_t;
 #define MICROPY_FLOAT_HIGH_QUALITY_HASH (0)
 #endif
 
+// Whether to convert floats to decimal exactly, with big integer arithmetic on
+// the stack instead of repeated float multiplication.  Formatted floats are then
+// correctly rounded and repr gives the shortest string that reads back as the
+// same float, as in CPython, and parsing is correctly rounded for up to 19
+// significant digits.  Increases code size by about 3k.
+#ifndef MICROPY_FLOAT_FORMAT_EXACT
+#define MICROPY_FLOAT_FORMAT_EXACT (0)
+#endif
+
 // Enable features which improve CPython compatibility
 // but may lead to more code size/memory usage.
 // TODO: Originally intended as generic category to not
@@ -692,16 +870,49 @@ typedef double mp_float_t;
 #define MICROPY_ENABLE_SCHEDULER (0)
 #endif
 
-// Maximum number of entries in the scheduler
+// Number of entries in the scheduler queue at startup; it can be made larger at
+// runtime with mp_sched_set_depth
 #ifndef MICROPY_SCHEDULER_DEPTH
 #define MICROPY_SCHEDULER_DEPTH (4)
 #endif
 
+// Largest number of entries mp_sched_set_depth allows.  Scheduling a callback
+// scans and shifts the queue with interrupts disabled, so this bounds the time
+// they are off.
+#ifndef MICROPY_SCHEDULER_MAX_DEPTH
+#define MICROPY_SCHEDULER_MAX_DEPTH (32)
+#endif
+
+// Whether to record how long scheduled callbacks wait before they run, as a
+// histogram of MICROPY_SCHEDULER_LATENCY_BUCKETS power-of-two buckets of
+// microseconds.  Requires mp_hal_ticks_us.
+#ifndef MICROPY_SCHEDULER_LATENCY
+#define MICROPY_SCHEDULER_LATENCY (0)
+#endif
+
+#ifndef MICROPY_SCHEDULER_LATENCY_BUCKETS
+#define MICROPY_SCHEDULER_LATENCY_BUCKETS (20)
+#endif
+
 // Support for generic VFS sub-system
 #ifndef MICROPY_VFS
 #define MICROPY_VFS (0)
 #endif
 
+// Number of directories whose listings mp_vfs_import_stat keeps, so that the
+// paths tried by import are looked up in memory rather than each one scanning
+// the directory on the filesystem; 0 disables the cache.  The cache is cleared
+// when the filesystems are changed through the VFS, but a port must call
+// mp_vfs_import_stat_cache_clear if they can change in other ways.
+#ifndef MICROPY_VFS_IMPORT_STAT_CACHE
+#define MICROPY_VFS_IMPORT_STAT_CACHE (0)
+#endif
+
+// Size in bytes of the largest directory listing kept in the cache above
+#ifndef MICROPY_VFS_IMPORT_STAT_CACHE_MAX_LISTING
+#define MICROPY_VFS_IMPORT_STAT_CACHE_MAX_LISTING (2048)
+#endif
+
 // Support for VFS POSIX component, to mount a POSIX filesystem within VFS
 #ifndef MICROPY_VFS
 #define MICROPY_VFS_POSIX (0)
@@ -741,6 +952,14 @@ typedef double mp_float_t;
 #define MICROPY_PY_DELATTR_SETATTR (0)
 #endif
 
+// Whether to support __slots__ in user classes, storing the listed attributes
+// in a fixed array at the end of the instance rather than in its members map
+// This costs some code size and makes stores to instances of slotted classes
+// do an extra class lookup
+#ifndef MICROPY_PY_CLASS_SLOTS
+#define MICROPY_PY_CLASS_SLOTS (0)
+#endif
+
 // Support for async/await/async for/async with
 #ifndef MICROPY_PY_ASYNC_AWAIT
 #define MICROPY_PY_ASYNC_AWAIT (1)
@@ -785,6 +1004,13 @@ typedef double mp_float_t;
 #define MICROPY_PY_BUILTINS_STR_SPLITLINES (0)
 #endif
 
+// Whether list.sort() and sorted() use a stable, adaptive merge sort that calls
+// the key function once per item, instead of an in-place quicksort
+// This costs some code size and temporary heap memory while sorting
+#ifndef MICROPY_PY_BUILTINS_STABLE_SORT
+#define MICROPY_PY_BUILTINS_STABLE_SORT (0)
+#endif
+
 // Whether to support bytearray object
 #ifndef MICROPY_PY_BUILTINS_BYTEARRAY
 #define MICROPY_PY_BUILTINS_BYTEARRAY (1)
@@ -1151,6 +1377,42 @@ typedef double mp_float_t;
 #define MICROPY_PY_THREAD_GIL_VM_DIVISOR (32)
 #endif
 
+// Whether a garbage collection stops all other threads while it marks, so
+// that without a GIL no thread can move a pointer behind the collector's
+// back.  The port must provide mp_thread_gc_stop_others() and
+// mp_thread_gc_resume_others().
+#ifndef MICROPY_PY_THREAD_GC_STOP_WORLD
+#define MICROPY_PY_THREAD_GC_STOP_WORLD (MICROPY_PY_THREAD && !MICROPY_PY_THREAD_GIL)
+#endif
+
+// Whether builtin dicts, sets, lists, bytearrays and instance members take a
+// lock while they are accessed, so that they stay consistent when shared by
+// threads without a GIL.  Locks are striped by object address and are only
+// taken once a second thread has been started.
+#ifndef MICROPY_PY_THREAD_OBJ_LOCK
+#define MICROPY_PY_THREAD_OBJ_LOCK (MICROPY_PY_THREAD && !MICROPY_PY_THREAD_GIL)
+#endif
+
+// Number of locks shared between all objects (must be a power of 2)
+#ifndef MICROPY_PY_THREAD_OBJ_LOCK_NUM
+#define MICROPY_PY_THREAD_OBJ_LOCK_NUM (64)
+#endif
+
+// Whether each thread allocates small objects from its own buffer of heap
+// blocks, without taking the GC mutex, once a second thread has been started.
+// Unused parts of the buffers are returned at the start of each collection.
+// Requires MICROPY_PY_THREAD_GC_STOP_WORLD, and the port must not stop a
+// thread for a collection while its gc_tlab_busy flag is set.
+#ifndef MICROPY_GC_TLAB
+#define MICROPY_GC_TLAB (MICROPY_PY_THREAD_GC_STOP_WORLD)
+#endif
+
+// Number of blocks in a thread's allocation buffer (a multiple of 4).
+// Allocations of up to a quarter of this are served from the buffer.
+#ifndef MICROPY_GC_TLAB_BLOCKS
+#define MICROPY_GC_TLAB_BLOCKS (64)
+#endif
+
 // Extended modules
 
 #ifndef MICROPY_PY_UCTYPES
@@ -1190,6 +1452,13 @@ typedef double mp_float_t;
 #define MICROPY_PY_UTIMEQ (0)
 #endif
 
+// Whether to provide the "uevent" module, an event loop for coroutines with
+// native awaitables for sleeping and for stream I/O.  Requires MICROPY_PY_UTIMEQ
+// and streams that support the MP_STREAM_POLL ioctl.
+#ifndef MICROPY_PY_UEVENT
+#define MICROPY_PY_UEVENT (0)
+#endif
+
 #ifndef MICROPY_PY_UHASHLIB
 #define MICROPY_PY_UHASHLIB (0)
 #endif
@@ -45,6 +45,7 @@
 typedef struct mp_dynamic_compiler_t {
     uint8_t small_int_bits; // must be <= host small_int_bits
     bool opt_cache_map_lookup_in_bytecode;
+    bool opt_bytecode_superinstructions;
     bool py_builtins_str_unicode;
 } mp_dynamic_compiler_t;
 extern mp_dynamic_compiler_t mp_dynamic_compiler;
@@ -58,14 +59,60 @@ extern mp_dynamic_compiler_t mp_dynamic_compiler;
 typedef struct _mp_sched_item_t {
     mp_obj_t func;
     mp_obj_t arg;
+    uint8_t priority;
+    #if MICROPY_SCHEDULER_LATENCY
+    mp_uint_t ticks_us; // when the callback was scheduled
+    #endif
 } mp_sched_item_t;
 
+#if MICROPY_GC_FREE_LISTS
+// A run of free blocks in the GC heap.  Entries are only hints and are checked
+// against the allocation table before they are used.
+typedef struct _mp_gc_free_run_t {
+    size_t start;
+    size_t len;
+} mp_gc_free_run_t;
+
+typedef struct _mp_gc_free_list_t {
+    size_t len;
+    mp_gc_free_run_t runs[MICROPY_GC_FREE_LIST_LEN];
+} mp_gc_free_list_t;
+#endif
+
+#if MICROPY_OPT_CLASS_LOOKUP_CACHE
+// An entry in the class lookup cache: the result of looking up attr in the
+// class hierarchy of type, valid while version matches the global version.
+// found_in is NULL if attr was not found in any class dict.
+typedef struct _mp_class_lookup_cache_entry_t {
+    const struct _mp_obj_type_t *type;
+    const struct _mp_obj_type_t *found_in;
+    mp_obj_t value;
+    qstr attr;
+    size_t version;
+} mp_class_lookup_cache_entry_t;
+#endif
+
+#if MICROPY_OPT_STR_UNICODE_INDEX
+// An entry in the str index cache, for the str with the given data and len.
+// checkpoints holds the byte offset of every STR_INDEX_STRIDE'th code point,
+// or is NULL if the str is ASCII-only (char_len == len).
+typedef struct _mp_str_index_cache_entry_t {
+    const byte *data;
+    size_t len;
+    size_t char_len;
+    size_t *checkpoints;
+} mp_str_index_cache_entry_t;
+#endif
+
 // This structure hold information about the memory allocation system.
 typedef struct _mp_state_mem_t {
     #if MICROPY_MEM_STATS
     size_t total_bytes_allocated;
     size_t current_bytes_allocated;
     size_t peak_bytes_allocated;
+    #if MICROPY_COMP_STREAM
+    size_t compile_peak_bytes_allocated;
+    #endif
     #endif
 
     byte *gc_alloc_table_start;
@@ -95,6 +142,46 @@ typedef struct _mp_state_mem_t {
     size_t gc_first_free_atb_index;
     size_t gc_last_free_atb_index;
 
+    #if MICROPY_GC_FREE_LISTS
+    // gc_free_lists[n] holds free runs of n + 2 blocks (or more for the last)
+    mp_gc_free_list_t gc_free_lists[MICROPY_GC_FREE_LIST_MAX_BLOCKS - 1];
+    #endif
+
+    #if MICROPY_GC_COMPACT
+    // storage being considered by gc_compact, pinned by root pointers into it
+    struct _gc_compact_candidate_t *gc_compact_candidates;
+    size_t gc_compact_n_candidates;
+    #if MICROPY_PY_THREAD && !MICROPY_PY_THREAD_GIL
+    // set once a thread is started; compaction can't stop other threads
+    bool gc_compact_blocked;
+    #endif
+    #endif
+
+    #if MICROPY_GC_TLAB
+    // threads that have an allocation buffer, linked by gc_tlab_next
+    struct _mp_state_thread_t *gc_tlab_threads;
+    // set once a thread is started
+    bool gc_tlab_enabled;
+    // where to look for the next buffer; buffers are handed out in address
+    // order between collections
+    size_t gc_tlab_next_atb_index;
+    #endif
+
+    #if MICROPY_GC_GENERATIONAL
+    // Blocks at or above this one belong to the old generation during the
+    // current collection.  It's the end of the heap for a full collection.
+    size_t gc_young_end_block;
+    bool gc_minor_requested;
+    uint32_t gc_max_pause_us;
+    uint32_t gc_last_full_pause_us;
+    mp_uint_t gc_collect_start_us;
+    // pause statistics, reported by gc.pause_stats()
+    size_t gc_n_minor;
+    size_t gc_n_full;
+    uint32_t gc_longest_pause_us;
+    size_t gc_pause_hist[MICROPY_GC_PAUSE_HIST_LEN];
+    #endif
+
     #if MICROPY_PY_GC_COLLECT_RETVAL
     size_t gc_collected;
     #endif
@@ -119,6 +206,11 @@ typedef struct _mp_state_vm_t {
 
     qstr_pool_t *last_pool;
 
+    #if MICROPY_QSTR_HASH_INDEX
+    // hash index of the qstrs that aren't in mp_qstr_const_pool
+    qstr_hash_index_t *qstr_hash_index;
+    #endif
+
     // non-heap memory for creating an exception if we can't allocate RAM
     mp_obj_exception_t mp_emergency_exception_obj;
 
@@ -148,7 +240,9 @@ typedef struct _mp_state_vm_t {
     volatile mp_obj_t mp_pending_exception;
 
     #if MICROPY_ENABLE_SCHEDULER
+    // the queue is sched_stack until mp_sched_set_depth allocates a bigger one
     mp_sched_item_t sched_stack[MICROPY_SCHEDULER_DEPTH];
+    mp_sched_item_t *sched_queue;
     #endif
 
     // current exception being handled, for sys.exc_info()
@@ -168,6 +262,11 @@ typedef struct _mp_state_vm_t {
     mp_obj_dict_t *mp_module_builtins_override_dict;
     #endif
 
+    #if MICROPY_EMIT_NATIVE_JIT
+    // bytecode recently compiled by the JIT, each with the raw code holding the result
+    struct _mp_jit_cache_entry_t *jit_cache[MICROPY_EMIT_NATIVE_JIT_CACHE_SIZE];
+    #endif
+
     // include any root pointers defined by a port
     MICROPY_PORT_ROOT_POINTERS
 
@@ -189,6 +288,9 @@ typedef struct _mp_state_vm_t {
     #if MICROPY_VFS
     struct _mp_vfs_mount_t *vfs_cur;
     struct _mp_vfs_mount_t *vfs_mount_table;
+    #if MICROPY_VFS_IMPORT_STAT_CACHE
+    char *vfs_import_stat_cache[MICROPY_VFS_IMPORT_STAT_CACHE];
+    #endif
     #endif
 
     //
@@ -206,6 +308,23 @@ typedef struct _mp_state_vm_t {
     mp_thread_mutex_t qstr_mutex;
     #endif
 
+    #if MICROPY_PY_THREAD && MICROPY_PERSISTENT_CODE_LOAD_LAZY
+    // Taken while a lazily loaded raw code is loaded.
+    mp_thread_mutex_t lazy_load_mutex;
+    #endif
+
+    #if MICROPY_PY_THREAD_OBJ_LOCK
+    // Locks taken by builtin containers when they're shared between threads,
+    // see mp_thread_obj_lock().  They're only used once a thread is started.
+    mp_thread_obj_lock_t obj_lock[MICROPY_PY_THREAD_OBJ_LOCK_NUM];
+    bool obj_lock_enabled;
+    #endif
+
+    #if MICROPY_OPT_STR_CHAR_CACHE
+    // qstr of each one-character ASCII string made so far, or MP_QSTR_NULL
+    uint16_t str_char_cache[128];
+    #endif
+
     #if MICROPY_ENABLE_COMPILER
     mp_uint_t mp_optimise_value;
     #endif
@@ -218,6 +337,15 @@ typedef struct _mp_state_vm_t {
     #if MICROPY_ENABLE_SCHEDULER
     volatile int16_t sched_state;
     uint16_t sched_sp;
+    uint16_t sched_depth;
+    #if MICROPY_SCHEDULER_LATENCY
+    mp_uint_t sched_latency[MICROPY_SCHEDULER_LATENCY_BUCKETS];
+    #endif
+    #endif
+
+    #if MICROPY_OPT_CLASS_LOOKUP_CACHE
+    // incremented each time a class dict is modified or a type is created
+    size_t class_lookup_cache_version;
     #endif
 
     #if MICROPY_PY_THREAD_GIL
@@ -246,6 +374,31 @@ typedef struct _mp_state_thread_t {
     uint8_t *pystack_cur;
     #endif
 
+    #if MICROPY_OPT_CLASS_LOOKUP_CACHE
+    // Not scanned by the GC: entries are validated against the type they
+    // were created for, which keeps the cached value alive.
+    mp_class_lookup_cache_entry_t class_lookup_cache[MICROPY_OPT_CLASS_LOOKUP_CACHE_SIZE];
+    #endif
+
+    #if MICROPY_GC_TLAB
+    // Blocks [gc_tlab_start, gc_tlab_end) of the heap are this thread's
+    // allocation buffer and [gc_tlab_cur, gc_tlab_end) is still unused; see
+    // gc_alloc.  The end is 0 when there's no buffer.
+    size_t gc_tlab_start;
+    volatile size_t gc_tlab_cur;
+    volatile size_t gc_tlab_end;
+    // set while the thread allocates from its buffer without the GC mutex
+    volatile bool gc_tlab_busy;
+    // next thread with a buffer, see MP_STATE_MEM(gc_tlab_threads)
+    struct _mp_state_thread_t *gc_tlab_next;
+    #endif
+
+    #if MICROPY_PY_THREAD_OBJ_LOCK
+    // number of object locks this thread holds, counting each time it took
+    // one; see mp_thread_obj_call_unlocked()
+    size_t obj_lock_depth;
+    #endif
+
     ////////////////////////////////////////////////////////////
     // START ROOT POINTER SECTION
     // Everything that needs GC scanning must start here, and
@@ -256,6 +409,17 @@ typedef struct _mp_state_thread_t {
     mp_obj_dict_t *dict_globals;
 
     nlr_buf_t *nlr_top;
+
+    // return value of a native iterator finishing a yield from, see
+    // mp_make_stop_iteration
+    mp_obj_t stop_iteration_arg;
+
+    #if MICROPY_OPT_STR_UNICODE_INDEX
+    // Scanned by the GC so the str data and checkpoint tables stay alive while
+    // they are cached, which means data can't be reused by a different str.
+    mp_str_index_cache_entry_t str_index_cache[MICROPY_OPT_STR_UNICODE_INDEX_CACHE_SIZE];
+    size_t str_index_cache_next;
+    #endif
 } mp_state_thread_t;
 
 // This structure combines the above 3 structures.
@@ -47,8 +47,69 @@ void mp_thread_mutex_init(mp_thread_mutex_t *mutex);
 int mp_thread_mutex_lock(mp_thread_mutex_t *mutex, int wait);
 void mp_thread_mutex_unlock(mp_thread_mutex_t *mutex);
 
+#if MICROPY_PY_THREAD_GC_STOP_WORLD
+void mp_thread_gc_stop_others(void);
+void mp_thread_gc_resume_others(void);
+#endif
+
 #endif // MICROPY_PY_THREAD
 
+#if MICROPY_PY_THREAD_OBJ_LOCK
+#include "py/nlr.h"
+
+// A recursive lock shared by all objects whose address maps to it.
+typedef struct _mp_thread_obj_lock_t {
+    mp_thread_mutex_t mutex;
+    struct _mp_state_thread_t *volatile owner;
+    size_t depth;
+} mp_thread_obj_lock_t;
+
+void mp_thread_obj_lock(const void *obj);
+void mp_thread_obj_unlock(const void *obj);
+
+// Hold the lock of obj from MP_THREAD_OBJ_LOCK until MP_THREAD_OBJ_UNLOCK,
+// releasing it if an exception is raised in between.  There can be only one
+// such region in a function and it must not be left by return or goto.
+#define MP_THREAD_OBJ_LOCK(obj) \
+    nlr_buf_t obj_lock_nlr; \
+    bool obj_locked = MP_STATE_VM(obj_lock_enabled); \
+    if (obj_locked) { \
+        mp_thread_obj_lock(obj); \
+        if (nlr_push(&obj_lock_nlr) != 0) { \
+            mp_thread_obj_unlock(obj); \
+            nlr_jump(obj_lock_nlr.ret_val); \
+        } \
+    }
+#define MP_THREAD_OBJ_UNLOCK(obj) \
+    if (obj_locked) { \
+        nlr_pop(); \
+        mp_thread_obj_unlock(obj); \
+    }
+
+// Whether objects may be shared with another thread, in which case code that
+// reads them without taking their lock must use the locked path instead.
+#define MP_THREAD_OBJ_SHARED() (MP_STATE_VM(obj_lock_enabled))
+#else
+#define MP_THREAD_OBJ_LOCK(obj)
+#define MP_THREAD_OBJ_UNLOCK(obj)
+#define MP_THREAD_OBJ_SHARED() (0)
+#endif
+
+#if MICROPY_PY_THREAD
+// Make the stores before this visible to other threads before those after it,
+// so that a thread which sees a pointer stored after it sees what it points to.
+#define MP_THREAD_STORE_FENCE() __atomic_thread_fence(__ATOMIC_RELEASE)
+#else
+#define MP_THREAD_STORE_FENCE()
+#endif
+
+#if MICROPY_PY_THREAD && !MICROPY_PY_THREAD_GIL
+// Increment a counter which other threads may be incrementing at the same time.
+#define MP_THREAD_ATOMIC_INC(x) __atomic_add_fetch(&(x), 1, __ATOMIC_SEQ_CST)
+#else
+#define MP_THREAD_ATOMIC_INC(x) (++(x))
+#endif
+
 #if MICROPY_PY_THREAD && MICROPY_PY_THREAD_GIL
 #include "py/mpstate.h"
 #define MP_THREAD_GIL_ENTER() mp_thread_mutex_lock(&MP_STATE_VM(gil_mutex), 1)
@@ -449,6 +449,117 @@ STATIC size_t mpn_mul(mpz_dig_t *idig, mpz_dig_t *jdig, size_t jlen, mpz_dig_t *
     return ilen;
 }
 
+#if MICROPY_OPT_MPZ_LARGE_NUMBERS
+
+/* computes i = i + j, where i has ilen digits and j has jlen <= ilen digits
+   assumes the sum fits in ilen digits
+*/
+STATIC void mpn_add_fixed(mpz_dig_t *idig, size_t ilen, const mpz_dig_t *jdig, size_t jlen) {
+    mpz_dbl_dig_t carry = 0;
+    for (size_t n = 0; n < ilen && (n < jlen || carry != 0); ++n) {
+        carry += (mpz_dbl_dig_t)idig[n];
+        if (n < jlen) {
+            carry += (mpz_dbl_dig_t)jdig[n];
+        }
+        idig[n] = carry & DIG_MASK;
+        carry >>= DIG_SIZE;
+    }
+    assert(carry == 0);
+}
+
+/* computes i = i - j, where i has ilen digits and j has jlen <= ilen digits
+   assumes i >= j
+*/
+STATIC void mpn_sub_fixed(mpz_dig_t *idig, size_t ilen, const mpz_dig_t *jdig, size_t jlen) {
+    mpz_dbl_dig_signed_t borrow = 0;
+    for (size_t n = 0; n < ilen && (n < jlen || borrow != 0); ++n) {
+        borrow += (mpz_dbl_dig_t)idig[n];
+        if (n < jlen) {
+            borrow -= (mpz_dbl_dig_t)jdig[n];
+        }
+        idig[n] = borrow & DIG_MASK;
+        borrow >>= DIG_SIZE; // signed shift
+    }
+    assert(borrow == 0);
+}
+
+/* number of digits of scratch memory needed by mpn_mul_karatsuba for operands
+   of up to n digits
+*/
+STATIC size_t mpn_mul_karatsuba_scratch(size_t n) {
+    size_t len = 0;
+    while (n >= MICROPY_MPZ_KARATSUBA_THRESHOLD) {
+        size_t m = (n + 1) / 2;
+        len += 4 * (m + 1);
+        n = m + 1;
+    }
+    return len;
+}
+
+/* computes i = j * k using Karatsuba multiplication above the threshold
+   writes all jlen + klen digits of i; j and k need not be normalised
+   tdig is scratch memory with mpn_mul_karatsuba_scratch(max(jlen, klen)) digits
+*/
+STATIC void mpn_mul_karatsuba(mpz_dig_t *idig, mpz_dig_t *jdig, size_t jlen, mpz_dig_t *kdig, size_t klen, mpz_dig_t *tdig) {
+    if (jlen < klen) {
+        mpz_dig_t *t = jdig; jdig = kdig; kdig = t;
+        size_t l = jlen; jlen = klen; klen = l;
+    }
+
+    if (klen < MICROPY_MPZ_KARATSUBA_THRESHOLD) {
+        memset(idig, 0, (jlen + klen) * sizeof(mpz_dig_t));
+        if (klen > 0) {
+            mpn_mul(idig, jdig, jlen, kdig, klen);
+        }
+        return;
+    }
+
+    size_t m = (jlen + 1) / 2;
+
+    if (klen <= m) {
+        // unbalanced: multiply k by each klen-digit chunk of j and accumulate
+        memset(idig, 0, (jlen + klen) * sizeof(mpz_dig_t));
+        for (size_t off = 0; off < jlen; off += klen) {
+            size_t clen = jlen - off < klen ? jlen - off : klen;
+            mpn_mul_karatsuba(tdig, jdig + off, clen, kdig, klen, tdig + clen + klen);
+            mpn_add_fixed(idig + off, jlen + klen - off, tdig, clen + klen);
+        }
+        return;
+    }
+
+    // balanced: with j = j1*B^m + j0 and k = k1*B^m + k0,
+    // j*k = z2*B^2m + ((j0 + j1)*(k0 + k1) - z2 - z0)*B^m + z0
+    // where z2 = j1*k1 and z0 = j0*k0
+    size_t z2len = jlen + klen - 2 * m;
+    mpz_dig_t *sj = tdig;
+    mpz_dig_t *sk = tdig + m + 1;
+    mpz_dig_t *z1 = tdig + 2 * (m + 1);
+    mpz_dig_t *t = tdig + 4 * (m + 1);
+
+    mpn_mul_karatsuba(idig, jdig, m, kdig, m, t);
+    mpn_mul_karatsuba(idig + 2 * m, jdig + m, jlen - m, kdig + m, klen - m, t);
+
+    memset(sj, 0, 2 * (m + 1) * sizeof(mpz_dig_t));
+    memcpy(sj, jdig, m * sizeof(mpz_dig_t));
+    mpn_add_fixed(sj, m + 1, jdig + m, jlen - m);
+    memcpy(sk, kdig, m * sizeof(mpz_dig_t));
+    mpn_add_fixed(sk, m + 1, kdig + m, klen - m);
+    mpn_mul_karatsuba(z1, sj, m + 1, sk, m + 1, t);
+
+    mpn_sub_fixed(z1, 2 * (m + 1), idig, 2 * m);
+    mpn_sub_fixed(z1, 2 * (m + 1), idig + 2 * m, z2len);
+
+    // the middle term is less than B^(jlen + klen - m), so drop its top zeros
+    size_t z1len = 2 * (m + 1);
+    while (z1len > jlen + klen - m) {
+        assert(z1[z1len - 1] == 0);
+        --z1len;
+    }
+    mpn_add_fixed(idig + m, jlen + klen - m, z1, z1len);
+}
+
+#endif
+
 /* natural_div - quo * den + new_num = old_num (ie num is replaced with rem)
    assumes den != 0
    assumes num_dig has enough memory to be extended by 1 digit
@@ -490,6 +601,9 @@ STATIC void mpn_div(mpz_dig_t *num_dig, size_t *num_len, const mpz_dig_t *den_di
         }
     }
 
+    // the denominator is shifted on the fly by den_shift bits
+    mpz_dig_t den_shift = norm_shift;
+
     // now need to shift numerator by same amount as denominator
     // first, increase length of numerator in case we need more room to shift
     num_dig[*num_len] = 0;
@@ -500,10 +614,24 @@ STATIC void mpn_div(mpz_dig_t *num_dig, size_t *num_len, const mpz_dig_t *den_di
         carry = (mpz_dbl_dig_t)n >> (DIG_SIZE - norm_shift);
     }
 
+    #if MICROPY_OPT_MPZ_LARGE_NUMBERS
+    // normalise a copy of the denominator up front, rather than each time a
+    // digit of it is needed
+    mpz_dig_t *den_norm = NULL;
+    if (norm_shift != 0) {
+        den_norm = m_new(mpz_dig_t, den_len);
+        for (size_t i = den_len; i-- > 0;) {
+            den_norm[i] = (((mpz_dbl_dig_t)den_dig[i] << norm_shift) | (i > 0 ? (mpz_dbl_dig_t)den_dig[i - 1] >> (DIG_SIZE - norm_shift) : 0)) & DIG_MASK;
+        }
+        den_dig = den_norm;
+        den_shift = 0;
+    }
+    #endif
+
     // cache the leading digit of the denominator
-    lead_den_digit = (mpz_dbl_dig_t)den_dig[den_len - 1] << norm_shift;
+    lead_den_digit = (mpz_dbl_dig_t)den_dig[den_len - 1] << den_shift;
     if (den_len >= 2) {
-        lead_den_digit |= (mpz_dbl_dig_t)den_dig[den_len - 2] >> (DIG_SIZE - norm_shift);
+        lead_den_digit |= (mpz_dbl_dig_t)den_dig[den_len - 2] >> (DIG_SIZE - den_shift);
     }
 
     // point num_dig to last digit in numerator
@@ -520,7 +648,23 @@ STATIC void mpn_div(mpz_dig_t *num_dig, size_t *num_len, const mpz_dig_t *den_di
         mpz_dbl_dig_t quo = ((mpz_dbl_dig_t)*num_dig << DIG_SIZE) | num_dig[-1];
 
         // get approximate quotient
+        #if MICROPY_OPT_MPZ_LARGE_NUMBERS
+        // using the next digits of num and den it is refined to be at most 1
+        // too large (Knuth's algorithm D), so the add back below is rare
+        mpz_dbl_dig_t rem = quo % lead_den_digit;
         quo /= lead_den_digit;
+        if (den_len >= 2) {
+            while (quo > DIG_MASK || quo * den_dig[den_len - 2] > ((rem << DIG_SIZE) | num_dig[-2])) {
+                --quo;
+                rem += lead_den_digit;
+                if (rem > DIG_MASK) {
+                    break;
+                }
+            }
+        }
+        #else
+        quo /= lead_den_digit;
+        #endif
 
         // Multiply quo by den and subtract from num to get remainder.
         // We have different code here to handle different compile-time
@@ -542,7 +686,7 @@ STATIC void mpn_div(mpz_dig_t *num_dig, size_t *num_len, const mpz_dig_t *den_di
         mpz_dbl_dig_t d_norm = 0;
         mpz_dbl_dig_t borrow = 0;
         for (mpz_dig_t *n = num_dig - den_len; n < num_dig; ++n, ++d) {
-            d_norm = ((mpz_dbl_dig_t)*d << norm_shift) | (d_norm >> DIG_SIZE);
+            d_norm = ((mpz_dbl_dig_t)*d << den_shift) | (d_norm >> DIG_SIZE);
             mpz_dbl_dig_t x = (mpz_dbl_dig_t)quo * (d_norm & DIG_MASK);
             #if DIG_SIZE < MPZ_DBL_DIG_SIZE / 2
             borrow += (mpz_dbl_dig_t)*n - x; // will overflow if DIG_SIZE >= MPZ_DBL_DIG_SIZE/2
@@ -582,7 +726,7 @@ STATIC void mpn_div(mpz_dig_t *num_dig, size_t *num_len, const mpz_dig_t *den_di
             d_norm = 0;
             mpz_dbl_dig_t carry = 0;
             for (mpz_dig_t *n = num_dig - den_len; n < num_dig; ++n, ++d) {
-                d_norm = ((mpz_dbl_dig_t)*d << norm_shift) | (d_norm >> DIG_SIZE);
+                d_norm = ((mpz_dbl_dig_t)*d << den_shift) | (d_norm >> DIG_SIZE);
                 carry += (mpz_dbl_dig_t)*n + (d_norm & DIG_MASK);
                 *n = carry & DIG_MASK;
                 carry >>= DIG_SIZE;
@@ -599,6 +743,12 @@ STATIC void mpn_div(mpz_dig_t *num_dig, size_t *num_len, const mpz_dig_t *den_di
         --(*num_len);
     }
 
+    #if MICROPY_OPT_MPZ_LARGE_NUMBERS
+    if (den_norm != NULL) {
+        m_del(mpz_dig_t, den_norm, den_len);
+    }
+    #endif
+
     // unnormalise numerator (remainder now)
     for (mpz_dig_t *num = orig_num_dig + *num_len - 1, carry = 0; num >= orig_num_dig; --num) {
         mpz_dig_t n = *num;
@@ -1313,8 +1463,22 @@ void mpz_mul_inpl(mpz_t *dest, const mpz_t *lhs, const mpz_t *rhs) {
     }
 
     mpz_need_dig(dest, lhs->len + rhs->len); // min mem l+r-1, max mem l+r
-    memset(dest->dig, 0, dest->alloc * sizeof(mpz_dig_t));
-    dest->len = mpn_mul(dest->dig, lhs->dig, lhs->len, rhs->dig, rhs->len);
+    #if MICROPY_OPT_MPZ_LARGE_NUMBERS
+    if (lhs->len >= MICROPY_MPZ_KARATSUBA_THRESHOLD && rhs->len >= MICROPY_MPZ_KARATSUBA_THRESHOLD) {
+        size_t tlen = mpn_mul_karatsuba_scratch(MAX(lhs->len, rhs->len));
+        mpz_dig_t *tdig = m_new(mpz_dig_t, tlen);
+        mpn_mul_karatsuba(dest->dig, lhs->dig, lhs->len, rhs->dig, rhs->len, tdig);
+        m_del(mpz_dig_t, tdig, tlen);
+        dest->len = lhs->len + rhs->len;
+        if (dest->dig[dest->len - 1] == 0) {
+            dest->len -= 1;
+        }
+    } else
+    #endif
+    {
+        memset(dest->dig, 0, dest->alloc * sizeof(mpz_dig_t));
+        dest->len = mpn_mul(dest->dig, lhs->dig, lhs->len, rhs->dig, rhs->len);
+    }
 
     if (lhs->neg == rhs->neg) {
         dest->neg = 0;
@@ -1359,6 +1523,69 @@ void mpz_pow_inpl(mpz_t *dest, const mpz_t *lhs, const mpz_t *rhs) {
     mpz_free(n);
 }
 
+#if MICROPY_OPT_MPZ_LARGE_NUMBERS
+
+/* computes dest = (lhs ** rhs) % mod for an rhs of nbits bits using a sliding
+   window: runs of up to w bits of rhs that end in a 1 are applied with a
+   single multiply by a precomputed odd power of lhs
+   can have dest, lhs, rhs the same; mod can't be the same as dest
+*/
+STATIC void mpz_pow3_inpl_window(mpz_t *dest, const mpz_t *lhs, const mpz_t *rhs, size_t nbits, const mpz_t *mod) {
+    unsigned int w = nbits > 512 ? 5 : nbits > 128 ? 4 : 3;
+    mpz_t *n = mpz_clone(rhs);
+    mpz_t quo; mpz_init_zero(&quo);
+
+    // odd_pow[i] = lhs ** (2 * i + 1) % mod, for windows of up to 5 bits
+    mpz_t odd_pow[16];
+    mpz_t x2; mpz_init_zero(&x2);
+    mpz_init_zero(&odd_pow[0]);
+    mpz_divmod_inpl(&quo, &odd_pow[0], lhs, mod);
+    mpz_mul_inpl(&x2, &odd_pow[0], &odd_pow[0]);
+    mpz_divmod_inpl(&quo, &x2, &x2, mod);
+    for (size_t i = 1; i < (1U << (w - 1)); ++i) {
+        mpz_init_zero(&odd_pow[i]);
+        mpz_mul_inpl(&odd_pow[i], &odd_pow[i - 1], &x2);
+        mpz_divmod_inpl(&quo, &odd_pow[i], &odd_pow[i], mod);
+    }
+
+    #define N_BIT(b) ((n->dig[(b) / DIG_SIZE] >> ((b) % DIG_SIZE)) & 1)
+    mpz_set_from_int(dest, 1);
+    for (size_t b = nbits; b > 0;) {
+        if (!N_BIT(b - 1)) {
+            mpz_mul_inpl(dest, dest, dest);
+            mpz_divmod_inpl(&quo, dest, dest, mod);
+            --b;
+            continue;
+        }
+        // take the longest window of at most w bits that ends in a 1
+        size_t len = b < w ? b : w;
+        while (!N_BIT(b - len)) {
+            --len;
+        }
+        unsigned int val = 0;
+        for (size_t i = b; i > b - len; --i) {
+            val = (val << 1) | N_BIT(i - 1);
+        }
+        for (size_t i = 0; i < len; ++i) {
+            mpz_mul_inpl(dest, dest, dest);
+            mpz_divmod_inpl(&quo, dest, dest, mod);
+        }
+        mpz_mul_inpl(dest, dest, &odd_pow[val >> 1]);
+        mpz_divmod_inpl(&quo, dest, dest, mod);
+        b -= len;
+    }
+    #undef N_BIT
+
+    for (size_t i = 0; i < (1U << (w - 1)); ++i) {
+        mpz_deinit(&odd_pow[i]);
+    }
+    mpz_deinit(&x2);
+    mpz_deinit(&quo);
+    mpz_free(n);
+}
+
+#endif
+
 /* computes dest = (lhs ** rhs) % mod
    can have dest, lhs, rhs the same; mod can't be the same as dest
 */
@@ -1374,6 +1601,17 @@ void mpz_pow3_inpl(mpz_t *dest, const mpz_t *lhs, const mpz_t *rhs, const mpz_t
         return;
     }
 
+    #if MICROPY_OPT_MPZ_LARGE_NUMBERS
+    size_t nbits = (rhs->len - 1) * DIG_SIZE;
+    for (mpz_dig_t d = rhs->dig[rhs->len - 1]; d != 0; d >>= 1) {
+        ++nbits;
+    }
+    if (nbits > 8) {
+        mpz_pow3_inpl_window(dest, lhs, rhs, nbits, mod);
+        return;
+    }
+    #endif
+
     mpz_t *x = mpz_clone(lhs);
     mpz_t *n = mpz_clone(rhs);
     mpz_t quo; mpz_init_zero(&quo);
@@ -1668,9 +1906,23 @@ size_t mpz_as_str_inpl(const mpz_t *i, unsigned int base, const char *prefix, ch
     }
 
     // make a copy of mpz digits, so we can do the div/mod calculation
-    mpz_dig_t *dig = m_new(mpz_dig_t, ilen);
+    mpz_dig_t *dig = m_new(mpz_dig_t, i->len);
     memcpy(dig, i->dig, ilen * sizeof(mpz_dig_t));
 
+    #if MICROPY_OPT_MPZ_LARGE_NUMBERS
+    // divide by the largest power of base that fits in a digit, which gives
+    // that many characters for each pass over the digits
+    mpz_dig_t chunk_base = base;
+    unsigned int chunk_len = 1;
+    while ((mpz_dbl_dig_t)chunk_base * base <= DIG_MASK) {
+        chunk_base *= base;
+        chunk_len += 1;
+    }
+    #else
+    const mpz_dig_t chunk_base = base;
+    const unsigned int chunk_len = 1;
+    #endif
+
     // convert
     char *last_comma = str;
     bool done;
@@ -1681,34 +1933,37 @@ size_t mpz_as_str_inpl(const mpz_t *i, unsigned int base, const char *prefix, ch
         // compute next remainder
         while (--d >= dig) {
             a = (a << DIG_SIZE) | *d;
-            *d = a / base;
-            a %= base;
+            *d = a / chunk_base;
+            a %= chunk_base;
         }
 
-        // convert to character
-        a += '0';
-        if (a > '9') {
-            a += base_char - '9' - 1;
+        // drop leading zero digits, the number is zero when none are left
+        while (ilen > 0 && dig[ilen - 1] == 0) {
+            --ilen;
         }
-        *s++ = a;
-
-        // check if number is zero
-        done = true;
-        for (d = dig; d < dig + ilen; ++d) {
-            if (*d != 0) {
-                done = false;
+        done = ilen == 0;
+
+        // convert to characters, without leading zeros in the last chunk
+        for (unsigned int n = 0; n < chunk_len; ++n) {
+            char c = a % base + '0';
+            a /= base;
+            if (c > '9') {
+                c += base_char - '9' - 1;
+            }
+            *s++ = c;
+            if (done && a == 0) {
                 break;
             }
-        }
-        if (comma && (s - last_comma) == 3) {
-            *s++ = comma;
-            last_comma = s;
+            if (comma && (s - last_comma) == 3) {
+                *s++ = comma;
+                last_comma = s;
+            }
         }
     }
     while (!done);
 
     // free the copy of the digits array
-    m_del(mpz_dig_t, dig, ilen);
+    m_del(mpz_dig_t, dig, i->len);
 
     if (prefix) {
         const char *p = &prefix[strlen(prefix)];
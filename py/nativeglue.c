@@ -49,6 +49,9 @@ mp_uint_t mp_convert_obj_to_native(mp_obj_t obj, mp_uint_t type) {
         case MP_NATIVE_TYPE_BOOL:
         case MP_NATIVE_TYPE_INT:
         case MP_NATIVE_TYPE_UINT: return mp_obj_get_int_truncated(obj);
+        #if MICROPY_PY_BUILTINS_FLOAT
+        case MP_NATIVE_TYPE_FLOAT: return mp_native_from_float(mp_obj_get_float(obj));
+        #endif
         default: { // cast obj to a pointer
             mp_buffer_info_t bufinfo;
             if (mp_get_buffer(obj, &bufinfo, MP_BUFFER_RW)) {
@@ -73,6 +76,9 @@ mp_obj_t mp_convert_native_to_obj(mp_uint_t val, mp_uint_t type) {
         case MP_NATIVE_TYPE_BOOL: return mp_obj_new_bool(val);
         case MP_NATIVE_TYPE_INT: return mp_obj_new_int(val);
         case MP_NATIVE_TYPE_UINT: return mp_obj_new_int_from_uint(val);
+        #if MICROPY_PY_BUILTINS_FLOAT
+        case MP_NATIVE_TYPE_FLOAT: return mp_obj_new_float(mp_native_to_float(val));
+        #endif
         default: // a pointer
             // we return just the value of the pointer as an integer
             return mp_obj_new_int_from_uint(val);
@@ -90,9 +96,14 @@ mp_obj_t mp_native_call_function_n_kw(mp_obj_t fun_in, size_t n_args_kw, const m
 }
 
 // wrapper that makes raise obj and raises it
-// END_FINALLY opcode requires that we don't raise if o==None
+// END_FINALLY opcode requires that we don't raise if o==None, nor if o is
+// MP_OBJ_SENTINEL, which the native emitter uses to mark an unwind jump
 void mp_native_raise(mp_obj_t o) {
-    if (o != mp_const_none) {
+    if (o == MP_OBJ_NULL) {
+        // a bare raise, outside of an except clause
+        mp_raise_msg(&mp_type_RuntimeError, translate("no active exception to reraise"));
+    }
+    if (o != mp_const_none && o != MP_OBJ_SENTINEL) {
         nlr_raise(mp_make_raise_obj(o));
     }
 }
@@ -123,6 +134,86 @@ STATIC mp_obj_t mp_native_iternext(mp_obj_iter_buf_t *iter) {
     return mp_iternext(obj);
 }
 
+// wrapper for the YIELD_FROM opcode: resumes gen, sending in send_value or
+// throwing in *ret_value if that's not MP_OBJ_NULL.  Returns true if gen
+// yielded and false if it finished, with the value in *ret_value either way.
+STATIC bool mp_native_yield_from(mp_obj_t gen, mp_obj_t send_value, mp_obj_t *ret_value) {
+    mp_obj_t throw_value = *ret_value;
+    mp_vm_return_kind_t ret_kind;
+    nlr_buf_t nlr;
+    if (nlr_push(&nlr) == 0) {
+        if (throw_value != MP_OBJ_NULL) {
+            ret_kind = mp_resume(gen, MP_OBJ_NULL, throw_value, ret_value);
+        } else {
+            ret_kind = mp_resume(gen, send_value, MP_OBJ_NULL, ret_value);
+        }
+        nlr_pop();
+    } else {
+        // the iternext of a native iterator raised, eg StopIteration with a
+        // value, which the VM handles in its exception handler
+        ret_kind = MP_VM_RETURN_EXCEPTION;
+        *ret_value = MP_OBJ_FROM_PTR(nlr.ret_val);
+    }
+
+    if (ret_kind == MP_VM_RETURN_YIELD) {
+        return true;
+    } else if (ret_kind == MP_VM_RETURN_NORMAL) {
+        if (*ret_value == MP_OBJ_STOP_ITERATION) {
+            *ret_value = mp_const_none;
+        }
+    } else {
+        assert(ret_kind == MP_VM_RETURN_EXCEPTION);
+        if (!mp_obj_exception_match(*ret_value, MP_OBJ_FROM_PTR(&mp_type_StopIteration))) {
+            nlr_raise(*ret_value);
+        }
+        *ret_value = mp_obj_exception_get_value(*ret_value);
+    }
+
+    // if GeneratorExit was thrown in then re-raise it, even if it was swallowed
+    if (throw_value != MP_OBJ_NULL && mp_obj_exception_match(throw_value, MP_OBJ_FROM_PTR(&mp_type_GeneratorExit))) {
+        nlr_raise(mp_make_raise_obj(throw_value));
+    }
+    return false;
+}
+
+#if MICROPY_PY_BUILTINS_FLOAT
+
+// arithmetic on unboxed viper floats, for targets without inline float code
+STATIC mp_uint_t mp_native_float_binary_op(mp_uint_t op, mp_uint_t lhs_in, mp_uint_t rhs_in) {
+    mp_float_t lhs = mp_native_to_float(lhs_in);
+    mp_float_t rhs = mp_native_to_float(rhs_in);
+    switch (op) {
+        case MP_BINARY_OP_ADD: return mp_native_from_float(lhs + rhs);
+        case MP_BINARY_OP_SUBTRACT: return mp_native_from_float(lhs - rhs);
+        case MP_BINARY_OP_MULTIPLY: return mp_native_from_float(lhs * rhs);
+        case MP_BINARY_OP_TRUE_DIVIDE: return mp_native_from_float(lhs / rhs);
+        case MP_BINARY_OP_LESS: return lhs < rhs;
+        case MP_BINARY_OP_MORE: return lhs > rhs;
+        case MP_BINARY_OP_EQUAL: return lhs == rhs;
+        case MP_BINARY_OP_LESS_EQUAL: return lhs <= rhs;
+        case MP_BINARY_OP_MORE_EQUAL: return lhs >= rhs;
+        default: return lhs != rhs; // MP_BINARY_OP_NOT_EQUAL
+    }
+}
+
+// convert between unboxed viper floats and ints, type is the wanted MP_NATIVE_TYPE_xxx
+STATIC mp_uint_t mp_native_float_convert(mp_uint_t val, mp_uint_t type) {
+    if (type == MP_NATIVE_TYPE_FLOAT) {
+        return mp_native_from_float((mp_float_t)(mp_int_t)val);
+    } else {
+        return (mp_int_t)mp_native_to_float(val);
+    }
+}
+
+#endif
+
+#if MICROPY_EMIT_NATIVE_JIT
+// code compiled by the JIT calls this when it loads an unbound local
+STATIC NORETURN void mp_native_raise_unbound_local(void) {
+    nlr_raise(mp_obj_new_exception_msg(&mp_type_NameError, translate("local variable referenced before assignment")));
+}
+#endif
+
 // these must correspond to the respective enum in runtime0.h
 void *const mp_fun_table[MP_F_NUMBER_OF] = {
     mp_convert_obj_to_native,
@@ -173,6 +264,14 @@ void *const mp_fun_table[MP_F_NUMBER_OF] = {
     mp_setup_code_state,
     mp_small_int_floor_divide,
     mp_small_int_modulo,
+    mp_native_yield_from,
+#if MICROPY_PY_BUILTINS_FLOAT
+    mp_native_float_binary_op,
+    mp_native_float_convert,
+#endif
+#if MICROPY_EMIT_NATIVE_JIT
+    mp_native_raise_unbound_local,
+#endif
 };
 
 /*
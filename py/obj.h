@@ -210,6 +210,14 @@ static inline bool MP_OBJ_IS_OBJ(mp_const_obj_t o)
 #define MP_OBJ_TO_PTR(o) ((void*)(uintptr_t)(o))
 #define MP_OBJ_FROM_PTR(p) ((mp_obj_t)((uintptr_t)(p)))
 
+#if UINTPTR_MAX == UINT64_MAX
+// on a 64-bit host an object pointer is stored as is, it just has to be
+// initialised through a pointer member to be a constant expression
+typedef union _mp_rom_obj_t { uint64_t u64; const void *ptr; } mp_rom_obj_t;
+#define MP_ROM_INT(i) {MP_OBJ_NEW_SMALL_INT(i)}
+#define MP_ROM_QSTR(q) {MP_OBJ_NEW_QSTR(q)}
+#define MP_ROM_PTR(p) {.ptr = (p)}
+#else
 // rom object storage needs special handling to widen 32-bit pointer to 64-bits
 typedef union _mp_rom_obj_t { uint64_t u64; struct { const void *lo, *hi; } u32; } mp_rom_obj_t;
 #define MP_ROM_INT(i) {MP_OBJ_NEW_SMALL_INT(i)}
@@ -219,6 +227,7 @@ typedef union _mp_rom_obj_t { uint64_t u64; struct { const void *lo, *hi; } u32;
 #else
 #define MP_ROM_PTR(p) {.u32 = {.lo = NULL, .hi = (p)}}
 #endif
+#endif
 
 #endif
 
@@ -368,7 +377,9 @@ typedef struct _mp_map_t {
     size_t is_ordered : 1;  // an ordered array
     size_t scanning : 1;    // true if we're in the middle of scanning linked dictionaries,
                             // e.g., make_dict_long_lived()
-    size_t used : (8 * sizeof(size_t) - 4);
+    size_t is_class_dict : 1; // true if this is the locals dict of a class; modifying
+                              // it invalidates the class lookup cache
+    size_t used : (8 * sizeof(size_t) - 5);
     size_t alloc;
     mp_map_elem_t *table;
 } mp_map_t;
@@ -394,6 +405,13 @@ mp_map_elem_t *mp_map_lookup(mp_map_t *map, mp_obj_t index, mp_map_lookup_kind_t
 void mp_map_clear(mp_map_t *map);
 void mp_map_dump(mp_map_t *map);
 
+#if MICROPY_OPT_CLASS_LOOKUP_CACHE
+void mp_class_lookup_cache_invalidate(void);
+#define MP_MAP_CLASS_DICT_MUTATED(map) do { if ((map)->is_class_dict) { mp_class_lookup_cache_invalidate(); } } while (0)
+#else
+#define MP_MAP_CLASS_DICT_MUTATED(map) (void)0
+#endif
+
 // Underlying set implementation (not set object)
 
 typedef struct _mp_set_t {
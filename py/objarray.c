@@ -62,6 +62,7 @@
 STATIC mp_obj_t array_iterator_new(mp_obj_t array_in, mp_obj_iter_buf_t *iter_buf);
 STATIC mp_obj_t array_append(mp_obj_t self_in, mp_obj_t arg);
 STATIC mp_obj_t array_extend(mp_obj_t self_in, mp_obj_t arg_in);
+STATIC mp_obj_t array_subscr(mp_obj_t self_in, mp_obj_t index_in, mp_obj_t value);
 STATIC mp_int_t array_get_buffer(mp_obj_t o_in, mp_buffer_info_t *bufinfo, mp_uint_t flags);
 
 /******************************************************************************/
@@ -141,7 +142,8 @@ STATIC mp_obj_t array_construct(char typecode, mp_obj_t initializer) {
 
     mp_obj_array_t *array = array_new(typecode, len);
 
-    mp_obj_t iterable = mp_getiter(initializer, NULL);
+    mp_obj_iter_buf_t iter_buf;
+    mp_obj_t iterable = mp_getiter(initializer, &iter_buf);
     mp_obj_t item;
     size_t i = 0;
     while ((item = mp_iternext(iterable)) != MP_OBJ_STOP_ITERATION) {
@@ -348,6 +350,7 @@ STATIC mp_obj_t array_append(mp_obj_t self_in, mp_obj_t arg) {
         || (MICROPY_PY_ARRAY && MP_OBJ_IS_TYPE(self_in, &mp_type_array)));
     mp_obj_array_t *self = MP_OBJ_TO_PTR(self_in);
 
+    MP_THREAD_OBJ_LOCK(self);
     if (self->free == 0) {
         size_t item_sz = mp_binary_get_size('@', self->typecode, NULL);
         // TODO: alloc policy
@@ -359,6 +362,7 @@ STATIC mp_obj_t array_append(mp_obj_t self_in, mp_obj_t arg) {
     // only update length/free if set succeeded
     self->len++;
     self->free--;
+    MP_THREAD_OBJ_UNLOCK(self);
     return mp_const_none; // return None, as per CPython
 }
 STATIC MP_DEFINE_CONST_FUN_OBJ_2(array_append_obj, array_append);
@@ -378,6 +382,8 @@ STATIC mp_obj_t array_extend(mp_obj_t self_in, mp_obj_t arg_in) {
     // convert byte count to element count
     size_t len = arg_bufinfo.len / sz;
 
+    MP_THREAD_OBJ_LOCK(self);
+
     // make sure we have enough room to extend
     // TODO: alloc policy; at the moment we go conservative
     if (self->free < len) {
@@ -390,13 +396,14 @@ STATIC mp_obj_t array_extend(mp_obj_t self_in, mp_obj_t arg_in) {
     // extend
     mp_seq_copy((byte*)self->items + self->len * sz, arg_bufinfo.buf, len * sz, byte);
     self->len += len;
+    MP_THREAD_OBJ_UNLOCK(self);
 
     return mp_const_none;
 }
 STATIC MP_DEFINE_CONST_FUN_OBJ_2(array_extend_obj, array_extend);
 #endif
 
-STATIC mp_obj_t array_subscr(mp_obj_t self_in, mp_obj_t index_in, mp_obj_t value) {
+STATIC mp_obj_t array_subscr_unlocked(mp_obj_t self_in, mp_obj_t index_in, mp_obj_t value) {
     if (value == MP_OBJ_NULL) {
         // delete item
         // TODO implement
@@ -526,6 +533,13 @@ STATIC mp_obj_t array_subscr(mp_obj_t self_in, mp_obj_t index_in, mp_obj_t value
     }
 }
 
+STATIC mp_obj_t array_subscr(mp_obj_t self_in, mp_obj_t index_in, mp_obj_t value) {
+    MP_THREAD_OBJ_LOCK(MP_OBJ_TO_PTR(self_in));
+    mp_obj_t ret = array_subscr_unlocked(self_in, index_in, value);
+    MP_THREAD_OBJ_UNLOCK(MP_OBJ_TO_PTR(self_in));
+    return ret;
+}
+
 STATIC mp_int_t array_get_buffer(mp_obj_t o_in, mp_buffer_info_t *bufinfo, mp_uint_t flags) {
     mp_obj_array_t *o = MP_OBJ_TO_PTR(o_in);
     size_t sz = mp_binary_get_size('@', o->typecode & TYPECODE_MASK, NULL);
@@ -641,11 +655,13 @@ typedef struct _mp_obj_array_it_t {
 
 STATIC mp_obj_t array_it_iternext(mp_obj_t self_in) {
     mp_obj_array_it_t *self = MP_OBJ_TO_PTR(self_in);
+    mp_obj_t next = MP_OBJ_STOP_ITERATION;
+    MP_THREAD_OBJ_LOCK(self->array);
     if (self->cur < self->array->len) {
-        return mp_binary_get_val_array(self->array->typecode & TYPECODE_MASK, self->array->items, self->offset + self->cur++);
-    } else {
-        return MP_OBJ_STOP_ITERATION;
+        next = mp_binary_get_val_array(self->array->typecode & TYPECODE_MASK, self->array->items, self->offset + self->cur++);
     }
+    MP_THREAD_OBJ_UNLOCK(self->array);
+    return next;
 }
 
 STATIC const mp_obj_type_t array_it_type = {
@@ -91,7 +91,7 @@ STATIC mp_obj_t dict_make_new(const mp_obj_type_t *type, size_t n_args, const mp
     }
     #endif
     if (n_args > 0 || kw_args != NULL) {
-        mp_obj_t args2[2] = {dict_out, NULL}; // args[0] is always valid, even if it's not a positional arg
+        mp_obj_t args2[2] = {dict_out, MP_OBJ_NULL}; // args[0] is always valid, even if it's not a positional arg
         if (n_args > 0) {
             args2[1] = args[0];
         }
@@ -119,7 +119,9 @@ STATIC mp_obj_t dict_binary_op(mp_binary_op_t op, mp_obj_t lhs_in, mp_obj_t rhs_
     mp_obj_dict_t *o = MP_OBJ_TO_PTR(lhs_in);
     switch (op) {
         case MP_BINARY_OP_CONTAINS: {
+            MP_THREAD_OBJ_LOCK(o);
             mp_map_elem_t *elem = mp_map_lookup(&o->map, rhs_in, MP_MAP_LOOKUP);
+            MP_THREAD_OBJ_UNLOCK(o);
             return mp_obj_new_bool(elem != NULL);
         }
         case MP_BINARY_OP_EQUAL: {
@@ -166,12 +168,14 @@ STATIC mp_obj_t dict_binary_op(mp_binary_op_t op, mp_obj_t lhs_in, mp_obj_t rhs_
 // TODO: Make sure this is inlined in dict_subscr() below.
 mp_obj_t mp_obj_dict_get(mp_obj_t self_in, mp_obj_t index) {
     mp_obj_dict_t *self = MP_OBJ_TO_PTR(self_in);
+    MP_THREAD_OBJ_LOCK(self);
     mp_map_elem_t *elem = mp_map_lookup(&self->map, index, MP_MAP_LOOKUP);
-    if (elem == NULL) {
+    mp_obj_t value = elem == NULL ? MP_OBJ_NULL : elem->value;
+    MP_THREAD_OBJ_UNLOCK(self);
+    if (value == MP_OBJ_NULL) {
         nlr_raise(mp_obj_new_exception_arg1(&mp_type_KeyError, index));
-    } else {
-        return elem->value;
     }
+    return value;
 }
 
 STATIC mp_obj_t dict_subscr(mp_obj_t self_in, mp_obj_t index, mp_obj_t value) {
@@ -182,12 +186,14 @@ STATIC mp_obj_t dict_subscr(mp_obj_t self_in, mp_obj_t index, mp_obj_t value) {
     } else if (value == MP_OBJ_SENTINEL) {
         // load
         mp_obj_dict_t *self = MP_OBJ_TO_PTR(self_in);
+        MP_THREAD_OBJ_LOCK(self);
         mp_map_elem_t *elem = mp_map_lookup(&self->map, index, MP_MAP_LOOKUP);
-        if (elem == NULL) {
+        mp_obj_t load = elem == NULL ? MP_OBJ_NULL : elem->value;
+        MP_THREAD_OBJ_UNLOCK(self);
+        if (load == MP_OBJ_NULL) {
             nlr_raise(mp_obj_new_exception_arg1(&mp_type_KeyError, index));
-        } else {
-            return elem->value;
         }
+        return load;
     } else {
         // store
         mp_obj_dict_store(self_in, index, value);
@@ -209,7 +215,9 @@ STATIC mp_obj_t dict_clear(mp_obj_t self_in) {
     mp_obj_dict_t *self = MP_OBJ_TO_PTR(self_in);
     mp_ensure_not_fixed(self);
 
+    MP_THREAD_OBJ_LOCK(self);
     mp_map_clear(&self->map);
+    MP_THREAD_OBJ_UNLOCK(self);
 
     return mp_const_none;
 }
@@ -218,21 +226,27 @@ STATIC MP_DEFINE_CONST_FUN_OBJ_1(dict_clear_obj, dict_clear);
 STATIC mp_obj_t dict_copy(mp_obj_t self_in) {
     mp_check_self(MP_OBJ_IS_DICT_TYPE(self_in));
     mp_obj_dict_t *self = MP_OBJ_TO_PTR(self_in);
-    mp_obj_t other_out = mp_obj_new_dict(self->map.alloc);
+    mp_obj_t other_out = mp_obj_new_dict(0);
     mp_obj_dict_t *other = MP_OBJ_TO_PTR(other_out);
     other->base.type = self->base.type;
+    MP_THREAD_OBJ_LOCK(self);
+    // copy the table as is, with the same size so that the hashes still apply
+    other->map.alloc = self->map.alloc;
+    other->map.table = m_new(mp_map_elem_t, other->map.alloc);
     other->map.used = self->map.used;
     other->map.all_keys_are_qstrs = self->map.all_keys_are_qstrs;
     other->map.is_fixed = 0;
     other->map.is_ordered = self->map.is_ordered;
     memcpy(other->map.table, self->map.table, self->map.alloc * sizeof(mp_map_elem_t));
+    MP_THREAD_OBJ_UNLOCK(self);
     return other_out;
 }
 STATIC MP_DEFINE_CONST_FUN_OBJ_1(dict_copy_obj, dict_copy);
 
 // this is a classmethod
 STATIC mp_obj_t dict_fromkeys(size_t n_args, const mp_obj_t *args) {
-    mp_obj_t iter = mp_getiter(args[1], NULL);
+    mp_obj_iter_buf_t iter_buf;
+    mp_obj_t iter = mp_getiter(args[1], &iter_buf);
     mp_obj_t value = mp_const_none;
     mp_obj_t next = MP_OBJ_NULL;
 
@@ -266,12 +280,13 @@ STATIC mp_obj_t dict_get_helper(size_t n_args, const mp_obj_t *args, mp_map_look
     if (lookup_kind != MP_MAP_LOOKUP) {
         mp_ensure_not_fixed(self);
     }
+    MP_THREAD_OBJ_LOCK(self);
     mp_map_elem_t *elem = mp_map_lookup(&self->map, args[1], lookup_kind);
     mp_obj_t value;
     if (elem == NULL || elem->value == MP_OBJ_NULL) {
         if (n_args == 2) {
             if (lookup_kind == MP_MAP_LOOKUP_REMOVE_IF_FOUND) {
-                nlr_raise(mp_obj_new_exception_arg1(&mp_type_KeyError, args[1]));
+                value = MP_OBJ_NULL; // KeyError, raised once the dict is unlocked
             } else {
                 value = mp_const_none;
             }
@@ -287,6 +302,10 @@ STATIC mp_obj_t dict_get_helper(size_t n_args, const mp_obj_t *args, mp_map_look
             elem->value = MP_OBJ_NULL; // so that GC can collect the deleted value
         }
     }
+    MP_THREAD_OBJ_UNLOCK(self);
+    if (value == MP_OBJ_NULL) {
+        nlr_raise(mp_obj_new_exception_arg1(&mp_type_KeyError, args[1]));
+    }
     return value;
 }
 
@@ -309,15 +328,22 @@ STATIC mp_obj_t dict_popitem(mp_obj_t self_in) {
     mp_check_self(MP_OBJ_IS_DICT_TYPE(self_in));
     mp_obj_dict_t *self = MP_OBJ_TO_PTR(self_in);
     mp_ensure_not_fixed(self);
+    MP_THREAD_OBJ_LOCK(self);
     size_t cur = 0;
     mp_map_elem_t *next = dict_iter_next(self, &cur);
+    mp_obj_t items[] = {MP_OBJ_NULL, MP_OBJ_NULL};
+    if (next != NULL) {
+        MP_MAP_CLASS_DICT_MUTATED(&self->map);
+        self->map.used--;
+        items[0] = next->key;
+        items[1] = next->value;
+        next->key = MP_OBJ_SENTINEL; // must mark key as sentinel to indicate that it was deleted
+        next->value = MP_OBJ_NULL;
+    }
+    MP_THREAD_OBJ_UNLOCK(self);
     if (next == NULL) {
         mp_raise_msg(&mp_type_KeyError, translate("popitem(): dictionary is empty"));
     }
-    self->map.used--;
-    mp_obj_t items[] = {next->key, next->value};
-    next->key = MP_OBJ_SENTINEL; // must mark key as sentinel to indicate that it was deleted
-    next->value = MP_OBJ_NULL;
     mp_obj_t tuple = mp_obj_new_tuple(2, items);
 
     return tuple;
@@ -340,15 +366,17 @@ STATIC mp_obj_t dict_update(size_t n_args, const mp_obj_t *args, mp_map_t *kwarg
                 size_t cur = 0;
                 mp_map_elem_t *elem = NULL;
                 while ((elem = dict_iter_next((mp_obj_dict_t*)MP_OBJ_TO_PTR(args[1]), &cur)) != NULL) {
-                    mp_map_lookup(&self->map, elem->key, MP_MAP_LOOKUP_ADD_IF_NOT_FOUND)->value = elem->value;
+                    mp_obj_dict_store(args[0], elem->key, elem->value);
                 }
             }
         } else {
             // update from a generic iterable of pairs
-            mp_obj_t iter = mp_getiter(args[1], NULL);
+            mp_obj_iter_buf_t iter_buf;
+            mp_obj_t iter = mp_getiter(args[1], &iter_buf);
             mp_obj_t next = MP_OBJ_NULL;
             while ((next = mp_iternext(iter)) != MP_OBJ_STOP_ITERATION) {
-                mp_obj_t inneriter = mp_getiter(next, NULL);
+                mp_obj_iter_buf_t inner_iter_buf;
+                mp_obj_t inneriter = mp_getiter(next, &inner_iter_buf);
                 mp_obj_t key = mp_iternext(inneriter);
                 mp_obj_t value = mp_iternext(inneriter);
                 mp_obj_t stop = mp_iternext(inneriter);
@@ -357,7 +385,7 @@ STATIC mp_obj_t dict_update(size_t n_args, const mp_obj_t *args, mp_map_t *kwarg
                     || stop != MP_OBJ_STOP_ITERATION) {
                     mp_raise_ValueError(translate("dict update sequence has wrong length"));
                 } else {
-                    mp_map_lookup(&self->map, key, MP_MAP_LOOKUP_ADD_IF_NOT_FOUND)->value = value;
+                    mp_obj_dict_store(args[0], key, value);
                 }
             }
         }
@@ -366,7 +394,7 @@ STATIC mp_obj_t dict_update(size_t n_args, const mp_obj_t *args, mp_map_t *kwarg
     // update the dict with any keyword args
     for (size_t i = 0; i < kwargs->alloc; i++) {
         if (MP_MAP_SLOT_IS_FILLED(kwargs, i)) {
-            mp_map_lookup(&self->map, kwargs->table[i].key, MP_MAP_LOOKUP_ADD_IF_NOT_FOUND)->value = kwargs->table[i].value;
+            mp_obj_dict_store(args[0], kwargs->table[i].key, kwargs->table[i].value);
         }
     }
 
@@ -405,21 +433,27 @@ typedef struct _mp_obj_dict_view_t {
 STATIC mp_obj_t dict_view_it_iternext(mp_obj_t self_in) {
     mp_check_self(MP_OBJ_IS_TYPE(self_in, &dict_view_it_type));
     mp_obj_dict_view_it_t *self = MP_OBJ_TO_PTR(self_in);
-    mp_map_elem_t *next = dict_iter_next(MP_OBJ_TO_PTR(self->dict), &self->cur);
+    mp_obj_dict_t *dict = MP_OBJ_TO_PTR(self->dict);
+    MP_THREAD_OBJ_LOCK(dict);
+    mp_map_elem_t *next = dict_iter_next(dict, &self->cur);
+    mp_obj_t items[] = {MP_OBJ_NULL, MP_OBJ_NULL};
+    if (next != NULL) {
+        items[0] = next->key;
+        items[1] = next->value;
+    }
+    MP_THREAD_OBJ_UNLOCK(dict);
 
     if (next == NULL) {
         return MP_OBJ_STOP_ITERATION;
     } else {
         switch (self->kind) {
             case MP_DICT_VIEW_ITEMS:
-            default: {
-                mp_obj_t items[] = {next->key, next->value};
+            default:
                 return mp_obj_new_tuple(2, items);
-            }
             case MP_DICT_VIEW_KEYS:
-                return next->key;
+                return items[0];
             case MP_DICT_VIEW_VALUES:
-                return next->value;
+                return items[1];
         }
     }
 }
@@ -594,7 +628,9 @@ mp_obj_t mp_obj_dict_store(mp_obj_t self_in, mp_obj_t key, mp_obj_t value) {
     mp_check_self(MP_OBJ_IS_DICT_TYPE(self_in));
     mp_obj_dict_t *self = MP_OBJ_TO_PTR(self_in);
     mp_ensure_not_fixed(self);
+    MP_THREAD_OBJ_LOCK(self);
     mp_map_lookup(&self->map, key, MP_MAP_LOOKUP_ADD_IF_NOT_FOUND)->value = value;
+    MP_THREAD_OBJ_UNLOCK(self);
     return self_in;
 }
 
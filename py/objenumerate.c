@@ -35,6 +35,10 @@ typedef struct _mp_obj_enumerate_t {
     mp_obj_base_t base;
     mp_obj_t iter;
     mp_int_t cur;
+    // Holds the iterator if its type can build it in a buffer, in which case
+    // iter is MP_OBJ_NULL.  The buffer's address can't be kept in iter since
+    // the enumerate object may be moved to the long-lived part of the heap.
+    mp_obj_iter_buf_t iter_buf;
 } mp_obj_enumerate_t;
 
 STATIC mp_obj_t enumerate_iternext(mp_obj_t self_in);
@@ -56,15 +60,18 @@ STATIC mp_obj_t enumerate_make_new(const mp_obj_type_t *type, size_t n_args, con
     // create enumerate object
     mp_obj_enumerate_t *o = m_new_obj(mp_obj_enumerate_t);
     o->base.type = type;
-    o->iter = mp_getiter(arg_vals.iterable.u_obj, NULL);
+    o->iter = mp_getiter(arg_vals.iterable.u_obj, &o->iter_buf);
     o->cur = arg_vals.start.u_int;
 #else
     (void)kw_args;
     mp_obj_enumerate_t *o = m_new_obj(mp_obj_enumerate_t);
     o->base.type = type;
-    o->iter = mp_getiter(args[0], NULL);
+    o->iter = mp_getiter(args[0], &o->iter_buf);
     o->cur = n_args > 1 ? mp_obj_get_int(args[1]) : 0;
 #endif
+    if (o->iter == MP_OBJ_FROM_PTR(&o->iter_buf)) {
+        o->iter = MP_OBJ_NULL;
+    }
 
     return MP_OBJ_FROM_PTR(o);
 }
@@ -80,7 +87,8 @@ const mp_obj_type_t mp_type_enumerate = {
 STATIC mp_obj_t enumerate_iternext(mp_obj_t self_in) {
     assert(MP_OBJ_IS_TYPE(self_in, &mp_type_enumerate));
     mp_obj_enumerate_t *self = MP_OBJ_TO_PTR(self_in);
-    mp_obj_t next = mp_iternext(self->iter);
+    mp_obj_t iter = self->iter != MP_OBJ_NULL ? self->iter : MP_OBJ_FROM_PTR(&self->iter_buf);
+    mp_obj_t next = mp_iternext(iter);
     if (next == MP_OBJ_STOP_ITERATION) {
         return MP_OBJ_STOP_ITERATION;
     } else {
@@ -692,14 +692,12 @@ STATIC mp_obj_t traceback_from_values(size_t *values, mp_obj_t tb_next) {
 };
 
 mp_obj_t mp_obj_exception_get_traceback_obj(mp_obj_t self_in) {
-    mp_obj_exception_t *self = MP_OBJ_TO_PTR(self_in);
-
-    if (!mp_obj_is_exception_instance(self)) {
+    if (!mp_obj_is_exception_instance(self_in)) {
         return mp_const_none;
     }
 
     size_t n, *values;
-    mp_obj_exception_get_traceback(self, &n, &values);
+    mp_obj_exception_get_traceback(self_in, &n, &values);
     if (n == 0) {
         return mp_const_none;
     }
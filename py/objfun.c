@@ -30,8 +30,10 @@
 
 #include "py/objtuple.h"
 #include "py/objfun.h"
+#include "py/emitjit.h"
 #include "py/runtime.h"
 #include "py/bc.h"
+#include "py/persistentcode.h"
 #include "py/stackctrl.h"
 
 #if MICROPY_DEBUG_VERBOSE // print debugging info
@@ -160,6 +162,7 @@ qstr mp_obj_fun_get_name(mp_const_obj_t fun_in) {
     }
     #endif
 
+    mp_obj_fun_bc_ensure_loaded((mp_obj_fun_bc_t*)fun);
     const byte *bc = fun->bytecode;
     bc = mp_decode_uint_skip(bc); // skip n_state
     bc = mp_decode_uint_skip(bc); // skip n_exc_stack
@@ -221,6 +224,7 @@ STATIC void dump_args(const mp_obj_t *a, size_t sz) {
 mp_code_state_t *mp_obj_fun_bc_prepare_codestate(mp_obj_t self_in, size_t n_args, size_t n_kw, const mp_obj_t *args) {
     MP_STACK_CHECK();
     mp_obj_fun_bc_t *self = MP_OBJ_TO_PTR(self_in);
+    mp_obj_fun_bc_ensure_loaded(self);
 
     size_t n_state, state_size;
     DECODE_CODESTATE_SIZE(self->bytecode, n_state, state_size);
@@ -259,6 +263,14 @@ STATIC mp_obj_t fun_bc_call(mp_obj_t self_in, size_t n_args, size_t n_kw, const
     dump_args(args + n_args, n_kw * 2);
     mp_obj_fun_bc_t *self = MP_OBJ_TO_PTR(self_in);
     DEBUG_printf("Func n_def_args: %d\n", self->n_def_args);
+    mp_obj_fun_bc_ensure_loaded(self);
+
+    #if MICROPY_EMIT_NATIVE_JIT
+    mp_obj_t native = mp_jit_get(self);
+    if (native != MP_OBJ_NULL) {
+        return mp_jit_call(self, native, n_args, n_kw, args);
+    }
+    #endif
 
     size_t n_state, state_size;
     DECODE_CODESTATE_SIZE(self->bytecode, n_state, state_size);
@@ -362,6 +374,12 @@ const mp_obj_type_t mp_type_fun_bc = {
 #endif
 };
 
+#if MICROPY_PERSISTENT_CODE_LOAD_LAZY
+void mp_obj_fun_bc_load(mp_obj_fun_bc_t *self) {
+    mp_raw_code_load_lazy_fun(&self->bytecode, &self->const_table);
+}
+#endif
+
 mp_obj_t mp_obj_new_fun_bc(mp_obj_t def_args_in, mp_obj_t def_kw_args, const byte *code, const mp_uint_t *const_table) {
     size_t n_def_args = 0;
     size_t n_extra_args = 0;
@@ -379,6 +397,9 @@ mp_obj_t mp_obj_new_fun_bc(mp_obj_t def_args_in, mp_obj_t def_kw_args, const byt
     o->globals = mp_globals_get();
     o->bytecode = code;
     o->const_table = const_table;
+    #if MICROPY_EMIT_NATIVE_JIT
+    o->jit = MP_JIT_COUNTER_INIT;
+    #endif
     if (def_args != NULL) {
         memcpy(o->extra_args, def_args->items, n_def_args * sizeof(mp_obj_t));
     }
@@ -410,6 +431,9 @@ STATIC const mp_obj_type_t mp_type_fun_native = {
 mp_obj_t mp_obj_new_fun_native(mp_obj_t def_args_in, mp_obj_t def_kw_args, const void *fun_data, const mp_uint_t *const_table) {
     mp_obj_fun_bc_t *o = mp_obj_new_fun_bc(def_args_in, def_kw_args, (const byte*)fun_data, const_table);
     o->base.type = &mp_type_fun_native;
+    #if MICROPY_EMIT_NATIVE_JIT
+    o->jit = mp_const_none;
+    #endif
     return o;
 }
 
@@ -33,6 +33,9 @@ typedef struct _mp_obj_fun_bc_t {
     mp_obj_dict_t *globals;         // the context within which this function was defined
     const byte *bytecode;           // bytecode for the function
     const mp_uint_t *const_table;   // constant table
+    #if MICROPY_EMIT_NATIVE_JIT
+    mp_obj_t jit;                   // see py/emitjit.h
+    #endif
     // the following extra_args array is allocated space to take (in order):
     //  - values of positional default args (if any)
     //  - a single slot for default kw args dict (if it has them)
@@ -41,4 +44,19 @@ typedef struct _mp_obj_fun_bc_t {
     mp_obj_t extra_args[];
 } mp_obj_fun_bc_t;
 
+#if MICROPY_PERSISTENT_CODE_LOAD_LAZY
+// A function made from a lazily loaded raw code has a NULL bytecode pointer,
+// and its const_table points to the raw code, until it is first needed.
+void mp_obj_fun_bc_load(mp_obj_fun_bc_t *self);
+static inline void mp_obj_fun_bc_ensure_loaded(mp_obj_fun_bc_t *self) {
+    if (self->bytecode == NULL) {
+        mp_obj_fun_bc_load(self);
+    }
+}
+#else
+static inline void mp_obj_fun_bc_ensure_loaded(mp_obj_fun_bc_t *self) {
+    (void)self;
+}
+#endif
+
 #endif // MICROPY_INCLUDED_PY_OBJFUN_H
@@ -32,6 +32,7 @@
 #include "py/bc.h"
 #include "py/objgenerator.h"
 #include "py/objfun.h"
+#include "py/emitjit.h"
 #include "py/stackctrl.h"
 
 #include "supervisor/shared/translate.h"
@@ -50,14 +51,48 @@ typedef struct _mp_obj_gen_instance_t {
     mp_code_state_t code_state;
 } mp_obj_gen_instance_t;
 
+// Natively compiled generators have the offset to their prelude as the first
+// word of their code, followed by the entry point.  They are marked by having
+// a NULL exc_sp, as they keep their exception state in the state array.
+#if MICROPY_EMIT_NATIVE
+#define GEN_IS_NATIVE(code_state) ((code_state)->exc_sp == NULL)
+#else
+#define GEN_IS_NATIVE(code_state) (false)
+#endif
+
+STATIC const byte *gen_get_prelude(const mp_obj_fun_bc_t *fun, bool is_native) {
+    const byte *prelude = fun->bytecode;
+    if (is_native) {
+        prelude += *(const uintptr_t*)prelude;
+    }
+    return prelude;
+}
+
 STATIC mp_obj_t gen_wrap_call(mp_obj_t self_in, size_t n_args, size_t n_kw, const mp_obj_t *args) {
     mp_obj_gen_wrap_t *self = MP_OBJ_TO_PTR(self_in);
     mp_obj_fun_bc_t *self_fun = (mp_obj_fun_bc_t*)self->fun;
+    #if MICROPY_EMIT_NATIVE
+    bool is_native = self_fun->base.type != &mp_type_fun_bc;
+    #else
+    bool is_native = false;
     assert(self_fun->base.type == &mp_type_fun_bc);
+    #endif
+    mp_obj_fun_bc_ensure_loaded(self_fun);
+
+    #if MICROPY_EMIT_NATIVE_JIT
+    if (!is_native) {
+        mp_obj_t native = mp_jit_get(self_fun);
+        if (native != MP_OBJ_NULL) {
+            self_fun = MP_OBJ_TO_PTR(native);
+            is_native = true;
+        }
+    }
+    #endif
 
     // bytecode prelude: get state size and exception stack size
-    size_t n_state = mp_decode_uint_value(self_fun->bytecode);
-    size_t n_exc_stack = mp_decode_uint_value(mp_decode_uint_skip(self_fun->bytecode));
+    const byte *prelude = gen_get_prelude(self_fun, is_native);
+    size_t n_state = mp_decode_uint_value(prelude);
+    size_t n_exc_stack = mp_decode_uint_value(mp_decode_uint_skip(prelude));
 
     // allocate the generator object, with room for local stack and exception stack
     mp_obj_gen_instance_t *o = m_new_obj_var(mp_obj_gen_instance_t, byte,
@@ -66,8 +101,11 @@ STATIC mp_obj_t gen_wrap_call(mp_obj_t self_in, size_t n_args, size_t n_kw, cons
 
     o->globals = self_fun->globals;
     o->code_state.fun_bc = self_fun;
-    o->code_state.ip = 0;
+    o->code_state.ip = (const byte*)(prelude - self_fun->bytecode);
     mp_setup_code_state(&o->code_state, n_args, n_kw, args);
+    if (is_native) {
+        o->code_state.exc_sp = NULL;
+    }
     return MP_OBJ_FROM_PTR(o);
 }
 
@@ -91,7 +129,12 @@ mp_obj_t mp_obj_new_gen_wrap(mp_obj_t fun) {
 STATIC void gen_instance_print(const mp_print_t *print, mp_obj_t self_in, mp_print_kind_t kind) {
     (void)kind;
     mp_obj_gen_instance_t *self = MP_OBJ_TO_PTR(self_in);
-    mp_printf(print, "<generator object '%q' at %p>", mp_obj_fun_get_name(MP_OBJ_FROM_PTR(self->code_state.fun_bc)), self);
+    // get the name from the prelude, which native generators have too
+    const byte *prelude = gen_get_prelude(self->code_state.fun_bc, GEN_IS_NATIVE(&self->code_state));
+    prelude = mp_decode_uint_skip(prelude); // skip n_state
+    prelude = mp_decode_uint_skip(prelude); // skip n_exc_stack
+    prelude += 4; // skip scope_flags, n_pos_args, n_kwonly_args, n_def_pos_args
+    mp_printf(print, "<generator object '%q' at %p>", mp_obj_code_get_name(prelude), self);
 }
 
 mp_vm_return_kind_t mp_obj_gen_resume(mp_obj_t self_in, mp_obj_t send_value, mp_obj_t throw_value, mp_obj_t *ret_val) {
@@ -130,7 +173,17 @@ mp_vm_return_kind_t mp_obj_gen_resume(mp_obj_t self_in, mp_obj_t send_value, mp_
     self->code_state.old_globals = mp_globals_get();
     mp_globals_set(self->globals);
     self->globals = NULL;
-    mp_vm_return_kind_t ret_kind = mp_execute_bytecode(&self->code_state, throw_value);
+    mp_vm_return_kind_t ret_kind;
+    #if MICROPY_EMIT_NATIVE
+    if (GEN_IS_NATIVE(&self->code_state)) {
+        typedef mp_vm_return_kind_t (*mp_native_gen_fun_t)(mp_code_state_t*, mp_obj_t);
+        mp_native_gen_fun_t fun = MICROPY_MAKE_POINTER_CALLABLE((void*)(self->code_state.fun_bc->bytecode + sizeof(uintptr_t)));
+        ret_kind = fun(&self->code_state, throw_value);
+    } else
+    #endif
+    {
+        ret_kind = mp_execute_bytecode(&self->code_state, throw_value);
+    }
     self->globals = mp_globals_get();
     mp_globals_set(self->code_state.old_globals);
 
@@ -154,9 +207,16 @@ mp_vm_return_kind_t mp_obj_gen_resume(mp_obj_t self_in, mp_obj_t send_value, mp_
             break;
 
         case MP_VM_RETURN_EXCEPTION: {
-            size_t n_state = mp_decode_uint_value(self->code_state.fun_bc->bytecode);
+            bool is_native = GEN_IS_NATIVE(&self->code_state);
+            size_t n_state = mp_decode_uint_value(gen_get_prelude(self->code_state.fun_bc, is_native));
             self->code_state.ip = 0;
             *ret_val = self->code_state.state[n_state - 1];
+            #if MICROPY_EMIT_NATIVE_JIT
+            if (is_native && self->code_state.fun_bc->jit != mp_const_none) {
+                // jit-compiled, the VM would have added an entry for it
+                mp_jit_add_traceback(MP_OBJ_TO_PTR(self->code_state.fun_bc->jit), *ret_val);
+            }
+            #endif
             break;
         }
     }
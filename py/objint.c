@@ -119,9 +119,14 @@ STATIC mp_fp_as_int_class_t mp_classify_fp_as_int(mp_float_t val) {
     } else {
         e &= ~((1 << MP_FLOAT_EXP_SHIFT_I32) - 1);
     }
-    // 8 * sizeof(uintptr_t) counts the number of bits for a small int
+    // 8 * sizeof(uintptr_t) counts the number of bits for a small int, except
+    // with nan-boxing where a small int has 48 bits whatever the pointer size
     // TODO provide a way to configure this properly
+    #if MICROPY_OBJ_REPR == MICROPY_OBJ_REPR_D
+    if (e <= ((48 + MP_FLOAT_EXP_BIAS - 3) << MP_FLOAT_EXP_SHIFT_I32)) {
+    #else
     if (e <= ((8 * sizeof(uintptr_t) + MP_FLOAT_EXP_BIAS - 3) << MP_FLOAT_EXP_SHIFT_I32)) {
+    #endif
         return MP_FP_CLASS_FIT_SMALLINT;
     }
 #if MICROPY_LONGINT_IMPL == MICROPY_LONGINT_IMPL_LONGLONG
@@ -28,6 +28,7 @@
 #include <assert.h>
 
 #include "py/objlist.h"
+#include "py/objstr.h"
 #include "py/runtime.h"
 #include "py/stackctrl.h"
 
@@ -60,7 +61,8 @@ STATIC void list_print(const mp_print_t *print, mp_obj_t o_in, mp_print_kind_t k
 }
 
 STATIC mp_obj_t list_extend_from_iter(mp_obj_t list, mp_obj_t iterable) {
-    mp_obj_t iter = mp_getiter(iterable, NULL);
+    mp_obj_iter_buf_t iter_buf;
+    mp_obj_t iter = mp_getiter(iterable, &iter_buf);
     mp_obj_t item;
     while ((item = mp_iternext(iter)) != MP_OBJ_STOP_ITERATION) {
         mp_obj_list_append(list, item);
@@ -158,7 +160,7 @@ STATIC mp_obj_t list_binary_op(mp_binary_op_t op, mp_obj_t lhs, mp_obj_t rhs) {
     }
 }
 
-STATIC mp_obj_t list_subscr(mp_obj_t self_in, mp_obj_t index, mp_obj_t value) {
+STATIC mp_obj_t list_subscr_unlocked(mp_obj_t self_in, mp_obj_t index, mp_obj_t value) {
     if (value == MP_OBJ_NULL) {
         // delete
 #if MICROPY_PY_BUILTINS_SLICE
@@ -235,6 +237,13 @@ STATIC mp_obj_t list_subscr(mp_obj_t self_in, mp_obj_t index, mp_obj_t value) {
     }
 }
 
+STATIC mp_obj_t list_subscr(mp_obj_t self_in, mp_obj_t index, mp_obj_t value) {
+    MP_THREAD_OBJ_LOCK(MP_OBJ_TO_PTR(self_in));
+    mp_obj_t ret = list_subscr_unlocked(self_in, index, value);
+    MP_THREAD_OBJ_UNLOCK(MP_OBJ_TO_PTR(self_in));
+    return ret;
+}
+
 STATIC mp_obj_t list_getiter(mp_obj_t o_in, mp_obj_iter_buf_t *iter_buf) {
     return mp_obj_new_list_iterator(o_in, 0, iter_buf);
 }
@@ -242,12 +251,14 @@ STATIC mp_obj_t list_getiter(mp_obj_t o_in, mp_obj_iter_buf_t *iter_buf) {
 mp_obj_t mp_obj_list_append(mp_obj_t self_in, mp_obj_t arg) {
     mp_check_self(MP_OBJ_IS_TYPE(self_in, &mp_type_list));
     mp_obj_list_t *self = MP_OBJ_TO_PTR(self_in);
+    MP_THREAD_OBJ_LOCK(self);
     if (self->len >= self->alloc) {
         self->items = m_renew(mp_obj_t, self->items, self->alloc, self->alloc * 2);
         self->alloc *= 2;
         mp_seq_clear(self->items, self->len + 1, self->alloc, sizeof(*self->items));
     }
     self->items[self->len++] = arg;
+    MP_THREAD_OBJ_UNLOCK(self);
     return mp_const_none; // return None, as per CPython
 }
 
@@ -257,6 +268,7 @@ STATIC mp_obj_t list_extend(mp_obj_t self_in, mp_obj_t arg_in) {
         mp_obj_list_t *self = MP_OBJ_TO_PTR(self_in);
         mp_obj_list_t *arg = MP_OBJ_TO_PTR(arg_in);
 
+        MP_THREAD_OBJ_LOCK(self);
         if (self->len + arg->len > self->alloc) {
             // TODO: use alloc policy for "4"
             self->items = m_renew(mp_obj_t, self->items, self->alloc, self->len + arg->len + 4);
@@ -266,6 +278,7 @@ STATIC mp_obj_t list_extend(mp_obj_t self_in, mp_obj_t arg_in) {
 
         memcpy(self->items + self->len, arg->items, sizeof(mp_obj_t) * arg->len);
         self->len += arg->len;
+        MP_THREAD_OBJ_UNLOCK(self);
     } else {
         list_extend_from_iter(self_in, arg_in);
     }
@@ -275,6 +288,7 @@ STATIC mp_obj_t list_extend(mp_obj_t self_in, mp_obj_t arg_in) {
 STATIC mp_obj_t list_pop(size_t n_args, const mp_obj_t *args) {
     mp_check_self(MP_OBJ_IS_TYPE(args[0], &mp_type_list));
     mp_obj_list_t *self = MP_OBJ_TO_PTR(args[0]);
+    MP_THREAD_OBJ_LOCK(self);
     if (self->len == 0) {
         mp_raise_IndexError(translate("pop from empty list"));
     }
@@ -288,9 +302,579 @@ STATIC mp_obj_t list_pop(size_t n_args, const mp_obj_t *args) {
         self->items = m_renew(mp_obj_t, self->items, self->alloc, self->alloc/2);
         self->alloc /= 2;
     }
+    MP_THREAD_OBJ_UNLOCK(self);
     return ret;
 }
 
+#if MICROPY_PY_BUILTINS_STABLE_SORT
+
+// Stable, adaptive merge sort following Tim Peters' listsort.txt.  Natural
+// runs are found (and short ones extended with binary insertion) and then
+// merged, switching to galloping when one run keeps winning.  Elements are
+// either single items or, with a key function, (key, item) pairs so that each
+// key is computed only once.  Keys that are all small ints, all str or all
+// floats are compared directly instead of through mp_binary_op.
+
+#define SORT_MIN_GALLOP (7)
+#define SORT_MAX_RUNS (sizeof(size_t) * 8 * 3 / 2)
+
+typedef enum _sort_cmp_t {
+    SORT_CMP_GENERIC,
+    SORT_CMP_SMALL_INT,
+    SORT_CMP_STR,
+    #if MICROPY_PY_BUILTINS_FLOAT
+    SORT_CMP_FLOAT,
+    #endif
+} sort_cmp_t;
+
+typedef struct _sort_run_t {
+    mp_obj_t *base;
+    size_t len;
+} sort_run_t;
+
+typedef struct _sort_state_t {
+    size_t width; // words per element, 1 for an item or 2 for a (key, item) pair
+    sort_cmp_t cmp;
+    bool reverse;
+    size_t min_gallop;
+    mp_obj_t *tmp;
+    size_t tmp_alloc; // in elements
+    size_t n_runs;
+    sort_run_t runs[SORT_MAX_RUNS];
+} sort_state_t;
+
+STATIC sort_cmp_t sort_select_cmp(const mp_obj_t *keys, size_t n, size_t w) {
+    mp_obj_t first = keys[0];
+    sort_cmp_t cmp;
+    if (MP_OBJ_IS_SMALL_INT(first)) {
+        cmp = SORT_CMP_SMALL_INT;
+    } else if (MP_OBJ_IS_STR(first)) {
+        cmp = SORT_CMP_STR;
+    #if MICROPY_PY_BUILTINS_FLOAT
+    } else if (mp_obj_is_float(first)) {
+        cmp = SORT_CMP_FLOAT;
+    #endif
+    } else {
+        return SORT_CMP_GENERIC;
+    }
+    for (size_t i = 1; i < n; i++) {
+        mp_obj_t k = keys[i * w];
+        bool same;
+        switch (cmp) {
+            case SORT_CMP_SMALL_INT: same = MP_OBJ_IS_SMALL_INT(k); break;
+            case SORT_CMP_STR: same = MP_OBJ_IS_STR(k); break;
+            #if MICROPY_PY_BUILTINS_FLOAT
+            case SORT_CMP_FLOAT: same = mp_obj_is_float(k); break;
+            #endif
+            default: same = false; break;
+        }
+        if (!same) {
+            return SORT_CMP_GENERIC;
+        }
+    }
+    return cmp;
+}
+
+// Returns true if element a sorts strictly before element b.
+STATIC bool sort_lt(const sort_state_t *st, const mp_obj_t *a, const mp_obj_t *b) {
+    mp_obj_t lhs = *a;
+    mp_obj_t rhs = *b;
+    if (st->reverse) {
+        lhs = *b;
+        rhs = *a;
+    }
+    switch (st->cmp) {
+        case SORT_CMP_SMALL_INT:
+            return MP_OBJ_SMALL_INT_VALUE(lhs) < MP_OBJ_SMALL_INT_VALUE(rhs);
+        case SORT_CMP_STR: {
+            GET_STR_DATA_LEN(lhs, lhs_data, lhs_len);
+            GET_STR_DATA_LEN(rhs, rhs_data, rhs_len);
+            return mp_seq_cmp_bytes(MP_BINARY_OP_LESS, lhs_data, lhs_len, rhs_data, rhs_len);
+        }
+        #if MICROPY_PY_BUILTINS_FLOAT
+        case SORT_CMP_FLOAT:
+            return mp_obj_float_get(lhs) < mp_obj_float_get(rhs);
+        #endif
+        default:
+            return mp_obj_is_true(mp_binary_op(MP_BINARY_OP_LESS, lhs, rhs));
+    }
+}
+
+static inline void sort_set(mp_obj_t *dest, const mp_obj_t *src, size_t w) {
+    dest[0] = src[0];
+    if (w == 2) {
+        dest[1] = src[1];
+    }
+}
+
+static inline void sort_move(mp_obj_t *dest, const mp_obj_t *src, size_t n, size_t w) {
+    memmove(dest, src, n * w * sizeof(mp_obj_t));
+}
+
+// Sorts a[0:n] by binary insertion, given that a[0:start] is already sorted.
+STATIC void sort_binary_insertion(const sort_state_t *st, mp_obj_t *a, size_t n, size_t start) {
+    size_t w = st->width;
+    mp_obj_t pivot[2];
+    for (size_t i = start; i < n; i++) {
+        sort_set(pivot, a + i * w, w);
+        // insert after all elements that are equal to pivot, to keep the sort stable
+        size_t lo = 0;
+        size_t hi = i;
+        while (lo < hi) {
+            size_t mid = lo + ((hi - lo) >> 1);
+            if (sort_lt(st, pivot, a + mid * w)) {
+                hi = mid;
+            } else {
+                lo = mid + 1;
+            }
+        }
+        sort_move(a + (lo + 1) * w, a + lo * w, i - lo, w);
+        sort_set(a + lo * w, pivot, w);
+    }
+}
+
+// Returns the length of the run starting at a[0], which is either
+// non-descending or strictly descending; the latter is reversed in place.
+STATIC size_t sort_count_run(const sort_state_t *st, mp_obj_t *a, size_t n) {
+    size_t w = st->width;
+    if (n == 1) {
+        return 1;
+    }
+    size_t len = 2;
+    if (sort_lt(st, a + w, a)) {
+        while (len < n && sort_lt(st, a + len * w, a + (len - 1) * w)) {
+            len++;
+        }
+        mp_obj_t t[2];
+        for (mp_obj_t *lo = a, *hi = a + (len - 1) * w; lo < hi; lo += w, hi -= w) {
+            sort_set(t, lo, w);
+            sort_set(lo, hi, w);
+            sort_set(hi, t, w);
+        }
+    } else {
+        while (len < n && !sort_lt(st, a + len * w, a + (len - 1) * w)) {
+            len++;
+        }
+    }
+    return len;
+}
+
+// Returns the number of elements of the sorted a[0:n] that go before key,
+// starting the search from a[hint].  Elements equal to key count as going
+// before it if right is true, so key is placed after them.
+STATIC size_t sort_gallop(const sort_state_t *st, const mp_obj_t *key, const mp_obj_t *a, size_t n, size_t hint, bool right) {
+    size_t w = st->width;
+    #define BEFORE(i) (right ? !sort_lt(st, key, a + (i) * w) : sort_lt(st, a + (i) * w, key))
+    size_t last = 0;
+    size_t ofs = 1;
+    size_t lo, hi;
+    if (BEFORE(hint)) {
+        // gallop towards the end, keeping a[hint + last] before key
+        size_t max_ofs = n - hint;
+        while (ofs < max_ofs && BEFORE(hint + ofs)) {
+            last = ofs;
+            ofs = (ofs << 1) + 1;
+        }
+        if (ofs > max_ofs) {
+            ofs = max_ofs;
+        }
+        lo = hint + last + 1;
+        hi = hint + ofs;
+    } else {
+        // gallop towards the start, keeping a[hint - last] not before key
+        size_t max_ofs = hint + 1;
+        while (ofs < max_ofs && !BEFORE(hint - ofs)) {
+            last = ofs;
+            ofs = (ofs << 1) + 1;
+        }
+        if (ofs > max_ofs) {
+            ofs = max_ofs;
+        }
+        lo = hint + 1 - ofs;
+        hi = hint - last;
+    }
+    // the answer is in [lo, hi], so binary search for it
+    while (lo < hi) {
+        size_t mid = lo + ((hi - lo) >> 1);
+        if (BEFORE(mid)) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    #undef BEFORE
+    return lo;
+}
+
+STATIC mp_obj_t *sort_get_tmp(sort_state_t *st, size_t n) {
+    if (n > st->tmp_alloc) {
+        m_del(mp_obj_t, st->tmp, st->tmp_alloc * st->width);
+        st->tmp = NULL;
+        st->tmp_alloc = 0;
+        st->tmp = m_new(mp_obj_t, n * st->width);
+        st->tmp_alloc = n;
+    }
+    return st->tmp;
+}
+
+// Merges the adjacent sorted runs a[0:na] and b[0:nb], where na <= nb, the
+// first element of b goes before a[0] and the last element of a goes after
+// b[nb - 1].  Run a is moved out of the way and merged from the left.
+STATIC void sort_merge_lo(sort_state_t *st, mp_obj_t *a, size_t na, mp_obj_t *b, size_t nb) {
+    size_t w = st->width;
+    mp_obj_t *dest = a;
+    mp_obj_t *pa = sort_get_tmp(st, na);
+    mp_obj_t *pb = b;
+    sort_move(pa, a, na, w);
+
+    sort_set(dest, pb, w);
+    dest += w;
+    pb += w;
+    if (--nb == 0) {
+        goto done;
+    }
+    if (na == 1) {
+        goto copy_b;
+    }
+
+    size_t min_gallop = st->min_gallop;
+    for (;;) {
+        size_t acount = 0;
+        size_t bcount = 0;
+
+        // merge one element at a time until one run wins often enough
+        do {
+            if (sort_lt(st, pb, pa)) {
+                sort_set(dest, pb, w);
+                dest += w;
+                pb += w;
+                ++bcount;
+                acount = 0;
+                if (--nb == 0) {
+                    goto done;
+                }
+            } else {
+                sort_set(dest, pa, w);
+                dest += w;
+                pa += w;
+                ++acount;
+                bcount = 0;
+                if (--na == 1) {
+                    goto copy_b;
+                }
+            }
+        } while (acount < min_gallop && bcount < min_gallop);
+
+        // gallop until neither run wins by a big enough margin
+        ++min_gallop;
+        do {
+            min_gallop -= min_gallop > 1;
+            size_t k = sort_gallop(st, pb, pa, na, 0, true);
+            acount = k;
+            if (k != 0) {
+                sort_move(dest, pa, k, w);
+                dest += k * w;
+                pa += k * w;
+                na -= k;
+                if (na == 1) {
+                    goto copy_b;
+                }
+                // na can only be 0 here if the comparison is inconsistent
+                if (na == 0) {
+                    goto done;
+                }
+            }
+            sort_set(dest, pb, w);
+            dest += w;
+            pb += w;
+            if (--nb == 0) {
+                goto done;
+            }
+
+            k = sort_gallop(st, pa, pb, nb, 0, false);
+            bcount = k;
+            if (k != 0) {
+                sort_move(dest, pb, k, w);
+                dest += k * w;
+                pb += k * w;
+                nb -= k;
+                if (nb == 0) {
+                    goto done;
+                }
+            }
+            sort_set(dest, pa, w);
+            dest += w;
+            pa += w;
+            if (--na == 1) {
+                goto copy_b;
+            }
+        } while (acount >= SORT_MIN_GALLOP || bcount >= SORT_MIN_GALLOP);
+        ++min_gallop;
+        st->min_gallop = min_gallop;
+    }
+
+done:
+    sort_move(dest, pa, na, w);
+    return;
+
+copy_b:
+    // the last element of a goes after the rest of b
+    sort_move(dest, pb, nb, w);
+    sort_set(dest + nb * w, pa, w);
+}
+
+// As sort_merge_lo but with na > nb, so run b is moved out of the way and
+// the runs are merged from the right.
+STATIC void sort_merge_hi(sort_state_t *st, mp_obj_t *a, size_t na, mp_obj_t *b, size_t nb) {
+    size_t w = st->width;
+    mp_obj_t *base_b = sort_get_tmp(st, nb);
+    sort_move(base_b, b, nb, w);
+    mp_obj_t *dest = b + (nb - 1) * w;
+    mp_obj_t *pa = a + (na - 1) * w;
+    mp_obj_t *pb = base_b + (nb - 1) * w;
+
+    sort_set(dest, pa, w);
+    dest -= w;
+    pa -= w;
+    if (--na == 0) {
+        goto done;
+    }
+    if (nb == 1) {
+        goto copy_a;
+    }
+
+    size_t min_gallop = st->min_gallop;
+    for (;;) {
+        size_t acount = 0;
+        size_t bcount = 0;
+
+        // merge one element at a time until one run wins often enough
+        do {
+            if (sort_lt(st, pb, pa)) {
+                sort_set(dest, pa, w);
+                dest -= w;
+                pa -= w;
+                ++acount;
+                bcount = 0;
+                if (--na == 0) {
+                    goto done;
+                }
+            } else {
+                sort_set(dest, pb, w);
+                dest -= w;
+                pb -= w;
+                ++bcount;
+                acount = 0;
+                if (--nb == 1) {
+                    goto copy_a;
+                }
+            }
+        } while (acount < min_gallop && bcount < min_gallop);
+
+        // gallop until neither run wins by a big enough margin
+        ++min_gallop;
+        do {
+            min_gallop -= min_gallop > 1;
+            size_t k = na - sort_gallop(st, pb, a, na, na - 1, true);
+            acount = k;
+            if (k != 0) {
+                dest -= k * w;
+                pa -= k * w;
+                sort_move(dest + w, pa + w, k, w);
+                na -= k;
+                if (na == 0) {
+                    goto done;
+                }
+            }
+            sort_set(dest, pb, w);
+            dest -= w;
+            pb -= w;
+            if (--nb == 1) {
+                goto copy_a;
+            }
+
+            k = nb - sort_gallop(st, pa, base_b, nb, nb - 1, false);
+            bcount = k;
+            if (k != 0) {
+                dest -= k * w;
+                pb -= k * w;
+                sort_move(dest + w, pb + w, k, w);
+                nb -= k;
+                if (nb == 1) {
+                    goto copy_a;
+                }
+                // nb can only be 0 here if the comparison is inconsistent
+                if (nb == 0) {
+                    goto done;
+                }
+            }
+            sort_set(dest, pa, w);
+            dest -= w;
+            pa -= w;
+            if (--na == 0) {
+                goto done;
+            }
+        } while (acount >= SORT_MIN_GALLOP || bcount >= SORT_MIN_GALLOP);
+        ++min_gallop;
+        st->min_gallop = min_gallop;
+    }
+
+done:
+    if (nb != 0) {
+        sort_move(dest - (nb - 1) * w, base_b, nb, w);
+    }
+    return;
+
+copy_a:
+    // the first element of b goes before the rest of a
+    dest -= na * w;
+    pa -= na * w;
+    sort_move(dest + w, pa + w, na, w);
+    sort_set(dest, pb, w);
+}
+
+// Merges the runs at index i and i + 1 of the run stack.
+STATIC void sort_merge_at(sort_state_t *st, size_t i) {
+    size_t w = st->width;
+    mp_obj_t *a = st->runs[i].base;
+    size_t na = st->runs[i].len;
+    mp_obj_t *b = st->runs[i + 1].base;
+    size_t nb = st->runs[i + 1].len;
+
+    st->runs[i].len = na + nb;
+    if (i == st->n_runs - 3) {
+        st->runs[i + 1] = st->runs[i + 2];
+    }
+    --st->n_runs;
+
+    // elements of a that go before b[0] are already in place
+    size_t k = sort_gallop(st, b, a, na, 0, true);
+    a += k * w;
+    na -= k;
+    if (na == 0) {
+        return;
+    }
+    // elements of b that go after the last element of a are already in place
+    nb = sort_gallop(st, a + (na - 1) * w, b, nb, nb - 1, false);
+    if (nb == 0) {
+        return;
+    }
+
+    if (na <= nb) {
+        sort_merge_lo(st, a, na, b, nb);
+    } else {
+        sort_merge_hi(st, a, na, b, nb);
+    }
+}
+
+// Merges runs until the lengths on the stack decrease faster than the
+// Fibonacci numbers, which keeps the merges balanced and the stack short.
+STATIC void sort_merge_collapse(sort_state_t *st) {
+    sort_run_t *runs = st->runs;
+    while (st->n_runs > 1) {
+        size_t n = st->n_runs - 2;
+        if ((n > 0 && runs[n - 1].len <= runs[n].len + runs[n + 1].len)
+            || (n > 1 && runs[n - 2].len <= runs[n - 1].len + runs[n].len)) {
+            if (runs[n - 1].len < runs[n + 1].len) {
+                --n;
+            }
+        } else if (runs[n].len > runs[n + 1].len) {
+            break;
+        }
+        sort_merge_at(st, n);
+    }
+}
+
+STATIC void sort_stable(sort_state_t *st, mp_obj_t *items, size_t n) {
+    size_t w = st->width;
+
+    // Runs shorter than minrun are extended by binary insertion.  It is
+    // chosen in [32, 64] so that n / minrun is a power of 2 or a bit less.
+    size_t minrun = n;
+    size_t extra = 0;
+    while (minrun >= 64) {
+        extra |= minrun & 1;
+        minrun >>= 1;
+    }
+    minrun += extra;
+
+    mp_obj_t *lo = items;
+    size_t remaining = n;
+    while (remaining != 0) {
+        size_t len = sort_count_run(st, lo, remaining);
+        if (len < minrun) {
+            size_t force = remaining < minrun ? remaining : minrun;
+            sort_binary_insertion(st, lo, force, len);
+            len = force;
+        }
+        assert(st->n_runs < SORT_MAX_RUNS);
+        st->runs[st->n_runs].base = lo;
+        st->runs[st->n_runs].len = len;
+        ++st->n_runs;
+        sort_merge_collapse(st);
+        lo += len * w;
+        remaining -= len;
+    }
+
+    while (st->n_runs > 1) {
+        size_t i = st->n_runs - 2;
+        if (i > 0 && st->runs[i - 1].len < st->runs[i + 1].len) {
+            --i;
+        }
+        sort_merge_at(st, i);
+    }
+}
+
+STATIC void list_sort_stable(mp_obj_list_t *self, mp_obj_t key_fn, bool reverse) {
+    size_t n = self->len;
+    sort_state_t st;
+    st.reverse = reverse;
+    st.min_gallop = SORT_MIN_GALLOP;
+    st.tmp = NULL;
+    st.tmp_alloc = 0;
+    st.n_runs = 0;
+
+    // Sort a copy of the items, unless comparisons can't call back into
+    // Python code, so an exception or a change to the list can't leave it
+    // half sorted.
+    mp_obj_t *work;
+    if (key_fn != MP_OBJ_NULL) {
+        st.width = 2;
+        work = m_new(mp_obj_t, 2 * n);
+        for (size_t i = 0; i < n; i++) {
+            work[2 * i + 1] = self->items[i];
+        }
+        for (size_t i = 0; i < n; i++) {
+            work[2 * i] = mp_call_function_1(key_fn, work[2 * i + 1]);
+        }
+        st.cmp = sort_select_cmp(work, n, 2);
+    } else {
+        st.width = 1;
+        st.cmp = sort_select_cmp(self->items, n, 1);
+        if (st.cmp == SORT_CMP_GENERIC) {
+            work = m_new(mp_obj_t, n);
+            memcpy(work, self->items, n * sizeof(mp_obj_t));
+        } else {
+            work = self->items;
+        }
+    }
+
+    sort_stable(&st, work, n);
+    m_del(mp_obj_t, st.tmp, st.tmp_alloc * st.width);
+
+    if (work != self->items) {
+        if (self->len != n) {
+            mp_raise_ValueError(translate("list modified during sort"));
+        }
+        for (size_t i = 0; i < n; i++) {
+            self->items[i] = work[i * st.width + st.width - 1];
+        }
+        m_del(mp_obj_t, work, n * st.width);
+    }
+}
+
+#else
+
 STATIC void mp_quicksort(mp_obj_t *head, mp_obj_t *tail, mp_obj_t key_fn, mp_obj_t binop_less_result) {
     MP_STACK_CHECK();
     while (head < tail) {
@@ -319,7 +903,8 @@ STATIC void mp_quicksort(mp_obj_t *head, mp_obj_t *tail, mp_obj_t key_fn, mp_obj
     }
 }
 
-// TODO Python defines sort to be stable but ours is not
+#endif
+
 mp_obj_t mp_obj_list_sort(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_args) {
     static const mp_arg_t allowed_args[] = {
         { MP_QSTR_key, MP_ARG_KW_ONLY | MP_ARG_OBJ, {.u_rom_obj = MP_ROM_PTR(&mp_const_none_obj)} },
@@ -336,11 +921,34 @@ mp_obj_t mp_obj_list_sort(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_
     mp_check_self(MP_OBJ_IS_TYPE(pos_args[0], &mp_type_list));
     mp_obj_list_t *self = MP_OBJ_TO_PTR(pos_args[0]);
 
+    MP_THREAD_OBJ_LOCK(self);
     if (self->len > 1) {
-        mp_quicksort(self->items, self->items + self->len - 1,
+        #if MICROPY_PY_BUILTINS_STABLE_SORT
+        list_sort_stable(self, args.key.u_obj == mp_const_none ? MP_OBJ_NULL : args.key.u_obj,
+                         args.reverse.u_bool);
+        #else
+        // TODO Python defines sort to be stable but ours is not
+        // Another thread can change the list while comparisons run Python
+        // code, so a list that may be shared is sorted as a copy.
+        size_t n = self->len;
+        mp_obj_t *items = self->items;
+        if (MP_THREAD_OBJ_SHARED()) {
+            items = m_new(mp_obj_t, n);
+            memcpy(items, self->items, n * sizeof(mp_obj_t));
+        }
+        mp_quicksort(items, items + n - 1,
                      args.key.u_obj == mp_const_none ? MP_OBJ_NULL : args.key.u_obj,
                      args.reverse.u_bool ? mp_const_false : mp_const_true);
+        if (items != self->items) {
+            if (self->len != n) {
+                mp_raise_ValueError(translate("list modified during sort"));
+            }
+            memcpy(self->items, items, n * sizeof(mp_obj_t));
+            m_del(mp_obj_t, items, n);
+        }
+        #endif
     }
+    MP_THREAD_OBJ_UNLOCK(self);
 
     return mp_const_none;
 }
@@ -348,34 +956,73 @@ mp_obj_t mp_obj_list_sort(size_t n_args, const mp_obj_t *pos_args, mp_map_t *kw_
 mp_obj_t mp_obj_list_clear(mp_obj_t self_in) {
     mp_check_self(MP_OBJ_IS_TYPE(self_in, &mp_type_list));
     mp_obj_list_t *self = MP_OBJ_TO_PTR(self_in);
+    MP_THREAD_OBJ_LOCK(self);
     self->len = 0;
     self->items = m_renew(mp_obj_t, self->items, self->alloc, LIST_MIN_ALLOC);
     self->alloc = LIST_MIN_ALLOC;
     mp_seq_clear(self->items, 0, self->alloc, sizeof(*self->items));
+    MP_THREAD_OBJ_UNLOCK(self);
     return mp_const_none;
 }
 
 STATIC mp_obj_t list_copy(mp_obj_t self_in) {
     mp_check_self(MP_OBJ_IS_TYPE(self_in, &mp_type_list));
     mp_obj_list_t *self = MP_OBJ_TO_PTR(self_in);
-    return mp_obj_new_list(self->len, self->items);
+    MP_THREAD_OBJ_LOCK(self);
+    mp_obj_t copy = mp_obj_new_list(self->len, self->items);
+    MP_THREAD_OBJ_UNLOCK(self);
+    return copy;
 }
 
 STATIC mp_obj_t list_count(mp_obj_t self_in, mp_obj_t value) {
     mp_check_self(MP_OBJ_IS_TYPE(self_in, &mp_type_list));
     mp_obj_list_t *self = MP_OBJ_TO_PTR(self_in);
-    return mp_seq_count_obj(self->items, self->len, value);
+    MP_THREAD_OBJ_LOCK(self);
+    // comparing can run Python code which changes the list, so its items
+    // and length are read again for each element
+    size_t count = 0;
+    for (size_t i = 0; i < self->len; i++) {
+        if (mp_obj_equal(self->items[i], value)) {
+            count++;
+        }
+    }
+    MP_THREAD_OBJ_UNLOCK(self);
+    // Common sense says this cannot overflow small int
+    return MP_OBJ_NEW_SMALL_INT(count);
 }
 
 STATIC mp_obj_t list_index(size_t n_args, const mp_obj_t *args) {
     mp_check_self(MP_OBJ_IS_TYPE(args[0], &mp_type_list));
     mp_obj_list_t *self = MP_OBJ_TO_PTR(args[0]);
-    return mp_seq_index_obj(self->items, self->len, n_args, args);
+    MP_THREAD_OBJ_LOCK(self);
+    size_t start = 0;
+    size_t stop = self->len;
+    if (n_args >= 3) {
+        start = mp_get_index(self->base.type, self->len, args[2], true);
+        if (n_args >= 4) {
+            stop = mp_get_index(self->base.type, self->len, args[3], true);
+        }
+    }
+    // as in list_count, the list can change while it's searched
+    mp_obj_t index = MP_OBJ_NULL;
+    for (size_t i = start; i < stop && i < self->len; i++) {
+        if (mp_obj_equal(self->items[i], args[1])) {
+            // Common sense says this cannot overflow small int
+            index = MP_OBJ_NEW_SMALL_INT(i);
+            break;
+        }
+    }
+    if (index == MP_OBJ_NULL) {
+        mp_raise_ValueError(translate("object not in sequence"));
+    }
+    MP_THREAD_OBJ_UNLOCK(self);
+    return index;
 }
 
 STATIC mp_obj_t list_insert(mp_obj_t self_in, mp_obj_t idx, mp_obj_t obj) {
     mp_check_self(MP_OBJ_IS_TYPE(self_in, &mp_type_list));
     mp_obj_list_t *self = MP_OBJ_TO_PTR(self_in);
+    MP_THREAD_OBJ_LOCK(self);
     // insert has its own strange index logic
     mp_int_t index = MP_OBJ_SMALL_INT_VALUE(idx);
     if (index < 0) {
@@ -394,6 +1041,7 @@ STATIC mp_obj_t list_insert(mp_obj_t self_in, mp_obj_t idx, mp_obj_t obj) {
          self->items[i] = self->items[i-1];
     }
     self->items[index] = obj;
+    MP_THREAD_OBJ_UNLOCK(self);
 
     return mp_const_none;
 }
@@ -401,8 +1049,11 @@ STATIC mp_obj_t list_insert(mp_obj_t self_in, mp_obj_t idx, mp_obj_t obj) {
 mp_obj_t mp_obj_list_remove(mp_obj_t self_in, mp_obj_t value) {
     mp_check_self(MP_OBJ_IS_TYPE(self_in, &mp_type_list));
     mp_obj_t args[] = {self_in, value};
+    // hold the lock so that the item found is the one popped
+    MP_THREAD_OBJ_LOCK(MP_OBJ_TO_PTR(self_in));
     args[1] = list_index(2, args);
     list_pop(2, args);
+    MP_THREAD_OBJ_UNLOCK(MP_OBJ_TO_PTR(self_in));
 
     return mp_const_none;
 }
@@ -411,12 +1062,14 @@ STATIC mp_obj_t list_reverse(mp_obj_t self_in) {
     mp_check_self(MP_OBJ_IS_TYPE(self_in, &mp_type_list));
     mp_obj_list_t *self = MP_OBJ_TO_PTR(self_in);
 
+    MP_THREAD_OBJ_LOCK(self);
     mp_int_t len = self->len;
     for (mp_int_t i = 0; i < len/2; i++) {
          mp_obj_t a = self->items[i];
          self->items[i] = self->items[len-i-1];
          self->items[len-i-1] = a;
     }
+    MP_THREAD_OBJ_UNLOCK(self);
 
     return mp_const_none;
 }
@@ -517,13 +1170,14 @@ typedef struct _mp_obj_list_it_t {
 STATIC mp_obj_t list_it_iternext(mp_obj_t self_in) {
     mp_obj_list_it_t *self = MP_OBJ_TO_PTR(self_in);
     mp_obj_list_t *list = MP_OBJ_TO_PTR(self->list);
+    mp_obj_t o_out = MP_OBJ_STOP_ITERATION;
+    MP_THREAD_OBJ_LOCK(list);
     if (self->cur < list->len) {
-        mp_obj_t o_out = list->items[self->cur];
+        o_out = list->items[self->cur];
         self->cur += 1;
-        return o_out;
-    } else {
-        return MP_OBJ_STOP_ITERATION;
     }
+    MP_THREAD_OBJ_UNLOCK(list);
+    return o_out;
 }
 
 mp_obj_t mp_obj_new_list_iterator(mp_obj_t list, size_t cur, mp_obj_iter_buf_t *iter_buf) {
@@ -119,7 +119,8 @@ STATIC mp_obj_t set_make_new(const mp_obj_type_t *type, size_t n_args, const mp_
         default: { // can only be 0 or 1 arg
             // 1 argument, an iterable from which we make a new set
             mp_obj_t set = mp_obj_new_set(0, NULL);
-            mp_obj_t iterable = mp_getiter(args[0], NULL);
+            mp_obj_iter_buf_t iter_buf;
+            mp_obj_t iterable = mp_getiter(args[0], &iter_buf);
             mp_obj_t item;
             while ((item = mp_iternext(iterable)) != MP_OBJ_STOP_ITERATION) {
                 mp_obj_set_store(set, item);
@@ -133,17 +134,21 @@ STATIC mp_obj_t set_make_new(const mp_obj_type_t *type, size_t n_args, const mp_
 
 STATIC mp_obj_t set_it_iternext(mp_obj_t self_in) {
     mp_obj_set_it_t *self = MP_OBJ_TO_PTR(self_in);
+    MP_THREAD_OBJ_LOCK(self->set);
     size_t max = self->set->set.alloc;
     mp_set_t *set = &self->set->set;
+    mp_obj_t next = MP_OBJ_STOP_ITERATION;
 
     for (size_t i = self->cur; i < max; i++) {
         if (MP_SET_SLOT_IS_FILLED(set, i)) {
             self->cur = i + 1;
-            return set->table[i];
+            next = set->table[i];
+            break;
         }
     }
 
-    return MP_OBJ_STOP_ITERATION;
+    MP_THREAD_OBJ_UNLOCK(self->set);
+    return next;
 }
 
 STATIC mp_obj_t set_getiter(mp_obj_t set_in, mp_obj_iter_buf_t *iter_buf) {
@@ -163,7 +168,9 @@ STATIC mp_obj_t set_getiter(mp_obj_t set_in, mp_obj_iter_buf_t *iter_buf) {
 STATIC mp_obj_t set_add(mp_obj_t self_in, mp_obj_t item) {
     check_set(self_in);
     mp_obj_set_t *self = MP_OBJ_TO_PTR(self_in);
+    MP_THREAD_OBJ_LOCK(self);
     mp_set_lookup(&self->set, item, MP_MAP_LOOKUP_ADD_IF_NOT_FOUND);
+    MP_THREAD_OBJ_UNLOCK(self);
     return mp_const_none;
 }
 STATIC MP_DEFINE_CONST_FUN_OBJ_2(set_add_obj, set_add);
@@ -172,7 +179,9 @@ STATIC mp_obj_t set_clear(mp_obj_t self_in) {
     check_set(self_in);
     mp_obj_set_t *self = MP_OBJ_TO_PTR(self_in);
 
+    MP_THREAD_OBJ_LOCK(self);
     mp_set_clear(&self->set);
+    MP_THREAD_OBJ_UNLOCK(self);
 
     return mp_const_none;
 }
@@ -183,9 +192,13 @@ STATIC mp_obj_t set_copy(mp_obj_t self_in) {
     mp_obj_set_t *self = MP_OBJ_TO_PTR(self_in);
     mp_obj_set_t *other = m_new_obj(mp_obj_set_t);
     other->base.type = self->base.type;
-    mp_set_init(&other->set, self->set.alloc);
+    MP_THREAD_OBJ_LOCK(self);
+    // copy the table as is, with the same size so that the hashes still apply
+    other->set.alloc = self->set.alloc;
     other->set.used = self->set.used;
+    other->set.table = m_new(mp_obj_t, other->set.alloc);
     memcpy(other->set.table, self->set.table, self->set.alloc * sizeof(mp_obj_t));
+    MP_THREAD_OBJ_UNLOCK(self);
     return MP_OBJ_FROM_PTR(other);
 }
 STATIC MP_DEFINE_CONST_FUN_OBJ_1(set_copy_obj, set_copy);
@@ -193,7 +206,9 @@ STATIC MP_DEFINE_CONST_FUN_OBJ_1(set_copy_obj, set_copy);
 STATIC mp_obj_t set_discard(mp_obj_t self_in, mp_obj_t item) {
     check_set(self_in);
     mp_obj_set_t *self = MP_OBJ_TO_PTR(self_in);
+    MP_THREAD_OBJ_LOCK(self);
     mp_set_lookup(&self->set, item, MP_MAP_LOOKUP_REMOVE_IF_FOUND);
+    MP_THREAD_OBJ_UNLOCK(self);
     return mp_const_none;
 }
 STATIC MP_DEFINE_CONST_FUN_OBJ_2(set_discard_obj, set_discard);
@@ -213,7 +228,8 @@ STATIC mp_obj_t set_diff_int(size_t n_args, const mp_obj_t *args, bool update) {
             set_clear(self);
         } else {
             mp_set_t *self_set = &((mp_obj_set_t*)MP_OBJ_TO_PTR(self))->set;
-            mp_obj_t iter = mp_getiter(other, NULL);
+            mp_obj_iter_buf_t iter_buf;
+            mp_obj_t iter = mp_getiter(other, &iter_buf);
             mp_obj_t next;
             while ((next = mp_iternext(iter)) != MP_OBJ_STOP_ITERATION) {
                 mp_set_lookup(self_set, next, MP_MAP_LOOKUP_REMOVE_IF_FOUND);
@@ -249,7 +265,8 @@ STATIC mp_obj_t set_intersect_int(mp_obj_t self_in, mp_obj_t other, bool update)
     mp_obj_set_t *self = MP_OBJ_TO_PTR(self_in);
     mp_obj_set_t *out = MP_OBJ_TO_PTR(mp_obj_new_set(0, NULL));
 
-    mp_obj_t iter = mp_getiter(other, NULL);
+    mp_obj_iter_buf_t iter_buf;
+    mp_obj_t iter = mp_getiter(other, &iter_buf);
     mp_obj_t next;
     while ((next = mp_iternext(iter)) != MP_OBJ_STOP_ITERATION) {
         if (mp_set_lookup(&self->set, next, MP_MAP_LOOKUP)) {
@@ -366,7 +383,9 @@ STATIC mp_obj_t set_equal(mp_obj_t self_in, mp_obj_t other_in) {
 STATIC mp_obj_t set_pop(mp_obj_t self_in) {
     check_set(self_in);
     mp_obj_set_t *self = MP_OBJ_TO_PTR(self_in);
+    MP_THREAD_OBJ_LOCK(self);
     mp_obj_t obj = mp_set_remove_first(&self->set);
+    MP_THREAD_OBJ_UNLOCK(self);
     if (obj == MP_OBJ_NULL) {
         mp_raise_msg(&mp_type_KeyError, translate("pop from an empty set"));
     }
@@ -377,7 +396,10 @@ STATIC MP_DEFINE_CONST_FUN_OBJ_1(set_pop_obj, set_pop);
 STATIC mp_obj_t set_remove(mp_obj_t self_in, mp_obj_t item) {
     check_set(self_in);
     mp_obj_set_t *self = MP_OBJ_TO_PTR(self_in);
-    if (mp_set_lookup(&self->set, item, MP_MAP_LOOKUP_REMOVE_IF_FOUND) == MP_OBJ_NULL) {
+    MP_THREAD_OBJ_LOCK(self);
+    mp_obj_t removed = mp_set_lookup(&self->set, item, MP_MAP_LOOKUP_REMOVE_IF_FOUND);
+    MP_THREAD_OBJ_UNLOCK(self);
+    if (removed == MP_OBJ_NULL) {
         nlr_raise(mp_obj_new_exception_arg1(&mp_type_KeyError, item));
     }
     return mp_const_none;
@@ -387,7 +409,8 @@ STATIC MP_DEFINE_CONST_FUN_OBJ_2(set_remove_obj, set_remove);
 STATIC mp_obj_t set_symmetric_difference_update(mp_obj_t self_in, mp_obj_t other_in) {
     check_set_or_frozenset(self_in); // can be frozenset due to call from set_symmetric_difference
     mp_obj_set_t *self = MP_OBJ_TO_PTR(self_in);
-    mp_obj_t iter = mp_getiter(other_in, NULL);
+    mp_obj_iter_buf_t iter_buf;
+    mp_obj_t iter = mp_getiter(other_in, &iter_buf);
     mp_obj_t next;
     while ((next = mp_iternext(iter)) != MP_OBJ_STOP_ITERATION) {
         mp_set_lookup(&self->set, next, MP_MAP_LOOKUP_ADD_IF_NOT_FOUND_OR_REMOVE_IF_FOUND);
@@ -404,7 +427,8 @@ STATIC mp_obj_t set_symmetric_difference(mp_obj_t self_in, mp_obj_t other_in) {
 STATIC MP_DEFINE_CONST_FUN_OBJ_2(set_symmetric_difference_obj, set_symmetric_difference);
 
 STATIC void set_update_int(mp_obj_set_t *self, mp_obj_t other_in) {
-    mp_obj_t iter = mp_getiter(other_in, NULL);
+    mp_obj_iter_buf_t iter_buf;
+    mp_obj_t iter = mp_getiter(other_in, &iter_buf);
     mp_obj_t next;
     while ((next = mp_iternext(iter)) != MP_OBJ_STOP_ITERATION) {
         mp_set_lookup(&self->set, next, MP_MAP_LOOKUP_ADD_IF_NOT_FOUND);
@@ -509,7 +533,9 @@ STATIC mp_obj_t set_binary_op(mp_binary_op_t op, mp_obj_t lhs, mp_obj_t rhs) {
             return set_issuperset(lhs, rhs);
         case MP_BINARY_OP_CONTAINS: {
             mp_obj_set_t *o = MP_OBJ_TO_PTR(lhs);
+            MP_THREAD_OBJ_LOCK(o);
             mp_obj_t elem = mp_set_lookup(&o->set, rhs, MP_MAP_LOOKUP);
+            MP_THREAD_OBJ_UNLOCK(o);
             return mp_obj_new_bool(elem != MP_OBJ_NULL);
         }
         default:
@@ -594,7 +620,9 @@ mp_obj_t mp_obj_new_set(size_t n_args, mp_obj_t *items) {
 void mp_obj_set_store(mp_obj_t self_in, mp_obj_t item) {
     mp_check_self(MP_OBJ_IS_TYPE(self_in, &mp_type_set));
     mp_obj_set_t *self = MP_OBJ_TO_PTR(self_in);
+    MP_THREAD_OBJ_LOCK(self);
     mp_set_lookup(&self->set, item, MP_MAP_LOOKUP_ADD_IF_NOT_FOUND);
+    MP_THREAD_OBJ_UNLOCK(self);
 }
 
 #endif // MICROPY_PY_BUILTINS_SET
@@ -740,12 +740,7 @@ STATIC mp_obj_t str_finder(size_t n_args, const mp_obj_t *args, int direction, b
         }
     } else {
         // found
-        #if MICROPY_PY_BUILTINS_STR_UNICODE
-        if (self_type == &mp_type_str) {
-            return MP_OBJ_NEW_SMALL_INT(utf8_ptr_to_index(haystack, p));
-        }
-        #endif
-        return MP_OBJ_NEW_SMALL_INT(p - haystack);
+        return MP_OBJ_NEW_SMALL_INT(str_offset_to_index(self_type, haystack, haystack_len, p - haystack));
     }
 }
 
@@ -1120,6 +1115,11 @@ STATIC vstr_t mp_obj_str_format_helper(const char *str, const char *top, int *ar
                 assert(conversion == 'r');
                 print_kind = PRINT_REPR;
             }
+            if (!format_spec) {
+                // nothing to pad or truncate, so print the arg straight out
+                mp_obj_print_helper(&print, arg, print_kind);
+                continue;
+            }
             vstr_t arg_vstr;
             mp_print_t arg_print;
             vstr_init_print(&arg_vstr, 16, &arg_print);
@@ -1145,11 +1145,19 @@ STATIC vstr_t mp_obj_str_format_helper(const char *str, const char *top, int *ar
             // precision   ::=  integer
             // type        ::=  "b" | "c" | "d" | "e" | "E" | "f" | "F" | "g" | "G" | "n" | "o" | "s" | "x" | "X" | "%"
 
-            // recursively call the formatter to format any nested specifiers
-            MP_STACK_CHECK();
-            vstr_t format_spec_vstr = mp_obj_str_format_helper(format_spec, str, arg_i, n_args, args, kwargs);
-            const char *s = vstr_null_terminated_str(&format_spec_vstr);
-            const char *stop = s + format_spec_vstr.len;
+            // a specifier without nested ones is parsed where it is, and ends
+            // at the closing '}'
+            const char *s = format_spec;
+            const char *stop = str;
+            vstr_t format_spec_vstr;
+            bool nested = memchr(format_spec, '{', str - format_spec) != NULL;
+            if (nested) {
+                // recursively call the formatter to format any nested specifiers
+                MP_STACK_CHECK();
+                format_spec_vstr = mp_obj_str_format_helper(format_spec, str, arg_i, n_args, args, kwargs);
+                s = vstr_null_terminated_str(&format_spec_vstr);
+                stop = s + format_spec_vstr.len;
+            }
             if (isalignment(*s)) {
                 align = *s++;
             } else if (*s && isalignment(s[1])) {
@@ -1188,14 +1196,16 @@ STATIC vstr_t mp_obj_str_format_helper(const char *str, const char *top, int *ar
             if (istype(*s)) {
                 type = *s++;
             }
-            if (*s) {
+            if (s < stop) {
                 if (MICROPY_ERROR_REPORTING == MICROPY_ERROR_REPORTING_TERSE) {
                     terse_str_format_value_error();
                 } else {
                     mp_raise_ValueError(translate("invalid format specifier"));
                 }
             }
-            vstr_clear(&format_spec_vstr);
+            if (nested) {
+                vstr_clear(&format_spec_vstr);
+            }
         }
         if (!align) {
             if (arg_looks_numeric(arg)) {
@@ -1559,15 +1569,20 @@ not_enough_args:
             case 'r':
             case 's':
             {
-                vstr_t arg_vstr;
-                mp_print_t arg_print;
-                vstr_init_print(&arg_vstr, 16, &arg_print);
                 mp_print_kind_t print_kind = (*str == 'r' ? PRINT_REPR : PRINT_STR);
                 if (print_kind == PRINT_STR && is_bytes && MP_OBJ_IS_TYPE(arg, &mp_type_bytes)) {
                     // If we have something like b"%s" % b"1", bytes arg should be
                     // printed undecorated.
                     print_kind = PRINT_RAW;
                 }
+                if (prec < 0 && width <= 0) {
+                    // nothing to pad or truncate, so print the arg straight out
+                    mp_obj_print_helper(&print, arg, print_kind);
+                    break;
+                }
+                vstr_t arg_vstr;
+                mp_print_t arg_print;
+                vstr_init_print(&arg_vstr, 16, &arg_print);
                 mp_obj_print_helper(&arg_print, arg, print_kind);
                 uint vlen = arg_vstr.len;
                 if (prec < 0) {
@@ -2043,6 +2058,19 @@ mp_obj_t mp_obj_new_str_of_type(const mp_obj_type_t *type, const byte* data, siz
 
 // Create a str using a qstr to store the data; may use existing or new qstr.
 mp_obj_t mp_obj_new_str_via_qstr(const char* data, size_t len) {
+    #if MICROPY_OPT_STR_CHAR_CACHE
+    if (len == 1 && (byte)data[0] < 128) {
+        uint16_t *cached = &MP_STATE_VM(str_char_cache)[(byte)data[0]];
+        if (*cached == MP_QSTR_NULL) {
+            qstr q = qstr_from_strn(data, 1);
+            if (q > 0xffff) {
+                return MP_OBJ_NEW_QSTR(q);
+            }
+            *cached = q;
+        }
+        return MP_OBJ_NEW_QSTR(*cached);
+    }
+    #endif
     return MP_OBJ_NEW_QSTR(qstr_from_strn(data, len));
 }
 
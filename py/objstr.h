@@ -71,6 +71,10 @@ mp_obj_t mp_obj_new_str_of_type(const mp_obj_type_t *type, const byte* data, siz
 mp_obj_t mp_obj_str_binary_op(mp_binary_op_t op, mp_obj_t lhs_in, mp_obj_t rhs_in);
 mp_int_t mp_obj_str_get_buffer(mp_obj_t self_in, mp_buffer_info_t *bufinfo, mp_uint_t flags);
 
+#if MICROPY_OPT_STR_UNICODE_INDEX
+// clears the str index cache of the current thread
+void mp_str_index_cache_init(void);
+#endif
 size_t str_offset_to_index(const mp_obj_type_t *type, const byte *self_data, size_t self_len,
                            size_t offset);
 const byte *str_index_to_ptr(const mp_obj_type_t *type, const byte *self_data, size_t self_len,
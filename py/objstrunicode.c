@@ -100,12 +100,107 @@ STATIC void uni_print(const mp_print_t *print, mp_obj_t self_in, mp_print_kind_t
     }
 }
 
+#if MICROPY_OPT_STR_UNICODE_INDEX
+
+// Strs shorter than this many bytes are cheap enough to walk and aren't cached.
+#define STR_INDEX_MIN_LEN (64)
+
+// A checkpoint is recorded every this many code points, so at most
+// STR_INDEX_STRIDE - 1 code points are walked to find an index.
+#define STR_INDEX_STRIDE (32)
+
+void mp_str_index_cache_init(void) {
+    memset(MP_STATE_THREAD(str_index_cache), 0, sizeof(MP_STATE_THREAD(str_index_cache)));
+    MP_STATE_THREAD(str_index_cache_next) = 0;
+}
+
+// Returns the cached index of the given str data, or NULL if there is none.
+STATIC const mp_str_index_cache_entry_t *str_index_lookup(const byte *data, size_t len) {
+    mp_str_index_cache_entry_t *cache = MP_STATE_THREAD(str_index_cache);
+    for (size_t i = 0; i < MICROPY_OPT_STR_UNICODE_INDEX_CACHE_SIZE; ++i) {
+        if (cache[i].data == data && cache[i].len == len) {
+            return &cache[i];
+        }
+    }
+    return NULL;
+}
+
+// Returns the index of the given str data, building it (and evicting the
+// oldest entry) if it's not cached.  Returns NULL if the str is too short to
+// be worth indexing, or there is no memory for its checkpoint table.
+STATIC const mp_str_index_cache_entry_t *str_index_get(const byte *data, size_t len) {
+    if (len < STR_INDEX_MIN_LEN) {
+        return NULL;
+    }
+    const mp_str_index_cache_entry_t *entry = str_index_lookup(data, len);
+    if (entry != NULL) {
+        return entry;
+    }
+
+    size_t char_len = utf8_charlen(data, len);
+    size_t *checkpoints = NULL;
+    if (char_len != len) {
+        checkpoints = m_new_maybe(size_t, char_len / STR_INDEX_STRIDE + 1);
+        if (checkpoints == NULL) {
+            return NULL;
+        }
+        size_t n = 0, k = 0;
+        for (size_t i = 0; i < len; ++i) {
+            if (!UTF8_IS_CONT(data[i])) {
+                if (k == 0) {
+                    checkpoints[n++] = i;
+                    k = STR_INDEX_STRIDE;
+                }
+                --k;
+            }
+        }
+    }
+
+    size_t slot = MP_STATE_THREAD(str_index_cache_next);
+    MP_STATE_THREAD(str_index_cache_next) = (slot + 1) % MICROPY_OPT_STR_UNICODE_INDEX_CACHE_SIZE;
+    mp_str_index_cache_entry_t *e = &MP_STATE_THREAD(str_index_cache)[slot];
+    if (e->checkpoints != NULL) {
+        // only this cache refers to the table
+        m_del(size_t, e->checkpoints, e->char_len / STR_INDEX_STRIDE + 1);
+    }
+    e->data = data;
+    e->len = len;
+    e->char_len = char_len;
+    e->checkpoints = checkpoints;
+    return e;
+}
+
+// Returns a pointer to the lead byte of code point i, where 0 <= i < char_len.
+STATIC const byte *str_index_ptr(const mp_str_index_cache_entry_t *e, size_t i) {
+    if (e->checkpoints == NULL) {
+        return e->data + i;
+    }
+    const byte *s = e->data + e->checkpoints[i / STR_INDEX_STRIDE];
+    for (i %= STR_INDEX_STRIDE; i > 0; --i) {
+        ++s;
+        while (UTF8_IS_CONT(*s)) {
+            ++s;
+        }
+    }
+    return s;
+}
+
+#endif // MICROPY_OPT_STR_UNICODE_INDEX
+
 STATIC mp_obj_t uni_unary_op(mp_unary_op_t op, mp_obj_t self_in) {
     GET_STR_DATA_LEN(self_in, str_data, str_len);
     switch (op) {
         case MP_UNARY_OP_BOOL:
             return mp_obj_new_bool(str_len != 0);
         case MP_UNARY_OP_LEN:
+            #if MICROPY_OPT_STR_UNICODE_INDEX
+            if (str_len >= STR_INDEX_MIN_LEN) {
+                const mp_str_index_cache_entry_t *e = str_index_lookup(str_data, str_len);
+                if (e != NULL) {
+                    return MP_OBJ_NEW_SMALL_INT(e->char_len);
+                }
+            }
+            #endif
             return MP_OBJ_NEW_SMALL_INT(utf8_charlen(str_data, str_len));
         default:
             return MP_OBJ_NULL; // op not supported
@@ -122,6 +217,32 @@ size_t str_offset_to_index(const mp_obj_type_t *type, const byte *self_data, siz
         return offset;
     }
 
+    #if MICROPY_OPT_STR_UNICODE_INDEX
+    const mp_str_index_cache_entry_t *e;
+    if (offset >= STR_INDEX_STRIDE && (e = str_index_get(self_data, self_len)) != NULL) {
+        if (e->checkpoints == NULL) {
+            return offset;
+        }
+        // binary search for the last checkpoint at or before offset
+        size_t lo = 0, hi = e->char_len / STR_INDEX_STRIDE + 1;
+        while (hi - lo > 1) {
+            size_t mid = (lo + hi) / 2;
+            if (e->checkpoints[mid] <= offset) {
+                lo = mid;
+            } else {
+                hi = mid;
+            }
+        }
+        size_t index_val = lo * STR_INDEX_STRIDE;
+        for (const byte *s = self_data + e->checkpoints[lo], *top = self_data + offset; s < top; s++) {
+            if (!UTF8_IS_CONT(*s)) {
+                ++index_val;
+            }
+        }
+        return index_val;
+    }
+    #endif
+
     size_t index_val = 0;
     const byte *s = self_data;
     for (size_t i = 0; i < offset; i++, s++) {
@@ -154,6 +275,29 @@ const byte *str_index_to_ptr(const mp_obj_type_t *type, const byte *self_data, s
         mp_raise_TypeError_varg(translate("string indices must be integers, not %s"), mp_obj_get_type_str(index));
     }
     const byte *s, *top = self_data + self_len;
+    #if MICROPY_OPT_STR_UNICODE_INDEX
+    // Indices near either end are found quickly by walking, others by using
+    // the index of the str.
+    const mp_str_index_cache_entry_t *e;
+    if ((i >= STR_INDEX_STRIDE || i < -STR_INDEX_STRIDE)
+        && (e = str_index_get(self_data, self_len)) != NULL) {
+        if (i < 0) {
+            i += e->char_len;
+            if (i < 0) {
+                if (is_slice) {
+                    return self_data;
+                }
+                mp_raise_IndexError(translate("string index out of range"));
+            }
+        } else if ((size_t)i >= e->char_len) {
+            if (is_slice) {
+                return top;
+            }
+            mp_raise_IndexError(translate("string index out of range"));
+        }
+        return str_index_ptr(e, i);
+    }
+    #endif
     if (i < 0)
     {
         // Negative indexing is performed by counting from the end of the string.
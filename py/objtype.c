@@ -47,9 +47,6 @@
 #define ENABLE_SPECIAL_ACCESSORS \
     (MICROPY_PY_DESCRIPTORS  || MICROPY_PY_DELATTR_SETATTR || MICROPY_PY_BUILTINS_PROPERTY)
 
-#define TYPE_FLAG_IS_SUBCLASSED (0x0001)
-#define TYPE_FLAG_HAS_SPECIAL_ACCESSORS (0x0002)
-
 STATIC mp_obj_t static_class_method_make_new(const mp_obj_type_t *self_in, size_t n_args, const mp_obj_t *args, mp_map_t *kw_args);
 
 /******************************************************************************/
@@ -105,9 +102,19 @@ STATIC
 mp_obj_instance_t *mp_obj_new_instance(const mp_obj_type_t *class, const mp_obj_type_t **native_base) {
     size_t num_native_bases = instance_count_native_bases(class, native_base);
     assert(num_native_bases < 2);
-    mp_obj_instance_t *o = m_new_obj_var(mp_obj_instance_t, mp_obj_t, num_native_bases);
+    size_t num_subobj = num_native_bases;
+    #if MICROPY_PY_CLASS_SLOTS
+    // Slots follow the native base-class slot and start out unset.
+    if (TYPE_SLOT_END(class) > num_subobj) {
+        num_subobj = TYPE_SLOT_END(class);
+    }
+    #endif
+    mp_obj_instance_t *o = m_new_obj_var(mp_obj_instance_t, mp_obj_t, num_subobj);
     o->base.type = class;
     mp_map_init(&o->members, 0);
+    for (size_t i = num_native_bases; i < num_subobj; i++) {
+        o->subobj[i] = MP_OBJ_NULL;
+    }
     // Initialise the native base-class slot (should be 1 at most) with a valid
     // object.  It doesn't matter which object, so long as it can be uniquely
     // distinguished from a native class that is initialised.
@@ -117,6 +124,35 @@ mp_obj_instance_t *mp_obj_new_instance(const mp_obj_type_t *class, const mp_obj_
     return o;
 }
 
+#if MICROPY_PY_CLASS_SLOTS
+STATIC void member_descriptor_print(const mp_print_t *print, mp_obj_t self_in, mp_print_kind_t kind) {
+    (void)kind;
+    mp_obj_member_descriptor_t *self = MP_OBJ_TO_PTR(self_in);
+    mp_printf(print, "<member '%q' of '%q' objects>", self->name, self->owner->name);
+}
+
+const mp_obj_type_t mp_type_member_descriptor = {
+    { &mp_type_type },
+    .name = MP_QSTR_member_descriptor,
+    .print = member_descriptor_print,
+};
+
+// Returns the storage of the slot described by member in the given instance,
+// or NULL if member is not a member descriptor of the instance's class.
+STATIC mp_obj_t *instance_get_slot(mp_obj_instance_t *self, mp_obj_t member) {
+    if (!MP_OBJ_IS_TYPE(member, &mp_type_member_descriptor)) {
+        return NULL;
+    }
+    mp_obj_member_descriptor_t *desc = MP_OBJ_TO_PTR(member);
+    if (desc->owner != self->base.type
+        && !mp_obj_is_subclass_fast(MP_OBJ_FROM_PTR(self->base.type), MP_OBJ_FROM_PTR(desc->owner))) {
+        // descriptor was copied into an unrelated class, treat it as a plain value
+        return NULL;
+    }
+    return &self->subobj[desc->index];
+}
+#endif
+
 // When instances are first created they have the base_init wrapper as their native parent's
 // instance because make_new combines __new__ and __init__. This object is invalid for the native
 // code so it must call this method to ensure that the given object has been __init__'d and is
@@ -147,8 +183,36 @@ struct class_lookup_data {
     size_t meth_offset;
     mp_obj_t *dest;
     bool is_type;
+    #if MICROPY_OPT_CLASS_LOOKUP_CACHE
+    // filled in by mp_obj_class_lookup for use by the class lookup cache
+    bool saw_native_base;
+    const mp_obj_type_t *found_in;
+    mp_obj_t found_value;
+    #endif
 };
 
+// Converts value found in the locals_dict of type to the result of the lookup.
+STATIC void mp_obj_class_lookup_found(struct class_lookup_data *lookup, const mp_obj_type_t *type, mp_obj_t value) {
+    if (lookup->is_type) {
+        // If we look up a class method, we need to return original type for which we
+        // do a lookup, not a (base) type in which we found the class method.
+        const mp_obj_type_t *org_type = (const mp_obj_type_t*)lookup->obj;
+        mp_convert_member_lookup(MP_OBJ_NULL, org_type, value, lookup->dest);
+    } else if (MP_OBJ_IS_TYPE(value, &mp_type_property)) {
+        lookup->dest[0] = value;
+    } else {
+        mp_obj_instance_t *obj = lookup->obj;
+        mp_obj_t obj_obj;
+        if (obj != NULL && mp_obj_is_native_type(type) && type != &mp_type_object /* object is not a real type */) {
+            // If we're dealing with native base class, then it applies to native sub-object
+            obj_obj = obj->subobj[0];
+        } else {
+            obj_obj = MP_OBJ_FROM_PTR(obj);
+        }
+        mp_convert_member_lookup(obj_obj, type, value, lookup->dest);
+    }
+}
+
 STATIC void mp_obj_class_lookup(struct class_lookup_data  *lookup, const mp_obj_type_t *type) {
     assert(lookup->dest[0] == MP_OBJ_NULL);
     assert(lookup->dest[1] == MP_OBJ_NULL);
@@ -158,6 +222,12 @@ STATIC void mp_obj_class_lookup(struct class_lookup_data  *lookup, const mp_obj_
         // This avoids extra method_name => slot lookup. On the other hand,
         // this should not be applied to class types, as will result in extra
         // lookup either.
+        #if MICROPY_OPT_CLASS_LOOKUP_CACHE
+        if (mp_obj_is_native_type(type) && type != &mp_type_object) {
+            lookup->saw_native_base = true;
+        }
+        #endif
+
         if (lookup->meth_offset != 0 && mp_obj_is_native_type(type)) {
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wcast-align"
@@ -176,25 +246,11 @@ STATIC void mp_obj_class_lookup(struct class_lookup_data  *lookup, const mp_obj_
             mp_map_t *locals_map = &type->locals_dict->map;
             mp_map_elem_t *elem = mp_map_lookup(locals_map, MP_OBJ_NEW_QSTR(lookup->attr), MP_MAP_LOOKUP);
             if (elem != NULL) {
-                if (lookup->is_type) {
-                    // If we look up a class method, we need to return original type for which we
-                    // do a lookup, not a (base) type in which we found the class method.
-                    const mp_obj_type_t *org_type = (const mp_obj_type_t*)lookup->obj;
-                    mp_convert_member_lookup(MP_OBJ_NULL, org_type, elem->value, lookup->dest);
-                } else if (MP_OBJ_IS_TYPE(elem->value, &mp_type_property)) {
-                    lookup->dest[0] = elem->value;
-                    return;
-                } else {
-                    mp_obj_instance_t *obj = lookup->obj;
-                    mp_obj_t obj_obj;
-                    if (obj != NULL && mp_obj_is_native_type(type) && type != &mp_type_object /* object is not a real type */) {
-                        // If we're dealing with native base class, then it applies to native sub-object
-                        obj_obj = obj->subobj[0];
-                    } else {
-                        obj_obj = MP_OBJ_FROM_PTR(obj);
-                    }
-                    mp_convert_member_lookup(obj_obj, type, elem->value, lookup->dest);
-                }
+                #if MICROPY_OPT_CLASS_LOOKUP_CACHE
+                lookup->found_in = type;
+                lookup->found_value = elem->value;
+                #endif
+                mp_obj_class_lookup_found(lookup, type, elem->value);
 #if DEBUG_PRINT
                 printf("mp_obj_class_lookup: Returning: ");
                 mp_obj_print(lookup->dest[0], PRINT_REPR); printf(" ");
@@ -252,6 +308,86 @@ STATIC void mp_obj_class_lookup(struct class_lookup_data  *lookup, const mp_obj_
     }
 }
 
+#if MICROPY_OPT_CLASS_LOOKUP_CACHE
+
+#define CLASS_LOOKUP_CACHE_INDEX(type, attr) \
+    ((((uintptr_t)(type) >> 3) ^ (attr)) & (MICROPY_OPT_CLASS_LOOKUP_CACHE_SIZE - 1))
+
+void mp_class_lookup_cache_invalidate(void) {
+    // without the GIL another thread may be invalidating the cache as well,
+    // and neither increment may be lost
+    MP_THREAD_ATOMIC_INC(MP_STATE_VM(class_lookup_cache_version));
+}
+
+void mp_class_lookup_cache_init(void) {
+    memset(MP_STATE_THREAD(class_lookup_cache), 0, sizeof(MP_STATE_THREAD(class_lookup_cache)));
+}
+
+// Same as mp_obj_class_lookup but for a plain attribute lookup on an instance
+// or a class, remembering the result for (type, attr).  A hit is only valid while no class
+// dict has been modified and no type has been created since the entry was made.
+// Hierarchies with a native base are never cached because the result of the
+// lookup can then depend on the native sub-object of the instance.
+STATIC void mp_obj_class_lookup_cached(struct class_lookup_data *lookup, const mp_obj_type_t *type) {
+    assert(lookup->meth_offset == 0);
+    mp_class_lookup_cache_entry_t *entry = &MP_STATE_THREAD(class_lookup_cache)[CLASS_LOOKUP_CACHE_INDEX(type, lookup->attr)];
+    size_t version = MP_STATE_VM(class_lookup_cache_version);
+    if (entry->type == type && entry->attr == lookup->attr && entry->version == version) {
+        if (entry->found_in != NULL) {
+            mp_obj_class_lookup_found(lookup, entry->found_in, entry->value);
+        }
+        return;
+    }
+    mp_obj_class_lookup(lookup, type);
+    if (!lookup->saw_native_base) {
+        entry->type = type;
+        entry->found_in = lookup->found_in;
+        entry->value = lookup->found_value;
+        entry->attr = lookup->attr;
+        entry->version = version;
+    }
+}
+
+#else
+#define mp_obj_class_lookup_cached mp_obj_class_lookup
+#endif
+
+#if MICROPY_PY_CLASS_SLOTS
+// Returns the storage of the slot called attr in the given instance, or NULL if
+// there is no such slot or (for a store) the class may intercept the store.
+// This lets the VM access slots without the generic load/store attr functions.
+// If the slot is defined by the class of the instance then the index of its
+// descriptor in the locals dict is written to *cache, for use with
+// mp_obj_instance_cached_slot.
+mp_obj_t *mp_obj_instance_find_slot(mp_obj_instance_t *self, qstr attr, bool store, byte *cache) {
+    const mp_obj_type_t *type = self->base.type;
+    if (TYPE_SLOT_END(type) == 0 || (store && (type->flags & TYPE_FLAG_HAS_SPECIAL_ACCESSORS))) {
+        return NULL;
+    }
+    mp_obj_t member[2] = {MP_OBJ_NULL};
+    struct class_lookup_data lookup = {
+        .obj = self,
+        .attr = attr,
+        .meth_offset = 0,
+        .dest = member,
+        .is_type = false,
+    };
+    mp_obj_class_lookup_cached(&lookup, type);
+    if (member[0] == MP_OBJ_NULL) {
+        return NULL;
+    }
+    mp_obj_t *slot = instance_get_slot(self, member[0]);
+    if (slot != NULL) {
+        mp_map_t *locals_map = &type->locals_dict->map;
+        mp_map_elem_t *elem = mp_map_lookup(locals_map, MP_OBJ_NEW_QSTR(attr), MP_MAP_LOOKUP);
+        if (elem != NULL && elem->value == member[0]) {
+            *cache = elem - &locals_map->table[0];
+        }
+    }
+    return slot;
+}
+#endif
+
 STATIC void instance_print(const mp_print_t *print, mp_obj_t self_in, mp_print_kind_t kind) {
     mp_obj_instance_t *self = MP_OBJ_TO_PTR(self_in);
     qstr meth = (kind == PRINT_STR) ? MP_QSTR___str__ : MP_QSTR___repr__;
@@ -422,9 +558,14 @@ STATIC mp_obj_t instance_unary_op(mp_unary_op_t op, mp_obj_t self_in) {
     if (MP_UNLIKELY(op == MP_UNARY_OP_SIZEOF)) {
         // TODO: This doesn't count inherited objects (self->subobj)
         const mp_obj_type_t *native_base;
-        size_t num_native_bases = instance_count_native_bases(mp_obj_get_type(self_in), &native_base);
+        size_t num_subobj = instance_count_native_bases(mp_obj_get_type(self_in), &native_base);
+        #if MICROPY_PY_CLASS_SLOTS
+        if (TYPE_SLOT_END(self->base.type) > num_subobj) {
+            num_subobj = TYPE_SLOT_END(self->base.type);
+        }
+        #endif
 
-        size_t sz = sizeof(*self) + sizeof(*self->subobj) * num_native_bases
+        size_t sz = sizeof(*self) + sizeof(*self->subobj) * num_subobj
             + sizeof(*self->members.table) * self->members.alloc;
         return MP_OBJ_NEW_SMALL_INT(sz);
     }
@@ -596,14 +737,22 @@ STATIC void mp_obj_instance_load_attr(mp_obj_t self_in, qstr attr, mp_obj_t *des
     assert(mp_obj_is_instance_type(mp_obj_get_type(self_in)));
     mp_obj_instance_t *self = MP_OBJ_TO_PTR(self_in);
 
+    MP_THREAD_OBJ_LOCK(self);
     mp_map_elem_t *elem = mp_map_lookup(&self->members, MP_OBJ_NEW_QSTR(attr), MP_MAP_LOOKUP);
     if (elem != NULL) {
         // object member, always treated as a value
         dest[0] = elem->value;
+    }
+    MP_THREAD_OBJ_UNLOCK(self);
+    if (elem != NULL) {
         return;
     }
 #if MICROPY_CPYTHON_COMPAT
-    if (attr == MP_QSTR___dict__) {
+    if (attr == MP_QSTR___dict__
+        #if MICROPY_PY_CLASS_SLOTS
+        && !(self->base.type->flags & TYPE_FLAG_NO_INSTANCE_DICT)
+        #endif
+        ) {
         // Create a new dict with a copy of the instance's map items.
         // This creates, unlike CPython, a 'read-only' __dict__: modifying
         // it will not result in modifications to the actual instance members.
@@ -625,8 +774,20 @@ STATIC void mp_obj_instance_load_attr(mp_obj_t self_in, qstr attr, mp_obj_t *des
         .dest = dest,
         .is_type = false,
     };
-    mp_obj_class_lookup(&lookup, self->base.type);
+    mp_obj_class_lookup_cached(&lookup, self->base.type);
     mp_obj_t member = dest[0];
+    #if MICROPY_PY_CLASS_SLOTS
+    if (member != MP_OBJ_NULL && TYPE_SLOT_END(self->base.type) != 0) {
+        mp_obj_t *slot = instance_get_slot(self, member);
+        if (slot != NULL) {
+            // an unset slot falls through to __getattr__ like a missing member
+            member = dest[0] = *slot;
+            if (member != MP_OBJ_NULL) {
+                return;
+            }
+        }
+    }
+    #endif
     if (member != MP_OBJ_NULL) {
         // changes here may may require changes to super_attr, below
         if (!(self->base.type->flags & TYPE_FLAG_HAS_SPECIAL_ACCESSORS)) {
@@ -712,7 +873,7 @@ STATIC bool mp_obj_instance_store_attr(mp_obj_t self_in, qstr attr, mp_obj_t val
         .dest = member,
         .is_type = false,
     };
-    mp_obj_class_lookup(&lookup, self->base.type);
+    mp_obj_class_lookup_cached(&lookup, self->base.type);
 
     if (member[0] != MP_OBJ_NULL) {
         #if MICROPY_PY_BUILTINS_PROPERTY
@@ -804,15 +965,47 @@ STATIC bool mp_obj_instance_store_attr(mp_obj_t self_in, qstr attr, mp_obj_t val
 
 skip_special_accessors:
 
+    #if MICROPY_PY_CLASS_SLOTS
+    if (TYPE_SLOT_END(self->base.type) != 0) {
+        mp_obj_t slot_member[2] = {MP_OBJ_NULL};
+        struct class_lookup_data slot_lookup = {
+            .obj = self,
+            .attr = attr,
+            .meth_offset = 0,
+            .dest = slot_member,
+            .is_type = false,
+        };
+        mp_obj_class_lookup_cached(&slot_lookup, self->base.type);
+        if (slot_member[0] != MP_OBJ_NULL) {
+            mp_obj_t *slot = instance_get_slot(self, slot_member[0]);
+            if (slot != NULL) {
+                if (value == MP_OBJ_NULL && *slot == MP_OBJ_NULL) {
+                    // can't delete a slot that isn't set
+                    return false;
+                }
+                *slot = value;
+                return true;
+            }
+        }
+    }
+    if (self->base.type->flags & TYPE_FLAG_NO_INSTANCE_DICT) {
+        // only the slots can be stored to
+        return false;
+    }
+    #endif
+
+    MP_THREAD_OBJ_LOCK(self);
+    bool stored = true;
     if (value == MP_OBJ_NULL) {
         // delete attribute
         mp_map_elem_t *elem = mp_map_lookup(&self->members, MP_OBJ_NEW_QSTR(attr), MP_MAP_LOOKUP_REMOVE_IF_FOUND);
-        return elem != NULL;
+        stored = elem != NULL;
     } else {
         // store attribute
         mp_map_lookup(&self->members, MP_OBJ_NEW_QSTR(attr), MP_MAP_LOOKUP_ADD_IF_NOT_FOUND)->value = value;
-        return true;
     }
+    MP_THREAD_OBJ_UNLOCK(self);
+    return stored;
 }
 
 STATIC void mp_obj_instance_attr(mp_obj_t self_in, qstr attr, mp_obj_t *dest) {
@@ -1060,7 +1253,7 @@ STATIC void type_attr(mp_obj_t self_in, qstr attr, mp_obj_t *dest) {
             .dest = dest,
             .is_type = true,
         };
-        mp_obj_class_lookup(&lookup, self);
+        mp_obj_class_lookup_cached(&lookup, self);
     } else {
         // delete/store attribute
 
@@ -1112,6 +1305,67 @@ const mp_obj_type_t mp_type_type = {
     .attr = type_attr,
 };
 
+#if MICROPY_PY_CLASS_SLOTS
+// Replaces each name listed in __slots__ with a member descriptor, and records
+// the instance lay-out in the flags of the new type.  Slots of the base class
+// keep their indices, so there can be only one base with slots.
+STATIC void type_init_slots(mp_obj_type_t *o, mp_map_t *locals_map, const mp_obj_type_t *slot_base, bool bases_have_dict, size_t num_native_bases) {
+    size_t slot_end = 0;
+    if (slot_base != NULL) {
+        const mp_obj_type_t *native_base;
+        size_t slot_base_native_bases = instance_count_native_bases(slot_base, &native_base);
+        if (slot_base_native_bases != num_native_bases) {
+            mp_raise_TypeError(translate("multiple bases have instance lay-out conflict"));
+        }
+        slot_end = TYPE_SLOT_END(slot_base);
+    }
+
+    mp_map_elem_t *elem = mp_map_lookup(locals_map, MP_OBJ_NEW_QSTR(MP_QSTR___slots__), MP_MAP_LOOKUP);
+    if (elem == NULL) {
+        // instances have a members map as well as any inherited slots
+        o->flags |= slot_end << TYPE_SLOT_END_SHIFT;
+        return;
+    }
+
+    mp_obj_t names = elem->value;
+    if (MP_OBJ_IS_STR(names)) {
+        names = mp_obj_new_tuple(1, &names);
+    }
+    if (slot_end == 0) {
+        slot_end = num_native_bases;
+    }
+    bool has_dict = bases_have_dict;
+    mp_obj_iter_buf_t iter_buf;
+    mp_obj_t iterable = mp_getiter(names, &iter_buf);
+    mp_obj_t item;
+    while ((item = mp_iternext(iterable)) != MP_OBJ_STOP_ITERATION) {
+        qstr attr = mp_obj_str_get_qstr(item);
+        if (attr == MP_QSTR___dict__) {
+            has_dict = true;
+            continue;
+        }
+        mp_map_elem_t *slot = mp_map_lookup(locals_map, MP_OBJ_NEW_QSTR(attr), MP_MAP_LOOKUP_ADD_IF_NOT_FOUND);
+        if (slot->value != MP_OBJ_NULL) {
+            mp_raise_ValueError_varg(translate("'%q' in __slots__ conflicts with class variable"), attr);
+        }
+        if (slot_end >= TYPE_SLOT_END_MAX) {
+            mp_raise_ValueError(translate("too many __slots__"));
+        }
+        mp_obj_member_descriptor_t *desc = m_new_obj(mp_obj_member_descriptor_t);
+        desc->base.type = &mp_type_member_descriptor;
+        desc->owner = o;
+        desc->name = attr;
+        desc->index = slot_end++;
+        slot->value = MP_OBJ_FROM_PTR(desc);
+    }
+
+    o->flags |= slot_end << TYPE_SLOT_END_SHIFT;
+    if (!has_dict) {
+        o->flags |= TYPE_FLAG_NO_INSTANCE_DICT;
+    }
+}
+#endif
+
 mp_obj_t mp_obj_new_type(qstr name, mp_obj_t bases_tuple, mp_obj_t locals_dict) {
     // Verify input objects have expected type
     if (!MP_OBJ_IS_TYPE(bases_tuple, &mp_type_tuple)) {
@@ -1125,6 +1379,10 @@ mp_obj_t mp_obj_new_type(qstr name, mp_obj_t bases_tuple, mp_obj_t locals_dict)
 
     // Basic validation of base classes
     uint16_t base_flags = 0;
+    #if MICROPY_PY_CLASS_SLOTS
+    const mp_obj_type_t *slot_base = NULL;
+    bool bases_have_dict = false;
+    #endif
     size_t bases_len;
     mp_obj_t *bases_items;
     mp_obj_tuple_get(bases_tuple, &bases_len, &bases_items);
@@ -1148,6 +1406,21 @@ mp_obj_t mp_obj_new_type(qstr name, mp_obj_t bases_tuple, mp_obj_t locals_dict)
             base_flags |= t->flags & TYPE_FLAG_HAS_SPECIAL_ACCESSORS;
         }
         #endif
+        #if MICROPY_PY_CLASS_SLOTS
+        if (mp_obj_is_instance_type(t)) {
+            if (!(t->flags & TYPE_FLAG_NO_INSTANCE_DICT)) {
+                bases_have_dict = true;
+            }
+            if (TYPE_SLOT_END(t) != 0) {
+                // bases with slots must all be in one line of inheritance
+                if (slot_base == NULL || mp_obj_is_subclass_fast(bases_items[i], MP_OBJ_FROM_PTR(slot_base))) {
+                    slot_base = t;
+                } else if (!mp_obj_is_subclass_fast(MP_OBJ_FROM_PTR(slot_base), bases_items[i])) {
+                    mp_raise_TypeError(translate("multiple bases have instance lay-out conflict"));
+                }
+            }
+        }
+        #endif
     }
 
     mp_obj_type_t *o = m_new0_ll(mp_obj_type_t, 1);
@@ -1183,15 +1456,25 @@ mp_obj_t mp_obj_new_type(qstr name, mp_obj_t bases_tuple, mp_obj_t locals_dict)
         }
     }
 
-    o->locals_dict = make_dict_long_lived(locals_dict, 10);
-
-
     const mp_obj_type_t *native_base;
     size_t num_native_bases = instance_count_native_bases(o, &native_base);
     if (num_native_bases > 1) {
         mp_raise_TypeError(translate("multiple bases have instance lay-out conflict"));
     }
 
+    #if MICROPY_PY_CLASS_SLOTS
+    type_init_slots(o, mp_obj_dict_get_map(locals_dict), slot_base, bases_have_dict, num_native_bases);
+    #endif
+
+    o->locals_dict = make_dict_long_lived(MP_OBJ_TO_PTR(locals_dict), 10);
+
+    #if MICROPY_OPT_CLASS_LOOKUP_CACHE
+    // The new type may reuse the memory of a type that was freed, so entries
+    // in the cache keyed on that address must not be used anymore.
+    o->locals_dict->map.is_class_dict = 1;
+    mp_class_lookup_cache_invalidate();
+    #endif
+
     mp_map_t *locals_map = &o->locals_dict->map;
     #if ENABLE_SPECIAL_ACCESSORS
     // Check if the class has any special accessor methods
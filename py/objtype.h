@@ -44,10 +44,63 @@ void mp_obj_assert_native_inited(mp_obj_t native_object);
 mp_obj_instance_t *mp_obj_new_instance(const mp_obj_type_t *cls, const mp_obj_type_t **native_base);
 #endif
 
+// flags of types created by mp_obj_new_type
+#define TYPE_FLAG_IS_SUBCLASSED (0x0001)
+#define TYPE_FLAG_HAS_SPECIAL_ACCESSORS (0x0002)
+
+#if MICROPY_PY_CLASS_SLOTS
+// Set when the class and all its user-defined bases have __slots__ without
+// __dict__, so instances can't take attributes other than their slots.
+#define TYPE_FLAG_NO_INSTANCE_DICT (0x0004)
+// The remaining bits hold the number of entries needed in instance->subobj,
+// counting the native base (if any) followed by the slots of all classes in
+// the hierarchy.  Zero means the class has no slots.
+#define TYPE_SLOT_END_SHIFT (4)
+#define TYPE_SLOT_END_MAX (0xffff >> TYPE_SLOT_END_SHIFT)
+#define TYPE_SLOT_END(type) ((type)->flags >> TYPE_SLOT_END_SHIFT)
+
+// A member descriptor replaces each name listed in __slots__ in the locals
+// dict of the class, and gives the index of that attribute in instance->subobj.
+typedef struct _mp_obj_member_descriptor_t {
+    mp_obj_base_t base;
+    const mp_obj_type_t *owner;
+    qstr name;
+    size_t index;
+} mp_obj_member_descriptor_t;
+
+extern const mp_obj_type_t mp_type_member_descriptor;
+
+// these are used by the VM to load/store slots directly
+mp_obj_t *mp_obj_instance_find_slot(mp_obj_instance_t *self, qstr attr, bool store, byte *cache);
+
+// Returns the slot of the given instance whose descriptor is at index x of the
+// locals dict of its class, or NULL if that entry isn't the descriptor of key.
+static inline mp_obj_t *mp_obj_instance_cached_slot(mp_obj_instance_t *self, mp_uint_t x, mp_obj_t key, bool store) {
+    const mp_obj_type_t *type = self->base.type;
+    if (TYPE_SLOT_END(type) == 0 || (store && (type->flags & TYPE_FLAG_HAS_SPECIAL_ACCESSORS))) {
+        return NULL;
+    }
+    mp_map_t *locals_map = &type->locals_dict->map;
+    if (x < locals_map->alloc && locals_map->table[x].key == key
+        && MP_OBJ_IS_TYPE(locals_map->table[x].value, &mp_type_member_descriptor)) {
+        mp_obj_member_descriptor_t *desc = MP_OBJ_TO_PTR(locals_map->table[x].value);
+        if (desc->owner == type) {
+            return &self->subobj[desc->index];
+        }
+    }
+    return NULL;
+}
+#endif
+
 // these need to be exposed so mp_obj_is_callable can work correctly
 bool mp_obj_instance_is_callable(mp_obj_t self_in);
 mp_obj_t mp_obj_instance_call(mp_obj_t self_in, size_t n_args, size_t n_kw, const mp_obj_t *args);
 
+#if MICROPY_OPT_CLASS_LOOKUP_CACHE
+// clears the class lookup cache of the current thread
+void mp_class_lookup_cache_init(void);
+#endif
+
 #define mp_obj_is_instance_type(type) ((type)->make_new == mp_obj_instance_make_new)
 #define mp_obj_is_native_type(type) ((type)->make_new != mp_obj_instance_make_new)
 // this needs to be exposed for the above macros to work correctly
@@ -241,6 +241,10 @@ typedef struct _parser_t {
     #if MICROPY_COMP_CONST
     mp_map_t consts;
     #endif
+
+    #if MICROPY_COMP_STREAM
+    size_t tree_bytes;
+    #endif
 } parser_t;
 
 STATIC const uint16_t *get_rule_arg(uint8_t r_id) {
@@ -292,6 +296,9 @@ STATIC void *parser_alloc(parser_t *parser, size_t num_bytes) {
 
     byte *ret = chunk->data + chunk->union_.used;
     chunk->union_.used += num_bytes;
+    #if MICROPY_COMP_STREAM
+    parser->tree_bytes += num_bytes;
+    #endif
     return ret;
 }
 #pragma GCC diagnostic pop
@@ -399,7 +406,7 @@ void mp_parse_node_print(mp_parse_node_t pn, size_t indent) {
         mp_parse_node_struct_t *pns = (mp_parse_node_struct_t*)pn;
         if (MP_PARSE_NODE_STRUCT_KIND(pns) == RULE_const_object) {
             #if MICROPY_OBJ_REPR == MICROPY_OBJ_REPR_D
-            printf("literal const(%016llx)\n", (uint64_t)pns->nodes[0] | ((uint64_t)pns->nodes[1] << 32));
+            printf("literal const(%016llx)\n", (unsigned long long)((uint64_t)pns->nodes[0] | ((uint64_t)pns->nodes[1] << 32)));
             #else
             printf("literal const(%p)\n", (mp_obj_t)pns->nodes[0]);
             #endif
@@ -447,14 +454,17 @@ STATIC void push_result_node(parser_t *parser, mp_parse_node_t pn) {
 }
 
 STATIC mp_parse_node_t make_node_const_object(parser_t *parser, size_t src_line, mp_obj_t obj) {
-    mp_parse_node_struct_t *pn = parser_alloc(parser, sizeof(mp_parse_node_struct_t) + sizeof(mp_obj_t));
-    pn->source_line = src_line;
     #if MICROPY_OBJ_REPR == MICROPY_OBJ_REPR_D
-    // nodes are 32-bit pointers, but need to store 64-bit object
+    // nodes are 32-bit pointers, but need to store 64-bit object (on a 64-bit
+    // host the object fits in the first node and the second is redundant)
+    mp_parse_node_struct_t *pn = parser_alloc(parser, sizeof(mp_parse_node_struct_t) + 2 * sizeof(mp_parse_node_t));
+    pn->source_line = src_line;
     pn->kind_num_nodes = RULE_const_object | (2 << 8);
     pn->nodes[0] = (uint64_t)obj;
     pn->nodes[1] = (uint64_t)obj >> 32;
     #else
+    mp_parse_node_struct_t *pn = parser_alloc(parser, sizeof(mp_parse_node_struct_t) + sizeof(mp_obj_t));
+    pn->source_line = src_line;
     pn->kind_num_nodes = RULE_const_object | (1 << 8);
     pn->nodes[0] = (uintptr_t)obj;
     #endif
@@ -835,79 +845,88 @@ STATIC void push_result_rule(parser_t *parser, size_t src_line, uint8_t rule_id,
     push_result_node(parser, (mp_parse_node_t)pn);
 }
 
-mp_parse_tree_t mp_parse(mp_lexer_t *lex, mp_parse_input_kind_t input_kind) {
-
-    // initialise parser and allocate memory for its stacks
-
-    parser_t parser;
+STATIC NORETURN void raise_syntax_error(mp_lexer_t *lex) {
+    mp_obj_t exc;
+    if (lex->tok_kind == MP_TOKEN_INDENT) {
+        exc = mp_obj_new_exception_msg(&mp_type_IndentationError,
+            translate("unexpected indent"));
+    } else if (lex->tok_kind == MP_TOKEN_DEDENT_MISMATCH) {
+        exc = mp_obj_new_exception_msg(&mp_type_IndentationError,
+            translate("unindent does not match any outer indentation level"));
+    } else {
+        exc = mp_obj_new_exception_msg(&mp_type_SyntaxError,
+            translate("invalid syntax"));
+    }
+    // add traceback to give info about file name and location
+    // we don't have a 'block' name, so just pass the NULL qstr to indicate this
+    mp_obj_exception_add_traceback(exc, lex->source_name, lex->tok_line, MP_QSTR_NULL);
+    nlr_raise(exc);
+}
 
-    parser.rule_stack_alloc = MICROPY_ALLOC_PARSE_RULE_INIT;
-    parser.rule_stack_top = 0;
-    parser.rule_stack = NULL;
-    while (parser.rule_stack_alloc > 1) {
-        parser.rule_stack = m_new_maybe(rule_stack_t, parser.rule_stack_alloc);
-        if (parser.rule_stack != NULL) {
+STATIC void parser_init(parser_t *parser, mp_lexer_t *lex) {
+    // allocate memory for the parser stacks
+    parser->rule_stack_alloc = MICROPY_ALLOC_PARSE_RULE_INIT;
+    parser->rule_stack_top = 0;
+    parser->rule_stack = NULL;
+    while (parser->rule_stack_alloc > 1) {
+        parser->rule_stack = m_new_maybe(rule_stack_t, parser->rule_stack_alloc);
+        if (parser->rule_stack != NULL) {
             break;
         } else {
-            parser.rule_stack_alloc /= 2;
+            parser->rule_stack_alloc /= 2;
         }
     }
 
-    parser.result_stack_alloc = MICROPY_ALLOC_PARSE_RESULT_INIT;
-    parser.result_stack_top = 0;
-    parser.result_stack = NULL;
-    while (parser.result_stack_alloc > 1) {
-        parser.result_stack = m_new_maybe(mp_parse_node_t, parser.result_stack_alloc);
-        if (parser.result_stack != NULL) {
+    parser->result_stack_alloc = MICROPY_ALLOC_PARSE_RESULT_INIT;
+    parser->result_stack_top = 0;
+    parser->result_stack = NULL;
+    while (parser->result_stack_alloc > 1) {
+        parser->result_stack = m_new_maybe(mp_parse_node_t, parser->result_stack_alloc);
+        if (parser->result_stack != NULL) {
             break;
         } else {
-            parser.result_stack_alloc /= 2;
+            parser->result_stack_alloc /= 2;
         }
     }
-    if (parser.rule_stack == NULL || parser.result_stack == NULL) {
+    if (parser->rule_stack == NULL || parser->result_stack == NULL) {
         mp_raise_msg(&mp_type_MemoryError, translate("Unable to init parser"));
     }
 
-    parser.lexer = lex;
+    parser->lexer = lex;
 
-    parser.tree.chunk = NULL;
-    parser.cur_chunk = NULL;
+    parser->tree.chunk = NULL;
+    parser->cur_chunk = NULL;
 
     #if MICROPY_COMP_CONST
-    mp_map_init(&parser.consts, 0);
+    mp_map_init(&parser->consts, 0);
     #endif
+}
 
-    // work out the top-level rule to use, and push it on the stack
-    size_t top_level_rule;
-    switch (input_kind) {
-        case MP_PARSE_SINGLE_INPUT: top_level_rule = RULE_single_input; break;
-        case MP_PARSE_EVAL_INPUT: top_level_rule = RULE_eval_input; break;
-        default: top_level_rule = RULE_file_input;
-    }
-    push_rule(&parser, lex->tok_line, top_level_rule, 0);
-
-    // parse!
+// Parse the given rule, leaving its node on the result stack
+STATIC void parse_rule(parser_t *parser, size_t top_level_rule, mp_parse_input_kind_t input_kind) {
+    mp_lexer_t *lex = parser->lexer;
+    push_rule(parser, lex->tok_line, top_level_rule, 0);
 
     bool backtrack = false;
 
     for (;;) {
         next_rule:
-        if (parser.rule_stack_top == 0) {
+        if (parser->rule_stack_top == 0) {
             break;
         }
 
         // Pop the next rule to process it
         size_t i; // state for the current rule
         size_t rule_src_line; // source line for the first token matched by the current rule
-        uint8_t rule_id = pop_rule(&parser, &i, &rule_src_line);
+        uint8_t rule_id = pop_rule(parser, &i, &rule_src_line);
         uint8_t rule_act = rule_act_table[rule_id];
         const uint16_t *rule_arg = get_rule_arg(rule_id);
         size_t n = rule_act & RULE_ACT_ARG_MASK;
 
         #if 0
         // debugging
-        printf("depth=" UINT_FMT " ", parser.rule_stack_top);
-        for (int j = 0; j < parser.rule_stack_top; ++j) {
+        printf("depth=" UINT_FMT " ", parser->rule_stack_top);
+        for (int j = 0; j < parser->rule_stack_top; ++j) {
             printf(" ");
         }
         printf("%s n=" UINT_FMT " i=" UINT_FMT " bt=%d\n", rule_name_table[rule_id], n, i, backtrack);
@@ -924,16 +943,16 @@ mp_parse_tree_t mp_parse(mp_lexer_t *lex, mp_parse_input_kind_t input_kind) {
                     uint16_t kind = rule_arg[i] & RULE_ARG_KIND_MASK;
                     if (kind == RULE_ARG_TOK) {
                         if (lex->tok_kind == (rule_arg[i] & RULE_ARG_ARG_MASK)) {
-                            push_result_token(&parser, rule_id);
+                            push_result_token(parser, rule_id);
                             mp_lexer_to_next(lex);
                             goto next_rule;
                         }
                     } else {
                         assert(kind == RULE_ARG_RULE);
                         if (i + 1 < n) {
-                            push_rule(&parser, rule_src_line, rule_id, i + 1); // save this or-rule
+                            push_rule(parser, rule_src_line, rule_id, i + 1); // save this or-rule
                         }
-                        push_rule_from_arg(&parser, rule_arg[i]); // push child of or-rule
+                        push_rule_from_arg(parser, rule_arg[i]); // push child of or-rule
                         goto next_rule;
                     }
                 }
@@ -947,13 +966,13 @@ mp_parse_tree_t mp_parse(mp_lexer_t *lex, mp_parse_input_kind_t input_kind) {
                     assert(i > 0);
                     if ((rule_arg[i - 1] & RULE_ARG_KIND_MASK) == RULE_ARG_OPT_RULE) {
                         // an optional rule that failed, so continue with next arg
-                        push_result_node(&parser, MP_PARSE_NODE_NULL);
+                        push_result_node(parser, MP_PARSE_NODE_NULL);
                         backtrack = false;
                     } else {
                         // a mandatory rule that failed, so propagate backtrack
                         if (i > 1) {
                             // already eaten tokens so can't backtrack
-                            goto syntax_error;
+                            raise_syntax_error(lex);
                         } else {
                             goto next_rule;
                         }
@@ -968,14 +987,14 @@ mp_parse_tree_t mp_parse(mp_lexer_t *lex, mp_parse_input_kind_t input_kind) {
                         if (lex->tok_kind == tok_kind) {
                             // matched token
                             if (tok_kind == MP_TOKEN_NAME) {
-                                push_result_token(&parser, rule_id);
+                                push_result_token(parser, rule_id);
                             }
                             mp_lexer_to_next(lex);
                         } else {
                             // failed to match token
                             if (i > 0) {
                                 // already eaten tokens so can't backtrack
-                                goto syntax_error;
+                                raise_syntax_error(lex);
                             } else {
                                 // this rule failed, so backtrack
                                 backtrack = true;
@@ -983,8 +1002,8 @@ mp_parse_tree_t mp_parse(mp_lexer_t *lex, mp_parse_input_kind_t input_kind) {
                             }
                         }
                     } else {
-                        push_rule(&parser, rule_src_line, rule_id, i + 1); // save this and-rule
-                        push_rule_from_arg(&parser, rule_arg[i]); // push child of and-rule
+                        push_rule(parser, rule_src_line, rule_id, i + 1); // save this and-rule
+                        push_rule_from_arg(parser, rule_arg[i]); // push child of and-rule
                         goto next_rule;
                     }
                 }
@@ -995,16 +1014,16 @@ mp_parse_tree_t mp_parse(mp_lexer_t *lex, mp_parse_input_kind_t input_kind) {
 
                 #if !MICROPY_ENABLE_DOC_STRING
                 // this code discards lonely statements, such as doc strings
-                if (input_kind != MP_PARSE_SINGLE_INPUT && rule_id == RULE_expr_stmt && peek_result(&parser, 0) == MP_PARSE_NODE_NULL) {
-                    mp_parse_node_t p = peek_result(&parser, 1);
+                if (input_kind != MP_PARSE_SINGLE_INPUT && rule_id == RULE_expr_stmt && peek_result(parser, 0) == MP_PARSE_NODE_NULL) {
+                    mp_parse_node_t p = peek_result(parser, 1);
                     if ((MP_PARSE_NODE_IS_LEAF(p) && !MP_PARSE_NODE_IS_ID(p))
                         || MP_PARSE_NODE_IS_STRUCT_KIND(p, RULE_const_object)) {
-                        pop_result(&parser); // MP_PARSE_NODE_NULL
-                        pop_result(&parser); // const expression (leaf or RULE_const_object)
+                        pop_result(parser); // MP_PARSE_NODE_NULL
+                        pop_result(parser); // const expression (leaf or RULE_const_object)
                         // Pushing the "pass" rule here will overwrite any RULE_const_object
                         // entry that was on the result stack, allowing the GC to reclaim
                         // the memory from the const object when needed.
-                        push_result_rule(&parser, rule_src_line, RULE_pass_stmt, 0);
+                        push_result_rule(parser, rule_src_line, RULE_pass_stmt, 0);
                         break;
                     }
                 }
@@ -1024,7 +1043,7 @@ mp_parse_tree_t mp_parse(mp_lexer_t *lex, mp_parse_input_kind_t input_kind) {
                         }
                     } else {
                         // rules are always pushed
-                        if (peek_result(&parser, i) != MP_PARSE_NODE_NULL) {
+                        if (peek_result(parser, i) != MP_PARSE_NODE_NULL) {
                             num_not_nil += 1;
                         }
                         i += 1;
@@ -1035,22 +1054,22 @@ mp_parse_tree_t mp_parse(mp_lexer_t *lex, mp_parse_input_kind_t input_kind) {
                     // this rule has only 1 argument and should not be emitted
                     mp_parse_node_t pn = MP_PARSE_NODE_NULL;
                     for (size_t x = 0; x < i; ++x) {
-                        mp_parse_node_t pn2 = pop_result(&parser);
+                        mp_parse_node_t pn2 = pop_result(parser);
                         if (pn2 != MP_PARSE_NODE_NULL) {
                             pn = pn2;
                         }
                     }
-                    push_result_node(&parser, pn);
+                    push_result_node(parser, pn);
                 } else {
                     // this rule must be emitted
 
                     if (rule_act & RULE_ACT_ADD_BLANK) {
                         // and add an extra blank node at the end (used by the compiler to store data)
-                        push_result_node(&parser, MP_PARSE_NODE_NULL);
+                        push_result_node(parser, MP_PARSE_NODE_NULL);
                         i += 1;
                     }
 
-                    push_result_rule(&parser, rule_src_line, rule_id, i);
+                    push_result_rule(parser, rule_src_line, rule_id, i);
                 }
                 break;
             }
@@ -1085,7 +1104,7 @@ mp_parse_tree_t mp_parse(mp_lexer_t *lex, mp_parse_input_kind_t input_kind) {
                                 backtrack = false;
                             } else {
                                 // list doesn't allowing trailing separator; fail
-                                goto syntax_error;
+                                raise_syntax_error(lex);
                             }
                         } else {
                             // fail on separator; finish parsing list
@@ -1100,7 +1119,7 @@ mp_parse_tree_t mp_parse(mp_lexer_t *lex, mp_parse_input_kind_t input_kind) {
                                 if (i & 1 & n) {
                                     // separators which are tokens are not pushed to result stack
                                 } else {
-                                    push_result_token(&parser, rule_id);
+                                    push_result_token(parser, rule_id);
                                 }
                                 mp_lexer_to_next(lex);
                                 // got element of list, so continue parsing list
@@ -1113,8 +1132,8 @@ mp_parse_tree_t mp_parse(mp_lexer_t *lex, mp_parse_input_kind_t input_kind) {
                             }
                         } else {
                             assert((arg & RULE_ARG_KIND_MASK) == RULE_ARG_RULE);
-                            push_rule(&parser, rule_src_line, rule_id, i + 1); // save this list-rule
-                            push_rule_from_arg(&parser, arg); // push child of list-rule
+                            push_rule(parser, rule_src_line, rule_id, i + 1); // save this list-rule
+                            push_rule_from_arg(parser, arg); // push child of list-rule
                             goto next_rule;
                         }
                     }
@@ -1132,69 +1151,134 @@ mp_parse_tree_t mp_parse(mp_lexer_t *lex, mp_parse_input_kind_t input_kind) {
                     // list matched single item
                     if (had_trailing_sep) {
                         // if there was a trailing separator, make a list of a single item
-                        push_result_rule(&parser, rule_src_line, rule_id, i);
+                        push_result_rule(parser, rule_src_line, rule_id, i);
                     } else {
                         // just leave single item on stack (ie don't wrap in a list)
                     }
                 } else {
-                    push_result_rule(&parser, rule_src_line, rule_id, i);
+                    push_result_rule(parser, rule_src_line, rule_id, i);
                 }
                 break;
             }
         }
     }
+}
 
+// Truncate the final chunk and link it into the chain of chunks, which are
+// then owned by the returned tree.
+STATIC mp_parse_tree_t parser_take_tree(parser_t *parser) {
+    if (parser->cur_chunk != NULL) {
+        (void)m_renew_maybe(byte, parser->cur_chunk,
+            sizeof(mp_parse_chunk_t) + parser->cur_chunk->alloc,
+            sizeof(mp_parse_chunk_t) + parser->cur_chunk->union_.used,
+            false);
+        parser->cur_chunk->alloc = parser->cur_chunk->union_.used;
+        parser->cur_chunk->union_.next = parser->tree.chunk;
+        parser->tree.chunk = parser->cur_chunk;
+    }
+    mp_parse_tree_t tree = parser->tree;
+    parser->tree.chunk = NULL;
+    parser->cur_chunk = NULL;
+    return tree;
+}
+
+STATIC void parser_deinit(parser_t *parser) {
     #if MICROPY_COMP_CONST
-    mp_map_deinit(&parser.consts);
+    mp_map_deinit(&parser->consts);
     #endif
 
-    // truncate final chunk and link into chain of chunks
-    if (parser.cur_chunk != NULL) {
-        (void)m_renew_maybe(byte, parser.cur_chunk,
-            sizeof(mp_parse_chunk_t) + parser.cur_chunk->alloc,
-            sizeof(mp_parse_chunk_t) + parser.cur_chunk->union_.used,
-            false);
-        parser.cur_chunk->alloc = parser.cur_chunk->union_.used;
-        parser.cur_chunk->union_.next = parser.tree.chunk;
-        parser.tree.chunk = parser.cur_chunk;
+    // free the memory that we don't need anymore
+    m_del(rule_stack_t, parser->rule_stack, parser->rule_stack_alloc);
+    m_del(mp_parse_node_t, parser->result_stack, parser->result_stack_alloc);
+
+    // we also free the lexer on behalf of the caller
+    mp_lexer_free(parser->lexer);
+}
+
+mp_parse_tree_t mp_parse(mp_lexer_t *lex, mp_parse_input_kind_t input_kind) {
+    parser_t parser;
+    parser_init(&parser, lex);
+
+    // work out the top-level rule to use, and parse it
+    size_t top_level_rule;
+    switch (input_kind) {
+        case MP_PARSE_SINGLE_INPUT: top_level_rule = RULE_single_input; break;
+        case MP_PARSE_EVAL_INPUT: top_level_rule = RULE_eval_input; break;
+        default: top_level_rule = RULE_file_input;
     }
+    parse_rule(&parser, top_level_rule, input_kind);
 
     if (
         lex->tok_kind != MP_TOKEN_END // check we are at the end of the token stream
         || parser.result_stack_top == 0 // check that we got a node (can fail on empty input)
         ) {
-    syntax_error:;
-        mp_obj_t exc;
-        if (lex->tok_kind == MP_TOKEN_INDENT) {
-            exc = mp_obj_new_exception_msg(&mp_type_IndentationError,
-                translate("unexpected indent"));
-        } else if (lex->tok_kind == MP_TOKEN_DEDENT_MISMATCH) {
-            exc = mp_obj_new_exception_msg(&mp_type_IndentationError,
-                translate("unindent does not match any outer indentation level"));
-        } else {
-            exc = mp_obj_new_exception_msg(&mp_type_SyntaxError,
-                translate("invalid syntax"));
-        }
-        // add traceback to give info about file name and location
-        // we don't have a 'block' name, so just pass the NULL qstr to indicate this
-        mp_obj_exception_add_traceback(exc, lex->source_name, lex->tok_line, MP_QSTR_NULL);
-        nlr_raise(exc);
+        raise_syntax_error(lex);
     }
 
     // get the root parse node that we created
     assert(parser.result_stack_top == 1);
-    parser.tree.root = parser.result_stack[0];
+    mp_parse_tree_t tree = parser_take_tree(&parser);
+    tree.root = parser.result_stack[0];
 
-    // free the memory that we don't need anymore
-    m_del(rule_stack_t, parser.rule_stack, parser.rule_stack_alloc);
-    m_del(mp_parse_node_t, parser.result_stack, parser.result_stack_alloc);
+    parser_deinit(&parser);
 
-    // we also free the lexer on behalf of the caller
-    mp_lexer_free(lex);
+    return tree;
+}
+
+#if MICROPY_COMP_STREAM
+
+struct _mp_parse_stream_t {
+    parser_t parser;
+};
 
-    return parser.tree;
+mp_parse_stream_t *mp_parse_stream_new(mp_lexer_t *lex) {
+    mp_parse_stream_t *ps = m_new_obj(mp_parse_stream_t);
+    parser_init(&ps->parser, lex);
+    return ps;
 }
 
+mp_parse_tree_t mp_parse_stream_next(mp_parse_stream_t *ps) {
+    parser_t *parser = &ps->parser;
+    mp_lexer_t *lex = parser->lexer;
+
+    // parse statements until there are enough parse nodes to be worth
+    // compiling, like file_input but a group at a time
+    size_t src_line = lex->tok_line;
+    size_t num_stmts = 0;
+    parser->tree_bytes = 0;
+    for (;;) {
+        while (lex->tok_kind == MP_TOKEN_NEWLINE) {
+            mp_lexer_to_next(lex);
+        }
+        if (lex->tok_kind == MP_TOKEN_END || parser->tree_bytes >= MICROPY_ALLOC_PARSE_STREAM_GROUP) {
+            break;
+        }
+        parse_rule(parser, RULE_stmt, MP_PARSE_FILE_INPUT);
+        if (parser->result_stack_top != num_stmts + 1) {
+            // the statement didn't match
+            raise_syntax_error(lex);
+        }
+        num_stmts += 1;
+    }
+
+    mp_parse_node_t root = MP_PARSE_NODE_NULL;
+    if (num_stmts > 0) {
+        push_result_rule(parser, src_line, RULE_file_input_2, num_stmts);
+        root = pop_result(parser);
+    }
+
+    mp_parse_tree_t tree = parser_take_tree(parser);
+    tree.root = root;
+    return tree;
+}
+
+void mp_parse_stream_free(mp_parse_stream_t *ps) {
+    parser_deinit(&ps->parser);
+    m_del_obj(mp_parse_stream_t, ps);
+}
+
+#endif // MICROPY_COMP_STREAM
+
 void mp_parse_tree_clear(mp_parse_tree_t *tree) {
     mp_parse_chunk_t *chunk = tree->chunk;
     while (chunk != NULL) {
@@ -104,4 +104,14 @@ typedef struct _mp_parse_t {
 mp_parse_tree_t mp_parse(struct _mp_lexer_t *lex, mp_parse_input_kind_t input_kind);
 void mp_parse_tree_clear(mp_parse_tree_t *tree);
 
+#if MICROPY_COMP_STREAM
+// Parse a file a group of top-level statements at a time.  Each call to
+// mp_parse_stream_next returns the tree for the next group, with a null root
+// at the end of the file.  mp_parse_stream_free also frees the lexer.
+typedef struct _mp_parse_stream_t mp_parse_stream_t;
+mp_parse_stream_t *mp_parse_stream_new(struct _mp_lexer_t *lex);
+mp_parse_tree_t mp_parse_stream_next(mp_parse_stream_t *ps);
+void mp_parse_stream_free(mp_parse_stream_t *ps);
+#endif
+
 #endif // MICROPY_INCLUDED_PY_PARSE_H
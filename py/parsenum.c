@@ -30,6 +30,7 @@
 #include "py/runtime.h"
 #include "py/parsenumbase.h"
 #include "py/parsenum.h"
+#include "py/formatfloat.h"
 #include "py/smallint.h"
 
 #include "supervisor/shared/translate.h"
@@ -181,10 +182,12 @@ mp_obj_t mp_parse_num_decimal(const char *str, size_t len, bool allow_imag, bool
 #define DEC_VAL_MAX 1e20F
 #define SMALL_NORMAL_VAL (1e-37F)
 #define SMALL_NORMAL_EXP (-37)
+#define EXACT_POWER_OF_10 (9)
 #elif MICROPY_FLOAT_IMPL == MICROPY_FLOAT_IMPL_DOUBLE
 #define DEC_VAL_MAX 1e200
 #define SMALL_NORMAL_VAL (1e-307)
 #define SMALL_NORMAL_EXP (-307)
+#define EXACT_POWER_OF_10 (22)
 #endif
 
     const char *top = str + len;
@@ -233,6 +236,12 @@ mp_obj_t mp_parse_num_decimal(const char *str, size_t len, bool allow_imag, bool
         bool exp_neg = false;
         int exp_val = 0;
         int exp_extra = 0;
+        #if MICROPY_FLOAT_FORMAT_EXACT
+        // the leading digits, exactly, for correcting the rounding of dec_val
+        uint64_t dec_int = 0;
+        int exp_int_extra = 0;
+        bool dec_int_more = false;
+        #endif
         while (str < top) {
             unsigned int dig = *str++;
             if ('0' <= dig && dig <= '9') {
@@ -245,6 +254,19 @@ mp_obj_t mp_parse_num_decimal(const char *str, size_t len, bool allow_imag, bool
                         exp_val = 10 * exp_val + dig;
                     }
                 } else {
+                    #if MICROPY_FLOAT_FORMAT_EXACT
+                    if (dec_int < 1000000000000000000ULL) {
+                        dec_int = 10 * dec_int + dig;
+                        if (in == PARSE_DEC_IN_FRAC) {
+                            --exp_int_extra;
+                        }
+                    } else {
+                        dec_int_more |= dig != 0;
+                        if (in == PARSE_DEC_IN_INTG) {
+                            ++exp_int_extra;
+                        }
+                    }
+                    #endif
                     if (dec_val < DEC_VAL_MAX) {
                         // dec_val won't overflow so keep accumulating
                         dec_val = 10 * dec_val + dig;
@@ -290,6 +312,9 @@ mp_obj_t mp_parse_num_decimal(const char *str, size_t len, bool allow_imag, bool
         if (exp_neg) {
             exp_val = -exp_val;
         }
+        #if MICROPY_FLOAT_FORMAT_EXACT
+        int exp_int = exp_val + exp_int_extra;
+        #endif
 
         // apply the exponent, making sure it's not a subnormal value
         exp_val += exp_extra;
@@ -297,7 +322,17 @@ mp_obj_t mp_parse_num_decimal(const char *str, size_t len, bool allow_imag, bool
             exp_val -= SMALL_NORMAL_EXP;
             dec_val *= SMALL_NORMAL_VAL;
         }
-        dec_val *= MICROPY_FLOAT_C_FUN(pow)(10, exp_val);
+        // Small positive powers of 10 are exact but negative ones aren't, so
+        // divide by the exact power rather than multiply by an inexact one;
+        // with a mantissa that is exact too this gives the nearest float.
+        if (exp_val < 0 && exp_val >= -EXACT_POWER_OF_10) {
+            dec_val /= MICROPY_FLOAT_C_FUN(pow)(10, -exp_val);
+        } else {
+            dec_val *= MICROPY_FLOAT_C_FUN(pow)(10, exp_val);
+        }
+        #if MICROPY_FLOAT_FORMAT_EXACT
+        dec_val = mp_float_round_decimal(dec_val, dec_int, exp_int, dec_int_more);
+        #endif
     }
 
     // negate value if needed
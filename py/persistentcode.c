@@ -48,12 +48,17 @@
 #define MPY_FEATURE_FLAGS ( \
     ((MICROPY_OPT_CACHE_MAP_LOOKUP_IN_BYTECODE) << 0) \
     | ((MICROPY_PY_BUILTINS_STR_UNICODE) << 1) \
+    | ((MICROPY_OPT_BYTECODE_SUPERINSTRUCTIONS) << 2) \
     )
 // This is a version of the flags that can be configured at runtime.
 #define MPY_FEATURE_FLAGS_DYNAMIC ( \
     ((MICROPY_OPT_CACHE_MAP_LOOKUP_IN_BYTECODE_DYNAMIC) << 0) \
     | ((MICROPY_PY_BUILTINS_STR_UNICODE_DYNAMIC) << 1) \
+    | ((MICROPY_OPT_BYTECODE_SUPERINSTRUCTIONS_DYNAMIC) << 2) \
     )
+// Bytecode without superinstructions runs on a VM that supports them, so this
+// flag is only required to be clear in the file if the VM lacks support.
+#define MPY_FEATURE_FLAG_SUPERINSTRUCTIONS (1 << 2)
 
 #if MICROPY_PERSISTENT_CODE_LOAD || (MICROPY_PERSISTENT_CODE_SAVE && !MICROPY_DYNAMIC_COMPILER)
 // The bytecode will depend on the number of bits in a small-int, and
@@ -181,6 +186,97 @@ STATIC void load_bytecode_qstrs(mp_reader_t *reader, byte *ip, byte *ip_top) {
     }
 }
 
+#if MICROPY_PERSISTENT_CODE_LOAD_LAZY
+
+// A reader over a .mpy image that stays in memory, so that raw code can be
+// left in the image and loaded later.
+typedef struct _mpy_rom_t {
+    const byte *cur;
+    const byte *top;
+    void *owner;
+} mpy_rom_t;
+
+STATIC mp_uint_t mpy_rom_readbyte(void *data) {
+    mpy_rom_t *rom = data;
+    if (rom->cur < rom->top) {
+        return *rom->cur++;
+    } else {
+        return MP_READER_EOF;
+    }
+}
+
+STATIC void mpy_rom_close(void *data) {
+    (void)data;
+}
+
+STATIC const byte *skip_bytes(mpy_rom_t *rom, size_t len) {
+    if (len > (size_t)(rom->top - rom->cur)) {
+        raise_corrupt_mpy();
+    }
+    const byte *start = rom->cur;
+    rom->cur += len;
+    return start;
+}
+
+STATIC void skip_qstr(mp_reader_t *reader) {
+    skip_bytes(reader->data, read_uint(reader));
+}
+
+// Skip over a raw code and all its children, returning its scope flags.
+STATIC uint skip_raw_code(mp_reader_t *reader) {
+    size_t bc_len = read_uint(reader);
+    const byte *bytecode = skip_bytes(reader->data, bc_len);
+
+    const byte *ip = bytecode;
+    const byte *ip2;
+    bytecode_prelude_t prelude;
+    extract_prelude(&ip, &ip2, &prelude);
+
+    skip_qstr(reader); // simple_name
+    skip_qstr(reader); // source_file
+    for (const byte *ip_top = bytecode + bc_len; ip < ip_top;) {
+        size_t sz;
+        uint f = mp_opcode_format(ip, &sz);
+        if (f == MP_OPCODE_QSTR) {
+            skip_qstr(reader);
+        }
+        ip += sz;
+    }
+
+    size_t n_obj = read_uint(reader);
+    size_t n_raw_code = read_uint(reader);
+    for (size_t i = 0; i < prelude.n_pos_args + prelude.n_kwonly_args; ++i) {
+        skip_qstr(reader);
+    }
+    for (size_t i = 0; i < n_obj; ++i) {
+        if (read_byte(reader) != 'e') {
+            skip_bytes(reader->data, read_uint(reader));
+        }
+    }
+    for (size_t i = 0; i < n_raw_code; ++i) {
+        skip_raw_code(reader);
+    }
+    return prelude.scope_flags;
+}
+
+// Make a raw code that refers to the next one in the image, to be loaded
+// by mp_raw_code_load_lazy when a function made from it is first called.
+STATIC mp_raw_code_t *new_lazy_raw_code(mp_reader_t *reader) {
+    mpy_rom_t *rom = reader->data;
+    const byte *mpy = rom->cur;
+    uint scope_flags = skip_raw_code(reader);
+    mp_raw_code_t *rc = mp_emit_glue_new_raw_code();
+    rc->kind = MP_CODE_BYTECODE_LAZY;
+    rc->scope_flags = scope_flags;
+    rc->data.u_lazy.mpy = mpy;
+    rc->data.u_lazy.mpy_top = rom->top;
+    rc->data.u_lazy.owner = rom->owner;
+    rc->data.u_lazy.loaded = NULL;
+    return rc;
+}
+
+#endif // MICROPY_PERSISTENT_CODE_LOAD_LAZY
+
 STATIC mp_raw_code_t *load_raw_code(mp_reader_t *reader) {
     // load bytecode
     size_t bc_len = read_uint(reader);
@@ -212,6 +308,12 @@ STATIC mp_raw_code_t *load_raw_code(mp_reader_t *reader) {
         *ct++ = (mp_uint_t)load_obj(reader);
     }
     for (size_t i = 0; i < n_raw_code; ++i) {
+        #if MICROPY_PERSISTENT_CODE_LOAD_LAZY
+        if (reader->readbyte == mpy_rom_readbyte) {
+            *ct++ = (mp_uint_t)(uintptr_t)new_lazy_raw_code(reader);
+            continue;
+        }
+        #endif
         *ct++ = (mp_uint_t)(uintptr_t)load_raw_code(reader);
     }
 
@@ -229,13 +331,18 @@ STATIC mp_raw_code_t *load_raw_code(mp_reader_t *reader) {
     return rc;
 }
 
+STATIC bool mpy_header_is_compatible(const byte *header) {
+    return header[0] == 'M'
+        && header[1] == MPY_VERSION
+        && ((header[2] ^ MPY_FEATURE_FLAGS) & ~MPY_FEATURE_FLAG_SUPERINSTRUCTIONS) == 0
+        && (header[2] & ~MPY_FEATURE_FLAGS) == 0
+        && header[3] <= mp_small_int_bits();
+}
+
 mp_raw_code_t *mp_raw_code_load(mp_reader_t *reader) {
     byte header[4];
     read_bytes(reader, header, sizeof(header));
-    if (header[0] != 'M'
-        || header[1] != MPY_VERSION
-        || header[2] != MPY_FEATURE_FLAGS
-        || header[3] > mp_small_int_bits()) {
+    if (!mpy_header_is_compatible(header)) {
         mp_raise_MpyError(translate("Incompatible .mpy file. Please update all .mpy files. See http://adafru.it/mpy-update for more info."));
     }
     mp_raw_code_t *rc = load_raw_code(reader);
@@ -249,12 +356,184 @@ mp_raw_code_t *mp_raw_code_load_mem(const byte *buf, size_t len) {
     return mp_raw_code_load(&reader);
 }
 
+#if MICROPY_PERSISTENT_CODE_LOAD_LAZY
+
+mp_raw_code_t *mp_raw_code_load_rom(const byte *buf, size_t len, void *owner) {
+    mpy_rom_t rom = {buf, buf + len, owner};
+    mp_reader_t reader = {&rom, mpy_rom_readbyte, mpy_rom_close};
+    return mp_raw_code_load(&reader);
+}
+
+#if MICROPY_PY_THREAD
+#define LAZY_ENTER() mp_thread_mutex_lock(&MP_STATE_VM(lazy_load_mutex), 1)
+#define LAZY_EXIT() mp_thread_mutex_unlock(&MP_STATE_VM(lazy_load_mutex))
+#else
+#define LAZY_ENTER()
+#define LAZY_EXIT()
+#endif
+
+// Return the loaded version of a lazy raw code, loading it if this is the
+// first time.  The lazy raw code itself is never changed other than to point
+// to the loaded one, so threads can share it without taking the lock once it
+// is loaded.
+// lazy_load_mutex must be taken while in this function
+STATIC mp_raw_code_t *load_lazy(mp_raw_code_t *rc) {
+    mp_raw_code_t *loaded = rc->data.u_lazy.loaded;
+    if (loaded == NULL) {
+        mpy_rom_t rom = {rc->data.u_lazy.mpy, rc->data.u_lazy.mpy_top, rc->data.u_lazy.owner};
+        mp_reader_t reader = {&rom, mpy_rom_readbyte, mpy_rom_close};
+        loaded = load_raw_code(&reader);
+        MP_THREAD_STORE_FENCE();
+        rc->data.u_lazy.loaded = loaded;
+    }
+    return loaded;
+}
+
+mp_raw_code_t *mp_raw_code_load_lazy(mp_raw_code_t *rc) {
+    mp_raw_code_t *loaded = rc->data.u_lazy.loaded;
+    if (loaded != NULL) {
+        return loaded;
+    }
+    LAZY_ENTER();
+    nlr_buf_t nlr;
+    if (nlr_push(&nlr) != 0) {
+        LAZY_EXIT();
+        nlr_jump(nlr.ret_val);
+    }
+    loaded = load_lazy(rc);
+    nlr_pop();
+    LAZY_EXIT();
+    return loaded;
+}
+
+void mp_raw_code_load_lazy_fun(const byte **bytecode, const mp_uint_t **const_table) {
+    LAZY_ENTER();
+    nlr_buf_t nlr;
+    if (nlr_push(&nlr) != 0) {
+        LAZY_EXIT();
+        nlr_jump(nlr.ret_val);
+    }
+    // another thread may have loaded it while this one waited for the lock
+    if (*bytecode == NULL) {
+        mp_raw_code_t *rc = load_lazy((mp_raw_code_t*)*const_table);
+        *const_table = rc->data.u_byte.const_table;
+        // a thread that sees the bytecode set must see the const_table too
+        MP_THREAD_STORE_FENCE();
+        *bytecode = rc->data.u_byte.bytecode;
+    }
+    nlr_pop();
+    LAZY_EXIT();
+}
+
+#endif
+
 mp_raw_code_t *mp_raw_code_load_file(const char *filename) {
+    #if MICROPY_READER_MAP_FILE
+    const byte *buf;
+    size_t len;
+    void *owner = mp_reader_map_file(filename, &buf, &len);
+    if (owner != NULL) {
+        return mp_raw_code_load_rom(buf, len, owner);
+    }
+    #endif
     mp_reader_t reader;
     mp_reader_new_file(&reader, filename);
     return mp_raw_code_load(&reader);
 }
 
+#if MICROPY_PERSISTENT_CODE_CACHE
+
+#include "py/lexer.h"
+#include "py/mpstate.h"
+
+// A cache file holds the key of the source it was compiled from, followed by
+// the .mpy data.  The key is the length of the source, the optimisation level
+// and emitter options it was compiled with, and a 64-bit FNV-1a hash of its
+// name and contents: file times can't be used because boards without an RTC
+// give every file the same one.
+STATIC void compute_cache_key(const char *source_file, const byte *source, size_t len, uint emit_opt, byte *key) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (const char *s = source_file; *s != '\0'; s++) {
+        hash = (hash ^ (byte)*s) * 0x100000001b3ULL;
+    }
+    for (size_t i = 0; i < len; i++) {
+        hash = (hash ^ source[i]) * 0x100000001b3ULL;
+    }
+    for (int i = 0; i < 4; i++) {
+        key[i] = (uint32_t)len >> (8 * i);
+    }
+    key[4] = MP_STATE_VM(mp_optimise_value);
+    key[5] = emit_opt;
+    for (int i = 0; i < 8; i++) {
+        key[6 + i] = hash >> (8 * i);
+    }
+}
+
+// Check that the cache file starts with the given key and a compatible .mpy
+// header, leaving the reader positioned after the header.
+STATIC bool read_cache_header(mp_reader_t *reader, const byte *key) {
+    byte header[MP_RAW_CODE_CACHE_KEY_LEN + 4];
+    for (size_t i = 0; i < sizeof(header); i++) {
+        mp_uint_t b = reader->readbyte(reader->data);
+        if (b == MP_READER_EOF) {
+            return false;
+        }
+        header[i] = b;
+    }
+    return memcmp(header, key, MP_RAW_CODE_CACHE_KEY_LEN) == 0
+        && mpy_header_is_compatible(header + MP_RAW_CODE_CACHE_KEY_LEN);
+}
+
+mp_raw_code_t *mp_raw_code_load_cached(const char *source_file, const byte *source, size_t source_len, uint emit_opt, byte *key) {
+    compute_cache_key(source_file, source, source_len, emit_opt, key);
+
+    size_t len = strlen(source_file);
+    char cache_file[len + 2];
+    memcpy(cache_file, source_file, len);
+    cache_file[len] = 'c';
+    cache_file[len + 1] = '\0';
+    if (mp_import_stat(cache_file) != MP_IMPORT_STAT_FILE) {
+        return NULL;
+    }
+
+    mp_reader_t reader;
+    mp_reader_new_file(&reader, cache_file);
+    if (!read_cache_header(&reader, key)) {
+        reader.close(reader.data);
+        return NULL;
+    }
+
+    // A stale or damaged cache file is not an error, the source is just
+    // compiled again.
+    mp_raw_code_t *rc = NULL;
+    nlr_buf_t nlr;
+    #if MICROPY_READER_MAP_FILE
+    // The cache file is only ever replaced by renaming a new file over it, so
+    // it can be mapped and its functions loaded lazily like a .mpy file.
+    reader.close(reader.data);
+    const byte *buf;
+    size_t map_len;
+    void *owner = mp_reader_map_file(cache_file, &buf, &map_len);
+    if (owner == NULL || map_len < MP_RAW_CODE_CACHE_KEY_LEN
+        || memcmp(buf, key, MP_RAW_CODE_CACHE_KEY_LEN) != 0) {
+        return NULL;
+    }
+    if (nlr_push(&nlr) == 0) {
+        rc = mp_raw_code_load_rom(buf + MP_RAW_CODE_CACHE_KEY_LEN, map_len - MP_RAW_CODE_CACHE_KEY_LEN, owner);
+        nlr_pop();
+    }
+    #else
+    if (nlr_push(&nlr) == 0) {
+        rc = load_raw_code(&reader);
+        nlr_pop();
+    }
+    reader.close(reader.data);
+    #endif
+    return rc;
+}
+
+#endif // MICROPY_PERSISTENT_CODE_CACHE
+
 #endif // MICROPY_PERSISTENT_CODE_LOAD
 
 #if MICROPY_PERSISTENT_CODE_SAVE
@@ -338,6 +617,11 @@ STATIC void save_bytecode_qstrs(mp_print_t *print, const byte *ip, const byte *i
 }
 
 STATIC void save_raw_code(mp_print_t *print, mp_raw_code_t *rc) {
+    #if MICROPY_PERSISTENT_CODE_LOAD_LAZY
+    if (rc->kind == MP_CODE_BYTECODE_LAZY) {
+        rc = mp_raw_code_load_lazy(rc);
+    }
+    #endif
     if (rc->kind != MP_CODE_BYTECODE) {
         mp_raise_ValueError(translate("can only save bytecode"));
     }
@@ -394,7 +678,43 @@ void mp_raw_code_save(mp_raw_code_t *rc, mp_print_t *print) {
 // here we define mp_raw_code_save_file depending on the port
 // TODO abstract this away properly
 
-#if defined(__i386__) || defined(__x86_64__) || defined(__unix__)
+#if MICROPY_VFS
+
+#include "py/stream.h"
+#include "extmod/vfs.h"
+
+STATIC mp_obj_t vfs_open_wb(const char *filename) {
+    mp_obj_t args[2] = {
+        mp_obj_new_str(filename, strlen(filename)),
+        MP_OBJ_NEW_QSTR(MP_QSTR_wb),
+    };
+    return mp_vfs_open(MP_ARRAY_SIZE(args), args, (mp_map_t*)&mp_const_empty_map);
+}
+
+STATIC void vfs_print_strn(void *env, const char *str, size_t len) {
+    int errcode;
+    mp_stream_write_exactly(MP_OBJ_FROM_PTR(env), str, len, &errcode);
+}
+
+void mp_raw_code_save_file(mp_raw_code_t *rc, const char *filename) {
+    mp_obj_t file = vfs_open_wb(filename);
+    mp_print_t vfs_print = {MP_OBJ_TO_PTR(file), vfs_print_strn};
+    mp_raw_code_save(rc, &vfs_print);
+    mp_stream_close(file);
+}
+
+#if MICROPY_PERSISTENT_CODE_CACHE
+// A partly written cache file is rejected when it is loaded, so it can be
+// written in place.  This raises if the filesystem is read-only.
+STATIC void write_cache_file(const char *filename, const vstr_t *data) {
+    mp_obj_t file = vfs_open_wb(filename);
+    int errcode;
+    mp_stream_write_exactly(file, data->buf, data->len, &errcode);
+    mp_stream_close(file);
+}
+#endif
+
+#elif defined(__i386__) || defined(__x86_64__) || defined(__unix__)
 
 #include <unistd.h>
 #include <sys/stat.h>
@@ -413,8 +733,52 @@ void mp_raw_code_save_file(mp_raw_code_t *rc, const char *filename) {
     close(fd);
 }
 
+#if MICROPY_PERSISTENT_CODE_CACHE
+// The data is written to a temporary file which is then renamed over the
+// cache file, so a cache file is never changed while it may be mapped.
+STATIC void write_cache_file(const char *filename, const vstr_t *data) {
+    char tmp_file[strlen(filename) + 12];
+    snprintf(tmp_file, sizeof(tmp_file), "%s.%u", filename, (unsigned)getpid());
+    int fd = open(tmp_file, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        return;
+    }
+    bool ok = write(fd, data->buf, data->len) == (ssize_t)data->len;
+    close(fd);
+    if (!ok || rename(tmp_file, filename) != 0) {
+        unlink(tmp_file);
+    }
+}
+#endif
+
 #else
 #error mp_raw_code_save_file not implemented for this platform
 #endif
 
+#if MICROPY_PERSISTENT_CODE_CACHE
+
+void mp_raw_code_save_cached(mp_raw_code_t *rc, const char *source_file, const byte *key) {
+    size_t len = strlen(source_file);
+    char cache_file[len + 2];
+    memcpy(cache_file, source_file, len);
+    cache_file[len] = 'c';
+    cache_file[len + 1] = '\0';
+
+    // Not being able to save the code, eg because it has native functions or
+    // the filesystem is read-only, just means it isn't cached.
+    nlr_buf_t nlr;
+    if (nlr_push(&nlr) == 0) {
+        vstr_t vstr;
+        mp_print_t print;
+        vstr_init_print(&vstr, 256, &print);
+        vstr_add_strn(&vstr, (const char*)key, MP_RAW_CODE_CACHE_KEY_LEN);
+        mp_raw_code_save(rc, &print);
+        write_cache_file(cache_file, &vstr);
+        vstr_clear(&vstr);
+        nlr_pop();
+    }
+}
+
+#endif // MICROPY_PERSISTENT_CODE_CACHE
+
 #endif // MICROPY_PERSISTENT_CODE_SAVE
@@ -34,7 +34,26 @@ mp_raw_code_t *mp_raw_code_load(mp_reader_t *reader);
 mp_raw_code_t *mp_raw_code_load_mem(const byte *buf, size_t len);
 mp_raw_code_t *mp_raw_code_load_file(const char *filename);
 
+#if MICROPY_PERSISTENT_CODE_LOAD_LAZY
+// buf must stay valid and unchanged for as long as owner, a heap object that
+// the lazily loaded raw code refers to, is alive
+mp_raw_code_t *mp_raw_code_load_rom(const byte *buf, size_t len, void *owner);
+mp_raw_code_t *mp_raw_code_load_lazy(mp_raw_code_t *rc);
+// Load the bytecode and const_table of a function made from a lazy raw code,
+// which are NULL and the raw code until then.
+void mp_raw_code_load_lazy_fun(const byte **bytecode, const mp_uint_t **const_table);
+#endif
+
 void mp_raw_code_save(mp_raw_code_t *rc, mp_print_t *print);
 void mp_raw_code_save_file(mp_raw_code_t *rc, const char *filename);
 
+#if MICROPY_PERSISTENT_CODE_CACHE
+// A key identifies the name and contents of a source file and how it is
+// compiled.  The load function fills in the key from the given contents of the
+// source file and returns the cached code if its key matches, else NULL.
+#define MP_RAW_CODE_CACHE_KEY_LEN (14)
+mp_raw_code_t *mp_raw_code_load_cached(const char *source_file, const byte *source, size_t source_len, uint emit_opt, byte *key);
+void mp_raw_code_save_cached(mp_raw_code_t *rc, const char *source_file, const byte *key);
+#endif
+
 #endif // MICROPY_INCLUDED_PY_PERSISTENTCODE_H
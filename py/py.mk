@@ -165,6 +165,7 @@ PY_CORE_O_BASENAME = $(addprefix py/,\
 	parsenumbase.o \
 	parsenum.o \
 	emitglue.o \
+	emitjit.o \
 	persistentcode.o \
 	runtime.o \
 	runtime_utils.o \
@@ -248,6 +249,7 @@ PY_EXTMOD_O_BASENAME = \
 	extmod/moduzlib.o \
 	extmod/moduheapq.o \
 	extmod/modutimeq.o \
+	extmod/moduevent.o \
 	extmod/moduhashlib.o \
 	extmod/modubinascii.o \
 	extmod/virtpin.o \
@@ -33,8 +33,8 @@
 #include "py/qstr.h"
 #include "py/gc.h"
 
-// NOTE: we are using linear arrays to store and search for qstr's (unique strings, interned strings)
-// ultimately we will replace this with a static hash table of some kind
+// NOTE: we are using linear arrays to store qstr's (unique strings, interned strings)
+// and, unless MICROPY_QSTR_HASH_INDEX is enabled, to search for them
 // also probably need to include the length in the string data, to allow null bytes in the string
 
 #if MICROPY_DEBUG_VERBOSE // print debugging info
@@ -61,6 +61,11 @@
 #else
     #error unimplemented qstr hash decoding
 #endif
+
+#if MICROPY_QSTR_HASH_INDEX && MICROPY_QSTR_BYTES_IN_HASH < 2
+    #error MICROPY_QSTR_HASH_INDEX requires MICROPY_QSTR_BYTES_IN_HASH of at least 2
+#endif
+
 #define Q_GET_ALLOC(q)  (MICROPY_QSTR_BYTES_IN_HASH + MICROPY_QSTR_BYTES_IN_LEN + Q_GET_LENGTH(q) + 1)
 #define Q_GET_DATA(q)   ((q) + MICROPY_QSTR_BYTES_IN_HASH + MICROPY_QSTR_BYTES_IN_LEN)
 #if MICROPY_QSTR_BYTES_IN_LEN == 1
@@ -105,13 +110,31 @@ const qstr_pool_t mp_qstr_const_pool = {
 #ifndef NO_QSTR
 #define QDEF(id, str) str,
 #define TRANSLATION(id, length, compressed...)
+#define QHASHINDEX(size, index...)
 #include "genhdr/qstrdefs.generated.h"
+#undef QHASHINDEX
 #undef TRANSLATION
 #undef QDEF
 #endif
     },
 };
 
+#if MICROPY_QSTR_HASH_INDEX
+// index of mp_qstr_const_pool generated by makeqstrdata.py, laid out like
+// the table of a qstr_hash_index_t
+#ifndef NO_QSTR
+#define QDEF(id, str)
+#define TRANSLATION(id, length, compressed...)
+#define QHASHINDEX(size, index...) STATIC const uint16_t qstr_const_hash_index[size] = index;
+#include "genhdr/qstrdefs.generated.h"
+#undef QHASHINDEX
+#undef TRANSLATION
+#undef QDEF
+#else
+STATIC const uint16_t qstr_const_hash_index[1] = {0};
+#endif
+#endif
+
 #ifdef MICROPY_QSTR_EXTRA_POOL
 extern const qstr_pool_t MICROPY_QSTR_EXTRA_POOL;
 #define CONST_POOL MICROPY_QSTR_EXTRA_POOL
@@ -119,6 +142,67 @@ extern const qstr_pool_t MICROPY_QSTR_EXTRA_POOL;
 #define CONST_POOL mp_qstr_const_pool
 #endif
 
+STATIC const byte *find_qstr(qstr q) {
+    if (q < MP_QSTRnumber_of) {
+        // the const pool is always at the bottom of the chain
+        return mp_qstr_const_pool.qstrs[q];
+    }
+    // search pool for this qstr
+    // total_prev_len==0 in the final pool, so the loop will always terminate
+    qstr_pool_t *pool = MP_STATE_VM(last_pool);
+    while (q < pool->total_prev_len) {
+        pool = pool->prev;
+    }
+    return pool->qstrs[q - pool->total_prev_len];
+}
+
+#if MICROPY_QSTR_HASH_INDEX
+STATIC void qstr_hash_index_insert(qstr_hash_index_t *index, qstr q) {
+    size_t mask = index->alloc - 1;
+    size_t i = Q_GET_HASH(find_qstr(q)) & mask;
+    while (index->table[i] != MP_QSTR_NULL) {
+        i = (i + 1) & mask;
+    }
+    index->table[i] = q;
+    index->used++;
+}
+
+// Make sure the heap index has room for one more qstr.  Growing it first means
+// a qstr is never added to a pool without also being indexed.
+// qstr_mutex must be taken while in this function
+STATIC void qstr_hash_index_reserve(void) {
+    qstr_hash_index_t *index = MP_STATE_VM(qstr_hash_index);
+    if (index != NULL && (index->used + 1) * 2 <= index->alloc) {
+        return;
+    }
+    size_t new_alloc = index == NULL ? MICROPY_QSTR_POOL_MAX_ENTRIES : index->alloc * 2;
+    qstr_hash_index_t *new_index = m_new_ll_obj_var_maybe(qstr_hash_index_t, qstr, new_alloc);
+    if (new_index == NULL) {
+        QSTR_EXIT();
+        m_malloc_fail(sizeof(qstr_hash_index_t) + new_alloc * sizeof(qstr));
+    }
+    new_index->alloc = new_alloc;
+    new_index->used = 0;
+    memset(new_index->table, 0, new_alloc * sizeof(qstr));
+    if (index != NULL) {
+        for (size_t i = 0; i < index->alloc; i++) {
+            if (index->table[i] != MP_QSTR_NULL) {
+                qstr_hash_index_insert(new_index, index->table[i]);
+            }
+        }
+    }
+    MP_STATE_VM(qstr_hash_index) = new_index;
+    #if !MICROPY_PY_THREAD
+    if (index != NULL) {
+        m_del_var(qstr_hash_index_t, qstr, index->alloc, index);
+    }
+    #else
+    // qstr_find_strn() doesn't take qstr_mutex, so another thread may still be
+    // reading the old index; leave it to the GC, which sees such references
+    #endif
+}
+#endif
+
 void qstr_init(void) {
     MP_STATE_VM(last_pool) = (qstr_pool_t*)&CONST_POOL; // we won't modify the const_pool since it has no allocated room left
     MP_STATE_VM(qstr_last_chunk) = NULL;
@@ -126,22 +210,31 @@ void qstr_init(void) {
     #if MICROPY_PY_THREAD
     mp_thread_mutex_init(&MP_STATE_VM(qstr_mutex));
     #endif
-}
 
-STATIC const byte *find_qstr(qstr q) {
-    // search pool for this qstr
-    // total_prev_len==0 in the final pool, so the loop will always terminate
-    qstr_pool_t *pool = MP_STATE_VM(last_pool);
-    while (q < pool->total_prev_len) {
-        pool = pool->prev;
+    #if MICROPY_OPT_STR_CHAR_CACHE
+    memset(MP_STATE_VM(str_char_cache), 0, sizeof(MP_STATE_VM(str_char_cache)));
+    #endif
+
+    #if MICROPY_QSTR_HASH_INDEX
+    // index any extra ROM pools, such as that of frozen bytecode
+    MP_STATE_VM(qstr_hash_index) = NULL;
+    for (const qstr_pool_t *pool = &CONST_POOL; pool != &mp_qstr_const_pool; pool = pool->prev) {
+        for (size_t i = 0; i < pool->len; i++) {
+            qstr_hash_index_reserve();
+            qstr_hash_index_insert(MP_STATE_VM(qstr_hash_index), pool->total_prev_len + i);
+        }
     }
-    return pool->qstrs[q - pool->total_prev_len];
+    #endif
 }
 
 // qstr_mutex must be taken while in this function
 STATIC qstr qstr_add(const byte *q_ptr) {
     DEBUG_printf("QSTR: add hash=%d len=%d data=%.*s\n", Q_GET_HASH(q_ptr), Q_GET_LENGTH(q_ptr), Q_GET_LENGTH(q_ptr), Q_GET_DATA(q_ptr));
 
+    #if MICROPY_QSTR_HASH_INDEX
+    qstr_hash_index_reserve();
+    #endif
+
     // make sure we have room in the pool for a new qstr
     if (MP_STATE_VM(last_pool)->len >= MP_STATE_VM(last_pool)->alloc) {
         uint32_t new_pool_length = MP_STATE_VM(last_pool)->alloc * 2;
@@ -163,15 +256,42 @@ STATIC qstr qstr_add(const byte *q_ptr) {
 
     // add the new qstr
     MP_STATE_VM(last_pool)->qstrs[MP_STATE_VM(last_pool)->len++] = q_ptr;
+    qstr q = MP_STATE_VM(last_pool)->total_prev_len + MP_STATE_VM(last_pool)->len - 1;
+
+    #if MICROPY_QSTR_HASH_INDEX
+    qstr_hash_index_insert(MP_STATE_VM(qstr_hash_index), q);
+    #endif
 
     // return id for the newly-added qstr
-    return MP_STATE_VM(last_pool)->total_prev_len + MP_STATE_VM(last_pool)->len - 1;
+    return q;
 }
 
 qstr qstr_find_strn(const char *str, size_t str_len) {
     // work out hash of str
     mp_uint_t str_hash = qstr_compute_hash((const byte*)str, str_len);
 
+    #if MICROPY_QSTR_HASH_INDEX
+    // look in the const pool
+    size_t mask = MP_ARRAY_SIZE(qstr_const_hash_index) - 1;
+    for (size_t i = str_hash & mask; qstr_const_hash_index[i] != MP_QSTR_NULL; i = (i + 1) & mask) {
+        const byte *q = mp_qstr_const_pool.qstrs[qstr_const_hash_index[i]];
+        if (Q_GET_HASH(q) == str_hash && Q_GET_LENGTH(q) == str_len && memcmp(Q_GET_DATA(q), str, str_len) == 0) {
+            return qstr_const_hash_index[i];
+        }
+    }
+
+    // look in all the other pools
+    qstr_hash_index_t *index = MP_STATE_VM(qstr_hash_index);
+    if (index != NULL) {
+        mask = index->alloc - 1;
+        for (size_t i = str_hash & mask; index->table[i] != MP_QSTR_NULL; i = (i + 1) & mask) {
+            const byte *q = find_qstr(index->table[i]);
+            if (Q_GET_HASH(q) == str_hash && Q_GET_LENGTH(q) == str_len && memcmp(Q_GET_DATA(q), str, str_len) == 0) {
+                return index->table[i];
+            }
+        }
+    }
+    #else
     // search pools for the data
     for (qstr_pool_t *pool = MP_STATE_VM(last_pool); pool != NULL; pool = pool->prev) {
         for (const byte **q = pool->qstrs, **q_top = pool->qstrs + pool->len; q < q_top; q++) {
@@ -180,6 +300,7 @@ qstr qstr_find_strn(const char *str, size_t str_len) {
             }
         }
     }
+    #endif
 
     // not found; return null qstr
     return 0;
@@ -55,6 +55,16 @@ typedef struct _qstr_pool_t {
     const byte *qstrs[];
 } qstr_pool_t;
 
+#if MICROPY_QSTR_HASH_INDEX
+// Open addressing table from qstr hash to qstr, kept at most half full.
+// alloc is a power of 2 and empty slots hold MP_QSTR_NULL.
+typedef struct _qstr_hash_index_t {
+    size_t alloc;
+    size_t used;
+    qstr table[];
+} qstr_hash_index_t;
+#endif
+
 #define QSTR_FROM_STR_STATIC(s) (qstr_from_strn((s), strlen(s)))
 #define QSTR_TOTAL() (MP_STATE_VM(last_pool)->total_prev_len + MP_STATE_VM(last_pool)->len)
 
@@ -124,6 +124,66 @@ void mp_reader_new_file_from_fd(mp_reader_t *reader, int fd, bool close_fd) {
     reader->close = mp_reader_posix_close;
 }
 
+// With a VFS, filenames are resolved by the VFS so can't be mapped directly.
+#if MICROPY_READER_MAP_FILE
+
+#include <sys/mman.h>
+
+typedef struct _mp_reader_map_t {
+    mp_obj_base_t base;
+    void *buf;
+    size_t len;
+} mp_reader_map_t;
+
+STATIC mp_obj_t mp_reader_map_del(mp_obj_t self_in) {
+    mp_reader_map_t *self = MP_OBJ_TO_PTR(self_in);
+    munmap(self->buf, self->len);
+    return mp_const_none;
+}
+STATIC MP_DEFINE_CONST_FUN_OBJ_1(mp_reader_map_del_obj, mp_reader_map_del);
+
+STATIC const mp_rom_map_elem_t mp_reader_map_locals_dict_table[] = {
+    { MP_ROM_QSTR(MP_QSTR___del__), MP_ROM_PTR(&mp_reader_map_del_obj) },
+};
+STATIC MP_DEFINE_CONST_DICT(mp_reader_map_locals_dict, mp_reader_map_locals_dict_table);
+
+STATIC const mp_obj_type_t mp_type_reader_map = {
+    { &mp_type_type },
+    .name = MP_QSTR_mmap,
+    .locals_dict = (mp_obj_dict_t*)&mp_reader_map_locals_dict,
+};
+
+// Map the given file read-only into memory, returning NULL if that's not
+// possible.  Otherwise return an object that owns the mapping, which is
+// removed when the object is collected.
+void *mp_reader_map_file(const char *filename, const byte **buf, size_t *len) {
+    // allocate the owner first so a MemoryError can't leak the mapping; it
+    // has no finaliser to run until it has a type
+    mp_reader_map_t *self = m_new_obj_with_finaliser(mp_reader_map_t);
+    self->base.type = NULL;
+    int fd = open(filename, O_RDONLY, 0644);
+    if (fd < 0) {
+        return NULL;
+    }
+    struct stat st;
+    void *map = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    close(fd);
+    if (map == MAP_FAILED) {
+        return NULL;
+    }
+    self->base.type = &mp_type_reader_map;
+    self->buf = map;
+    self->len = st.st_size;
+    *buf = map;
+    *len = st.st_size;
+    return self;
+}
+
+#endif
+
 #if !MICROPY_VFS_POSIX
 // If MICROPY_VFS_POSIX is defined then this function is provided by the VFS layer
 void mp_reader_new_file(mp_reader_t *reader, const char *filename) {
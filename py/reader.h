@@ -43,4 +43,11 @@ void mp_reader_new_mem(mp_reader_t *reader, const byte *buf, size_t len, size_t
 void mp_reader_new_file(mp_reader_t *reader, const char *filename);
 void mp_reader_new_file_from_fd(mp_reader_t *reader, int fd, bool close_fd);
 
+// Whether a file can be mapped into memory for its code to be loaded lazily.
+// The mapping is removed by the finaliser of the object that owns it.
+#define MICROPY_READER_MAP_FILE (MICROPY_PERSISTENT_CODE_LOAD_LAZY && MICROPY_READER_POSIX && !MICROPY_VFS && MICROPY_ENABLE_FINALISER)
+#if MICROPY_READER_MAP_FILE
+void *mp_reader_map_file(const char *filename, const byte **buf, size_t *len);
+#endif
+
 #endif // MICROPY_INCLUDED_PY_READER_H
@@ -69,6 +69,11 @@ void mp_init(void) {
     #if MICROPY_ENABLE_SCHEDULER
     MP_STATE_VM(sched_state) = MP_SCHED_IDLE;
     MP_STATE_VM(sched_sp) = 0;
+    MP_STATE_VM(sched_queue) = MP_STATE_VM(sched_stack);
+    MP_STATE_VM(sched_depth) = MICROPY_SCHEDULER_DEPTH;
+    #if MICROPY_SCHEDULER_LATENCY
+    memset(MP_STATE_VM(sched_latency), 0, sizeof(MP_STATE_VM(sched_latency)));
+    #endif
     #endif
 
 #if MICROPY_ENABLE_EMERGENCY_EXCEPTION_BUF
@@ -100,6 +105,14 @@ void mp_init(void) {
     MP_STATE_VM(mp_optimise_value) = 0;
     #endif
 
+    #if MICROPY_OPT_CLASS_LOOKUP_CACHE
+    mp_class_lookup_cache_init();
+    #endif
+
+    #if MICROPY_OPT_STR_UNICODE_INDEX
+    mp_str_index_cache_init();
+    #endif
+
     // init global module dict
     mp_obj_dict_init(&MP_STATE_VM(mp_loaded_modules_dict), 3);
 
@@ -116,6 +129,15 @@ void mp_init(void) {
     MP_STATE_VM(mp_module_builtins_override_dict) = NULL;
     #endif
 
+    #if MICROPY_EMIT_NATIVE_JIT
+    // the heap may have been reset, so forget what was compiled on it
+    memset(MP_STATE_VM(jit_cache), 0, sizeof(MP_STATE_VM(jit_cache)));
+    #endif
+
+    #if MICROPY_VFS && MICROPY_VFS_IMPORT_STAT_CACHE
+    mp_vfs_import_stat_cache_clear();
+    #endif
+
     #if MICROPY_PY_OS_DUPTERM
     for (size_t i = 0; i < MICROPY_PY_OS_DUPTERM; ++i) {
         MP_STATE_VM(dupterm_objs[i]) = MP_OBJ_NULL;
@@ -133,6 +155,20 @@ void mp_init(void) {
     mp_thread_mutex_init(&MP_STATE_VM(gil_mutex));
     #endif
 
+    #if MICROPY_PY_THREAD && MICROPY_PERSISTENT_CODE_LOAD_LAZY
+    mp_thread_mutex_init(&MP_STATE_VM(lazy_load_mutex));
+    #endif
+
+    #if MICROPY_PY_THREAD_OBJ_LOCK
+    for (size_t i = 0; i < MICROPY_PY_THREAD_OBJ_LOCK_NUM; i++) {
+        mp_thread_mutex_init(&MP_STATE_VM(obj_lock)[i].mutex);
+        MP_STATE_VM(obj_lock)[i].owner = NULL;
+        MP_STATE_VM(obj_lock)[i].depth = 0;
+    }
+    MP_STATE_VM(obj_lock_enabled) = false;
+    MP_STATE_THREAD(obj_lock_depth) = 0;
+    #endif
+
     MP_THREAD_GIL_ENTER();
 }
 
@@ -619,6 +655,11 @@ mp_obj_t mp_call_function_n_kw(mp_obj_t fun_in, size_t n_args, size_t n_kw, cons
 
     // do the call
     if (type->call != NULL) {
+        #if MICROPY_PY_THREAD_OBJ_LOCK
+        if (MP_STATE_VM(obj_lock_enabled) && MP_STATE_THREAD(obj_lock_depth) != 0) {
+            return mp_thread_obj_call_unlocked(fun_in, n_args, n_kw, args);
+        }
+        #endif
         return type->call(fun_in, n_args, n_kw, args);
     }
 
@@ -889,7 +930,8 @@ void mp_unpack_ex(mp_obj_t seq_in, size_t num_in, mp_obj_t *items) {
         // items destination array, then the rest to a dynamically created list.  Once the
         // iterable is exhausted, we take from this list for the right part of the items.
         // TODO Improve to waste less memory in the dynamically created list.
-        mp_obj_t iterable = mp_getiter(seq_in, NULL);
+        mp_obj_iter_buf_t iter_buf;
+        mp_obj_t iterable = mp_getiter(seq_in, &iter_buf);
         mp_obj_t item;
         for (seq_len = 0; seq_len < num_left; seq_len++) {
             item = mp_iternext(iterable);
@@ -1275,6 +1317,13 @@ mp_obj_t mp_iternext(mp_obj_t o_in) {
     }
 }
 
+// Finish an iternext with a value, without raising StopIteration.  The value
+// is what a generator gets from a yield from of the iterator; see mp_resume.
+mp_obj_t mp_make_stop_iteration(mp_obj_t o) {
+    MP_STATE_THREAD(stop_iteration_arg) = o;
+    return MP_OBJ_STOP_ITERATION;
+}
+
 // TODO: Unclear what to do with StopIterarion exception here.
 mp_vm_return_kind_t mp_resume(mp_obj_t self_in, mp_obj_t send_value, mp_obj_t throw_value, mp_obj_t *ret_val) {
     assert((send_value != MP_OBJ_NULL) ^ (throw_value != MP_OBJ_NULL));
@@ -1285,6 +1334,7 @@ mp_vm_return_kind_t mp_resume(mp_obj_t self_in, mp_obj_t send_value, mp_obj_t th
     }
 
     if (type->iternext != NULL && send_value == mp_const_none) {
+        MP_STATE_THREAD(stop_iteration_arg) = MP_OBJ_NULL;
         mp_obj_t ret = type->iternext(self_in);
         *ret_val = ret;
         if (ret != MP_OBJ_STOP_ITERATION) {
@@ -1292,6 +1342,10 @@ mp_vm_return_kind_t mp_resume(mp_obj_t self_in, mp_obj_t send_value, mp_obj_t th
         } else {
             // Emulate raise StopIteration()
             // Special case, handled in vm.c
+            if (MP_STATE_THREAD(stop_iteration_arg) != MP_OBJ_NULL) {
+                *ret_val = MP_STATE_THREAD(stop_iteration_arg);
+                MP_STATE_THREAD(stop_iteration_arg) = MP_OBJ_NULL;
+            }
             return MP_VM_RETURN_NORMAL;
         }
     }
@@ -1473,9 +1527,18 @@ mp_obj_t mp_parse_compile_execute(mp_lexer_t *lex, mp_parse_input_kind_t parse_i
 
     nlr_buf_t nlr;
     if (nlr_push(&nlr) == 0) {
-        qstr source_name = lex->source_name;
-        mp_parse_tree_t parse_tree = mp_parse(lex, parse_input_kind);
-        mp_obj_t module_fun = mp_compile(&parse_tree, source_name, MP_EMIT_OPT_NONE, false);
+        mp_obj_t module_fun;
+        #if MICROPY_COMP_STREAM
+        if (parse_input_kind == MP_PARSE_FILE_INPUT) {
+            mp_raw_code_t *rc = mp_compile_stream_to_raw_code(lex, MP_EMIT_OPT_NONE);
+            module_fun = mp_make_function_from_raw_code(rc, MP_OBJ_NULL, MP_OBJ_NULL);
+        } else
+        #endif
+        {
+            qstr source_name = lex->source_name;
+            mp_parse_tree_t parse_tree = mp_parse(lex, parse_input_kind);
+            module_fun = mp_compile(&parse_tree, source_name, MP_EMIT_OPT_NONE, false);
+        }
 
         mp_obj_t ret;
         if (MICROPY_PY_BUILTINS_COMPILE && globals == NULL) {
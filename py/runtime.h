@@ -72,6 +72,8 @@ void mp_sched_lock(void);
 void mp_sched_unlock(void);
 static inline unsigned int mp_sched_num_pending(void) { return MP_STATE_VM(sched_sp); }
 bool mp_sched_schedule(mp_obj_t function, mp_obj_t arg);
+bool mp_sched_schedule_priority(mp_obj_t function, mp_obj_t arg, uint8_t priority);
+bool mp_sched_set_depth(size_t depth);
 #endif
 
 // extra printing method specifically for mp_obj_t's which are integral type
@@ -112,6 +114,11 @@ mp_obj_t mp_call_method_self_n_kw(mp_obj_t meth, mp_obj_t self, size_t n_args, s
 mp_obj_t mp_call_function_1_protected(mp_obj_t fun, mp_obj_t arg);
 mp_obj_t mp_call_function_2_protected(mp_obj_t fun, mp_obj_t arg1, mp_obj_t arg2);
 
+#if MICROPY_PY_THREAD_OBJ_LOCK
+// Call fun without the object locks held by this thread (see modthread.c).
+mp_obj_t mp_thread_obj_call_unlocked(mp_obj_t fun, size_t n_args, size_t n_kw, const mp_obj_t *args);
+#endif
+
 typedef struct _mp_call_args_t {
     mp_obj_t fun;
     size_t n_args, n_kw, n_alloc;
@@ -140,6 +147,7 @@ void mp_store_attr(mp_obj_t base, qstr attr, mp_obj_t val);
 mp_obj_t mp_getiter(mp_obj_t o, mp_obj_iter_buf_t *iter_buf);
 mp_obj_t mp_iternext_allow_raise(mp_obj_t o); // may return MP_OBJ_STOP_ITERATION instead of raising StopIteration()
 mp_obj_t mp_iternext(mp_obj_t o); // will always return MP_OBJ_STOP_ITERATION instead of raising StopIteration(...)
+mp_obj_t mp_make_stop_iteration(mp_obj_t o);
 mp_vm_return_kind_t mp_resume(mp_obj_t self_in, mp_obj_t send_value, mp_obj_t throw_value, mp_obj_t *ret_val);
 
 mp_obj_t mp_make_raise_obj(mp_obj_t o);
@@ -183,6 +191,19 @@ mp_obj_t mp_convert_native_to_obj(mp_uint_t val, mp_uint_t type);
 mp_obj_t mp_native_call_function_n_kw(mp_obj_t fun_in, size_t n_args_kw, const mp_obj_t *args);
 void mp_native_raise(mp_obj_t o);
 
+#if MICROPY_PY_BUILTINS_FLOAT
+// viper keeps an unboxed float as the bits of its mp_float_t in a machine word
+static inline mp_uint_t mp_native_from_float(mp_float_t f) {
+    union { mp_float_t f; mp_uint_t u; } x = {.u = 0};
+    x.f = f;
+    return x.u;
+}
+static inline mp_float_t mp_native_to_float(mp_uint_t u) {
+    union { mp_float_t f; mp_uint_t u; } x = {.u = u};
+    return x.f;
+}
+#endif
+
 #define mp_sys_path (MP_OBJ_FROM_PTR(&MP_STATE_VM(mp_sys_path_obj)))
 #define mp_sys_argv (MP_OBJ_FROM_PTR(&MP_STATE_VM(mp_sys_argv_obj)))
 
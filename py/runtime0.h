@@ -33,6 +33,7 @@
 #define MP_SCOPE_FLAG_VARKEYWORDS  (0x02)
 #define MP_SCOPE_FLAG_GENERATOR    (0x04)
 #define MP_SCOPE_FLAG_DEFKWARGS    (0x08)
+#define MP_SCOPE_FLAG_NO_TRACEBACK (0x10)
 
 // types for native (viper) function signature
 #define MP_NATIVE_TYPE_OBJ  (0x00)
@@ -43,6 +44,8 @@
 #define MP_NATIVE_TYPE_PTR8 (0x05)
 #define MP_NATIVE_TYPE_PTR16 (0x06)
 #define MP_NATIVE_TYPE_PTR32 (0x07)
+#define MP_NATIVE_TYPE_FLOAT (0x08)
+#define MP_NATIVE_TYPE_PTR_F32 (0x09)
 
 typedef enum {
     // These ops may appear in the bytecode. Changing this group
@@ -193,6 +196,14 @@ typedef enum {
     MP_F_SETUP_CODE_STATE,
     MP_F_SMALL_INT_FLOOR_DIVIDE,
     MP_F_SMALL_INT_MODULO,
+    MP_F_NATIVE_YIELD_FROM,
+#if MICROPY_PY_BUILTINS_FLOAT
+    MP_F_NATIVE_FLOAT_BINARY_OP,
+    MP_F_NATIVE_FLOAT_CONVERT,
+#endif
+#if MICROPY_EMIT_NATIVE_JIT
+    MP_F_NATIVE_RAISE_UNBOUND_LOCAL,
+#endif
     MP_F_NUMBER_OF,
 } mp_fun_kind_t;
 
@@ -25,11 +25,31 @@
  */
 
 #include <stdio.h>
+#include <string.h>
 
 #include "py/runtime.h"
+#include "py/mphal.h"
+#include "py/smallint.h"
 
 #if MICROPY_ENABLE_SCHEDULER
 
+// The queue holds MP_STATE_VM(sched_sp) callbacks ordered by priority, lowest
+// first, with those of the same priority in reverse order of scheduling.  So
+// the next callback to run is always the last one.
+
+#if MICROPY_SCHEDULER_LATENCY
+STATIC void mp_sched_record_latency(mp_uint_t ticks_us) {
+    mp_uint_t dt = (mp_hal_ticks_us() - ticks_us) & (MICROPY_PY_UTIME_TICKS_PERIOD - 1);
+    // bucket i counts latencies of i bits, ie below 2**i microseconds
+    size_t i = 0;
+    while (dt != 0 && i < MICROPY_SCHEDULER_LATENCY_BUCKETS - 1) {
+        dt >>= 1;
+        ++i;
+    }
+    ++MP_STATE_VM(sched_latency)[i];
+}
+#endif
+
 // A variant of this is inlined in the VM at the pending exception check
 void mp_handle_pending(void) {
     if (MP_STATE_VM(sched_state) == MP_SCHED_PENDING) {
@@ -51,13 +71,19 @@ void mp_handle_pending(void) {
 // or by the VM's inlined version of that function.
 void mp_handle_pending_tail(mp_uint_t atomic_state) {
     MP_STATE_VM(sched_state) = MP_SCHED_LOCKED;
-    if (MP_STATE_VM(sched_sp) > 0) {
-        mp_sched_item_t item = MP_STATE_VM(sched_stack)[--MP_STATE_VM(sched_sp)];
+    // Run as many callbacks as are pending now, so a burst of them isn't spread
+    // over many branch points.  A callback that keeps scheduling itself still
+    // lets the VM continue in between.
+    for (size_t n = MP_STATE_VM(sched_sp); n > 0 && MP_STATE_VM(sched_sp) > 0; --n) {
+        mp_sched_item_t item = MP_STATE_VM(sched_queue)[--MP_STATE_VM(sched_sp)];
         MICROPY_END_ATOMIC_SECTION(atomic_state);
+        #if MICROPY_SCHEDULER_LATENCY
+        mp_sched_record_latency(item.ticks_us);
+        #endif
         mp_call_function_1_protected(item.func, item.arg);
-    } else {
-        MICROPY_END_ATOMIC_SECTION(atomic_state);
+        atomic_state = MICROPY_BEGIN_ATOMIC_SECTION();
     }
+    MICROPY_END_ATOMIC_SECTION(atomic_state);
     mp_sched_unlock();
 }
 
@@ -85,24 +111,86 @@ void mp_sched_unlock(void) {
 }
 
 bool mp_sched_schedule(mp_obj_t function, mp_obj_t arg) {
+    return mp_sched_schedule_priority(function, arg, 0);
+}
+
+// Callbacks of higher priority run first.  A callback that is already pending
+// with the same argument isn't queued again, so a burst of interrupts runs it
+// once; it keeps its place in the queue unless the new priority is higher.
+bool mp_sched_schedule_priority(mp_obj_t function, mp_obj_t arg, uint8_t priority) {
     mp_uint_t atomic_state = MICROPY_BEGIN_ATOMIC_SECTION();
+    mp_sched_item_t *queue = MP_STATE_VM(sched_queue);
+    size_t sp = MP_STATE_VM(sched_sp);
+    mp_sched_item_t item;
+    item.func = function;
+    item.arg = arg;
+    item.priority = priority;
+    #if MICROPY_SCHEDULER_LATENCY
+    item.ticks_us = mp_hal_ticks_us();
+    #endif
+    for (size_t i = 0; i < sp; ++i) {
+        if (queue[i].func == function && queue[i].arg == arg) {
+            if (queue[i].priority >= priority) {
+                MICROPY_END_ATOMIC_SECTION(atomic_state);
+                return true;
+            }
+            // take it out, to put it back in with the new priority
+            #if MICROPY_SCHEDULER_LATENCY
+            item.ticks_us = queue[i].ticks_us;
+            #endif
+            memmove(&queue[i], &queue[i + 1], (sp - i - 1) * sizeof(*queue));
+            --sp;
+            break;
+        }
+    }
     bool ret;
-    if (MP_STATE_VM(sched_sp) < MICROPY_SCHEDULER_DEPTH) {
+    if (sp < MP_STATE_VM(sched_depth)) {
         if (MP_STATE_VM(sched_state) == MP_SCHED_IDLE) {
             MP_STATE_VM(sched_state) = MP_SCHED_PENDING;
         }
-        MP_STATE_VM(sched_stack)[MP_STATE_VM(sched_sp)].func = function;
-        MP_STATE_VM(sched_stack)[MP_STATE_VM(sched_sp)].arg = arg;
-        ++MP_STATE_VM(sched_sp);
+        size_t i = sp;
+        for (; i > 0 && queue[i - 1].priority >= priority; --i) {
+            queue[i] = queue[i - 1];
+        }
+        queue[i] = item;
+        MP_STATE_VM(sched_sp) = sp + 1;
         ret = true;
     } else {
-        // schedule stack is full
+        // schedule queue is full
         ret = false;
     }
     MICROPY_END_ATOMIC_SECTION(atomic_state);
     return ret;
 }
 
+// Change the number of callbacks that can be pending, until the next soft
+// reset.  The depth is kept between MICROPY_SCHEDULER_DEPTH and
+// MICROPY_SCHEDULER_MAX_DEPTH.  Must not be called from an interrupt because a
+// queue bigger than MICROPY_SCHEDULER_DEPTH is allocated on the heap.  Returns
+// false if more callbacks than that are pending.
+bool mp_sched_set_depth(size_t depth) {
+    mp_sched_item_t *queue;
+    if (depth <= MICROPY_SCHEDULER_DEPTH) {
+        depth = MICROPY_SCHEDULER_DEPTH;
+        queue = MP_STATE_VM(sched_stack);
+    } else {
+        depth = MIN(depth, MICROPY_SCHEDULER_MAX_DEPTH);
+        queue = m_new(mp_sched_item_t, depth);
+    }
+    mp_uint_t atomic_state = MICROPY_BEGIN_ATOMIC_SECTION();
+    size_t sp = MP_STATE_VM(sched_sp);
+    bool ret = sp <= depth;
+    if (ret) {
+        if (queue != MP_STATE_VM(sched_queue)) {
+            memcpy(queue, MP_STATE_VM(sched_queue), sp * sizeof(*queue));
+        }
+        MP_STATE_VM(sched_queue) = queue;
+        MP_STATE_VM(sched_depth) = depth;
+    }
+    MICROPY_END_ATOMIC_SECTION(atomic_state);
+    return ret;
+}
+
 #else // MICROPY_ENABLE_SCHEDULER
 
 // A variant of this is inlined in the VM at the pending exception check
@@ -216,6 +216,21 @@ const byte *mp_bytecode_print_str(const byte *ip) {
             printf("LOAD_DEREF " UINT_FMT, unum);
             break;
 
+        case MP_BC_LOAD_FAST_CONST_BINARY_OP: {
+            mp_int_t num = 0;
+            if ((ip[0] & 0x40) != 0) {
+                // Number is negative
+                num--;
+            }
+            do {
+                num = (num * 128) | (*ip & 0x7f);
+            } while ((*ip++ & 0x80) != 0);
+            printf("LOAD_FAST_CONST_BINARY_OP " UINT_FMT " " INT_FMT " %s",
+                (mp_uint_t)ip[0], num, qstr_str(mp_binary_op_method_name[ip[1]]));
+            ip += 2;
+            break;
+        }
+
         case MP_BC_LOAD_NAME:
             DECODE_QSTR;
             printf("LOAD_NAME %s", qstr_str(qst));
@@ -345,6 +360,20 @@ const byte *mp_bytecode_print_str(const byte *ip) {
             printf("POP_JUMP_IF_FALSE " UINT_FMT, (mp_uint_t)(ip + unum - mp_showbc_code_start));
             break;
 
+        case MP_BC_COMPARE_POP_JUMP_IF_TRUE:
+            DECODE_SLABEL;
+            printf("COMPARE_POP_JUMP_IF_TRUE %s " UINT_FMT, qstr_str(mp_binary_op_method_name[ip[0]]),
+                (mp_uint_t)(ip + 1 + unum - mp_showbc_code_start));
+            ip += 1;
+            break;
+
+        case MP_BC_COMPARE_POP_JUMP_IF_FALSE:
+            DECODE_SLABEL;
+            printf("COMPARE_POP_JUMP_IF_FALSE %s " UINT_FMT, qstr_str(mp_binary_op_method_name[ip[0]]),
+                (mp_uint_t)(ip + 1 + unum - mp_showbc_code_start));
+            ip += 1;
+            break;
+
         case MP_BC_JUMP_IF_TRUE_OR_POP:
             DECODE_SLABEL;
             printf("JUMP_IF_TRUE_OR_POP " UINT_FMT, (mp_uint_t)(ip + unum - mp_showbc_code_start));
@@ -533,7 +562,14 @@ const byte *mp_bytecode_print_str(const byte *ip) {
             break;
 
         default:
-            if (ip[-1] < MP_BC_LOAD_CONST_SMALL_INT_MULTI + 64) {
+            if (ip[-1] < MP_BC_LOAD_FAST_ATTR_MULTI + 16) {
+                mp_uint_t local_num = ip[-1] - MP_BC_LOAD_FAST_ATTR_MULTI;
+                DECODE_QSTR;
+                printf("LOAD_FAST_ATTR " UINT_FMT " %s", local_num, qstr_str(qst));
+                if (MICROPY_OPT_CACHE_MAP_LOOKUP_IN_BYTECODE) {
+                    printf(" (cache=%u)", *ip++);
+                }
+            } else if (ip[-1] < MP_BC_LOAD_CONST_SMALL_INT_MULTI + 64) {
                 printf("LOAD_CONST_SMALL_INT " INT_FMT, (mp_int_t)ip[-1] - MP_BC_LOAD_CONST_SMALL_INT_MULTI - 16);
             } else if (ip[-1] < MP_BC_LOAD_FAST_MULTI + 16) {
                 printf("LOAD_FAST " UINT_FMT, (mp_uint_t)ip[-1] - MP_BC_LOAD_FAST_MULTI);
@@ -34,6 +34,8 @@
 #include "py/runtime.h"
 #include "py/bc0.h"
 #include "py/bc.h"
+#include "py/smallint.h"
+#include "py/emitjit.h"
 
 #if 0
 #define TRACE(ip) printf("sp=%d ", (int)(sp - &code_state->state[0] + 1)); mp_bytecode_print2(ip, 1, code_state->fun_bc->const_table);
@@ -56,6 +58,13 @@
 #define DECODE_ULABEL size_t ulab = (ip[0] | (ip[1] << 8)); ip += 2
 #define DECODE_SLABEL size_t slab = (ip[0] | (ip[1] << 8)) - 0x8000; ip += 2
 
+#if MICROPY_EMIT_NATIVE_JIT
+// a backward jump is a loop iteration, which counts towards the function being hot
+#define JIT_BACK_EDGE() if ((mp_int_t)slab < 0) { mp_jit_tick(code_state->fun_bc); }
+#else
+#define JIT_BACK_EDGE()
+#endif
+
 #if MICROPY_PERSISTENT_CODE
 
 #define DECODE_QSTR \
@@ -110,6 +119,31 @@
     exc_sp--; /* pop back to previous exception handler */ \
     CLEAR_SYS_EXC_INFO() /* just clear sys.exc_info(), not compliant, but it shouldn't be used in 1st place */
 
+#if MICROPY_OPT_BYTECODE_SUPERINSTRUCTIONS
+// Fast path for the binary ops that superinstructions most often perform on
+// two small ints.  Returns MP_OBJ_NULL if the caller must use mp_binary_op.
+static inline mp_obj_t vm_small_int_binary_op(mp_binary_op_t op, mp_int_t lhs, mp_int_t rhs) {
+    switch (op) {
+        case MP_BINARY_OP_LESS: return mp_obj_new_bool(lhs < rhs);
+        case MP_BINARY_OP_MORE: return mp_obj_new_bool(lhs > rhs);
+        case MP_BINARY_OP_EQUAL: return mp_obj_new_bool(lhs == rhs);
+        case MP_BINARY_OP_LESS_EQUAL: return mp_obj_new_bool(lhs <= rhs);
+        case MP_BINARY_OP_MORE_EQUAL: return mp_obj_new_bool(lhs >= rhs);
+        case MP_BINARY_OP_NOT_EQUAL: return mp_obj_new_bool(lhs != rhs);
+        case MP_BINARY_OP_ADD:
+        case MP_BINARY_OP_INPLACE_ADD: lhs += rhs; break;
+        case MP_BINARY_OP_SUBTRACT:
+        case MP_BINARY_OP_INPLACE_SUBTRACT: lhs -= rhs; break;
+        default: return MP_OBJ_NULL;
+    }
+    // two small ints always add or subtract without overflowing mp_int_t
+    if (!MP_SMALL_INT_FITS(lhs)) {
+        return MP_OBJ_NULL;
+    }
+    return MP_OBJ_NEW_SMALL_INT(lhs);
+}
+#endif
+
 // fastn has items in reverse order (fastn[0] is local[0], fastn[-1] is local[1], etc)
 // sp points to bottom of stack which grows up
 // returns:
@@ -266,6 +300,35 @@ dispatch_loop:
                     goto load_check;
                 }
 
+                #if MICROPY_OPT_BYTECODE_SUPERINSTRUCTIONS
+                ENTRY(MP_BC_LOAD_FAST_CONST_BINARY_OP): {
+                    MARK_EXC_IP_SELECTIVE();
+                    mp_int_t num = 0;
+                    if ((ip[0] & 0x40) != 0) {
+                        // Number is negative
+                        num--;
+                    }
+                    do {
+                        num = (num << 7) | (*ip & 0x7f);
+                    } while ((*ip++ & 0x80) != 0);
+                    obj_shared = fastn[-(mp_int_t)ip[0]];
+                    mp_binary_op_t op = ip[1];
+                    ip += 2;
+                    if (obj_shared == MP_OBJ_NULL) {
+                        goto local_name_error;
+                    }
+                    mp_obj_t res = MP_OBJ_NULL;
+                    if (MP_OBJ_IS_SMALL_INT(obj_shared)) {
+                        res = vm_small_int_binary_op(op, MP_OBJ_SMALL_INT_VALUE(obj_shared), num);
+                    }
+                    if (res == MP_OBJ_NULL) {
+                        res = mp_binary_op(op, obj_shared, MP_OBJ_NEW_SMALL_INT(num));
+                    }
+                    PUSH(res);
+                    DISPATCH();
+                }
+                #endif
+
                 #if !MICROPY_OPT_CACHE_MAP_LOOKUP_IN_BYTECODE
                 ENTRY(MP_BC_LOAD_NAME): {
                     MARK_EXC_IP_SELECTIVE();
@@ -325,18 +388,26 @@ dispatch_loop:
                 #endif
 
                 #if !MICROPY_OPT_CACHE_MAP_LOOKUP_IN_BYTECODE
-                ENTRY(MP_BC_LOAD_ATTR): {
+                ENTRY(MP_BC_LOAD_ATTR):
+                #if MICROPY_OPT_BYTECODE_SUPERINSTRUCTIONS
+                load_attr:
+                #endif
+                {
                     MARK_EXC_IP_SELECTIVE();
                     DECODE_QSTR;
                     SET_TOP(mp_load_attr(TOP(), qst));
                     DISPATCH();
                 }
                 #else
-                ENTRY(MP_BC_LOAD_ATTR): {
+                ENTRY(MP_BC_LOAD_ATTR):
+                #if MICROPY_OPT_BYTECODE_SUPERINSTRUCTIONS
+                load_attr:
+                #endif
+                {
                     MARK_EXC_IP_SELECTIVE();
                     DECODE_QSTR;
                     mp_obj_t top = TOP();
-                    if (mp_obj_is_instance_type(mp_obj_get_type(top))) {
+                    if (mp_obj_is_instance_type(mp_obj_get_type(top)) && !MP_THREAD_OBJ_SHARED()) {
                         mp_obj_instance_t *self = MP_OBJ_TO_PTR(top);
                         mp_uint_t x = *ip;
                         mp_obj_t key = MP_OBJ_NEW_QSTR(qst);
@@ -344,6 +415,17 @@ dispatch_loop:
                         if (x < self->members.alloc && self->members.table[x].key == key) {
                             elem = &self->members.table[x];
                         } else {
+                            #if MICROPY_PY_CLASS_SLOTS
+                            mp_obj_t *slot = mp_obj_instance_cached_slot(self, x, key, false);
+                            if (slot == NULL) {
+                                slot = mp_obj_instance_find_slot(self, qst, false, (byte*)ip);
+                            }
+                            if (slot != NULL && *slot != MP_OBJ_NULL) {
+                                SET_TOP(*slot);
+                                ip++;
+                                DISPATCH();
+                            }
+                            #endif
                             elem = mp_map_lookup(&self->members, key, MP_MAP_LOOKUP);
                             if (elem != NULL) {
                                 *(byte*)ip = elem - &self->members.table[0];
@@ -434,7 +516,7 @@ dispatch_loop:
                     MARK_EXC_IP_SELECTIVE();
                     DECODE_QSTR;
                     mp_obj_t top = TOP();
-                    if (mp_obj_is_instance_type(mp_obj_get_type(top)) && sp[-1] != MP_OBJ_NULL) {
+                    if (mp_obj_is_instance_type(mp_obj_get_type(top)) && sp[-1] != MP_OBJ_NULL && !MP_THREAD_OBJ_SHARED()) {
                         mp_obj_instance_t *self = MP_OBJ_TO_PTR(top);
                         mp_uint_t x = *ip;
                         mp_obj_t key = MP_OBJ_NEW_QSTR(qst);
@@ -442,6 +524,18 @@ dispatch_loop:
                         if (x < self->members.alloc && self->members.table[x].key == key) {
                             elem = &self->members.table[x];
                         } else {
+                            #if MICROPY_PY_CLASS_SLOTS
+                            mp_obj_t *slot = mp_obj_instance_cached_slot(self, x, key, true);
+                            if (slot == NULL) {
+                                slot = mp_obj_instance_find_slot(self, qst, true, (byte*)ip);
+                            }
+                            if (slot != NULL) {
+                                *slot = sp[-1];
+                                sp -= 2;
+                                ip++;
+                                DISPATCH();
+                            }
+                            #endif
                             elem = mp_map_lookup(&self->members, key, MP_MAP_LOOKUP);
                             if (elem != NULL) {
                                 *(byte*)ip = elem - &self->members.table[0];
@@ -536,6 +630,7 @@ dispatch_loop:
                 ENTRY(MP_BC_JUMP): {
                     DECODE_SLABEL;
                     ip += slab;
+                    JIT_BACK_EDGE();
                     DISPATCH_WITH_PEND_EXC_CHECK();
                 }
 
@@ -543,6 +638,7 @@ dispatch_loop:
                     DECODE_SLABEL;
                     if (mp_obj_is_true(POP())) {
                         ip += slab;
+                        JIT_BACK_EDGE();
                     }
                     DISPATCH_WITH_PEND_EXC_CHECK();
                 }
@@ -551,10 +647,35 @@ dispatch_loop:
                     DECODE_SLABEL;
                     if (!mp_obj_is_true(POP())) {
                         ip += slab;
+                        JIT_BACK_EDGE();
                     }
                     DISPATCH_WITH_PEND_EXC_CHECK();
                 }
 
+                #if MICROPY_OPT_BYTECODE_SUPERINSTRUCTIONS
+                ENTRY(MP_BC_COMPARE_POP_JUMP_IF_TRUE):
+                ENTRY(MP_BC_COMPARE_POP_JUMP_IF_FALSE): {
+                    MARK_EXC_IP_SELECTIVE();
+                    bool jump_if = ip[-1] == MP_BC_COMPARE_POP_JUMP_IF_TRUE;
+                    DECODE_SLABEL;
+                    mp_binary_op_t op = *ip++;
+                    mp_obj_t rhs = POP();
+                    mp_obj_t lhs = POP();
+                    mp_obj_t res = MP_OBJ_NULL;
+                    if (MP_OBJ_IS_SMALL_INT(lhs) && MP_OBJ_IS_SMALL_INT(rhs)) {
+                        res = vm_small_int_binary_op(op, MP_OBJ_SMALL_INT_VALUE(lhs), MP_OBJ_SMALL_INT_VALUE(rhs));
+                    }
+                    if (res == MP_OBJ_NULL) {
+                        res = mp_binary_op(op, lhs, rhs);
+                    }
+                    if (mp_obj_is_true(res) == jump_if) {
+                        ip += slab;
+                        JIT_BACK_EDGE();
+                    }
+                    DISPATCH_WITH_PEND_EXC_CHECK();
+                }
+                #endif
+
                 ENTRY(MP_BC_JUMP_IF_TRUE_OR_POP): {
                     DECODE_SLABEL;
                     if (mp_obj_is_true(TOP())) {
@@ -1240,6 +1361,16 @@ yield:
                     obj_shared = fastn[MP_BC_LOAD_FAST_MULTI - (mp_int_t)ip[-1]];
                     goto load_check;
 
+                #if MICROPY_OPT_BYTECODE_SUPERINSTRUCTIONS
+                ENTRY(MP_BC_LOAD_FAST_ATTR_MULTI):
+                    obj_shared = fastn[MP_BC_LOAD_FAST_ATTR_MULTI - (mp_int_t)ip[-1]];
+                    if (obj_shared == MP_OBJ_NULL) {
+                        goto local_name_error;
+                    }
+                    PUSH(obj_shared);
+                    goto load_attr;
+                #endif
+
                 ENTRY(MP_BC_STORE_FAST_MULTI):
                     fastn[MP_BC_STORE_FAST_MULTI - (mp_int_t)ip[-1]] = POP();
                     DISPATCH();
@@ -1261,6 +1392,16 @@ yield:
                     MARK_EXC_IP_SELECTIVE();
 #else
                 ENTRY_DEFAULT:
+                    #if MICROPY_OPT_BYTECODE_SUPERINSTRUCTIONS
+                    if (ip[-1] < MP_BC_LOAD_FAST_ATTR_MULTI + 16) {
+                        obj_shared = fastn[MP_BC_LOAD_FAST_ATTR_MULTI - (mp_int_t)ip[-1]];
+                        if (obj_shared == MP_OBJ_NULL) {
+                            goto local_name_error;
+                        }
+                        PUSH(obj_shared);
+                        goto load_attr;
+                    } else
+                    #endif
                     if (ip[-1] < MP_BC_LOAD_CONST_SMALL_INT_MULTI + 64) {
                         PUSH(MP_OBJ_NEW_SMALL_INT((mp_int_t)ip[-1] - MP_BC_LOAD_CONST_SMALL_INT_MULTI - 16));
                         DISPATCH();
@@ -1384,6 +1525,13 @@ unwind_loop:
                 const byte *ip = code_state->fun_bc->bytecode;
                 ip = mp_decode_uint_skip(ip); // skip n_state
                 ip = mp_decode_uint_skip(ip); // skip n_exc_stack
+                #if MICROPY_COMP_STREAM
+                if (*ip & MP_SCOPE_FLAG_NO_TRACEBACK) {
+                    // the outer module of a streamed compile; the group
+                    // that raised already added the module's entry
+                    goto traceback_done;
+                }
+                #endif
                 ip++; // skip scope_params
                 ip++; // skip n_pos_args
                 ip++; // skip n_kwonly_args
@@ -1427,6 +1575,9 @@ unwind_loop:
                 }
                 mp_obj_exception_add_traceback(MP_OBJ_FROM_PTR(nlr.ret_val), source_file, source_line, block_name);
             }
+#if MICROPY_COMP_STREAM
+traceback_done:
+#endif
 
             while (currently_in_except_block) {
                 // nested exception
@@ -40,6 +40,9 @@ static const void *const entry_table[256] = {
     [MP_BC_LOAD_NULL] = &&entry_MP_BC_LOAD_NULL,
     [MP_BC_LOAD_FAST_N] = &&entry_MP_BC_LOAD_FAST_N,
     [MP_BC_LOAD_DEREF] = &&entry_MP_BC_LOAD_DEREF,
+    #if MICROPY_OPT_BYTECODE_SUPERINSTRUCTIONS
+    [MP_BC_LOAD_FAST_CONST_BINARY_OP] = &&entry_MP_BC_LOAD_FAST_CONST_BINARY_OP,
+    #endif
     [MP_BC_LOAD_NAME] = &&entry_MP_BC_LOAD_NAME,
     [MP_BC_LOAD_GLOBAL] = &&entry_MP_BC_LOAD_GLOBAL,
     [MP_BC_LOAD_ATTR] = &&entry_MP_BC_LOAD_ATTR,
@@ -65,6 +68,10 @@ static const void *const entry_table[256] = {
     [MP_BC_JUMP] = &&entry_MP_BC_JUMP,
     [MP_BC_POP_JUMP_IF_TRUE] = &&entry_MP_BC_POP_JUMP_IF_TRUE,
     [MP_BC_POP_JUMP_IF_FALSE] = &&entry_MP_BC_POP_JUMP_IF_FALSE,
+    #if MICROPY_OPT_BYTECODE_SUPERINSTRUCTIONS
+    [MP_BC_COMPARE_POP_JUMP_IF_TRUE] = &&entry_MP_BC_COMPARE_POP_JUMP_IF_TRUE,
+    [MP_BC_COMPARE_POP_JUMP_IF_FALSE] = &&entry_MP_BC_COMPARE_POP_JUMP_IF_FALSE,
+    #endif
     [MP_BC_JUMP_IF_TRUE_OR_POP] = &&entry_MP_BC_JUMP_IF_TRUE_OR_POP,
     [MP_BC_JUMP_IF_FALSE_OR_POP] = &&entry_MP_BC_JUMP_IF_FALSE_OR_POP,
     [MP_BC_SETUP_WITH] = &&entry_MP_BC_SETUP_WITH,
@@ -106,6 +113,9 @@ static const void *const entry_table[256] = {
     [MP_BC_IMPORT_NAME] = &&entry_MP_BC_IMPORT_NAME,
     [MP_BC_IMPORT_FROM] = &&entry_MP_BC_IMPORT_FROM,
     [MP_BC_IMPORT_STAR] = &&entry_MP_BC_IMPORT_STAR,
+    #if MICROPY_OPT_BYTECODE_SUPERINSTRUCTIONS
+    [MP_BC_LOAD_FAST_ATTR_MULTI ... MP_BC_LOAD_FAST_ATTR_MULTI + 15] = &&entry_MP_BC_LOAD_FAST_ATTR_MULTI,
+    #endif
     [MP_BC_LOAD_CONST_SMALL_INT_MULTI ... MP_BC_LOAD_CONST_SMALL_INT_MULTI + 63] = &&entry_MP_BC_LOAD_CONST_SMALL_INT_MULTI,
     [MP_BC_LOAD_FAST_MULTI ... MP_BC_LOAD_FAST_MULTI + 15] = &&entry_MP_BC_LOAD_FAST_MULTI,
     [MP_BC_STORE_FAST_MULTI ... MP_BC_STORE_FAST_MULTI + 15] = &&entry_MP_BC_STORE_FAST_MULTI,
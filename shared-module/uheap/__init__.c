@@ -132,6 +132,7 @@ static uint32_t function_size(uint8_t indent_level, mp_obj_t obj) {
         return 0;
     } else if (MP_OBJ_IS_TYPE(obj, &mp_type_fun_bc)) {
         mp_obj_fun_bc_t* fn = MP_OBJ_TO_PTR(obj);
+        mp_obj_fun_bc_ensure_loaded(fn);
         uint32_t total_size = gc_nbytes(fn) + gc_nbytes(fn->bytecode) + gc_nbytes(fn->const_table);
         #if MICROPY_DEBUG_PRINTERS
         mp_printf(&mp_plat_print, "BYTECODE START\n");
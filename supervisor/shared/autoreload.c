@@ -26,6 +26,7 @@
 
 #include "autoreload.h"
 
+#include "extmod/vfs.h"
 #include "py/mphal.h"
 #include "py/reload.h"
 
@@ -69,6 +70,8 @@ inline bool autoreload_is_enabled() {
 }
 
 void autoreload_start() {
+    // the filesystem has been written to behind the VFS
+    mp_vfs_import_stat_cache_clear();
     autoreload_delay_ms = CIRCUITPY_AUTORELOAD_DELAY_MS;
 }
 
@@ -78,6 +81,7 @@ void autoreload_stop() {
 }
 
 void autoreload_now() {
+    mp_vfs_import_stat_cache_clear();
     if (!autoreload_enabled || autoreload_suspended || reload_requested) {
         return;
     }
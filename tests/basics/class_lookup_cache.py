@@ -0,0 +1,71 @@
+# test that lookups of class attributes through instances see changes to
+# the class hierarchy made after the attribute was first looked up
+
+class A:
+    x = 1
+    def f(self):
+        return 'A.f'
+
+class B(A):
+    pass
+
+b = B()
+for i in range(2):
+    print(b.x, b.f())
+
+# add to a base class
+A.y = 2
+print(b.y)
+
+# override in a derived class
+B.x = 3
+B.f = lambda self: 'B.f'
+for i in range(2):
+    print(b.x, b.f())
+
+# delete from the derived class, base class is visible again
+print(B.x, A.x)
+del B.x
+del B.f
+print(b.x, b.f(), B.x)
+
+# replace method in base class
+def g(self):
+    return 'g'
+A.f = g
+print(b.f())
+
+# instance member shadows class attribute
+b.x = 4
+print(b.x)
+del b.x
+print(b.x)
+
+# attribute that doesn't exist, then is added
+try:
+    b.z
+except AttributeError:
+    print('AttributeError')
+A.z = 5
+print(b.z)
+del A.z
+try:
+    b.z
+except AttributeError:
+    print('AttributeError')
+
+# many classes with the same attribute name
+classes = [type('C%d' % i, (), {'v': i}) for i in range(40)]
+for j in range(2):
+    print(sum(c().v for c in classes))
+
+# store to instance goes through a class attribute descriptor-less lookup
+class D:
+    def __init__(self):
+        self.v = 0
+    def inc(self):
+        self.v += 1
+d = D()
+for i in range(5):
+    d.inc()
+print(d.v)
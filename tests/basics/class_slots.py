@@ -0,0 +1,118 @@
+# test __slots__ in user classes
+
+class Test:
+    __slots__ = ('a',)
+try:
+    Test().b = 1
+    print('SKIP')
+    raise SystemExit
+except AttributeError:
+    pass
+
+class A:
+    __slots__ = ('x', 'y')
+
+    def __init__(self, x):
+        self.x = x
+
+a = A(1)
+print(a.x)
+
+# slot that hasn't been set
+try:
+    a.y
+except AttributeError:
+    print('AttributeError')
+a.y = 2
+print(a.x + a.y)
+
+# only the slots can be stored to
+try:
+    a.z = 3
+except AttributeError:
+    print('AttributeError')
+print(hasattr(a, '__dict__'))
+
+# delete a slot
+del a.x
+print(hasattr(a, 'x'))
+try:
+    del a.x
+except AttributeError:
+    print('AttributeError')
+a.x = 4
+print(a.x)
+
+# instances don't share slots
+b = A(5)
+print(a.x, b.x)
+
+# __slots__ given as a single string
+class B:
+    __slots__ = 'v'
+b = B()
+b.v = 6
+print(b.v)
+
+# subclass without __slots__ gets a dict for other attributes
+class C(A):
+    pass
+c = C(7)
+c.y = 8
+c.z = 9
+print(c.x, c.y, c.z)
+
+# subclass adding more slots
+class D(A):
+    __slots__ = ('z',)
+d = D(10)
+d.y = 11
+d.z = 12
+print(d.x, d.y, d.z)
+try:
+    d.w = 13
+except AttributeError:
+    print('AttributeError')
+
+# __dict__ in __slots__ allows other attributes
+class E:
+    __slots__ = ('a', '__dict__')
+e = E()
+e.a = 14
+e.b = 15
+print(e.a, e.b)
+
+# slots with methods and properties
+class F:
+    __slots__ = ('_v',)
+    def __init__(self):
+        self._v = 16
+    @property
+    def v(self):
+        return self._v
+    def get(self):
+        return self._v
+f = F()
+print(f.v, f.get())
+
+# unset slot falls back to __getattr__
+class G:
+    __slots__ = ('a',)
+    def __getattr__(self, name):
+        return name
+print(G().a)
+
+# slot name conflicting with a class variable
+try:
+    class H:
+        __slots__ = ('a',)
+        a = 1
+except ValueError as er:
+    print('ValueError', er)
+
+# slot names must be strings
+try:
+    class I:
+        __slots__ = (1,)
+except TypeError:
+    print('TypeError')
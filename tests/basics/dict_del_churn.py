@@ -0,0 +1,29 @@
+# deleting and re-adding keys many times must keep every remaining key reachable
+
+class A:
+    def __init__(self, x):
+        self.x = x
+    def __hash__(self):
+        return self.x
+    def __eq__(self, other):
+        return isinstance(other, A) and self.x == other.x
+
+for make in (lambda i: i, lambda i: i * 64, lambda i: 'k%d' % i, lambda i: (i, i), A):
+    d = {}
+    for i in range(300):
+        d[make(i)] = i
+        if i >= 20 and make(i - 20) in d:
+            del d[make(i - 20)]
+        if i % 7 == 0:
+            d.pop(make(i // 2), None)
+    print(len(d), sorted(d[k] for k in d))
+    print(all(d[make(v)] == v for v in d.values()))
+
+s = set()
+for i in range(300):
+    s.add(i * 32)
+    s.add('s%d' % i)
+    if i >= 10:
+        s.remove((i - 10) * 32)
+        s.discard('s%d' % (i - 10))
+print(len(s), sorted(x for x in s if isinstance(x, int)))
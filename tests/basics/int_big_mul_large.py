@@ -0,0 +1,31 @@
+# test multiplication, 3-arg pow and str() of numbers large enough to use
+# the algorithms for large numbers
+
+# operands of different sizes and signs, including very unbalanced ones
+a = 3 ** 2000
+b = 7 ** 1500
+c = 11 ** 300
+for x, y in ((a, a), (a, b), (b, a), (a, c), (c, a), (a * b, c), (a, -b), (-a, -b)):
+    p = x * y
+    print(p % 1000000007, p // x == y, len(str(p)))
+
+# squaring and repeated multiplication
+print((a * a * a) % 998244353, (a ** 5) % 998244353)
+
+# each digit of the divisor all ones or with only the top bit set
+for d in ((1 << 64) - 1, 1 << 1000, (1 << 1000) - 1, 3 << 998):
+    q, r = divmod(a, d)
+    print(q % 1000003, r % 1000003, q * d + r == a)
+
+# 3-arg pow with a long exponent, which uses a sliding window
+m = 3 ** 1292 + 4
+e = 5 ** 882 + 2
+print(pow(7, e, m) % 1000003, pow(a, e, m) % 1000003, pow(-a, e, m) % 1000003)
+print(pow(a, e, -m) % 1000003, pow(b, (1 << 300) - 1, m) % 1000003)
+
+# str() and format() of large numbers, with and without separators
+s = str(a)
+print(len(s), s[:20], s[-20:], int(s) == a)
+print(str(-b)[:20], str(b * 10 ** 50)[-60:])
+print('{:,}'.format(10 ** 45), '{:,}'.format(-123456789012345678901234))
+print(hex(a)[-20:], oct(-b)[:20], bin(c)[-20:])
@@ -0,0 +1,24 @@
+# test fused load-local/small-int/binary-op and compare/jump opcodes with big ints
+
+# small int overflows to a big int
+def f(a):
+    return a + 1, a - 1, a + 100000, a - 100000
+
+print(f(0x3fffffff))
+print(f(-0x40000000))
+print(f(0x3fffffffffffffff))
+print(f(-0x4000000000000000))
+print(f(2 ** 100))
+
+def f(a, b):
+    r = []
+    if a < b:
+        r.append("<")
+    if a != b:
+        r.append("!=")
+    while a < b:
+        a += 1
+    return r, a
+
+print(f(2 ** 100, 2 ** 100 + 3))
+print(f(0x3ffffffffffffffe, 0x4000000000000002))
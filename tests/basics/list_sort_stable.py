@@ -0,0 +1,41 @@
+# test that list.sort() and sorted() are stable and call the key function once
+
+if sorted([(0, i) for i in range(3)], key=lambda x: x[0]) != [(0, 0), (0, 1), (0, 2)]:
+    print('SKIP')
+    raise SystemExit
+
+# equal keys keep their original order, also when reversed
+l = [(i % 5, i) for i in range(40)]
+print(sorted(l, key=lambda x: x[0]))
+print(sorted(l, key=lambda x: x[0], reverse=True))
+
+# long runs, in both directions, with some equal items
+l = list(range(100)) + list(range(150, 50, -1)) + [75] * 20
+for x in (sorted(l), sorted(l, reverse=True)):
+    print(x[:5], x[95:105], x[-5:])
+l = [(x // 3, i) for i, x in enumerate(l)]
+print(sorted(l, key=lambda x: x[0])[90:110])
+
+# strings, floats and big ints
+print(sorted(['b', 'abc', 'ab', '', 'a', 'b', 'ba']))
+print(sorted([2.5, -1.0, 0.5, 2.5, 1e10, -1e-10]))
+print(sorted([1 << 70, 1, -(1 << 70), 0, 1 << 69]))
+print(sorted([3, 1.5, 2, 0.5]))
+
+# key function is called once per item
+n = 0
+def key(x):
+    global n
+    n += 1
+    return -x
+l = list(range(200))
+l.sort(key=key)
+print(n, l[:3])
+
+# all items are kept if a comparison fails
+l = [3, 2, 'a', 1]
+try:
+    l.sort()
+except TypeError:
+    print('TypeError')
+print(len(l))
@@ -0,0 +1,134 @@
+# test sequences of opcodes that the compiler may fuse into superinstructions
+
+# load local followed by attribute load
+class A:
+    def __init__(self):
+        self.x = 1
+        self.y = "y"
+
+def f(a):
+    return a.x, a.y
+
+print(f(A()))
+
+try:
+    f(None)
+except AttributeError:
+    print("AttributeError")
+
+# unbound local followed by attribute load
+def f():
+    if False:
+        a = A()
+    return a.x
+
+try:
+    f()
+except NameError:
+    print("NameError")
+
+# load local, load small int, binary op
+def f(a):
+    return a + 1, a - 2, a * 3, a // 4, a % 5, a < 6, a == 7, a >= -8
+
+print(f(7))
+print(f(-7))
+print(f(2.5))
+
+def f(a):
+    return a << 2, a >> 1, a & 6, a | 8, a ^ -1
+
+print(f(7))
+print(f(-7))
+
+# in-place ops
+def f(a):
+    a += 1
+    b = a
+    b -= 1000
+    return a, b
+
+print(f(5))
+print(f(5.5))
+
+# non-int operand
+def f(a):
+    return a * 2, a + "x"
+
+print(f("abc"))
+
+try:
+    f(1)
+except TypeError:
+    print("TypeError")
+
+# unbound local followed by binary op
+def f():
+    if False:
+        a = 1
+    return a + 1
+
+try:
+    f()
+except NameError:
+    print("NameError")
+
+# many locals, so the local number does not fit a single opcode
+def f():
+    a0 = a1 = a2 = a3 = a4 = a5 = a6 = a7 = a8 = a9 = a10 = a11 = a12 = a13 = a14 = a15 = 0
+    a16 = A()
+    a17 = 17
+    return a0, a16.x, a17 + 1, a17 < 20
+
+print(f())
+
+# comparison followed by conditional jump
+def f(a, b):
+    r = []
+    if a < b:
+        r.append("<")
+    if a > b:
+        r.append(">")
+    if a == b:
+        r.append("==")
+    if a <= b:
+        r.append("<=")
+    if a >= b:
+        r.append(">=")
+    if a != b:
+        r.append("!=")
+    if not a < b:
+        r.append("not <")
+    return r
+
+print(f(1, 2))
+print(f(2, 1))
+print(f(2, 2))
+print(f(1.5, 2))
+print(f("a", "b"))
+
+try:
+    f(1, "a")
+except TypeError:
+    print("TypeError")
+
+# loops use the fused forms in their condition
+def f(n):
+    i = 0
+    while i < n:
+        i += 1
+    while i != 0:
+        i -= 1
+    while n > i:
+        n -= 1
+    return i, n
+
+print(f(10))
+print(f(-1))
+
+# comparison operators that are not fused with the jump
+def f(a, b):
+    return a in b, a not in b, a is b, a is not b
+
+print(f(1, [1]))
+print(f(None, [None]))
@@ -0,0 +1,10 @@
+import bench
+
+def test(num):
+    # Multiply two 20000-bit numbers.
+    a = 3 ** 12600
+    b = 7 ** 7100
+    for i in iter(range(num // 200000)):
+        a * b
+
+bench.run(test)
@@ -0,0 +1,12 @@
+import bench
+
+def test(num):
+    # Modular exponentiation with a 2048-bit modulus and exponent, as in an RSA
+    # signature operation.
+    m = 3 ** 1292 + 4
+    e = 5 ** 882 + 2
+    x = 7 ** 700
+    for i in iter(range(num // 1000000)):
+        pow(x, e, m)
+
+bench.run(test)
@@ -0,0 +1,9 @@
+import bench
+
+def test(num):
+    # Convert a 20000-bit number to decimal.
+    a = 3 ** 12600
+    for i in iter(range(num // 1000000)):
+        str(a)
+
+bench.run(test)
@@ -0,0 +1,9 @@
+import bench
+
+def test(num):
+    for i in iter(range(num // 1000)):
+        d = {}
+        for j in range(1000):
+            d[j * 8] = j
+
+bench.run(test)
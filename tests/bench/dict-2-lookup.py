@@ -0,0 +1,12 @@
+import bench
+
+def test(num):
+    d = {}
+    for j in range(200):
+        d['k%d' % j] = j
+    keys = list(d.keys())
+    for i in iter(range(num // 200)):
+        for k in keys:
+            d[k]
+
+bench.run(test)
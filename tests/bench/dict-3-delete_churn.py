@@ -0,0 +1,12 @@
+import bench
+
+def test(num):
+    # Keep a dict of 100 entries while keys come and go, as with a cache or
+    # a table of pending requests.
+    d = {}
+    for i in iter(range(num // 2)):
+        d[i] = i
+        if i >= 100:
+            del d[i - 100]
+
+bench.run(test)
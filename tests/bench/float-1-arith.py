@@ -0,0 +1,13 @@
+import bench
+
+def test(num):
+    # Damped oscillator step; every intermediate result is a new float, which
+    # is a heap allocation unless floats are stored in the object (nan-boxing).
+    x = 1.0
+    v = 0.0
+    for i in iter(range(num // 20)):
+        a = -x * 0.5 - v * 0.01
+        v += a * 0.001
+        x += v * 0.001
+
+bench.run(test)
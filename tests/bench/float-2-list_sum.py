@@ -0,0 +1,11 @@
+import bench
+
+def test(num):
+    # Accumulate over a list of floats, with a multiply per element.
+    arr = [i * 0.5 for i in range(1000)]
+    for i in iter(range(num // 20000)):
+        s = 0.0
+        for f in arr:
+            s += f * 1.0001
+
+bench.run(test)
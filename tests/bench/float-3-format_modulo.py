@@ -0,0 +1,10 @@
+import bench
+
+def test(num):
+    # Log sensor readings as text with %-formatting.
+    x = 21.5
+    for i in iter(range(num // 200)):
+        s = '%.2f,%.3e,%s' % (x, x * 1000.0, x)
+        x += 0.01
+
+bench.run(test)
@@ -0,0 +1,13 @@
+import bench
+
+def test(num):
+    # Interleave live and dead single-block objects so the start of the heap
+    # is full of holes that are too small for the allocations below.
+    keep = [None] * (num // 2000)
+    for i in range(num // 2000):
+        keep[i] = i + 0.5
+        i + 0.25
+    for i in range(num // 200):
+        t = (i, i, i, i)
+
+bench.run(test)
@@ -0,0 +1,12 @@
+import bench
+
+def test(num):
+    # Strings built at runtime are looked up among the qstrs when they are
+    # created, and again by getattr if they aren't already interned.
+    l = []
+    parts = (('app', 'end'), ('ex', 'tend'), ('in', 'sert'), ('re', 'verse'), ('so', 'rt'))
+    for i in iter(range(num // 5)):
+        for a, b in parts:
+            getattr(l, a + b)
+
+bench.run(test)
@@ -0,0 +1,9 @@
+import bench
+
+def test(num):
+    # Every new str is checked against the qstrs so that it can share an
+    # existing interned string; most of these checks miss.
+    for i in iter(range(num // 5)):
+        s = 'item%d' % i
+
+bench.run(test)
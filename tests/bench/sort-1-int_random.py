@@ -0,0 +1,10 @@
+import bench
+
+def test(num):
+    # Sort a buffer of 10000 readings in pseudo-random order.
+    data = [(i * 7919) % 10007 for i in range(10000)]
+    for i in iter(range(num // 2000000)):
+        arr = data[:]
+        arr.sort()
+
+bench.run(test)
@@ -0,0 +1,13 @@
+import bench
+
+def test(num):
+    # Sort a buffer of 10000 readings that is mostly in order already, as
+    # when new readings are appended to a sorted buffer.
+    data = list(range(10000))
+    for i in range(0, 10000, 500):
+        data[i] = (i * 7919) % 10007
+    for i in iter(range(num // 2000000)):
+        arr = data[:]
+        arr.sort()
+
+bench.run(test)
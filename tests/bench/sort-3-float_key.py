@@ -0,0 +1,10 @@
+import bench
+
+def test(num):
+    # Sort 10000 (timestamp, value) records by value.
+    data = [(i, ((i * 7919) % 10007) / 10.0) for i in range(10000)]
+    for i in iter(range(num // 2000000)):
+        arr = data[:]
+        arr.sort(key=lambda r: r[1])
+
+bench.run(test)
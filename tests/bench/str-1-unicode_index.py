@@ -0,0 +1,11 @@
+import bench
+
+def test(num):
+    # Index every character of a 2000 character non-ASCII str.
+    s = "".join(chr(0x41 + i % 26) if i % 8 else chr(0x3b1 + i % 20) for i in range(2000))
+    n = len(s)
+    for i in iter(range(num // 200000)):
+        for j in range(n):
+            s[j]
+
+bench.run(test)
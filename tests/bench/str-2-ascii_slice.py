@@ -0,0 +1,10 @@
+import bench
+
+def test(num):
+    # Take 10 character slices at every position of a 2000 character str.
+    s = "".join(chr(0x41 + i % 26) for i in range(2000))
+    for i in iter(range(num // 200000)):
+        for j in range(len(s) - 10):
+            s[j:j + 10]
+
+bench.run(test)
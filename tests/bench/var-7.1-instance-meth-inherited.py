@@ -0,0 +1,23 @@
+import bench
+
+class Base:
+
+    def __init__(self):
+        self._num = 20000000
+
+    def num(self):
+        return self._num
+
+class Mid(Base):
+    pass
+
+class Foo(Mid):
+    pass
+
+def test(num):
+    o = Foo()
+    i = 0
+    while i < o.num():
+        i += 1
+
+bench.run(test)
@@ -0,0 +1,123 @@
+# test the uevent loop with sleeping tasks and user streams
+
+try:
+    import uevent
+    import uio as io
+except ImportError:
+    print('SKIP')
+    raise SystemExit
+
+if not hasattr(io, 'IOBase'):
+    print('SKIP')
+    raise SystemExit
+
+# tasks wake up in the order of their sleep times, not of their creation
+async def sleeper(name, ms):
+    print(name, 'start')
+    await uevent.sleep_ms(ms)
+    print(name, 'done')
+
+loop = uevent.Loop()
+loop.create_task(sleeper('c', 60))
+loop.create_task(sleeper('a', 20))
+loop.create_task(sleeper('b', 40))
+loop.run_forever()
+
+# tasks that only yield to the loop take turns
+def worker(name, n):
+    for i in range(n):
+        print(name, i)
+        yield
+
+loop.create_task(worker('x', 3))
+loop.create_task(worker('y', 2))
+loop.run_forever()
+
+# run_until_complete returns the value of the task, and waits for the tasks it
+# creates only as long as it runs itself
+async def add(a, b):
+    await uevent.sleep(0)
+    return a + b
+
+async def main():
+    loop.call_later_ms(10, sleeper('later', 0))
+    return await add(1, 2) * 2
+
+print(loop.run_until_complete(main()))
+loop.run_forever()
+
+# an exception in a task is raised out of the loop
+async def fail():
+    await uevent.sleep_ms(1)
+    raise ValueError('fail')
+
+loop.create_task(fail())
+try:
+    loop.run_forever()
+except ValueError as er:
+    print('ValueError', er)
+
+# stop() ends run_forever, leaving the other tasks for the next run
+async def stopper():
+    loop.stop()
+
+loop.create_task(stopper())
+loop.create_task(worker('z', 1))
+loop.run_forever()
+print('stopped')
+loop.run_forever()
+
+# a pipe whose reads would block until something is written
+class Pipe(io.IOBase):
+    def __init__(self):
+        self.data = bytearray()
+    def readinto(self, buf):
+        if not self.data:
+            return None
+        n = min(len(buf), len(self.data))
+        buf[:n] = self.data[:n]
+        self.data = self.data[n:]
+        return n
+    def write(self, buf):
+        self.data += buf
+        return len(buf)
+    def ioctl(self, req, arg):
+        if req == 3: # MP_STREAM_POLL
+            ret = arg & 4 # writes never block
+            if self.data:
+                ret |= arg & 1
+            return ret
+        return -1
+
+pipe = Pipe()
+
+async def reader():
+    print('read', await uevent.read(pipe, 3))
+    print('readline', await uevent.readline(pipe))
+    print('readline', await uevent.readline(pipe))
+    buf = bytearray(4)
+    print('readinto', await uevent.readinto(pipe, buf), buf)
+
+async def writer():
+    for s in (b'abc', b'de', b'f\n', b'gh\nijkl'):
+        await uevent.sleep_ms(5)
+        print('write', s)
+        await uevent.write(pipe, s)
+
+loop.create_task(reader())
+loop.create_task(writer())
+loop.run_forever()
+
+# a stream can only be waited on by one reader at a time
+loop.create_task(reader())
+loop.create_task(reader())
+try:
+    loop.run_forever()
+except RuntimeError:
+    print('RuntimeError')
+
+# the run queue needs room for at least one task
+try:
+    uevent.Loop(0)
+except ValueError as er:
+    print('ValueError', er)
@@ -1,4 +1,9 @@
 # this test for the availability of native emitter
+# (micropython.native is accepted even without it, but micropython.viper isn't)
 @micropython.native
 def f():
     pass
+
+@micropython.viper
+def g():
+    pass
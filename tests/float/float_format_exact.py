@@ -0,0 +1,30 @@
+# test correctly rounded and shortest round-trip float formatting
+
+# skip if floats aren't doubles formatted exactly
+if repr(0.1 + 0.2) != '0.30000000000000004':
+    print('SKIP')
+    raise SystemExit
+
+# repr gives the fewest digits that read back as the same float
+for x in (0.1, 0.3, 1 / 3, 2 / 3, 1e16, 1e22, 1e23, 2.0 ** 60, 123456.789, 5e-324, 2.2250738585072014e-308, 1.7976931348623157e308):
+    print(repr(x), repr(-x), float(repr(x)) == x)
+
+# fixed precision is correctly rounded, ties to even
+for x in (0.5, 1.5, 2.5, 0.125, 0.375, 2.675, 9.5, 99.5, 0.95, 0.0015, 123456.5, 1e-300):
+    print('%.0f %.1f %.2f %.3g %.1e' % (x, x, x, x, x))
+
+# rounding up that adds a digit can make 'g' switch to an exponent
+print('%.1g %.2g' % (-9.9, 99.9))
+
+# exact values of the float are used for many digits
+print('%.25f' % 0.1)
+print('%.20e' % 1e23)
+print('{:.20g}'.format(2.0 / 3))
+
+# parsing is correctly rounded too
+print(float('0.30000000000000004') == 0.1 + 0.2)
+print(float('2.2250738585072011e-308'))
+print(float('9007199254740993'))
+print(float('1.000000000000000111'))
+print(float('1.000000000000000112'))
+print(float('179769313486231580793728971405301e276'))
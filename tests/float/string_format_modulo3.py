@@ -1,3 +1,8 @@
-# uPy and CPython outputs differ for the following
+# uPy and CPython outputs differ for the following, unless floats are formatted
+# exactly, which float_format_exact.py tests
+if repr(0.1 + 0.2) == '0.30000000000000004':
+    print('SKIP')
+    raise SystemExit
+
 print("%.1g" % -9.9) # round up 'g' with '-' sign
 print("%.2g" % 99.9) # round up
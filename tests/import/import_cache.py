@@ -0,0 +1,80 @@
+# test that a module imported from a .py file is compiled again when its
+# source no longer matches the cached compiled code
+
+import sys
+
+try:
+    import uos as os
+except ImportError:
+    import os
+
+if not hasattr(os, "unlink"):
+    print("SKIP")
+    raise SystemExit
+
+sys.path.insert(0, "")
+
+
+def cleanup():
+    for name in ("import_cache_mod.py", "import_cache_mod.pyc"):
+        try:
+            os.unlink(name)
+        except OSError:
+            pass
+
+
+def load(src):
+    if src is not None:
+        with open("import_cache_mod.py", "w") as f:
+            f.write(src)
+    sys.modules.pop("import_cache_mod", None)
+    import import_cache_mod
+
+    return import_cache_mod
+
+
+cleanup()
+
+m = load("x = 1\ndef f(a):\n    return [a] * 2\n")
+try:
+    os.stat("import_cache_mod.pyc")
+except OSError:
+    cleanup()
+    print("SKIP")
+    raise SystemExit
+print(m.x, m.f(3))
+
+# loaded from the cache
+m = load(None)
+print(m.x, m.f(3))
+
+# source with a different length
+m = load("x = 22\ndef f(a):\n    return [a] * 2\n")
+print(m.x, m.f(3))
+
+# source with the same length
+m = load("x = 33\ndef f(a):\n    return [a] * 2\n")
+print(m.x, m.f(3))
+
+# damaged cache file
+with open("import_cache_mod.pyc", "rb") as f:
+    data = f.read()
+with open("import_cache_mod.pyc", "wb") as f:
+    f.write(data[: len(data) // 2])
+m = load(None)
+print(m.x, m.f(3))
+
+# compiled again at another optimisation level, which drops the assert
+import micropython
+
+m = load("def f():\n    assert 0\n    return 1\n")
+try:
+    m.f()
+except AssertionError:
+    print("AssertionError")
+micropython.opt_level(3)
+m = load(None)
+print(m.f())
+micropython.opt_level(0)
+
+cleanup()
@@ -0,0 +1,51 @@
+# test calling functions of a module that is imported again; when this test is
+# run from a .mpy file its functions are loaded lazily, when first called
+
+import gc
+import sys
+
+try:
+    __file__
+except NameError:
+    print("SKIP")
+    raise SystemExit
+
+
+def add(a, b=1):
+    return a + b
+
+
+def make_adder(n):
+    def adder(x):
+        return x + n
+
+    return adder
+
+
+def gen(n):
+    for i in range(n):
+        yield i
+
+
+if __name__ == "__main__":
+    print(add(1), add(2, 3), make_adder(10)(1), list(gen(3)))
+
+    # import this file again as a module, whose functions are new
+    path = __file__.rsplit("/", 1)
+    name = path[-1].split(".")[0]
+    sys.path.insert(0, path[0] if len(path) > 1 else "")
+    sys.modules.pop(name, None)
+    m = __import__(name)
+    print(m.add is add, m.add(1), m.make_adder(5)(1), list(m.gen(2)))
+
+    # functions outlive their module, whether they were loaded or not
+    called = m.add
+    uncalled = m.make_adder
+    sys.modules.pop(name)
+    m = None
+    gc.collect()
+    print(called(2), uncalled(3)(4))
+
+    # and a module imported once more loads its functions again
+    m = __import__(name)
+    print(m.add is called, m.add(3), m.make_adder(1)(1), list(m.gen(1)))
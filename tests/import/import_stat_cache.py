@@ -0,0 +1,72 @@
+# test that modules and packages made after an import looked for them are found
+
+import sys
+
+try:
+    import uos as os
+except ImportError:
+    import os
+
+if not (hasattr(os, "unlink") and hasattr(os, "mkdir") and hasattr(os, "rmdir")):
+    print("SKIP")
+    raise SystemExit
+
+sys.path.insert(0, "")
+
+
+def cleanup():
+    for name in (
+        "import_stat_mod.py",
+        "import_stat_mod.pyc",
+        "import_stat_pkg/__init__.py",
+        "import_stat_pkg/__init__.pyc",
+        "import_stat_pkg/sub.py",
+        "import_stat_pkg/sub.pyc",
+    ):
+        try:
+            os.unlink(name)
+        except OSError:
+            pass
+    try:
+        os.rmdir("import_stat_pkg")
+    except OSError:
+        pass
+
+
+def write(name, src):
+    with open(name, "w") as f:
+        f.write(src)
+
+
+def try_import(name):
+    sys.modules.pop(name, None)
+    try:
+        m = __import__(name, None, None, ("x",))
+        print(name, m.x)
+    except ImportError:
+        print(name, "not found")
+
+
+cleanup()
+
+# a module
+try_import("import_stat_mod")
+write("import_stat_mod.py", "x = 1\n")
+try_import("import_stat_mod")
+os.unlink("import_stat_mod.py")
+try:
+    os.unlink("import_stat_mod.pyc")
+except OSError:
+    pass
+try_import("import_stat_mod")
+
+# a package, and a module in it
+try_import("import_stat_pkg")
+os.mkdir("import_stat_pkg")
+write("import_stat_pkg/__init__.py", "x = 2\n")
+try_import("import_stat_pkg")
+try_import("import_stat_pkg.sub")
+write("import_stat_pkg/sub.py", "x = 3\n")
+try_import("import_stat_pkg.sub")
+
+cleanup()
@@ -0,0 +1,43 @@
+# test parsing and compiling a file a group of statements at a time
+try:
+    from micropython import mem_peak_compile
+except (ImportError, AttributeError):
+    print("SKIP")
+    raise SystemExit
+
+# enough top-level statements to be split into several groups
+src = "from micropython import const\nK = const(3)\n_L = const(4)\n"
+for i in range(100):
+    src += "def f%d(x):\n    return x + %d + K + _L\n\n" % (i, i)
+src += "class A:\n    def m(self):\n        return f99(1)\n"
+src += "if True:\n    y = A().m()\n"
+
+# consts and names are shared across groups
+g = {}
+exec(src, g)
+print(g["y"], g["f0"](0), "_L" in g)
+print(mem_peak_compile() > 0)
+
+# a syntax error late in the file is raised before anything runs
+g = {}
+try:
+    exec("z = 1\n" + src + "x = = 1\n", g)
+except SyntaxError:
+    print("SyntaxError", "z" in g)
+
+# an indentation error at top level
+try:
+    exec(src + " x = 1\n")
+except IndentationError:
+    print("IndentationError")
+
+# exceptions propagate out of later groups
+try:
+    exec(src + "raise ValueError(y)\n")
+except ValueError as e:
+    print("ValueError", e.args)
+
+# empty input and input with only newlines
+exec("")
+exec("\n\n")
+print("done")
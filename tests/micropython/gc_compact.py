@@ -0,0 +1,80 @@
+# test gc.compact()
+
+import gc
+
+try:
+    gc.compact
+except AttributeError:
+    print('SKIP')
+    raise SystemExit
+
+# fragment the heap with live lists and dicts between dead objects
+keep = []
+for i in range(30):
+    [0] * 20
+    l = list(range(i))
+    d = {j: str(j) for j in range(i % 10)}
+    keep.append((l, d))
+    {}
+del l, d
+
+# fill the rest of the heap with list storage, each piece followed by a tuple,
+# then free the tuples so that no free run is big enough for a large object
+gc.collect()
+zeros = [0] * 60
+filler = [0] * 64
+n = gc.mem_free() // 512
+lists = [[] for i in range(n)]
+fill = [None] * n
+try:
+    for i in range(n):
+        lists[i].extend(zeros)
+        fill[i] = tuple(filler)
+except MemoryError:
+    pass
+for i in range(n):
+    fill[i] = None
+try:
+    bytearray(4096)
+    print('allocated')
+except MemoryError:
+    print('MemoryError')
+
+# compacting moves the storage together, leaving room for the large object
+moved = gc.compact()
+print(moved > 0)
+b = bytearray(4096)
+print(len(b))
+
+# contents survive
+ok = True
+for i, (l, d) in enumerate(keep):
+    if l != list(range(i)) or d != {j: str(j) for j in range(i % 10)}:
+        ok = False
+for l in lists:
+    if l and l != zeros:
+        ok = False
+print(ok)
+del lists, fill, b
+
+# containers still work after being moved
+l, d = keep[29]
+l.append(99)
+d['x'] = 1
+print(len(l), l[-1], d['x'], d[3])
+
+# compacting while iterating
+total = 0
+for x in keep[20][0]:
+    gc.compact()
+    total += x
+print(total)
+n = 0
+for k in keep[9][1]:
+    gc.compact()
+    n += k
+print(n)
+
+# a second pass has nothing left to do
+gc.compact()
+print(gc.compact() == 0)
@@ -0,0 +1,47 @@
+# test minor (generation 0) collections and pause statistics
+
+import gc
+
+try:
+    gc.pause_stats
+except AttributeError:
+    print("SKIP")
+    raise SystemExit
+
+n_minor, n_full, longest, hist = gc.pause_stats()
+print(type(longest), len(hist) > 0)
+
+# module globals live in the old generation; objects they refer to must
+# survive a minor collection
+lst = [[i] * 4 for i in range(100)]
+d = {}
+for i in range(50):
+    d[i] = str(i) * 3
+gc.collect(0)
+gc.collect(0)
+print(sum(x[0] for x in lst), d[49])
+
+# garbage from the young generation is reclaimed by a minor collection
+for i in range(100):
+    [i] * 20
+gc.collect(0)
+print(sum(x[3] for x in lst))
+
+# a full collection still works
+gc.collect()
+gc.collect(1)
+
+n_minor2, n_full2, longest2, hist2 = gc.pause_stats()
+print(n_minor2 - n_minor >= 3, n_full2 - n_full >= 2)
+print(sum(hist2) - sum(hist) == (n_minor2 - n_minor) + (n_full2 - n_full))
+print(longest2 >= longest)
+
+# automatic collections honour the pause target
+old = gc.max_pause()
+gc.max_pause(1)
+print(gc.max_pause())
+gc.collect()
+for i in range(2000):
+    l = [i] * 10
+print(d[10], lst[99][0])
+gc.max_pause(old)
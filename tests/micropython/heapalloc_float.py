@@ -0,0 +1,39 @@
+# check that float arithmetic doesn't allocate heap memory on builds where
+# floats are stored in the object itself (eg with nan-boxing)
+
+import micropython
+
+# Check for stackless build, which can't call functions without
+# allocating a frame on heap.
+try:
+    def stackless(): pass
+    micropython.heap_lock(); stackless(); micropython.heap_unlock()
+except RuntimeError:
+    print("SKIP")
+    raise SystemExit
+
+try:
+    float
+except NameError:
+    print("SKIP")
+    raise SystemExit
+
+def test(x, y, out):
+    for i in range(4):
+        x = x * 1.5 + y
+        y = -x / 4.0 - 0.25
+    out[0] = x
+    out[1] = y
+    out[2] = x < y
+    out[3] = abs(y) * x
+
+out = [None] * 4
+micropython.heap_lock()
+try:
+    test(1.25, 0.5, out)
+except MemoryError:
+    micropython.heap_unlock()
+    print("SKIP")
+    raise SystemExit
+micropython.heap_unlock()
+print(out)
@@ -0,0 +1,34 @@
+# test that builtins which only iterate over their argument don't use the heap
+try:
+    set
+except NameError:
+    print("SKIP")
+    raise SystemExit
+
+try:
+    from micropython import heap_lock, heap_unlock
+except (ImportError, AttributeError):
+    heap_lock = heap_unlock = lambda:0
+
+# pre-create objects so the operations below don't have to grow them
+t = (1, 2)
+l = [1, 2]
+d = {1: None, 2: None}
+s = {1, 2, 3}
+pairs = ((1, 'a'), [2, 'b'])
+text = 'abc'
+for c in text + chr(100):
+    pass
+
+heap_lock()
+d.update(pairs)
+s.difference_update(l)
+s.symmetric_difference_update(t)
+s.update(l)
+for c in text:
+    print(c)
+print(text[1], chr(100))
+heap_unlock()
+
+print(sorted(d.items()))
+print(sorted(s))
@@ -0,0 +1,114 @@
+# test functions that become hot and are compiled by the JIT
+# the results must be the same as with the bytecode VM
+
+# enough calls for a function to be compiled on any build
+HOT = 1200
+
+# hot through its loop
+def loop(n):
+    s = 0
+    i = 0
+    while i < n:
+        s += i
+        i += 1
+    return s
+print(loop(HOT), loop(10))
+
+# hot through calls, with default, keyword and star args
+def args(a, b=2, *c, d=4, **e):
+    return a, b, c, d, sorted(e)
+for i in range(HOT):
+    args(i)
+print(args(1), args(1, 3, 5, d=6, z=7))
+
+# exceptions, finally and break/continue out of them
+def exc(x):
+    r = []
+    for i in range(4):
+        try:
+            if i == x:
+                break
+            if i == 1:
+                continue
+            r.append(10 // (i - 2))
+        except ZeroDivisionError:
+            r.append('zde')
+        finally:
+            r.append('f')
+    else:
+        r.append('else')
+    return r
+for i in range(HOT):
+    exc(i)
+print(exc(3))
+print(exc(9))
+
+# with statement
+class CM:
+    def __enter__(self):
+        return 1
+    def __exit__(self, a, b, c):
+        return a is ValueError
+def with_(x):
+    with CM() as y:
+        if x:
+            raise ValueError
+        return y
+    return 'suppressed'
+for i in range(HOT):
+    with_(i & 1)
+print(with_(0), with_(1))
+
+# closures and comprehensions
+def clo(n):
+    def f(x):
+        return x + n
+    return [f(i) for i in range(3)], {i: i * n for i in range(2)}
+for i in range(HOT):
+    clo(i)
+print(clo(5))
+
+# an unbound local is still an error
+def unbound(x):
+    if x:
+        y = 1
+    return y
+for i in range(HOT):
+    unbound(1)
+try:
+    unbound(0)
+except NameError:
+    print('NameError')
+
+# a hot function uses the globals of its own module
+glob = 'here'
+def get_glob():
+    return glob
+for i in range(HOT):
+    get_glob()
+print(get_glob())
+
+# sys.exc_info() in a hot except block
+import sys
+def exc_info():
+    try:
+        raise ValueError
+    except:
+        return sys.exc_info()[0]
+for i in range(HOT):
+    exc_info()
+print(exc_info())
+
+# a hot function that raises is in the traceback
+import uio
+def raiser(x):
+    if x:
+        raise ValueError
+for i in range(HOT):
+    raiser(0)
+try:
+    raiser(1)
+except ValueError as er:
+    s = uio.StringIO()
+    sys.print_exception(er, s)
+    print('raiser' in s.getvalue())
@@ -0,0 +1,38 @@
+# test generators that become hot and are compiled by the JIT
+
+# enough calls for a function to be compiled on any build
+HOT = 1200
+
+def gen(n):
+    for i in range(n):
+        yield i
+    yield from (7, 8)
+for i in range(HOT):
+    list(gen(2))
+print(list(gen(3)))
+
+def send():
+    x = yield 1
+    yield from gen(x)
+g = send()
+print(next(g), g.send(1), next(g), next(g))
+try:
+    next(g)
+except StopIteration:
+    print('StopIteration')
+
+log = []
+def throw():
+    try:
+        yield 1
+    except ValueError as er:
+        yield er.args[0]
+    finally:
+        log.append('finally')
+for i in range(HOT):
+    list(throw())
+g = throw()
+print(next(g))
+print(g.throw(ValueError(5)))
+g.close()
+print(len(log), log[-1])
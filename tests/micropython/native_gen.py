@@ -0,0 +1,60 @@
+# test for native generators
+
+# simple generator with yield and return
+@micropython.native
+def gen1(x):
+    yield x
+    yield x + 1
+    return x + 2
+g = gen1(3)
+print(next(g))
+print(next(g))
+try:
+    next(g)
+except StopIteration as e:
+    print(e.args[0])
+
+# using yield from
+@micropython.native
+def gen2(x):
+    yield from range(x)
+print(list(gen2(3)))
+
+# sending values in, including through yield from
+@micropython.native
+def gen3():
+    x = yield 1
+    print('got', x)
+    r = yield from gen1(x)
+    print('ret', r)
+g = gen3()
+print(next(g))
+print(g.send(10))
+print(next(g))
+try:
+    next(g)
+except StopIteration:
+    print('StopIteration')
+
+# throwing into and closing a generator
+@micropython.native
+def gen4():
+    try:
+        yield 1
+    except ValueError as er:
+        print('caught', er.args)
+        yield 2
+    finally:
+        print('finally')
+g = gen4()
+print(next(g))
+print(g.throw(ValueError(5)))
+g.close()
+
+# generator with many locals
+@micropython.native
+def gen5(n):
+    a, b, c, d, e, f, g, h = range(8)
+    for i in range(n):
+        yield a + b + c + d + e + f + g + h + i
+print(list(gen5(3)))
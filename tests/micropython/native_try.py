@@ -0,0 +1,70 @@
+# test native try handling
+
+# basic try-finally
+@micropython.native
+def f():
+    try:
+        fail
+    finally:
+        print('finally')
+try:
+    f()
+except NameError:
+    print('NameError')
+
+# nested try-except with try-finally
+@micropython.native
+def f():
+    try:
+        try:
+            fail
+        finally:
+            print('finally')
+    except NameError:
+        print('NameError')
+f()
+
+# check that locals written to in try blocks keep their values
+@micropython.native
+def f():
+    a = 100
+    try:
+        print(a)
+        a = 200
+        fail
+    except NameError:
+        print(a)
+        a = 300
+    print(a)
+f()
+
+# return, break and continue through finally
+@micropython.native
+def f(n):
+    for i in range(n):
+        try:
+            if i == 1:
+                continue
+            if i == 3:
+                break
+            if i == 2:
+                try:
+                    return i
+                finally:
+                    print('inner finally', i)
+        finally:
+            print('finally', i)
+print(f(5))
+
+# bare raise re-raises the current exception
+@micropython.native
+def f():
+    try:
+        raise ValueError(1)
+    except ValueError:
+        print('reraise')
+        raise
+try:
+    f()
+except ValueError as er:
+    print('ValueError', er)
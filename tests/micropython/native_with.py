@@ -0,0 +1,55 @@
+# test with handling within a native function
+
+class C:
+    def __init__(self):
+        print('__init__')
+    def __enter__(self):
+        print('__enter__')
+    def __exit__(self, a, b, c):
+        print('__exit__', a, b)
+
+# basic with
+@micropython.native
+def f():
+    with C():
+        print(1)
+f()
+
+# nested with and try-except
+@micropython.native
+def f():
+    try:
+        with C():
+            print(1)
+            fail
+            print(2)
+    except NameError:
+        print('NameError')
+f()
+
+# return and break from within with
+@micropython.native
+def f():
+    for i in range(3):
+        with C():
+            if i == 1:
+                break
+            print(i)
+    with C():
+        return 'ret'
+print(f())
+
+# __exit__ can suppress the exception
+class D:
+    def __enter__(self):
+        return self
+    def __exit__(self, a, b, c):
+        print('suppress', a)
+        return True
+
+@micropython.native
+def f():
+    with D():
+        raise KeyError
+    print('after')
+f()
@@ -0,0 +1,40 @@
+# test micropython.schedule() with priorities and duplicate callbacks
+
+import micropython
+
+try:
+    micropython.schedule
+except AttributeError:
+    print('SKIP')
+    raise SystemExit
+
+# Schedule from within a callback so that the scheduler is locked and all the
+# callbacks are pending together.
+
+def callback(arg):
+    global done
+    print(arg)
+    done += 1
+
+def schedule_all(arg):
+    micropython.schedule(callback, 'low 1')
+    micropython.schedule(callback, 'high', 2)
+    micropython.schedule(callback, 'low 2', 0)
+    micropython.schedule(callback, 'mid', 1)
+    # already pending, so not queued again
+    micropython.schedule(callback, 'low 1')
+    micropython.schedule(callback, 'high', 1)
+    # already pending, but moved up to the higher priority
+    micropython.schedule(callback, 'low 2', 3)
+
+done = 0
+micropython.schedule(schedule_all, None)
+while done != 4:
+    pass
+
+# the priority must fit in a byte
+for priority in (-1, 256):
+    try:
+        micropython.schedule(callback, None, priority)
+    except ValueError:
+        print('ValueError')
@@ -0,0 +1,53 @@
+# test viper float type: arithmetic, comparisons and casts
+
+@micropython.viper
+def add(a:float, b:float) -> float:
+    return a + b
+
+@micropython.viper
+def ops(a:float, b:float):
+    print(a - b, a * b, a / b, -a, +b)
+    print(a < b, a > b, a == b, a <= b, a >= b, a != b)
+
+@micropython.viper
+def inplace(x:float) -> float:
+    y = x * 2.0 + 0.5
+    y += 1.0
+    y *= 2.0
+    return y
+
+@micropython.viper
+def casts(i:int, o) -> int:
+    f = float(i) + float(o)
+    print(f)
+    return int(f * 1.5)
+
+@micropython.viper
+def nan_cmp(a:float):
+    b = a
+    print(a == b, a != b, a < b, a >= b)
+
+@micropython.viper
+def boxed() -> float:
+    x = 1.25
+    print([x, x * 2.0])
+    return x
+
+@micropython.viper
+def accum(a:float, n:int) -> int:
+    s = 0.0
+    for i in range(n):
+        s = s + a * a
+    return int(s)
+
+print(add(1.5, 2.25))
+ops(3.0, 4.0)
+ops(4.5, 1.5)
+ops(2.0, 2.0)
+print(inplace(1.0))
+print(casts(3, 2.5))
+print(casts(-3, 1))
+nan_cmp(float('nan'))
+nan_cmp(1.0)
+print(boxed())
+print(accum(1.5, 4))
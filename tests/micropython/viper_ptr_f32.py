@@ -0,0 +1,46 @@
+# test loading and storing through the ptr_f32 viper type
+
+try:
+    import array
+except ImportError:
+    print("SKIP")
+    raise SystemExit
+
+@micropython.viper
+def get(src:ptr_f32) -> float:
+    return src[0] + src[1]
+
+@micropython.viper
+def put(dest:ptr_f32, i:int, val:float):
+    dest[i] = val
+
+@micropython.viper
+def scale(a, s:float):
+    p = ptr_f32(a)
+    p[0] = p[0] * s
+    p[2] = -p[1]
+
+@micropython.viper
+def fir(x, coeffs, out, m:int):
+    n = int(len(x))
+    px = ptr_f32(x)
+    pc = ptr_f32(coeffs)
+    po = ptr_f32(out)
+    for i in range(n - m + 1):
+        acc = 0.0
+        for j in range(m):
+            acc += px[i + j] * pc[j]
+        po[i] = acc
+
+a = array.array('f', [1.5, 2.25, 0])
+print(get(a))
+put(a, 2, 4.75)
+print(list(a))
+scale(a, 2.0)
+print(list(a))
+
+x = array.array('f', [1, 2, 3, 4, 5, 6])
+c = array.array('f', [0.5, 0.25, 0.25])
+o = array.array('f', [0] * 4)
+fir(x, c, o, 3)
+print(list(o))
@@ -0,0 +1,50 @@
+# test shared dicts and lists whose keys run Python code that uses the
+# container of another thread, which must not deadlock
+
+import _thread
+
+class Key:
+    def __init__(self, n, other):
+        self.n = n
+        self.other = other
+
+    def __hash__(self):
+        self.other.get(-1)
+        return self.n
+
+    def __eq__(self, other):
+        return type(other) is Key and self.n == other.n
+
+# each thread stores into its own dict and list and reads from the other's
+d = [{}, {}]
+lst = [[], []]
+
+def th(n, idx):
+    mine = d[idx]
+    other = d[1 - idx]
+    for repeat in range(n):
+        for i in range(8):
+            k = Key(i, other)
+            mine[k] = repeat
+            assert mine[k] == repeat
+        lst[idx] = [Key(i, other) for i in range(8, 0, -1)]
+        lst[idx].sort(key=lambda k: other.get(-1, k.n))
+        assert [k.n for k in lst[idx]] == list(range(1, 9))
+        assert lst[idx].count(Key(3, other)) == 1
+    with lock:
+        global n_finished
+        n_finished += 1
+
+lock = _thread.allocate_lock()
+n_thread = 2
+n_finished = 0
+
+# spawn threads
+for i in range(n_thread):
+    _thread.start_new_thread(th, (100, i))
+
+# busy wait for threads to finish
+while n_finished < n_thread:
+    pass
+
+print(sorted(v for v in d[0].values()), sorted(v for v in d[1].values()))
@@ -0,0 +1,74 @@
+# test that two threads comparing containers held by other containers don't
+# deadlock when the locks of those objects are nested in opposite orders
+
+import _thread
+try:
+    import ustruct as struct
+except ImportError:
+    import struct
+
+# objects share a lock chosen by their address, see py/modthread.c
+BLOCK = 4 * struct.calcsize('P')
+
+def stripe(o):
+    return id(o) // BLOCK % 64
+
+# find pairs of outer and inner objects where the inner object of each pair
+# uses the lock of the outer object of the other pair
+def find_pairs(outers, inners):
+    by_stripe = {}
+    for o in inners:
+        by_stripe.setdefault(stripe(o), o)
+    for a in outers:
+        for b in outers:
+            if stripe(a) != stripe(b) and stripe(b) in by_stripe and stripe(a) in by_stripe:
+                return (a, by_stripe[stripe(b)]), (b, by_stripe[stripe(a)])
+    return (outers[0], inners[0]), (outers[1], inners[1])
+
+lists = [[] for i in range(64)]
+sets = [set(range(i, i + 4)) for i in range(64)]
+(la, sa), (lb, sb) = find_pairs(lists, sets)
+la.append(sa)
+lb.append(sb)
+
+# frozensets containing frozensets, made until their locks are found to
+# overlap in the same way
+def make_containing(item, want):
+    for i in range(1000):
+        f = frozenset((item,))
+        if stripe(f) == want:
+            return f
+    return f
+
+xa = frozenset(range(4))
+xb = frozenset(range(1, 5))
+fa = make_containing(xa, stripe(xb))
+fb = make_containing(xb, stripe(xa))
+
+def th(n, lst, value, fs, item):
+    # start together so the searches overlap
+    while not go:
+        pass
+    for i in range(n):
+        assert lst.index(value) == 0
+        assert lst.count(value) == 1
+        assert item in fs
+    with lock:
+        global n_finished
+        n_finished += 1
+
+lock = _thread.allocate_lock()
+n_thread = 2
+n_finished = 0
+go = False
+
+# search each list for a copy of its set, and each frozenset for a copy of its item
+_thread.start_new_thread(th, (20000, la, set(sa), fa, frozenset(xa)))
+_thread.start_new_thread(th, (20000, lb, set(sb), fb, frozenset(xb)))
+go = True
+
+# busy wait for threads to finish
+while n_finished < n_thread:
+    pass
+
+print(la == [sa], lb == [sb])
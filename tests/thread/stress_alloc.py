@@ -0,0 +1,48 @@
+# benchmark of small allocations made by several threads at once
+# run with an argument to print the time taken for 1, 2 and 4 threads; each
+# thread does the same work, so without contention the times are about equal
+#
+# MIT license
+
+import sys
+try:
+    import utime as time
+    ticks_ms = time.ticks_ms
+    ticks_diff = time.ticks_diff
+except ImportError:
+    import time
+    ticks_ms = lambda: int(time.time() * 1000)
+    ticks_diff = lambda a, b: a - b
+import _thread
+
+def thread_entry(n):
+    total = 0
+    for i in range(n):
+        # a few short lived objects per iteration
+        t = (i, i + 1)
+        l = [i, t]
+        total += l[1][1] - l[0]
+    with lock:
+        global n_finished, n_total
+        n_finished += 1
+        n_total += total
+
+def run(n_thread, n):
+    global n_finished, n_total
+    n_finished = 0
+    n_total = 0
+    t0 = ticks_ms()
+    for i in range(n_thread):
+        _thread.start_new_thread(thread_entry, (n,))
+    while n_finished < n_thread:
+        time.sleep(0.01)
+    return ticks_diff(ticks_ms(), t0), n_total
+
+lock = _thread.allocate_lock()
+verbose = len(sys.argv) > 1
+
+for n_thread in (1, 2, 4):
+    dt, total = run(n_thread, 100000)
+    if verbose:
+        print(n_thread, 'threads:', dt, 'ms')
+    print(n_thread, total)
@@ -0,0 +1,24 @@
+# indexing, slicing and searching long strs, which may use a code point index
+
+ascii = "".join(chr(48 + i % 40) for i in range(300))
+mixed = "".join(chr(0x41 + i % 26) if i % 3 else chr(0x3b1 + i % 20) for i in range(300))
+wide = "".join(chr(0x1f600 + i % 50) for i in range(100)) + "end"
+
+for s in (ascii, mixed, wide):
+    n = len(s)
+    print(n, len(s[:]))
+    print("".join(s[i] for i in range(n)) == s)
+    print("".join(s[-i] for i in range(n, 0, -1)) == s)
+    for i in (0, 1, 31, 32, 33, 63, 64, 65, 100, n - 33, n - 32, n - 1):
+        print(i, s[i], s[-i - 1], s[i:i + 3], s[-i - 3:-i], len(s[i:]), len(s[:-i]))
+    print(s[n:], s[-n - 1:-n], s[n + 100:], len(s[-n - 100:]))
+    for idx in (n, -n - 1, 1000, -1000):
+        try:
+            s[idx]
+        except IndexError:
+            print("IndexError", idx)
+    # find returns a code point index
+    for i in (5, 40, 100, n - 2):
+        sub = s[i:i + 2]
+        print(s.find(sub, i), s.rfind(sub), s.index(sub, i, i + 2))
+    print(s.find(s[-1], 50), s.find("x", 40))
@@ -0,0 +1,48 @@
+# Name index of frozen modules, shared by make-frozen.py and mpy-tool.py.
+#
+# The generated arrays are looked up by py/frozenmod.c.
+
+from __future__ import print_function
+import sys
+
+
+def name_hash(name):
+    # djb2, as computed by frozen_hash in py/frozenmod.c
+    h = 5381
+    for c in bytearray(name.encode('utf8')):
+        h = (h * 33 ^ c) & 0xffffffff
+    return h
+
+def print_index(prefix, names):
+    # Offset of each name, and an open addressing table, at most half full, of
+    # the names and of the directories they're in.  A slot holds the index of
+    # a name + 1, with the top bit set for the directory part of the name, and
+    # 0 marks an empty slot.
+    offsets = []
+    offset = 0
+    entries = []
+    dirs = set()
+    for i, name in enumerate(names):
+        offsets.append(offset)
+        offset += len(name.encode('utf8')) + 1
+        entries.append((name, i + 1))
+        parts = name.split('/')
+        for j in range(1, len(parts)):
+            d = '/'.join(parts[:j])
+            if d not in dirs:
+                dirs.add(d)
+                entries.append((d, (i + 1) | 0x8000))
+    if offset > 0xffff or len(names) >= 0x7fff:
+        sys.exit('too many frozen modules')
+    size = 2
+    while size < 2 * (len(entries) + 1):
+        size *= 2
+    table = [0] * size
+    for name, slot in entries:
+        i = name_hash(name) & (size - 1)
+        while table[i]:
+            i = (i + 1) & (size - 1)
+        table[i] = slot
+    print('const uint16_t %s_name_offsets[] = {%s};' % (prefix, ', '.join(str(o) for o in offsets or [0])))
+    print('const uint16_t %s_index_size = %d;' % (prefix, size))
+    print('const uint16_t %s_index[] = {%s};' % (prefix, ', '.join(str(s) for s in table)))
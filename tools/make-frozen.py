@@ -21,6 +21,8 @@ from __future__ import print_function
 import sys
 import os
 
+from frozen_index import print_index
+
 
 def module_name(f):
     return f
@@ -43,6 +45,8 @@ for f, st in modules:
     print('"%s\\0"' % m)
 print('"\\0"};')
 
+print_index("mp_frozen_str", [module_name(f) for f, st in modules])
+
 print("const uint32_t mp_frozen_str_sizes[] = {")
 
 for f, st in modules:
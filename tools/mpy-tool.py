@@ -47,6 +47,7 @@ from collections import namedtuple
 
 sys.path.append(sys.path[0] + '/../py')
 import makeqstrdata as qstrutil
+import frozen_index
 
 class FreezeError(Exception):
     def __init__(self, rawcode, msg):
@@ -61,6 +62,7 @@ class Config:
     MICROPY_LONGINT_IMPL_NONE = 0
     MICROPY_LONGINT_IMPL_LONGLONG = 1
     MICROPY_LONGINT_IMPL_MPZ = 2
+    MICROPY_OPT_BYTECODE_SUPERINSTRUCTIONS = False
 config = Config()
 
 MP_OPCODE_BYTE = 0
@@ -72,11 +74,16 @@ MP_OPCODE_OFFSET = 3
 MP_BC_MAKE_CLOSURE = 0x62
 MP_BC_MAKE_CLOSURE_DEFARGS = 0x63
 MP_BC_RAISE_VARARGS = 0x5c
+MP_BC_UNWIND_JUMP = 0x46
+MP_BC_COMPARE_POP_JUMP_IF_TRUE = 0x2c
+MP_BC_COMPARE_POP_JUMP_IF_FALSE = 0x2d
+MP_BC_LOAD_FAST_CONST_BINARY_OP = 0x13 # 2 extra bytes
 # extra byte if caching enabled:
-MP_BC_LOAD_NAME = 0x1c
-MP_BC_LOAD_GLOBAL = 0x1d
-MP_BC_LOAD_ATTR = 0x1e
+MP_BC_LOAD_NAME = 0x1b
+MP_BC_LOAD_GLOBAL = 0x1c
+MP_BC_LOAD_ATTR = 0x1d
 MP_BC_STORE_ATTR = 0x26
+MP_BC_LOAD_FAST_ATTR_MULTI = 0x00
 
 # load opcode names
 opcode_names = {}
@@ -100,18 +107,18 @@ def make_opcode_format():
     O = 3
     return bytes_cons((
     # this table is taken verbatim from py/bc.c
-    OC4(U, U, U, U), # 0x00-0x03
-    OC4(U, U, U, U), # 0x04-0x07
-    OC4(U, U, U, U), # 0x08-0x0b
-    OC4(U, U, U, U), # 0x0c-0x0f
-    OC4(B, B, B, U), # 0x10-0x13
+    OC4(Q, Q, Q, Q), # 0x00-0x03
+    OC4(Q, Q, Q, Q), # 0x04-0x07
+    OC4(Q, Q, Q, Q), # 0x08-0x0b
+    OC4(Q, Q, Q, Q), # 0x0c-0x0f
+    OC4(B, B, B, V), # 0x10-0x13
     OC4(V, U, Q, V), # 0x14-0x17
     OC4(B, V, V, Q), # 0x18-0x1b
     OC4(Q, Q, Q, Q), # 0x1c-0x1f
     OC4(B, B, V, V), # 0x20-0x23
     OC4(Q, Q, Q, B), # 0x24-0x27
     OC4(V, V, Q, Q), # 0x28-0x2b
-    OC4(U, U, U, U), # 0x2c-0x2f
+    OC4(O, O, U, U), # 0x2c-0x2f
     OC4(B, B, B, B), # 0x30-0x33
     OC4(B, O, O, O), # 0x34-0x37
     OC4(O, O, U, U), # 0x38-0x3b
@@ -177,20 +184,27 @@ def mp_opcode_format(bytecode, ip, opcode_format=make_opcode_format()):
     opcode = bytecode[ip]
     ip_start = ip
     f = (opcode_format[opcode >> 2] >> (2 * (opcode & 3))) & 3
+    extra_byte = (
+        opcode == MP_BC_RAISE_VARARGS
+        or opcode == MP_BC_MAKE_CLOSURE
+        or opcode == MP_BC_MAKE_CLOSURE_DEFARGS
+        or opcode == MP_BC_UNWIND_JUMP
+        or opcode == MP_BC_COMPARE_POP_JUMP_IF_TRUE
+        or opcode == MP_BC_COMPARE_POP_JUMP_IF_FALSE
+    )
+    if opcode == MP_BC_LOAD_FAST_CONST_BINARY_OP:
+        extra_byte = 2
+    if config.MICROPY_OPT_CACHE_MAP_LOOKUP_IN_BYTECODE and (
+        opcode == MP_BC_LOAD_NAME
+        or opcode == MP_BC_LOAD_GLOBAL
+        or opcode == MP_BC_LOAD_ATTR
+        or opcode == MP_BC_STORE_ATTR
+        or opcode < MP_BC_LOAD_FAST_ATTR_MULTI + 16
+    ):
+        extra_byte = 1
     if f == MP_OPCODE_QSTR:
         ip += 3
     else:
-        extra_byte = (
-            opcode == MP_BC_RAISE_VARARGS
-            or opcode == MP_BC_MAKE_CLOSURE
-            or opcode == MP_BC_MAKE_CLOSURE_DEFARGS
-            or config.MICROPY_OPT_CACHE_MAP_LOOKUP_IN_BYTECODE and (
-                opcode == MP_BC_LOAD_NAME
-                or opcode == MP_BC_LOAD_GLOBAL
-                or opcode == MP_BC_LOAD_ATTR
-                or opcode == MP_BC_STORE_ATTR
-            )
-        )
         ip += 1
         if f == MP_OPCODE_VAR_UINT:
             while bytecode[ip] & 0x80 != 0:
@@ -198,7 +212,7 @@ def mp_opcode_format(bytecode, ip, opcode_format=make_opcode_format()):
             ip += 1
         elif f == MP_OPCODE_OFFSET:
             ip += 2
-        ip += extra_byte
+    ip += extra_byte
     return f, ip - ip_start
 
 def decode_uint(bytecode, ip):
@@ -305,7 +319,7 @@ class RawCode:
                 opcode = '0x%02x' % opcode
             if f == 1:
                 qst = self._unpack_qstr(ip + 1).qstr_id
-                print('    {}, {} & 0xff, {} >> 8,'.format(opcode, qst, qst))
+                print('    {}, {} & 0xff, {} >> 8,{}'.format(opcode, qst, qst, ''.join(' 0x%02x,' % self.bytecode[ip + i] for i in range(3, sz))))
             else:
                 print('    {},{}'.format(opcode, ''.join(' 0x%02x,' % self.bytecode[ip + i] for i in range(1, sz))))
             ip += sz
@@ -489,6 +503,8 @@ def read_mpy(filename):
         feature_flags = header[2]
         config.MICROPY_OPT_CACHE_MAP_LOOKUP_IN_BYTECODE = (feature_flags & 1) != 0
         config.MICROPY_PY_BUILTINS_STR_UNICODE = (feature_flags & 2) != 0
+        # superinstructions are needed if any of the files may use them
+        config.MICROPY_OPT_BYTECODE_SUPERINSTRUCTIONS |= (feature_flags & 4) != 0
         config.mp_small_int_bits = header[3]
         return read_raw_code(f)
 
@@ -518,6 +534,12 @@ def freeze_mpy(base_qstrs, raw_codes):
     print('#endif')
     print()
 
+    if config.MICROPY_OPT_BYTECODE_SUPERINSTRUCTIONS:
+        print('#if !MICROPY_OPT_BYTECODE_SUPERINSTRUCTIONS')
+        print('#error "incompatible MICROPY_OPT_BYTECODE_SUPERINSTRUCTIONS"')
+        print('#endif')
+        print()
+
     print('#if MICROPY_LONGINT_IMPL != %u' % config.MICROPY_LONGINT_IMPL)
     print('#error "incompatible MICROPY_LONGINT_IMPL"')
     print('#endif')
@@ -584,6 +606,7 @@ def freeze_mpy(base_qstrs, raw_codes):
         print('"%s\\0"' % module_name)
         qstr_size["filenames"] += len(module_name) + 1
     print('"\\0"};')
+    frozen_index.print_index('mp_frozen_mpy', [rc.source_file.str for rc in raw_codes])
 
     print('const mp_raw_code_t *const mp_frozen_mpy_content[] = {')
     for rc in raw_codes: